@@ -17,6 +17,7 @@
 
 #include <string>
 #include <sstream>
+#include <algorithm>
 #include <curl/curl.h>
 
 #include "CurlWrapper.h"
@@ -543,6 +544,365 @@ namespace CW
 
 
 
+    ////////////////////////////////////////////////////////////////////////////////
+    //
+    // HttpEngine
+    //
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class HttpEngine::Transfer
+    {
+    public :
+
+        Transfer(CURL* inHandle) : fHandle(inHandle), fResult(CURLE_OK), fDone(new XBOX::VSyncEvent()) {}
+        ~Transfer() { XBOX::ReleaseRefCountable(&fDone); }
+
+        void Complete(CURLcode inResult)
+        {
+            //The waiting task may destroy this object as soon as the event is signaled.
+            XBOX::VSyncEvent* done=XBOX::RetainRefCountable(fDone);
+
+            fResult=inResult;
+            done->Unlock();
+            done->Release();
+        }
+
+        CURL*               fHandle;
+        CURLcode            fResult;
+        XBOX::VSyncEvent*   fDone;
+    };
+
+
+    static XBOX::VCriticalSection   sEngineMutex;
+    static HttpEngine*              sEngine=NULL;
+
+
+    HttpEngine* HttpEngine::Get()
+    {
+        XBOX::VTaskLock lock(&sEngineMutex);
+
+        if(!sEngine)
+            sEngine=new HttpEngine();
+
+        return sEngine;
+    }
+
+
+    HttpEngine::HttpEngine() :
+        fShare(NULL),
+        fMulti(NULL),
+        fTask(NULL),
+        fWakeUp(new XBOX::VSyncEvent()),
+        fClosed(false)
+    {
+        fShare=curl_share_init();
+
+        if(fShare)
+        {
+            curl_share_setopt(fShare, CURLSHOPT_LOCKFUNC, LockShare);
+            curl_share_setopt(fShare, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+            curl_share_setopt(fShare, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(fShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+
+            //Connections are not shared here : libcurl does not support sharing them between
+            //concurrent threads, the multi handle below owns the connection cache instead.
+        }
+
+        fMulti=curl_multi_init();
+
+        if(fMulti)
+        {
+            curl_multi_setopt(fMulti, CURLMOPT_MAXCONNECTS, kMaxConnections);
+#if LIBCURL_VERSION_NUM >= 0x071e00
+            curl_multi_setopt(fMulti, CURLMOPT_MAX_HOST_CONNECTIONS, kMaxHostConnections);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+            curl_multi_setopt(fMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#endif
+        }
+    }
+
+
+    HttpEngine::~HttpEngine()
+    {
+        //The engine lives as long as the process, handles are left to the OS.
+        XBOX::ReleaseRefCountable(&fWakeUp);
+    }
+
+
+    CURL* HttpEngine::AcquireHandle()
+    {
+        {
+            XBOX::VTaskLock lock(&fMutex);
+
+            if(!fIdleHandles.empty())
+            {
+                CURL* handle=fIdleHandles.back();
+                fIdleHandles.pop_back();
+
+                return handle;
+            }
+        }
+
+        return curl_easy_init();
+    }
+
+
+    void HttpEngine::ReleaseHandle(CURL* inHandle)
+    {
+        if(!inHandle)
+            return;
+
+        //Drops options and callbacks but keeps live connections and caches.
+        curl_easy_reset(inHandle);
+
+        {
+            XBOX::VTaskLock lock(&fMutex);
+
+            if(fIdleHandles.size()<kMaxIdleHandles)
+            {
+                fIdleHandles.push_back(inHandle);
+                return;
+            }
+        }
+
+        curl_easy_cleanup(inHandle);
+    }
+
+
+    CURLcode HttpEngine::Perform(CURL* inHandle)
+    {
+        if(fShare)
+            curl_easy_setopt(inHandle, CURLOPT_SHARE, fShare);
+
+        //Without a multi handle or an engine task (quitting), run the transfer in the calling task.
+        if(!fMulti || !StartTask())
+            return curl_easy_perform(inHandle);
+
+        Transfer transfer(inHandle);
+        bool queued=false;
+
+        {
+            XBOX::VTaskLock lock(&fMutex);
+
+            //Once the engine task has aborted its transfers, nobody would complete a queued one.
+            if(!fClosed)
+            {
+                fPending.push_back(&transfer);
+                fWakeUp->Unlock();
+                queued=true;
+            }
+        }
+
+        if(!queued)
+            return curl_easy_perform(inHandle);
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(fMulti);
+#endif
+
+        //The engine completes all its transfers before quitting. Don't rely on it only : if its task
+        //died without doing so, give up instead of waiting forever.
+        while(!transfer.fDone->Lock(kIdleWaitMs))
+        {
+            if(IsTaskAlive())
+                continue;
+
+            if(transfer.fDone->TryToLock())
+                break;
+
+            {
+                XBOX::VTaskLock lock(&fMutex);
+
+                std::vector<Transfer*>::iterator it=std::find(fPending.begin(), fPending.end(), &transfer);
+
+                if(it!=fPending.end())
+                    fPending.erase(it);
+            }
+
+            curl_multi_remove_handle(fMulti, inHandle);
+
+            return CURLE_ABORTED_BY_CALLBACK;
+        }
+
+        return transfer.fResult;
+    }
+
+
+    bool HttpEngine::StartTask()
+    {
+        XBOX::VTaskLock lock(&fMutex);
+
+        if(!fTask)
+        {
+            fTask=new XBOX::VTask(NULL, 0, XBOX::eTaskStylePreemptive, RunProc);
+            fTask->SetKindData((sLONG_PTR) this);
+            fTask->SetName(CVSTR("HTTP client engine"));
+
+            if(!fTask->Run())
+            {
+                XBOX::ReleaseRefCountable(&fTask);
+                return false;
+            }
+        }
+
+        return fTask->GetState()<XBOX::TS_DYING;
+    }
+
+
+    bool HttpEngine::IsTaskAlive()
+    {
+        XBOX::VTaskLock lock(&fMutex);
+
+        return fTask && fTask->GetState()<XBOX::TS_DEAD;
+    }
+
+
+    sLONG HttpEngine::RunProc(XBOX::VTask* inTask)
+    {
+        ((HttpEngine*) inTask->GetKindData())->Run(inTask);
+        return 0;
+    }
+
+
+    void HttpEngine::Run(XBOX::VTask* inTask)
+    {
+        while(inTask->GetState()<XBOX::TS_DYING)
+        {
+            //Sleep on the wake up event while there is nothing to transfer.
+            if(!AddPendingTransfers(fRunning.empty()))
+                continue;
+
+            int running=0;
+            curl_multi_perform(fMulti, &running);
+
+            ReadCompletedTransfers();
+
+            if(fRunning.empty())
+                continue;
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(fMulti, NULL, 0, kIdleWaitMs, NULL);
+#else
+            //No way to interrupt the wait from another task, keep it short so new transfers start quickly.
+            curl_multi_wait(fMulti, NULL, 0, 50, NULL);
+#endif
+        }
+
+        AbortTransfers();
+    }
+
+
+    bool HttpEngine::AddPendingTransfers(bool inWaitIfIdle)
+    {
+        std::vector<Transfer*> pending;
+
+        {
+            XBOX::VTaskLock lock(&fMutex);
+
+            pending.swap(fPending);
+
+            if(pending.empty() && inWaitIfIdle)
+                fWakeUp->Reset();
+        }
+
+        if(pending.empty())
+        {
+            if(inWaitIfIdle)
+            {
+                fWakeUp->Lock(kIdleWaitMs);
+                return false;
+            }
+
+            return true;
+        }
+
+        for(std::vector<Transfer*>::iterator it=pending.begin(); it!=pending.end(); ++it)
+        {
+            Transfer* transfer=*it;
+
+            curl_easy_setopt(transfer->fHandle, CURLOPT_PRIVATE, transfer);
+
+            CURLMcode res=curl_multi_add_handle(fMulti, transfer->fHandle);
+
+            if(res==CURLM_OK)
+                fRunning.push_back(transfer);
+            else
+                transfer->Complete(res==CURLM_OUT_OF_MEMORY ? CURLE_OUT_OF_MEMORY : CURLE_FAILED_INIT);
+        }
+
+        return true;
+    }
+
+
+    void HttpEngine::ReadCompletedTransfers()
+    {
+        int left=0;
+        CURLMsg* msg=NULL;
+
+        while((msg=curl_multi_info_read(fMulti, &left))!=NULL)
+        {
+            if(msg->msg!=CURLMSG_DONE)
+                continue;
+
+            CURL* handle=msg->easy_handle;
+            CURLcode result=msg->data.result;   //msg is not valid anymore once the handle is removed
+
+            Transfer* transfer=NULL;
+            curl_easy_getinfo(handle, CURLINFO_PRIVATE, (char**) &transfer);
+
+            curl_multi_remove_handle(fMulti, handle);
+
+            std::vector<Transfer*>::iterator it=std::find(fRunning.begin(), fRunning.end(), transfer);
+
+            if(it!=fRunning.end())
+            {
+                fRunning.erase(it);
+                transfer->Complete(result);
+            }
+        }
+    }
+
+
+    void HttpEngine::AbortTransfers()
+    {
+        for(std::vector<Transfer*>::iterator it=fRunning.begin(); it!=fRunning.end(); ++it)
+        {
+            curl_multi_remove_handle(fMulti, (*it)->fHandle);
+            (*it)->Complete(CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        fRunning.clear();
+
+        std::vector<Transfer*> pending;
+
+        {
+            XBOX::VTaskLock lock(&fMutex);
+            pending.swap(fPending);
+            fClosed=true;
+        }
+
+        for(std::vector<Transfer*>::iterator it=pending.begin(); it!=pending.end(); ++it)
+            (*it)->Complete(CURLE_ABORTED_BY_CALLBACK);
+    }
+
+
+    void HttpEngine::LockShare(CURL* inHandle, curl_lock_data inData, curl_lock_access inAccess, void* inUserPtr)
+    {
+        if(inData>=0 && inData<CURL_LOCK_DATA_LAST)
+            ((HttpEngine*) inUserPtr)->fShareMutexes[inData].Lock();
+    }
+
+
+    void HttpEngine::UnlockShare(CURL* inHandle, curl_lock_data inData, void* inUserPtr)
+    {
+        if(inData>=0 && inData<CURL_LOCK_DATA_LAST)
+            ((HttpEngine*) inUserPtr)->fShareMutexes[inData].Unlock();
+    }
+
+
+
     ////////////////////////////////////////////////////////////////////////////////
     //
     // HttpRequest
@@ -558,14 +918,14 @@ namespace CW
         fHasValidProxyCode(false),
         fProxyCode(0)
     {
-        fHandle=curl_easy_init();
+        fHandle=HttpEngine::Get()->AcquireHandle();
     }
 
 
     HttpRequest::~HttpRequest()
     {
         if(fHandle)
-            curl_easy_cleanup(fHandle);
+            HttpEngine::Get()->ReleaseHandle(fHandle);
     }
 
 	
@@ -694,7 +1054,7 @@ namespace CW
 
         SetOpts();
 
-        CURLcode res_perf=curl_easy_perform(fHandle);
+        CURLcode res_perf=HttpEngine::Get()->Perform(fHandle);
 
         if(res_perf!=CURLE_OK && outError)
             *outError=CurlCodeToVError(res_perf);
@@ -711,8 +1071,8 @@ namespace CW
         if(code!=0)
             fHasValidProxyCode=true, fProxyCode=code;
 
-        //Dans l'immediat, on n'a plus besoin des ressources utilisees par cURL
-        curl_easy_cleanup(fHandle);
+        //Dans l'immediat, on n'a plus besoin du handle ; il retourne dans le pool avec ses connexions
+        HttpEngine::Get()->ReleaseHandle(fHandle);
         fHandle=NULL;
 
         return res_perf==CURLE_OK && res_inf1==CURLE_OK && res_inf2==CURLE_OK;
@@ -786,6 +1146,13 @@ namespace CW
         curl_easy_setopt(fHandle, CURLOPT_HEADERFUNCTION, fRespHdrs.GetWriteFunction());
         curl_easy_setopt(fHandle, CURLOPT_HEADERDATA, fRespHdrs.GetWriteData());
 		curl_easy_setopt(fHandle, CURLOPT_TCP_NODELAY, 1L);
+#if LIBCURL_VERSION_NUM >= 0x071900
+		curl_easy_setopt(fHandle, CURLOPT_TCP_KEEPALIVE, 1L);
+#endif
+#if LIBCURL_VERSION_NUM >= 0x072b00
+		//Prefer waiting for a connection that can be multiplexed over opening a new one
+		curl_easy_setopt(fHandle, CURLOPT_PIPEWAIT, 1L);
+#endif
 		
 		//jmo - Meme comportement que la webview webkit sous Windows : Pas de verification des certificats !
 		curl_easy_setopt(fHandle, CURLOPT_SSL_VERIFYPEER, 0);
@@ -233,6 +233,66 @@ namespace CW
     };
 
 
+    ////////////////////////////////////////////////////////////////////////////////
+    //
+    // HttpEngine : Process wide transfer engine shared by all HttpRequest objects.
+    //
+    // - Easy handles are recycled (curl_easy_reset keeps their caches alive) instead
+    //   of being created and destroyed for each request.
+    // - A curl share handle makes DNS and SSL session caches common to all handles.
+    // - Transfers are driven by a single curl multi handle, run by a dedicated task,
+    //   which keeps a per host pool of keep-alive connections and multiplexes HTTP/2
+    //   streams. The calling task sleeps on an event until its transfer completes.
+    //
+    ////////////////////////////////////////////////////////////////////////////////
+
+    class HttpEngine
+    {
+    public :
+
+        static HttpEngine*  Get                     ();
+
+        CURL*               AcquireHandle           ();
+        void                ReleaseHandle           (CURL* inHandle);
+        CURLcode            Perform                 (CURL* inHandle);
+
+
+    private :
+
+        class Transfer;
+
+        HttpEngine();
+        ~HttpEngine();
+
+        bool                StartTask               ();
+        bool                IsTaskAlive             ();
+        void                Run                     (XBOX::VTask* inTask);
+        bool                AddPendingTransfers     (bool inWaitIfIdle);
+        void                ReadCompletedTransfers  ();
+        void                AbortTransfers          ();
+
+        static sLONG                RunProc         (XBOX::VTask* inTask);
+        static void     CW_CDECL    LockShare       (CURL* inHandle, curl_lock_data inData, curl_lock_access inAccess, void* inUserPtr);
+        static void     CW_CDECL    UnlockShare     (CURL* inHandle, curl_lock_data inData, void* inUserPtr);
+
+        static const size_t kMaxIdleHandles=16;
+        static const long   kMaxHostConnections=8;
+        static const long   kMaxConnections=64;
+        static const sLONG  kIdleWaitMs=1000;
+
+        CURLSH*                 fShare;
+        XBOX::VCriticalSection  fShareMutexes[CURL_LOCK_DATA_LAST];
+        CURLM*                  fMulti;
+        XBOX::VTask*            fTask;
+        XBOX::VSyncEvent*       fWakeUp;
+        XBOX::VCriticalSection  fMutex;         //Protects fIdleHandles, fPending, fTask and fClosed
+        std::vector<CURL*>      fIdleHandles;
+        std::vector<Transfer*>  fPending;
+        bool                    fClosed;        //Set once the engine task has aborted its transfers
+        std::vector<Transfer*>  fRunning;       //Only used by engine task
+    };
+
+
     class HttpRequest
     {
     public :
@@ -49,6 +49,19 @@ JS4D::StringRef JS4D::VStringToString( const VString& inString)
 }
 
 
+JS4D::StringRef JS4D::RetainString( StringRef inJSString)
+{
+	return (inJSString != NULL) ? JSStringRetain( inJSString) : NULL;
+}
+
+
+void JS4D::ReleaseString( StringRef inJSString)
+{
+	if (inJSString != NULL)
+		JSStringRelease( inJSString);
+}
+
+
 bool JS4D::StringToVString( StringRef inJSString, VString& outString)
 {
 	bool ok;
@@ -140,6 +140,10 @@ public:
 	
 	static	StringRef				VStringToString( const XBOX::VString& inString);
 	static	bool					StringToVString( StringRef inJSString, XBOX::VString& outString);
+
+	// JavaScriptCore strings are immutable and may be shared between contexts and threads.
+	static	StringRef				RetainString( StringRef inJSString);
+	static	void					ReleaseString( StringRef inJSString);
 	
 	// returns false if the string doesn't appear to be a valid positive or negative 32bits integer.
 	static	bool					StringToLong( StringRef inJSString, sLONG *outValue);
@@ -34,6 +34,19 @@ VJSBufferObject::VJSBufferObject (VSize inLength, void *inBuffer, bool inFromMem
 	fLength = inLength;
 	fBuffer = (uBYTE *) inBuffer;
 	fFromMemoryBuffer = inFromMemoryBuffer;
+	fFreeFunction = NULL;
+}
+
+VJSBufferObject::VJSBufferObject (VSize inLength, void *inBuffer, FreeFunction inFreeFunction)
+{
+	xbox_assert(inLength >= 0);
+	xbox_assert(!(inLength > 0 && inBuffer == NULL));
+
+	fParent = NULL;
+	fLength = inLength;
+	fBuffer = (uBYTE *) inBuffer;
+	fFromMemoryBuffer = false;
+	fFreeFunction = inFreeFunction;
 }
 
 VJSBufferObject::VJSBufferObject (VSize inLength)
@@ -44,6 +57,7 @@ VJSBufferObject::VJSBufferObject (VSize inLength)
 	fLength = inLength;
 	fBuffer = inLength ? (uBYTE *) malloc(inLength) : NULL;
 	fFromMemoryBuffer = false;
+	fFreeFunction = NULL;
 }
 
 CharSet VJSBufferObject::GetEncodingType (const XBOX::VString &inEncodingName)
@@ -88,13 +102,7 @@ void VJSBufferObject::ToString (CharSet inEncoding, sLONG inStart, sLONG inEnd,
 
 		case eENCODING_ASCII: {
 
-			sLONG	n;
-			uBYTE	*p;
-
-			for (n = inEnd - inStart, p = &fBuffer[inStart]; n != 0; n--, p++)
-
-				outString->AppendUniChar(*p & 0x7f);
-
+			_Widen(&fBuffer[inStart], inEnd - inStart, 0x7f, outString);
 			break;
 
 		}
@@ -113,7 +121,9 @@ void VJSBufferObject::ToString (CharSet inEncoding, sLONG inStart, sLONG inEnd,
 			bool ok = Base64Coder::Encode(&fBuffer[inStart], inEnd - inStart, resultBuffer);
 			if (ok)
 			{
-				outString->FromBlock( resultBuffer.GetDataPtr(), resultBuffer.GetDataSize(), VTC_UTF_8);
+				// Base64 output is pure ASCII, widen it directly instead of going through the UTF-8 decoder.
+
+				_Widen((const uBYTE *) resultBuffer.GetDataPtr(), (sLONG) resultBuffer.GetDataSize(), 0x7f, outString);
 			}
 			break;
 
@@ -121,28 +131,52 @@ void VJSBufferObject::ToString (CharSet inEncoding, sLONG inStart, sLONG inEnd,
 
 		case eENCODING_BINARY: {
 
+			_Widen(&fBuffer[inStart], inEnd - inStart, 0xff, outString);
+			break;
+
+		}
+
+		case eENCODING_HEX: {
+
 			sLONG	n;
 			uBYTE	*p;
+			UniChar	*q;
+
+			n = inEnd - inStart;
+			if (!n)
+
+				break;
+
+			if ((q = outString->GetCPointerForWrite(2 * n)) == NULL) {
+
+				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+				break;
+
+			}
 
-			for (n = inEnd - inStart, p = &fBuffer[inStart]; n != 0; n--, p++)
+			for (p = &fBuffer[inStart]; n != 0; n--, p++) {
 
-				outString->AppendUniChar(*p & 0xff);
+				*q++ = _ToHex(*p >> 4);
+				*q++ = _ToHex(*p & 0xf);
 
+			}
+
+			outString->Validate(2 * (inEnd - inStart));
 			break;
 
 		}
 
-		case eENCODING_HEX: {
+		case XBOX::VTC_UTF_8: {
 
-			sLONG	n;
-			uBYTE	*p;
+			// Most UTF-8 payloads (JSON, HTTP headers, etc.) are plain ASCII, in which case decoding is a simple widening.
 
-			for (n = inEnd - inStart, p = &fBuffer[inStart]; n != 0; n--, p++) {
+			if (_IsASCII(&fBuffer[inStart], inEnd - inStart))
 
-				outString->AppendUniChar(_ToHex((*p >> 4) & 0xf));
-				outString->AppendUniChar(_ToHex(*p & 0xf));
-				
-			}
+				_Widen(&fBuffer[inStart], inEnd - inStart, 0xff, outString);
+
+			else
+
+				outString->FromBlock(&fBuffer[inStart], inEnd - inStart, inEncoding);
 
 			break;
 
@@ -203,10 +237,14 @@ sLONG VJSBufferObject::FromString (const XBOX::VString &inString, CharSet inEnco
 			uBYTE	mask;
 			sLONG	i;
 
+			const UniChar	*p;
+
+			// Only the first size characters are encoded, the output buffer may be smaller than the string.
+
 			mask = inEncoding == eENCODING_ASCII ? 0x7f : 0xff;
-			for (i = 0; i < inString.GetLength(); i++) 
+			for (i = 0, p = inString.GetCPointer(); i < size; i++) 
 
-				encodedData[i] = inString.GetUniChar(i + 1) & mask;
+				encodedData[i] = (uBYTE) p[i] & mask;
 
 			r = size;
 
@@ -283,10 +321,6 @@ sLONG VJSBufferObject::FromString (const XBOX::VString &inString, CharSet inEnco
 
 				size = inMaximumLength;
 
-			if (size & 1)
-
-				size--;		// inMaximumLength can be an odd number.
-
 			if (!size) {
 
 				r = 0;
@@ -307,29 +341,23 @@ sLONG VJSBufferObject::FromString (const XBOX::VString &inString, CharSet inEnco
 
 			}
 	
-			uLONG			i;
+			sLONG			i;
 			const UniChar	*p;
 			uBYTE			*q;
 			
 			p = inString.GetCPointer();
 			q = encodedData;
-			for (i = 0; i < size; i++) {
+			for (i = 0; i < size; i++, p += 2) {
 
-				sLONG	c;
+				sLONG	high, low;
 
-				if ((c = _FromHex(*p++)) < 0)
+				// Left shifting the negative value of an invalid digit is undefined, test both digits first.
 
-					break;
-
-				*q = c << 4;
-
-				if ((c = _FromHex(*p++)) < 0)
+				if ((high = _FromHex(p[0])) < 0 || (low = _FromHex(p[1])) < 0)
 
 					break;
 
-				*q |= c;
-
-				q++;
+				*q++ = (uBYTE) ((high << 4) | low);
 
 			}
 
@@ -340,9 +368,9 @@ sLONG VJSBufferObject::FromString (const XBOX::VString &inString, CharSet inEnco
 
 			} else {
 
-				// An error occured.
+				// An error occured, free buffer only if allocated here.
 
-				if (outBuffer == NULL)
+				if (*outBuffer == NULL)
 
 					::free(encodedData);
 
@@ -354,7 +382,36 @@ sLONG VJSBufferObject::FromString (const XBOX::VString &inString, CharSet inEnco
 
 		default: {
 
-			if (*outBuffer != NULL) 
+			if (inEncoding == XBOX::VTC_UTF_8 && _IsASCII(inString.GetCPointer(), inString.GetLength())) {
+
+				// ASCII strings have the same UTF-8 representation, just narrow the characters.
+
+				sLONG			size;
+				const UniChar	*p;
+				uBYTE			*q;
+
+				size = inString.GetLength();
+				if (inMaximumLength >= 0 && inMaximumLength < size)
+
+					size = inMaximumLength;
+
+				if (!size)
+
+					r = 0;
+
+				else if (*outBuffer == NULL && (*outBuffer = (uBYTE *) ::malloc(size)) == NULL)
+
+					XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+				else {
+
+					for (p = inString.GetCPointer(), q = *outBuffer, r = size; size != 0; size--)
+
+						*q++ = (uBYTE) *p++;
+
+				}
+
+			} else if (*outBuffer != NULL) 
 
 				r = (sLONG) inString.ToBlock(*outBuffer, inMaximumLength, inEncoding, false, false);
 
@@ -397,6 +454,23 @@ VJSBufferObject::VJSBufferObject (VJSBufferObject *inParent, sLONG inStart, sLON
 	fLength = inEnd - inStart;
 	fBuffer = &inParent->fBuffer[inStart];
 	fFromMemoryBuffer = false;
+	fFreeFunction = NULL;
+}
+
+void VJSBufferObject::Transfer (VJSBufferObject *inDestination)
+{
+	xbox_assert(IsTransferable());
+	xbox_assert(inDestination != NULL && inDestination->fParent == NULL && inDestination->fBuffer == NULL);
+
+	inDestination->fLength = fLength;
+	inDestination->fBuffer = fBuffer;
+	inDestination->fFromMemoryBuffer = fFromMemoryBuffer;
+	inDestination->fFreeFunction = fFreeFunction;
+
+	fLength = 0;
+	fBuffer = NULL;
+	fFromMemoryBuffer = false;
+	fFreeFunction = NULL;
 }
 
 VJSBufferObject::~VJSBufferObject ()
@@ -411,6 +485,10 @@ VJSBufferObject::~VJSBufferObject ()
 
 			VMemory::DisposePtr((void *) fBuffer);
 
+		else if (fFreeFunction != NULL)
+
+			fFreeFunction((void *) fBuffer);
+
 		else
 
 			::free((void *) fBuffer);
@@ -420,40 +498,140 @@ VJSBufferObject::~VJSBufferObject ()
 	fBuffer	= NULL;
 }
 
+// Hexadecimal digits are table driven: one lookup per nibble instead of comparisons.
+
+static const char	sHexDigits[]	= "0123456789abcdef";
+
+static const sBYTE	sHexValues[128]	= {
+
+	-1, -1, -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	-1, -1, -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	-1, -1, -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	 0,  1,  2,  3,  4,  5,  6,  7,   8,  9, -1, -1, -1, -1, -1, -1, 
+	-1, 10, 11, 12, 13, 14, 15, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	-1, -1, -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	-1, 10, 11, 12, 13, 14, 15, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+	-1, -1, -1, -1, -1, -1, -1, -1,  -1, -1, -1, -1, -1, -1, -1, -1, 
+
+};
+
 UniChar VJSBufferObject::_ToHex (uBYTE inValue)
 {
 	xbox_assert(inValue >= 0 && inValue <= 0xf);
 
-	if (inValue < 10)
+	return sHexDigits[inValue];
+}
+
+sLONG VJSBufferObject::_FromHex (UniChar inUniChar)
+{
+	return inUniChar < 128 ? sHexValues[inUniChar] : -1;
+}
 
-		return '0' + inValue;
+bool VJSBufferObject::_IsASCII (const uBYTE *inData, sLONG inLength)
+{
+	xbox_assert(inData != NULL || !inLength);
 
-	else
+	// Test 8 bytes at a time, ::memcpy() is used to read unaligned words (optimized away by compilers).
+
+	const uBYTE	*p, *end;
+	uLONG8		word;
+
+	for (p = inData, end = inData + inLength; end - p >= 8; p += 8) {
+
+		::memcpy(&word, p, 8);
+		if (word & XBOX_LONG8(0x8080808080808080))
+
+			return false;
+
+	}
+	for ( ; p < end; p++)
+
+		if (*p & 0x80)
 
-		return 'a' + (inValue - 10);
+			return false;
+
+	return true;
 }
 
-sLONG VJSBufferObject::_FromHex (UniChar inUniChar)
+bool VJSBufferObject::_IsASCII (const UniChar *inString, sLONG inLength)
 {
-	if (inUniChar >= '0' && inUniChar <= '9') 
+	xbox_assert(inString != NULL || !inLength);
 
-		return inUniChar - '0';
+	const UniChar	*p, *end;
+	UniChar			bits;
 
-	else if (inUniChar >= 'a' && inUniChar <= 'f') 
+	// Or all characters together, non ASCII characters will set a bit above 0x7f.
 
-		return 10 + inUniChar - 'a';
+	for (p = inString, end = inString + inLength, bits = 0; p < end; p++)
 
-	else if (inUniChar >= 'A' && inUniChar <= 'F') 
+		bits |= *p;
 
-		return 10 + inUniChar - 'A';
+	return !(bits & 0xff80);
+}
 
-	else
+void VJSBufferObject::_Widen (const uBYTE *inData, sLONG inLength, uBYTE inMask, XBOX::VString *outString)
+{
+	xbox_assert(outString != NULL);
+
+	if (inLength <= 0)
+
+		return;
+
+	UniChar	*q;
+
+	if ((q = outString->GetCPointerForWrite(inLength)) == NULL) {
+
+		XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+		return;
+
+	}
+
+	const uBYTE	*p, *end;
+
+	for (p = inData, end = inData + inLength; p < end; p++)
+
+		*q++ = *p & inMask;
+
+	outString->Validate(inLength);
+}
+
+const uBYTE *VJSBufferObject::_Find (const uBYTE *inData, sLONG inLength, const uBYTE *inPattern, sLONG inPatternLength)
+{
+	xbox_assert(inData != NULL || !inLength);
+	xbox_assert(inPattern != NULL && inPatternLength > 0);
+
+	if (inPatternLength == 1)
+
+		return (const uBYTE *) ::memchr(inData, inPattern[0], inLength);
+
+	// Use ::memchr() to skip quickly to candidates for first byte, then check remaining with ::memcmp().
+
+	const uBYTE	*p, *last;
+
+	for (p = inData, last = inData + inLength - inPatternLength; p <= last; p++) {
+
+		if ((p = (const uBYTE *) ::memchr(p, inPattern[0], last - p + 1)) == NULL)
+
+			break;
+
+		if (!::memcmp(p + 1, inPattern + 1, inPatternLength - 1))
 
-		return -1;
+			return p;
+
+	}
+	return NULL;
 }
 
 void VJSBufferClass::GetDefinition (ClassDefinition &outDefinition)
 {
+	// "length" is read from the buffer object, as it becomes zero once memory has been transferred.
+
+	static inherited::StaticValue values[] =
+	{
+		{	"length",	js_getProperty<_GetLength>,	0,	JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontDelete	},
+		{	0,			0,							0,	0																	},
+	};
+
 	static inherited::StaticFunction functions[] =
 	{
 		{	"write",			js_callStaticFunction<_write>,			JS4D::PropertyAttributeDontDelete	},
@@ -464,6 +642,9 @@ void VJSBufferClass::GetDefinition (ClassDefinition &outDefinition)
 		{	"copy",				js_callStaticFunction<_copy>,			JS4D::PropertyAttributeDontDelete	},
 		{	"slice",			js_callStaticFunction<_slice>,			JS4D::PropertyAttributeDontDelete	},
 		{	"fill",				js_callStaticFunction<_fill>,			JS4D::PropertyAttributeDontDelete	},
+		{	"indexOf",			js_callStaticFunction<_indexOf>,		JS4D::PropertyAttributeDontDelete	},
+		{	"compare",			js_callStaticFunction<_compare>,		JS4D::PropertyAttributeDontDelete	},
+		{	"equals",			js_callStaticFunction<_equals>,			JS4D::PropertyAttributeDontDelete	},
 
 		{	"readUInt8",		js_callStaticFunction<_readUInt8>,		JS4D::PropertyAttributeDontDelete	},
 		{	"readInt8",			js_callStaticFunction<_readInt8>,		JS4D::PropertyAttributeDontDelete	},
@@ -511,6 +692,7 @@ void VJSBufferClass::GetDefinition (ClassDefinition &outDefinition)
 	};
 
     outDefinition.className			= "Buffer";
+	outDefinition.staticValues		= values;
 	outDefinition.staticFunctions	= functions;	
 	outDefinition.initialize		= js_initialize<_Initialize>;
 	outDefinition.finalize			= js_finalize<_Finalize>;
@@ -518,7 +700,7 @@ void VJSBufferClass::GetDefinition (ClassDefinition &outDefinition)
 	outDefinition.setProperty		= js_setProperty<_SetProperty>;
 }
 
-XBOX::VJSObject VJSBufferClass::NewInstance (XBOX::VJSContext inContext, VSize inLength, void *inBuffer)
+XBOX::VJSObject VJSBufferClass::NewInstance (XBOX::VJSContext inContext, VSize inLength, void *inBuffer, VJSBufferObject::FreeFunction inFreeFunction)
 {
 	xbox_assert(inLength >= 0);
 	xbox_assert(!(inLength > 0 && inBuffer == NULL));
@@ -526,7 +708,7 @@ XBOX::VJSObject VJSBufferClass::NewInstance (XBOX::VJSContext inContext, VSize i
 	XBOX::VJSObject	object(inContext);
 	VJSBufferObject	*buffer;
 	
-	if ((buffer = new VJSBufferObject(inLength, inBuffer)) == NULL) {
+	if ((buffer = new VJSBufferObject(inLength, inBuffer, inFreeFunction)) == NULL) {
 		
 		XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
 		object.SetNull();
@@ -537,6 +719,10 @@ XBOX::VJSObject VJSBufferClass::NewInstance (XBOX::VJSContext inContext, VSize i
 
 		object = VJSBufferClass::CreateInstance(inContext, buffer);
 
+		// Native memory isn't seen by the garbage collector, report it for idle collection scheduling.
+
+		inContext.GetGlobalObjectPrivateInstance()->ReportExtraMemory(inLength);
+
 	}
 
 	buffer->Release();
@@ -694,6 +880,7 @@ void VJSBufferClass::_Construct (XBOX::VJSParms_callAsConstructor &ioParms)
 	} else {
 
 		ioParms.ReturnConstructedObject(VJSBufferClass::CreateInstance(ioParms.GetContextRef(), buffer));
+		ioParms.GetContext().GetGlobalObjectPrivateInstance()->ReportExtraMemory(buffer->fLength);
 		buffer->Release();
 
 	}
@@ -704,7 +891,6 @@ void VJSBufferClass::_Initialize (const VJSParms_initialize &inParms, VJSBufferO
 	xbox_assert(inBuffer != NULL);
 
 	inBuffer->Retain();
-	inParms.GetObject().SetProperty("length", (sLONG) inBuffer->fLength, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontDelete );
 }
 
 void VJSBufferClass::_Finalize (const XBOX::VJSParms_finalize &inParms, VJSBufferObject *inBuffer)
@@ -737,6 +923,13 @@ void VJSBufferClass::_GetProperty (XBOX::VJSParms_getProperty &ioParms, VJSBuffe
 		ioParms.ForwardToParent();
 }
 
+void VJSBufferClass::_GetLength (XBOX::VJSParms_getProperty &ioParms, VJSBufferObject *inBuffer)
+{
+	xbox_assert(inBuffer != NULL);
+
+	ioParms.ReturnNumber<VSize>(inBuffer->fLength);
+}
+
 bool VJSBufferClass::_SetProperty (XBOX::VJSParms_setProperty &ioParms, VJSBufferObject *inBuffer)
 {
 	xbox_assert(inBuffer != NULL);
@@ -1371,6 +1564,172 @@ void VJSBufferClass::_fill (XBOX::VJSParms_callStaticFunction &ioParms, VJSBuffe
 	::memset(&inBuffer->fBuffer[offset], (uBYTE) value, length);
 }
 
+void VJSBufferClass::_indexOf (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer)
+{
+	xbox_assert(inBuffer != NULL);
+
+	sLONG	offset, length;
+
+	offset = 0;
+	length = (sLONG) inBuffer->fLength;
+	if (ioParms.CountParams() >= 2) {
+
+		if (!ioParms.IsNumberParam(2) || !ioParms.GetLongParam(2, &offset)) {
+
+			XBOX::vThrowError(XBOX::VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "2");
+			return;
+
+		} 
+
+		// A negative offset is relative to end of buffer.
+
+		if (offset < 0 && (offset += length) < 0)
+
+			offset = 0;
+
+	}
+
+	uBYTE			value, *pattern;
+	sLONG			patternLength;
+	bool			isAllocated;
+	const uBYTE		*p;
+
+	pattern = NULL;
+	isAllocated = false;
+	if (ioParms.IsNumberParam(1)) {
+
+		sLONG	number;
+
+		if (!ioParms.GetLongParam(1, &number)) {
+
+			XBOX::vThrowError(XBOX::VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "1");
+			return;
+
+		}
+		value = (uBYTE) number;
+		pattern = &value;
+		patternLength = 1;
+			
+	} else if (ioParms.IsStringParam(1)) {
+
+		XBOX::VString	string;
+		CharSet			encoding;
+
+		encoding = XBOX::VTC_UTF_8;
+		if (ioParms.CountParams() >= 3) {
+
+			XBOX::VString	encodingName;
+
+			if (!ioParms.IsStringParam(3) || !ioParms.GetStringParam(3, encodingName)) {
+
+				XBOX::vThrowError(XBOX::VE_JVSC_WRONG_PARAMETER_TYPE_STRING, "3");
+				return;
+
+			} else if ((encoding = VJSBufferObject::GetEncodingType(encodingName)) == XBOX::VTC_UNKNOWN) {
+
+				XBOX::vThrowError(XBOX::VE_JVSC_BUFFER_UNSUPPORTED_ENCODING, encodingName);
+				return;
+
+			}
+
+		}
+
+		ioParms.GetStringParam(1, string);
+		if ((patternLength = VJSBufferObject::FromString(string, encoding, &pattern)) < 0) {
+
+			XBOX::vThrowError(XBOX::VE_JVSC_BUFFER_ENCODING_FAILED);
+			return;
+
+		}
+		isAllocated = true;
+
+	} else {
+
+		VJSBufferObject	*buffer;
+
+		if ((buffer = _GetBufferParam(ioParms, 1)) == NULL)
+
+			return;
+
+		pattern = buffer->fBuffer;
+		patternLength = (sLONG) buffer->fLength;
+
+	}
+
+	// As String.indexOf(), an empty pattern is found at offset (clamped to length).
+
+	if (!patternLength) 
+
+		ioParms.ReturnNumber(offset < length ? offset : length);
+
+	else if (offset >= length
+	|| (p = VJSBufferObject::_Find(&inBuffer->fBuffer[offset], length - offset, pattern, patternLength)) == NULL)
+
+		ioParms.ReturnNumber(-1);
+
+	else
+
+		ioParms.ReturnNumber((sLONG) (p - inBuffer->fBuffer));
+
+	if (isAllocated && pattern != NULL)
+
+		::free(pattern);
+}
+
+void VJSBufferClass::_compare (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer)
+{
+	xbox_assert(inBuffer != NULL);
+
+	VJSBufferObject	*buffer;
+
+	if ((buffer = _GetBufferParam(ioParms, 1)) != NULL) {
+
+		VSize	length;
+		int		r;
+
+		length = inBuffer->fLength < buffer->fLength ? inBuffer->fLength : buffer->fLength;
+		if (!(r = length ? ::memcmp(inBuffer->fBuffer, buffer->fBuffer, length) : 0))
+
+			r = inBuffer->fLength == buffer->fLength ? 0 : (inBuffer->fLength < buffer->fLength ? -1 : 1);
+
+		ioParms.ReturnNumber(r < 0 ? -1 : (r > 0 ? 1 : 0));
+
+	}
+}
+
+void VJSBufferClass::_equals (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer)
+{
+	xbox_assert(inBuffer != NULL);
+
+	VJSBufferObject	*buffer;
+
+	if ((buffer = _GetBufferParam(ioParms, 1)) != NULL) 
+
+		ioParms.ReturnBool(inBuffer->fLength == buffer->fLength
+		&& (inBuffer->fBuffer == buffer->fBuffer || !::memcmp(inBuffer->fBuffer, buffer->fBuffer, inBuffer->fLength)));
+}
+
+VJSBufferObject *VJSBufferClass::_GetBufferParam (XBOX::VJSParms_callStaticFunction &ioParms, sLONG inIndex)
+{
+	XBOX::VJSObject	object(ioParms.GetContext());
+	VJSBufferObject	*buffer;
+	
+	if (!ioParms.GetParamObject(inIndex, object) || !object.IsInstanceOf("Buffer")) {
+
+		XBOX::VString	index;
+
+		index.FromLong(inIndex);
+		XBOX::vThrowError(XBOX::VE_JVSC_WRONG_PARAMETER_TYPE_BUFFER, index);
+		return NULL;
+
+	}
+
+	buffer = object.GetPrivateData<VJSBufferClass>();
+	xbox_assert(buffer != NULL);
+
+	return buffer;
+}
+
 void VJSBufferClass::_readUInt8 (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer)
 {
 	xbox_assert(inBuffer != NULL);
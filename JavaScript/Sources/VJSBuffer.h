@@ -36,6 +36,10 @@ public:
 
 	};
 
+	// Function used to free memory neither allocated by ::malloc() nor by VMemory (pooled memory for example).
+
+	typedef void	(*FreeFunction) (void *inBuffer);
+
 	// Create a buffer object with an already existing buffer.
 	// If inFromMemoryBufer is false, inBuffer must have been allocated using ::malloc() as it will be freed by destructor 
 	// using ::free(). If it is a data pointer "stolen" from a VMemoryBuffer<>, VMemory::DisposePtr() will be used instead.
@@ -43,6 +47,10 @@ public:
 
 					VJSBufferObject (VSize inLength, void *inBuffer, bool inFromMemoryBuffer = false);
 
+	// Create a buffer object owning memory to be freed by inFreeFunction, or by ::free() if NULL.
+
+					VJSBufferObject (VSize inLength, void *inBuffer, FreeFunction inFreeFunction);
+
 	// Create a buffer object. fBuffer must be checked (out of memory) after constructor called.
 
 					VJSBufferObject (VSize inLength);
@@ -50,6 +58,16 @@ public:
 	XBOX::VSize		GetDataSize () const	{	return fLength;	}
 	void			*GetDataPtr () const	{	return fBuffer; }
 
+	// Memory can be transferred (see structured clone) only if not shared: neither a slice nor referenced by anything 
+	// else than its JavaScript object (other slices, ArrayBuffer, etc.).
+
+	bool			IsTransferable () const	{	return fParent == NULL && GetRefCount() == 1;	}
+
+	// Move memory to an empty (zero length, unshared) buffer object, this one is "detached" and becomes zero length.
+	// Can't fail, so the destination can be allocated beforehand.
+
+	void			Transfer (VJSBufferObject *inDestination);
+
 	// If the encoding is unknown, then return XBOX::VTC_UNKNOWN.
 
 	static CharSet	GetEncodingType (const XBOX::VString &inEncoding);
@@ -75,6 +93,7 @@ friend class VJSBufferClass;
 	VSize			fLength;
 	uBYTE			*fBuffer;
 	bool			fFromMemoryBuffer;
+	FreeFunction	fFreeFunction;
 
 	// Create a reference to a parent buffer (used by slice() method only). 
 
@@ -84,6 +103,19 @@ friend class VJSBufferClass;
 
 	static UniChar	_ToHex (uBYTE inValue);
 	static sLONG	_FromHex (UniChar inUniChar);	// Return negative value if invalid.
+
+	// Return true if the data or string contains only 7-bit characters (UTF-8 and ASCII encodings are then identical).
+
+	static bool		_IsASCII (const uBYTE *inData, sLONG inLength);
+	static bool		_IsASCII (const UniChar *inString, sLONG inLength);
+
+	// Set a string from bytes, each byte (masked) being a character.
+
+	static void		_Widen (const uBYTE *inData, sLONG inLength, uBYTE inMask, XBOX::VString *outString);
+
+	// Return address of first occurence of pattern in data, NULL if not found. Pattern can't be empty.
+
+	static const uBYTE	*_Find (const uBYTE *inData, sLONG inLength, const uBYTE *inPattern, sLONG inPatternLength);
 };
 
 class XTOOLBOX_API VJSBufferClass : public XBOX::VJSClass<VJSBufferClass , VJSBufferObject>
@@ -92,9 +124,9 @@ public:
 
 	static void				GetDefinition (ClassDefinition &outDefinition);
 
-	// Create a Buffer object from binary data.
+	// Create a Buffer object from binary data, it will be freed using inFreeFunction (::free() if NULL).
 
-	static XBOX::VJSObject	NewInstance (XBOX::VJSContext inContext, VSize inLength, void *inBuffer);
+	static XBOX::VJSObject	NewInstance (XBOX::VJSContext inContext, VSize inLength, void *inBuffer, VJSBufferObject::FreeFunction inFreeFunction = NULL);
 
 	static XBOX::VJSObject	MakeConstructor (XBOX::VJSContext inContext);
 
@@ -108,6 +140,7 @@ private:
 	static void				_Finalize (const XBOX::VJSParms_finalize &inParms, VJSBufferObject *inBuffer);	
 
 	static void				_GetProperty (XBOX::VJSParms_getProperty &ioParms, VJSBufferObject *inBuffer);
+	static void				_GetLength (XBOX::VJSParms_getProperty &ioParms, VJSBufferObject *inBuffer);
 	static bool				_SetProperty (XBOX::VJSParms_setProperty &ioParms, VJSBufferObject *inBuffer);
 
 	static void				_IsBuffer (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *);
@@ -128,6 +161,15 @@ private:
 
 	static void				_fill (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer);
 
+	// indexOf() searches a byte value, a string (encoded using optional encoding), or a Buffer. compare() and equals() 
+	// do a byte-wise comparison (::memcmp()).
+
+	static void				_indexOf (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer);
+	static void				_compare (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer);
+	static void				_equals (XBOX::VJSParms_callStaticFunction &ioParms, VJSBufferObject *inBuffer);
+
+	static VJSBufferObject	*_GetBufferParam (XBOX::VJSParms_callStaticFunction &ioParms, sLONG inIndex);
+
 	// Read/write from/to the buffer.
 	//
 	// Implementation notes:
@@ -31,27 +31,11 @@
 #include "VJSGlobalClass.h"
 #include "VJSJSON.h"
 #include "VJSModule.h"
+#include "VJSScriptCache.h"
 
 USING_TOOLBOX_NAMESPACE
 
 
-
-static bool LoadScriptFile( VFile *inFile, VString& outScript)
-{
-	VFileStream stream( inFile);
-	VError err = stream.OpenReading();
-	if (err == VE_OK)
-	{
-		err = stream.GuessCharSetFromLeadingBytes( VTC_DefaultTextExport );		// sc 18/03/2011 instead of VTC_UTF_8
-		stream.SetCarriageReturnMode( eCRM_NATIVE );
-		if (err == VE_OK)
-			err = stream.GetText( outScript);
-	}
-	stream.CloseReading();
-	return err == VE_OK;
-}
-
-
 //======================================================
 
 VJSContext::VJSContext( const VJSGlobalContext *inGlobalContext)
@@ -86,13 +70,16 @@ VJSContext& VJSContext::operator=( const VJSContext& inOther)
 
 bool VJSContext::EvaluateScript( VFile *inFile, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject) const
 {
-	VString script;
-	bool ok = LoadScriptFile( inFile, script);
+	VTRACE_SCOPE( "js", "VJSContext::EvaluateScript(file)");
+
+	JS4D::StringRef jsScript = NULL;
+	bool ok = VJSScriptCache::GetScript( inFile->GetPath(), VJSScriptCache::eFORM_SCRIPT, NULL, &jsScript) == VE_OK;
 	
 	if (ok)
 	{
 		VURL url( inFile->GetPath());
-		ok = EvaluateScript( script, &url, outResult, outException, inThisObject);
+		ok = EvaluateScript( jsScript, &url, outResult, outException, inThisObject);
+		JS4D::ReleaseString( jsScript);
 	}
 
 	return ok;
@@ -101,6 +88,18 @@ bool VJSContext::EvaluateScript( VFile *inFile, VJSValue *outResult, JS4D::Excep
 
 bool VJSContext::EvaluateScript( const VString& inScript, const VURL *inSource, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject) const
 {
+	JSStringRef jsScript = JS4D::VStringToString( inScript);
+	bool ok = EvaluateScript( jsScript, inSource, outResult, outException, inThisObject);
+	JSStringRelease( jsScript);
+
+	return ok;
+}
+
+
+bool VJSContext::EvaluateScript( JS4D::StringRef inScript, const VURL *inSource, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject) const
+{
+	VTRACE_SCOPE( "js", "VJSContext::EvaluateScript");
+
 	VJSGlobalObject	*globalObject = GetGlobalObjectPrivateInstance();
 
 	// globalObject might be NULL when used on a WebView context.
@@ -118,10 +117,8 @@ bool VJSContext::EvaluateScript( const VString& inScript, const VURL *inSource,
 	}
 	
 	JSValueRef exception = NULL;
-    JSStringRef jsScript = JS4D::VStringToString( inScript);
 	int nStartingLineNumber = fDebuggerAllowed ? 0 : -1;
-	JSValueRef result = JS4DEvaluateScript( fContext, jsScript, inThisObject == NULL ? NULL : inThisObject->GetObjectRef()/*thisObject*/, jsUrl, nStartingLineNumber, &exception);
-    JSStringRelease( jsScript);
+	JSValueRef result = JS4DEvaluateScript( fContext, inScript, inThisObject == NULL ? NULL : inThisObject->GetObjectRef()/*thisObject*/, jsUrl, nStartingLineNumber, &exception);
 	
 	if (jsUrl != NULL)
 		JSStringRelease( jsUrl);
@@ -380,7 +377,7 @@ UniChar VJSGlobalContext::GetWildChar() const
 bool VJSGlobalContext::EvaluateScript( VFile *inFile, VValueSingle **outResult, bool inJSONresult ) const
 {
 	VString script;
-	bool ok = LoadScriptFile( inFile, script);
+	bool ok = VJSScriptCache::GetScript( inFile->GetPath(), VJSScriptCache::eFORM_SCRIPT, &script, NULL) == VE_OK;
 	if (ok)
 	{
 		VURL url( inFile->GetPath());
@@ -76,6 +76,7 @@ public:
 	
 			bool							EvaluateScript( VFile *inFile, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject = NULL) const;
 			bool							EvaluateScript( const VString& inScript, const VURL *inSource, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject = NULL) const;
+			bool							EvaluateScript( JS4D::StringRef inScript, const VURL *inSource, VJSValue *outResult, JS4D::ExceptionRef *outException, VJSObject* inThisObject = NULL) const;
 			
 			// Check syntax of the script. Return false if erroneous, in which case outException contains details. 
 
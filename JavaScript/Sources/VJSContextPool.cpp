@@ -0,0 +1,461 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VJavaScriptPrecompiled.h"
+
+#include "VJSContextPool.h"
+
+#include "VJSClass.h"
+#include "VJSGlobalClass.h"
+#include "VJSErrors.h"
+
+USING_TOOLBOX_NAMESPACE
+
+VJSContextPool::VJSContextPool (IJSContextPoolDelegate *inDelegate, sLONG inMinimumCount, sLONG inMaximumCount)
+{
+	xbox_assert(inDelegate != NULL);
+	xbox_assert(inMinimumCount >= 0 && inMaximumCount >= 1 && inMinimumCount <= inMaximumCount);
+
+	fDelegate = inDelegate;
+	fInUseCount = 0;
+	fMinimumCount = inMinimumCount;
+	fMaximumCount = inMaximumCount;
+	fIdleTimeout = DEFAULT_IDLE_TIMEOUT;
+	fLastTrimTime = _GetMilliseconds();
+	fGeneration = 0;
+
+	ResetStatistics();
+}
+
+VJSContextPool::~VJSContextPool ()
+{
+	xbox_assert(fInUseCount == 0);
+
+	Clear();
+}
+
+VError VJSContextPool::Prewarm ()
+{
+	VError	error	= VE_OK;
+
+	for ( ; ; ) {
+
+		{
+			StLocker<VCriticalSection>	lock(&fMutex);
+
+			if ((sLONG) fIdleContexts.size() + fInUseCount >= fMinimumCount)
+
+				break;
+
+			fInUseCount++;	// Reserve the slot while creating.
+
+		}
+
+		VJSGlobalContext	*context	= _CreateContext(error);
+
+		if (context == NULL) {
+
+			StLocker<VCriticalSection>	lock(&fMutex);
+
+			fInUseCount--;
+			fReleaseCondition.Broadcast();
+			break;
+
+		}
+
+		fMutex.Lock();
+		fInUseGenerations[context] = fGeneration;
+		fMutex.Unlock();
+
+		ReleaseContext(context);
+
+	}
+
+	return error;
+}
+
+VJSGlobalContext *VJSContextPool::RetainContext (VError& outError, sLONG inTimeoutMilliseconds)
+{
+	_TrimIfDue();
+
+	outError = VE_OK;
+
+	VJSGlobalContext	*context		= NULL;
+	bool				hasWaited		= false;
+	sLONG8				startCounter	= 0;
+	sLONG8				deadline		= 0;
+
+	fMutex.Lock();
+	fRetainCount++;
+
+	for ( ; ; ) {
+
+		if (!fIdleContexts.empty()) {
+
+			// Most recently released context is reused first, it is the most likely to still be in cpu caches.
+
+			context = fIdleContexts.back().fContext;
+			fIdleContexts.pop_back();
+			fInUseCount++;
+			fReuseCount++;
+			fInUseGenerations[context] = fGeneration;
+			break;
+
+		} 
+		
+		if (fInUseCount < fMaximumCount) {
+
+			// Grow, the context is created outside of the lock.
+
+			fInUseCount++;
+			break;
+
+		}
+		
+		sLONG	waitDuration;
+
+		if (!hasWaited) {
+
+			hasWaited = true;
+			fWaitCount++;
+			VSystem::GetProfilingCounter(startCounter);
+			if (inTimeoutMilliseconds >= 0)
+
+				deadline = _GetMilliseconds() + inTimeoutMilliseconds;
+
+		}
+
+		if (inTimeoutMilliseconds >= 0) {
+
+			sLONG8	remaining	= deadline - _GetMilliseconds();
+
+			if (remaining <= 0) {
+
+				fTimeoutCount++;
+				outError = VE_JVSC_CONTEXT_POOL_TIMEOUT;
+				break;
+
+			}
+			waitDuration = (sLONG) remaining;
+			fReleaseCondition.Wait(&fMutex, waitDuration);
+
+		} else
+
+			fReleaseCondition.Wait(&fMutex);
+
+	}
+
+	if (hasWaited) {
+
+		sLONG8	counter;
+
+		VSystem::GetProfilingCounter(counter);
+
+		sLONG8	waitMicroseconds	= ((counter - startCounter) * 1000000) / VSystem::GetProfilingFrequency();
+
+		fTotalWaitMicroseconds += waitMicroseconds;
+		if (waitMicroseconds > fMaxWaitMicroseconds)
+
+			fMaxWaitMicroseconds = waitMicroseconds;
+
+	}
+
+	fMutex.Unlock();
+
+	if (outError != VE_OK) 
+
+		vThrowError(outError);
+
+	else if (context == NULL) {
+
+		if ((context = _CreateContext(outError)) == NULL) {
+
+			StLocker<VCriticalSection>	lock(&fMutex);
+
+			fInUseCount--;
+			fReleaseCondition.Broadcast();
+
+		} else {
+
+			StLocker<VCriticalSection>	lock(&fMutex);
+
+			fInUseGenerations[context] = fGeneration;
+
+		}
+
+	}
+
+	return context;
+}
+
+VJSGlobalContext *VJSContextPool::TryRetainIdleContext ()
+{
+	StLocker<VCriticalSection>	lock(&fMutex);
+	VJSGlobalContext			*context;
+
+	if (fIdleContexts.empty())
+
+		return NULL;
+
+	context = fIdleContexts.back().fContext;
+	fIdleContexts.pop_back();
+	fInUseCount++;
+	fRetainCount++;
+	fReuseCount++;
+	fInUseGenerations[context] = fGeneration;
+
+	return context;
+}
+
+void VJSContextPool::ReleaseContext (VJSGlobalContext *inContext, bool inRecycle)
+{
+	if (inContext == NULL)
+
+		return;
+
+	// Scrub outside of the lock. A context which includes modified files has stale definitions.
+
+	VJSGlobalObject	*globalObject	= VJSContext(inContext).GetGlobalObjectPrivateInstance();
+
+	if (inRecycle && globalObject != NULL && globalObject->IsIncludedFilesHaveBeenChanged())
+
+		inRecycle = false;
+
+	if (inRecycle)
+
+		inRecycle = fDelegate->RecycleContext(inContext);
+
+	std::vector<VJSGlobalContext*>	contexts;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		std::map<VJSGlobalContext*, sLONG>::iterator	i	= fInUseGenerations.find(inContext);
+
+		xbox_assert(i != fInUseGenerations.end());
+		if (i != fInUseGenerations.end()) {
+
+			if (i->second != fGeneration)
+
+				inRecycle = false;
+
+			fInUseGenerations.erase(i);
+
+		}
+
+		fInUseCount--;
+
+		if (inRecycle && (sLONG) fIdleContexts.size() + fInUseCount < fMaximumCount) {
+
+			IdleContext	idleContext;
+
+			idleContext.fContext = inContext;
+			idleContext.fReleaseTime = _GetMilliseconds();
+			fIdleContexts.push_back(idleContext);
+
+		} else
+
+			contexts.push_back(inContext);
+
+		fReleaseCondition.Broadcast();
+	}
+
+	_DestroyContexts(contexts);
+	_TrimIfDue();
+}
+
+void VJSContextPool::SetLimits (sLONG inMinimumCount, sLONG inMaximumCount, sLONG inIdleTimeoutMilliseconds)
+{
+	xbox_assert(inMinimumCount >= 0 && inMaximumCount >= 1 && inMinimumCount <= inMaximumCount);
+
+	std::vector<VJSGlobalContext*>	contexts;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		fMinimumCount = inMinimumCount;
+		fMaximumCount = inMaximumCount;
+		fIdleTimeout = inIdleTimeoutMilliseconds;
+
+		// Oldest idle contexts go first if the pool is now above its maximum.
+
+		while (!fIdleContexts.empty() && (sLONG) fIdleContexts.size() + fInUseCount > fMaximumCount) {
+
+			contexts.push_back(fIdleContexts.front().fContext);
+			fIdleContexts.erase(fIdleContexts.begin());
+
+		}
+
+		// Maximum may have been raised.
+
+		fReleaseCondition.Broadcast();
+	}
+
+	_DestroyContexts(contexts);
+}
+
+sLONG VJSContextPool::Trim ()
+{
+	std::vector<VJSGlobalContext*>	contexts;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		fLastTrimTime = _GetMilliseconds();
+
+		sLONG8	limit	= fLastTrimTime - fIdleTimeout;
+
+		// Idle contexts are sorted by release time, oldest first.
+
+		while (!fIdleContexts.empty() 
+		&& (sLONG) fIdleContexts.size() + fInUseCount > fMinimumCount
+		&& fIdleContexts.front().fReleaseTime <= limit) {
+
+			contexts.push_back(fIdleContexts.front().fContext);
+			fIdleContexts.erase(fIdleContexts.begin());
+
+		}
+	}
+
+	_DestroyContexts(contexts);
+
+	return (sLONG) contexts.size();
+}
+
+void VJSContextPool::Clear ()
+{
+	std::vector<VJSGlobalContext*>	contexts;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		for (VectorOfIdleContext::iterator i = fIdleContexts.begin(); i != fIdleContexts.end(); ++i)
+
+			contexts.push_back(i->fContext);
+
+		fIdleContexts.clear();
+		fGeneration++;
+	}
+
+	_DestroyContexts(contexts);
+}
+
+void VJSContextPool::GetStatistics (Statistics& outStatistics) const
+{
+	StLocker<VCriticalSection>	lock(&fMutex);
+
+	outStatistics.fIdleCount = (sLONG) fIdleContexts.size();
+	outStatistics.fInUseCount = fInUseCount;
+	outStatistics.fMinimumCount = fMinimumCount;
+	outStatistics.fMaximumCount = fMaximumCount;
+	outStatistics.fRetainCount = fRetainCount;
+	outStatistics.fReuseCount = fReuseCount;
+	outStatistics.fCreationCount = fCreationCount;
+	outStatistics.fDestructionCount = fDestructionCount;
+	outStatistics.fWaitCount = fWaitCount;
+	outStatistics.fTimeoutCount = fTimeoutCount;
+	outStatistics.fTotalWaitMicroseconds = fTotalWaitMicroseconds;
+	outStatistics.fMaxWaitMicroseconds = fMaxWaitMicroseconds;
+}
+
+void VJSContextPool::GetStatistics (VValueBag& outBag) const
+{
+	Statistics	statistics;
+
+	GetStatistics(statistics);
+
+	outBag.SetLong("idle", statistics.fIdleCount);
+	outBag.SetLong("in_use", statistics.fInUseCount);
+	outBag.SetLong("minimum", statistics.fMinimumCount);
+	outBag.SetLong("maximum", statistics.fMaximumCount);
+	outBag.SetLong8("retains", statistics.fRetainCount);
+	outBag.SetLong8("reuses", statistics.fReuseCount);
+	outBag.SetLong8("creations", statistics.fCreationCount);
+	outBag.SetLong8("destructions", statistics.fDestructionCount);
+	outBag.SetLong8("waits", statistics.fWaitCount);
+	outBag.SetLong8("timeouts", statistics.fTimeoutCount);
+	outBag.SetLong8("total_wait", statistics.fTotalWaitMicroseconds);
+	outBag.SetLong8("max_wait", statistics.fMaxWaitMicroseconds);
+}
+
+void VJSContextPool::ResetStatistics ()
+{
+	StLocker<VCriticalSection>	lock(&fMutex);
+
+	fRetainCount = fReuseCount = fCreationCount = fDestructionCount = 0;
+	fWaitCount = fTimeoutCount = fTotalWaitMicroseconds = fMaxWaitMicroseconds = 0;
+}
+
+void VJSContextPool::_TrimIfDue ()
+{
+	bool	isDue;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		isDue = _GetMilliseconds() - fLastTrimTime >= fIdleTimeout / 4 && !fIdleContexts.empty();
+	}
+
+	if (isDue)
+
+		Trim();
+}
+
+VJSGlobalContext *VJSContextPool::_CreateContext (VError& outError)
+{
+	VTRACE_SCOPE("js", "VJSContextPool::_CreateContext");
+
+	outError = VE_OK;
+
+	VJSGlobalContext	*context	= fDelegate->CreateContext(outError);
+
+	if (context != NULL) {
+
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		fCreationCount++;
+
+	} else if (outError == VE_OK)
+
+		outError = VE_UNKNOWN_ERROR;
+
+	return context;
+}
+
+void VJSContextPool::_DestroyContexts (const std::vector<VJSGlobalContext*>& inContexts)
+{
+	if (inContexts.empty())
+
+		return;
+
+	{
+		StLocker<VCriticalSection>	lock(&fMutex);
+
+		fDestructionCount += inContexts.size();
+	}
+
+	for (std::vector<VJSGlobalContext*>::const_iterator i = inContexts.begin(); i != inContexts.end(); ++i)
+
+		(*i)->Release();
+}
+
+sLONG8 VJSContextPool::_GetMilliseconds ()
+{
+	VTime	time;
+
+	time.FromSystemTime();
+
+	return time.GetMilliseconds();
+}
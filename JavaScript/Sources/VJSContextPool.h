@@ -0,0 +1,158 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VJS_CONTEXT_POOL__
+#define __VJS_CONTEXT_POOL__
+
+#include "VJSContext.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VValueBag;
+
+// Creation and recycling policy of the contexts of a VJSContextPool.
+
+class XTOOLBOX_API IJSContextPoolDelegate
+{
+public:
+
+	// Create a fully initialized context (global classes, require() bootstrap, project specific setup).
+	// Called without the pool lock held, possibly from several tasks at once.
+
+	virtual	VJSGlobalContext	*CreateContext (VError& outError) = 0;
+
+	// Scrub per-request state of a context given back to the pool (specifics, session, ...).
+	// Return false to have the context destroyed instead of recycled.
+
+	virtual	bool				RecycleContext (VJSGlobalContext *inContext) = 0;
+};
+
+// Pool of ready to use global contexts. Creating a global context is expensive (global classes instantiation and evaluation 
+// of the require() bootstrap), so a minimum count of contexts is kept initialized. The pool grows on demand up to its 
+// maximum count, then requesters wait for a context to be released. Idle contexts above the minimum count are destroyed 
+// after the idle timeout, checked on retains and releases (at most every quarter of the timeout).
+//
+// VJSWorker serves the contexts of workers created with context reuse from the pool given to VJSWorker::SetContextPool().
+//
+// Contexts whose included files have been modified are never recycled.
+//
+// Thread safe.
+
+class XTOOLBOX_API VJSContextPool : public XBOX::VObject, public XBOX::IRefCountable
+{
+public:
+
+	typedef struct Statistics
+	{
+		sLONG		fIdleCount;				// contexts ready in the pool
+		sLONG		fInUseCount;			// contexts retained or being created
+		sLONG		fMinimumCount;
+		sLONG		fMaximumCount;
+		sLONG8		fRetainCount;
+		sLONG8		fReuseCount;			// retains served by an idle context
+		sLONG8		fCreationCount;
+		sLONG8		fDestructionCount;
+		sLONG8		fWaitCount;				// retains that had to wait for a release
+		sLONG8		fTimeoutCount;
+		sLONG8		fTotalWaitMicroseconds;
+		sLONG8		fMaxWaitMicroseconds;
+	} Statistics;
+
+	enum {
+
+		DEFAULT_IDLE_TIMEOUT	= 5 * 60 * 1000		// milliseconds
+
+	};
+
+	// The caller is responsible for the destruction of the delegate, which must outlive the pool.
+
+								VJSContextPool (IJSContextPoolDelegate *inDelegate, sLONG inMinimumCount, sLONG inMaximumCount);
+
+	// Create contexts until the minimum count is reached.
+
+	VError						Prewarm ();
+
+	// Retain a context, waiting at most inTimeoutMilliseconds (-1 for no limit) if the maximum count has been reached.
+	// Return NULL with VE_JVSC_CONTEXT_POOL_TIMEOUT on timeout. The context must be given back with ReleaseContext().
+
+	VJSGlobalContext			*RetainContext (VError& outError, sLONG inTimeoutMilliseconds = -1);
+
+	// Retain an idle context, return NULL if there is none. Neither creates a context nor waits (hence can be called 
+	// with locks held), a failed attempt isn't counted in the statistics.
+
+	VJSGlobalContext			*TryRetainIdleContext ();
+	void						ReleaseContext (VJSGlobalContext *inContext, bool inRecycle = true);
+
+	void						SetLimits (sLONG inMinimumCount, sLONG inMaximumCount, sLONG inIdleTimeoutMilliseconds = DEFAULT_IDLE_TIMEOUT);
+
+	// Destroy idle contexts above the minimum count that have not been used for the idle timeout.
+	// Return the number of destroyed contexts. Done automatically by RetainContext() and ReleaseContext(), 
+	// an owner may also call it periodically so that a pool which isn't used anymore shrinks.
+
+	sLONG						Trim ();
+
+	// Destroy all idle contexts, for example when the project is reloaded.
+	// Contexts in use are destroyed when released.
+
+	void						Clear ();
+
+	void						GetStatistics (Statistics& outStatistics) const;
+	void						GetStatistics (VValueBag& outBag) const;
+	void						ResetStatistics ();
+
+private:
+
+	typedef struct IdleContext
+	{
+		VJSGlobalContext	*fContext;
+		sLONG8				fReleaseTime;	// milliseconds
+	} IdleContext;
+
+	typedef std::vector<IdleContext>	VectorOfIdleContext;
+
+	virtual						~VJSContextPool ();
+
+	VJSGlobalContext			*_CreateContext (VError& outError);
+	void						_TrimIfDue ();
+	void						_DestroyContexts (const std::vector<VJSGlobalContext*>& inContexts);
+
+	static	sLONG8				_GetMilliseconds ();
+
+	IJSContextPoolDelegate		*fDelegate;
+
+	mutable	VCriticalSection	fMutex;
+	VConditionVariable			fReleaseCondition;
+	VectorOfIdleContext			fIdleContexts;		// most recently released last
+	sLONG						fInUseCount;
+	sLONG						fMinimumCount;
+	sLONG						fMaximumCount;
+	sLONG						fIdleTimeout;
+	sLONG8						fLastTrimTime;		// milliseconds
+	sLONG						fGeneration;		// incremented by Clear(), contexts retained before are not recycled
+	std::map<VJSGlobalContext*, sLONG>	fInUseGenerations;
+
+	sLONG8						fRetainCount;
+	sLONG8						fReuseCount;
+	sLONG8						fCreationCount;
+	sLONG8						fDestructionCount;
+	sLONG8						fWaitCount;
+	sLONG8						fTimeoutCount;
+	sLONG8						fTotalWaitMicroseconds;
+	sLONG8						fMaxWaitMicroseconds;
+};
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -140,6 +140,10 @@ const XBOX::VError	VE_JVSC_BINARY_STREAM_SOCKET			= MAKE_VERROR(kJAVASCRIPT_SIGN
 const XBOX::VError	VE_JVSC_UNABLE_TO_RETRIEVE_URL			= MAKE_VERROR(kJAVASCRIPT_SIGNATURE, 4500);
 const XBOX::VError	VE_JVSC_MODULE_INTERNAL_ERROR			= MAKE_VERROR(kJAVASCRIPT_SIGNATURE, 4501);
 
+// VJSContextPool, no context has been released before timeout.
+
+const XBOX::VError	VE_JVSC_CONTEXT_POOL_TIMEOUT			= MAKE_VERROR(kJAVASCRIPT_SIGNATURE, 4600);
+
 
 // Extension message
 const XBOX::VError	VE_JVSC_EXTENSION_ARG_MISSING			= MAKE_VERROR(kJAVASCRIPT_SIGNATURE, 5121);
@@ -34,21 +34,415 @@
 
 USING_TOOLBOX_NAMESPACE
 
-bool IJSEvent::InsertEvent (std::list<IJSEvent *> *ioEventQueue, IJSEvent *inEvent)
+IJSEvent::IJSEvent ()
 {
-	std::list<IJSEvent *>::iterator	i;
-	bool							isFirstPosition;
-		
-	for (i = ioEventQueue->begin(); i != ioEventQueue->end(); i++)
-		
-		if (inEvent->fTriggerTime <= (*i)->fTriggerTime)
-			
+	fPreviousEvent = fNextEvent = NULL;
+	fQueueSlot = VJSEventQueue::kNotQueued;
+	fTriggerTick = 0;
+	fSequence = 0;
+}
+
+VJSEventQueue::VJSEventQueue ()
+{
+	XBOX::VTime	currentTime;
+
+	currentTime.FromSystemTime();
+
+	fCount = fTimerCount = 0;
+	for (sLONG i = 0; i < kLevels; i++) 
+
+		fLevelCounts[i] = 0;
+
+	fNextTick = currentTime.GetMilliseconds();
+	fNextSequence = 0;
+	_Clear(&fReady);
+	for (sLONG i = 0; i < kLevels; i++)
+
+		for (sLONG j = 0; j < kSlotsPerLevel; j++)
+
+			_Clear(&fWheel[i][j]);
+}
+
+VJSEventQueue::~VJSEventQueue ()
+{
+	xbox_assert(IsEmpty());
+}
+
+void VJSEventQueue::Insert (IJSEvent *inEvent)
+{
+	xbox_assert(inEvent != NULL && !IsQueued(inEvent));
+
+	XBOX::VTime	currentTime;
+	sLONG8		currentTick;
+
+	// Expire timers first, so a ready event doesn't overtake older ones.
+
+	currentTime.FromSystemTime();
+	currentTick = currentTime.GetMilliseconds();
+	_Advance(currentTick);
+
+	inEvent->fTriggerTick = inEvent->fTriggerTime.GetMilliseconds();
+	inEvent->fSequence = fNextSequence++;
+	if (inEvent->fTriggerTick < fNextTick) {
+
+		inEvent->fQueueSlot = kReadySlot;
+		_Append(&fReady, inEvent);
+
+	} else {
+
+		_InsertTimer(inEvent);
+		fTimerCount++;
+
+	}
+	fCount++;
+}
+
+bool VJSEventQueue::Remove (IJSEvent *inEvent)
+{
+	xbox_assert(inEvent != NULL);
+
+	if (!IsQueued(inEvent))
+
+		return false;
+
+	if (inEvent->fQueueSlot != kReadySlot) {
+
+		fLevelCounts[inEvent->fQueueSlot >> kBitsPerLevel]--;
+		fTimerCount--;
+
+	}
+	_Unlink(_GetList(inEvent->fQueueSlot), inEvent);
+	inEvent->fQueueSlot = kNotQueued;
+	fCount--;
+
+	return true;
+}
+
+IJSEvent *VJSEventQueue::PopReadyEvent (const XBOX::VTime &inCurrentTime)
+{
+	_Advance(inCurrentTime.GetMilliseconds());
+	
+	IJSEvent	*event;
+
+	if ((event = fReady.fFirst) != NULL) {
+
+		_Unlink(&fReady, event);
+		event->fQueueSlot = kNotQueued;
+		fCount--;
+
+	}
+	return event;
+}
+
+bool VJSEventQueue::GetNextTriggerTime (XBOX::VTime *outTime) const
+{
+	xbox_assert(outTime != NULL);
+
+	sLONG8	tick;
+
+	if (IsEmpty()) 
+
+		return false;
+
+	else if (fReady.fFirst != NULL) 
+
+		tick = fNextTick - 1;	// Already due.
+
+	else {
+
+		// Level zero slots have exact trigger times. For upper levels, events can only get due after
+		// the cascade of their slot, so return the time of the first cascade of a non-empty slot.
+
+		tick = -1;
+		if (fLevelCounts[0]) 
+
+			for (sLONG8 i = 0; i < kSlotsPerLevel; i++) 
+
+				if (fWheel[0][(fNextTick + i) & kSlotMask].fFirst != NULL) {
+
+					tick = fNextTick + i;
+					break;
+
+				}
+
+		for (sLONG level = 1; level < kLevels; level++) {
+
+			if (!fLevelCounts[level]) 
+
+				continue;
+
+			sLONG8	period	= ((sLONG8) 1) << (kBitsPerLevel * level);
+			sLONG8	first	= ((fNextTick + period - 1) / period) * period;
+
+			for (sLONG8 i = 0; i < kSlotsPerLevel; i++) {
+
+				sLONG8	cascadeTick	= first + i * period;
+
+				if (tick >= 0 && cascadeTick >= tick)
+
+					break;
+
+				if (fWheel[level][(cascadeTick >> (kBitsPerLevel * level)) & kSlotMask].fFirst != NULL) {
+
+					tick = cascadeTick;
+					break;
+
+				}
+
+			}
+
+		}
+		xbox_assert(tick >= 0);
+
+	}
+	outTime->FromMilliseconds(tick);
+
+	return true;
+}
+
+void VJSEventQueue::RemoveAll (std::vector<IJSEvent *> *outEvents)
+{
+	xbox_assert(outEvents != NULL);
+
+	IJSEvent	*event;
+
+	// Ready events first, then timers (due or not).
+
+	outEvents->clear();
+	while ((event = fReady.fFirst) != NULL) {
+
+		Remove(event);
+		outEvents->push_back(event);
+
+	}
+	GetEvents(outEvents);
+	for (std::vector<IJSEvent *>::iterator i = outEvents->begin(); i != outEvents->end(); i++)
+
+		Remove(*i);
+
+	xbox_assert(IsEmpty());
+}
+
+void VJSEventQueue::GetEvents (std::vector<IJSEvent *> *outEvents) const
+{
+	xbox_assert(outEvents != NULL);
+
+	IJSEvent	*event;
+
+	for (event = fReady.fFirst; event != NULL; event = event->fNextEvent)
+
+		outEvents->push_back(event);
+
+	for (sLONG i = 0; i < kLevels; i++) {
+
+		if (!fLevelCounts[i])
+
+			continue;
+
+		for (sLONG j = 0; j < kSlotsPerLevel; j++)
+
+			for (event = fWheel[i][j].fFirst; event != NULL; event = event->fNextEvent)
+
+				outEvents->push_back(event);
+
+	}
+}
+
+void VJSEventQueue::_Advance (sLONG8 inCurrentTick)
+{
+	while (fNextTick <= inCurrentTick) {
+
+		if (!fTimerCount) {
+
+			fNextTick = inCurrentTick + 1;
 			break;
 
-	isFirstPosition = i == ioEventQueue->begin();
-	ioEventQueue->insert(i, inEvent);
+		}
+
+		sLONG	index	= (sLONG) (fNextTick & kSlotMask);
 
-	return isFirstPosition;
+		if (index) {
+
+			// Skip ticks with nothing to expire or cascade.
+
+			if (!fLevelCounts[0]) {
+
+				sLONG8	nextBoundary	= (fNextTick | kSlotMask) + 1;
+
+				fNextTick = nextBoundary > inCurrentTick ? inCurrentTick + 1 : nextBoundary;
+				continue;
+
+			}
+
+		} else {
+
+			// Cascade upper levels, down to first level whose index isn't zero.
+
+			for (sLONG level = 1; level < kLevels; level++) {
+
+				sLONG	slot	= (sLONG) ((fNextTick >> (kBitsPerLevel * level)) & kSlotMask);
+
+				_Cascade(level, slot);
+				if (slot)
+
+					break;
+
+			}
+
+		}
+
+		// All events in this slot are due.
+
+		SList		*list	= &fWheel[0][index];
+		IJSEvent	*event;
+
+		while ((event = list->fFirst) != NULL) {
+
+			_Unlink(list, event);
+			fLevelCounts[0]--;
+			fTimerCount--;
+			event->fQueueSlot = kReadySlot;
+			_Append(&fReady, event);
+
+		}
+		fNextTick++;
+
+	}
+}
+
+void VJSEventQueue::_Cascade (sLONG inLevel, sLONG inSlot)
+{
+	SList		*list	= &fWheel[inLevel][inSlot];
+	IJSEvent	*event;
+	
+	if (list->fFirst == NULL)
+
+		return;
+
+	// Detach list first, re-inserted events may go back to the same slot.
+
+	event = list->fFirst;
+	_Clear(list);
+	while (event != NULL) {
+
+		IJSEvent	*next	= event->fNextEvent;
+
+		fLevelCounts[inLevel]--;
+		_InsertTimer(event);
+		event = next;
+
+	}
+}
+
+void VJSEventQueue::_InsertTimer (IJSEvent *inEvent)
+{
+	xbox_assert(inEvent->fTriggerTick >= fNextTick);
+
+	sLONG8	delta	= inEvent->fTriggerTick - fNextTick;
+	sLONG8	tick	= inEvent->fTriggerTick;
+	sLONG	level;
+
+	for (level = 0; level < kLevels - 1; level++)
+
+		if (delta < (((sLONG8) 1) << (kBitsPerLevel * (level + 1))))
+
+			break;
+
+	if (delta >= (((sLONG8) 1) << (kBitsPerLevel * kLevels))) 
+
+		tick = fNextTick + (((sLONG8) 1) << (kBitsPerLevel * kLevels)) - 1;	// Will be re-cascaded.
+
+	sLONG	slot	= (sLONG) ((tick >> (kBitsPerLevel * level)) & kSlotMask);
+
+	inEvent->fQueueSlot = (level << kBitsPerLevel) | slot;
+	fLevelCounts[level]++;
+
+	// A cascaded timer may land in a slot holding timers inserted after it (directly, as they were closer
+	// to their trigger time), so keep slots sorted by insertion order. Usually just an append.
+
+	_InsertInSequence(&fWheel[level][slot], inEvent);
+}
+
+void VJSEventQueue::_Append (SList *ioList, IJSEvent *inEvent)
+{
+	inEvent->fNextEvent = NULL;
+	inEvent->fPreviousEvent = ioList->fLast;
+	if (ioList->fLast != NULL)
+
+		ioList->fLast->fNextEvent = inEvent;
+
+	else
+
+		ioList->fFirst = inEvent;
+
+	ioList->fLast = inEvent;
+}
+
+void VJSEventQueue::_InsertInSequence (SList *ioList, IJSEvent *inEvent)
+{
+	IJSEvent	*previous;
+
+	for (previous = ioList->fLast; previous != NULL && previous->fSequence > inEvent->fSequence; previous = previous->fPreviousEvent)
+
+		;
+
+	if (previous == ioList->fLast) {
+
+		_Append(ioList, inEvent);
+		return;
+
+	}
+
+	inEvent->fPreviousEvent = previous;
+	if (previous != NULL) {
+
+		inEvent->fNextEvent = previous->fNextEvent;
+		previous->fNextEvent = inEvent;
+
+	} else {
+
+		inEvent->fNextEvent = ioList->fFirst;
+		ioList->fFirst = inEvent;
+
+	}
+	inEvent->fNextEvent->fPreviousEvent = inEvent;
+}
+
+void VJSEventQueue::_Unlink (SList *ioList, IJSEvent *inEvent)
+{
+	if (inEvent->fPreviousEvent != NULL)
+
+		inEvent->fPreviousEvent->fNextEvent = inEvent->fNextEvent;
+
+	else
+
+		ioList->fFirst = inEvent->fNextEvent;
+
+	if (inEvent->fNextEvent != NULL)
+
+		inEvent->fNextEvent->fPreviousEvent = inEvent->fPreviousEvent;
+
+	else
+
+		ioList->fLast = inEvent->fPreviousEvent;
+
+	inEvent->fPreviousEvent = inEvent->fNextEvent = NULL;
+}
+
+void VJSEventQueue::_Clear (SList *ioList)
+{
+	ioList->fFirst = ioList->fLast = NULL;
+}
+
+VJSEventQueue::SList *VJSEventQueue::_GetList (sLONG inSlot)
+{
+	if (inSlot == kReadySlot)
+
+		return &fReady;
+
+	else
+
+		return &fWheel[inSlot >> kBitsPerLevel][inSlot & kSlotMask];
 }
 
 VJSMessageEvent *VJSMessageEvent::Create (VJSMessagePort *inMessagePort, VJSStructuredClone *inMessage)
@@ -99,16 +493,20 @@ void VJSMessageEvent::Discard ()
 	Release();
 }
 
-void VJSMessageEvent::RemoveMessageFrom (std::list<IJSEvent *> *ioEventQueue, VJSMessagePort *inMessagePort)
+void VJSMessageEvent::RemoveMessageFrom (VJSEventQueue *ioEventQueue, VJSMessagePort *inMessagePort)
 {
-	std::list<IJSEvent *>::iterator	i;
+	xbox_assert(ioEventQueue != NULL);
 
-	for (i = ioEventQueue->begin(); i != ioEventQueue->end(); i++)
+	std::vector<IJSEvent *>				events;
+	std::vector<IJSEvent *>::iterator	i;
+
+	ioEventQueue->GetEvents(&events);
+	for (i = events.begin(); i != events.end(); i++)
 
 		if ((*i)->GetType() == eTYPE_MESSAGE && ((VJSMessageEvent *) (*i))->fMessagePort == inMessagePort) {
 
+			ioEventQueue->Remove(*i);
 			(*i)->Discard();
-			ioEventQueue->erase(i);
 	
 		}
 }
@@ -259,6 +657,8 @@ VJSTimerEvent *VJSTimerEvent::Create (VJSTimer *inTimer, XBOX::VTime &inTriggerT
 	timerEvent->fTimer = inTimer;
 	timerEvent->fArguments = inArguments;
 
+	inTimer->fTimerEvent = timerEvent;
+
 	return timerEvent;
 }
 
@@ -297,24 +697,22 @@ void VJSTimerEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 
 void VJSTimerEvent::Discard ()
 {
+	fTimer->fTimerEvent = NULL;
 	fTimer->_ReleaseIfCleared();
 	Release();
 }
 
-void VJSTimerEvent::RemoveTimerEvent (std::list<IJSEvent *> *ioEventQueue, VJSTimer *inTimer)
+void VJSTimerEvent::RemoveTimerEvent (VJSEventQueue *ioEventQueue, VJSTimer *inTimer)
 {
-	std::list<IJSEvent *>::iterator	i;
+	xbox_assert(ioEventQueue != NULL && inTimer != NULL);
 
-	for (i = ioEventQueue->begin(); i != ioEventQueue->end(); i++)
+	// If the event is being processed, it isn't queued and its Discard() will be called after processing.
 
-		if ((*i)->GetType() == eTYPE_TIMER 
-		&& ((VJSTimerEvent *) (*i))->fTimer == inTimer) {
+	VJSTimerEvent	*timerEvent	= inTimer->fTimerEvent;
 
-			(*i)->Discard();
-			ioEventQueue->erase(i);
-			break;
+	if (timerEvent != NULL && ioEventQueue->Remove(timerEvent)) 
 
-		}
+		timerEvent->Discard();
 }
 
 VJSSystemWorkerEvent *VJSSystemWorkerEvent::Create (VJSSystemWorker *inSystemWorker, sLONG inType, XBOX::JS4D::ObjectRef inObjectRef, uBYTE *inData, sLONG inSize)
@@ -499,11 +897,9 @@ VJSNetEvent *VJSNetEvent::Create (VJSEventEmitter *inEventEmitter, const XBOX::V
 	return netEvent;
 }
 
-VJSNetEvent *VJSNetEvent::CreateData (VJSNetSocketObject *inSocketObject, uBYTE *inData, sLONG inSize)
+VJSNetEvent *VJSNetEvent::CreateData (VJSNetSocketObject *inSocketObject)
 {
 	xbox_assert(inSocketObject != NULL);
-	xbox_assert(inSize >= 0);
-	xbox_assert(!(inSize > 0 && inData == NULL));
 	
 	VJSNetEvent	*netEvent;
 
@@ -513,8 +909,10 @@ VJSNetEvent *VJSNetEvent::CreateData (VJSNetSocketObject *inSocketObject, uBYTE
 
 	netEvent->fSubType = eTYPE_DATA;
 	netEvent->fEventEmitter = XBOX::RetainRefCountable<VJSNetSocketObject>(inSocketObject);
-	netEvent->fData = inData;
-	netEvent->fSize = inSize;
+	netEvent->fData = NULL;
+	netEvent->fSize = 0;
+	netEvent->fFreeFunction = NULL;
+	netEvent->fHasTakenData = false;
 	
 	return netEvent;
 }
@@ -594,6 +992,15 @@ void VJSNetEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 
 	if (fSubType == eTYPE_DATA) {
 
+		// Take all data read since event has been queued. There is none if socket has been paused.
+
+		fHasTakenData = true;
+		isOk = ((VJSNetSocketObject *) fEventEmitter)->_TakeBufferedData(&fData, &fSize, &fFreeFunction);
+
+	}
+
+	if (fSubType == eTYPE_DATA && isOk) {
+
 		// If encoding is XBOX::VTC_UNKNOWN (default when Socket object is constructed), then data is 
 		// considered as binary and no string conversion takes place, returning a Buffer object.
 
@@ -601,7 +1008,7 @@ void VJSNetEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 
 		if ((encoding = ((VJSNetSocketObject *) fEventEmitter)->GetEncoding()) == XBOX::VTC_UNKNOWN) {
 
-			callbackArguments.push_back(VJSBufferClass::NewInstance(inContext, fSize, fData));
+			callbackArguments.push_back(VJSBufferClass::NewInstance(inContext, fSize, fData, fFreeFunction));
 	
 			// This will prevent Discard() from freeing memory.
 
@@ -612,7 +1019,7 @@ void VJSNetEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 			VJSBufferObject	*buffer;
 			VJSValue		value(inContext);
 						
-			if ((buffer = new VJSBufferObject(fSize, fData)) == NULL) {
+			if ((buffer = new VJSBufferObject(fSize, fData, fFreeFunction)) == NULL) {
 
 				value.SetString("");			
 				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
@@ -677,11 +1084,23 @@ void VJSNetEvent::Process (XBOX::VJSContext inContext, VJSWorker *inWorker)
 
 void VJSNetEvent::Discard ()
 {
-	if (fSubType == eTYPE_DATA && fData != NULL)
+	if (fSubType == eTYPE_DATA) {
+
+		if (fData != NULL) {
 
-		::free(fData);
+			if (fFreeFunction != NULL)
 
-	else if (fSubType == eTYPE_CONNECTION || fSubType == eTYPE_CONNECTION_SSL) {
+				fFreeFunction(fData);
+
+			else
+
+				::free(fData);
+
+		} else if (!fHasTakenData)
+
+			((VJSNetSocketObject *) fEventEmitter)->_DataEventDiscarded();
+
+	} else if (fSubType == eTYPE_CONNECTION || fSubType == eTYPE_CONNECTION_SSL) {
 
 		xbox_assert(fEndPoint != NULL);
 
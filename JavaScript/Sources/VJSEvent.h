@@ -18,6 +18,7 @@
 
 #include "VJSClass.h"
 #include "VJSValue.h"
+#include "VJSBuffer.h"
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -34,6 +35,7 @@ class VJSLocalFileSystem;
 class VJSEntry;
 class VJSDirectoryReader;
 class VJSSystemWorker;
+class VJSEventQueue;
 
 // Worker event interface.
 
@@ -76,17 +78,111 @@ public:
 
 	virtual void	Discard () = 0;
 
-	// Insert an event in an event queue, return true if it's been inserted at first position.
-	
-	static bool		InsertEvent (std::list<IJSEvent *> *ioEventQueue, IJSEvent *inEvent);
-
 protected:
 
 	uLONG			fType;
 	XBOX::VTime		fTriggerTime;
 
-					IJSEvent ()	{}
+					IJSEvent ();
 	virtual			~IJSEvent()	{}
+
+private:
+
+friend class VJSEventQueue;
+
+	// Intrusive links, only used by VJSEventQueue.
+
+	IJSEvent		*fPreviousEvent;
+	IJSEvent		*fNextEvent;
+	sLONG			fQueueSlot;		// Timing wheel slot, or one of VJSEventQueue's special values.
+	sLONG8			fTriggerTick;	// fTriggerTime in milliseconds.
+	sLONG8			fSequence;		// Insertion order, keeps timers with same trigger time in FIFO order.
+};
+
+// Event queue of a worker.
+//
+// Events to be triggered later (timers) are kept in a hierarchical timing wheel with a one millisecond resolution,
+// while events that are already due (messages, net data, expired timers, etc.) are kept in a FIFO "ready" queue.
+// Insertion and removal are O(1), events are dequeued in trigger time order (events with same trigger time are 
+// dequeued in insertion order). The queue isn't thread-safe, the worker's mutex must be held.
+
+class XTOOLBOX_API VJSEventQueue : public XBOX::VObject
+{
+public:
+
+						VJSEventQueue ();
+	virtual				~VJSEventQueue ();
+
+	bool				IsEmpty () const		{	return fCount == 0;	}
+	sLONG				GetCount () const		{	return fCount;		}
+
+	// Queue an event according to its trigger time. Event must not be already queued.
+
+	void				Insert (IJSEvent *inEvent);
+
+	// Remove an event from the queue, return false if it wasn't queued.
+
+	bool				Remove (IJSEvent *inEvent);
+
+	bool				IsQueued (const IJSEvent *inEvent) const	{	return inEvent->fQueueSlot != kNotQueued;	}
+
+	// Dequeue first event due at inCurrentTime, return NULL if none.
+
+	IJSEvent			*PopReadyEvent (const XBOX::VTime &inCurrentTime);
+
+	// Return the time at which the next event may be due. It is exact or slightly early (a wheel cascade is due), 
+	// never late. Return false if the queue is empty.
+
+	bool				GetNextTriggerTime (XBOX::VTime *outTime) const;
+
+	// Remove all events and return them, ready ones first (in queue order).
+
+	void				RemoveAll (std::vector<IJSEvent *> *outEvents);
+
+	// Return all events (still queued), in no particular order.
+
+	void				GetEvents (std::vector<IJSEvent *> *outEvents) const;
+
+private:
+
+friend class IJSEvent;
+
+	enum {
+
+		kNotQueued		= -1,
+		kReadySlot		= -2,
+
+		kBitsPerLevel	= 6,
+		kSlotsPerLevel	= 1 << kBitsPerLevel,
+		kSlotMask		= kSlotsPerLevel - 1,
+		kLevels			= 5,		// 2^30 milliseconds (more than 12 days), longer timers are re-cascaded.
+
+	};
+
+	struct SList {
+
+		IJSEvent	*fFirst;
+		IJSEvent	*fLast;
+
+	};
+
+	sLONG				fCount;
+	sLONG				fTimerCount;
+	sLONG				fLevelCounts[kLevels];
+	sLONG8				fNextTick;									// Next tick to be processed by the wheel.
+	sLONG8				fNextSequence;
+	SList				fReady;
+	SList				fWheel[kLevels][kSlotsPerLevel];
+
+	void				_Advance (sLONG8 inCurrentTick);
+	void				_Cascade (sLONG inLevel, sLONG inSlot);
+	void				_InsertTimer (IJSEvent *inEvent);
+
+	static void			_Append (SList *ioList, IJSEvent *inEvent);
+	static void			_InsertInSequence (SList *ioList, IJSEvent *inEvent);
+	static void			_Unlink (SList *ioList, IJSEvent *inEvent);
+	static void			_Clear (SList *ioList);
+	SList				*_GetList (sLONG inSlot);
 };
 
 // Interface to an event generator.
@@ -125,7 +221,7 @@ public:
 
 	// Remove all messages using given message port.
 
-	static void				RemoveMessageFrom (std::list<IJSEvent *> *ioEventQueue, VJSMessagePort *inMessagePort);
+	static void				RemoveMessageFrom (VJSEventQueue *ioEventQueue, VJSMessagePort *inMessagePort);
 	
 private:
 
@@ -201,7 +297,7 @@ public:
 
 	// Remove a timer event from an event queue.
 
-	static void					RemoveTimerEvent (std::list<IJSEvent *> *ioEventQueue, VJSTimer *inTimer);
+	static void					RemoveTimerEvent (VJSEventQueue *ioEventQueue, VJSTimer *inTimer);
 
 private:
 
@@ -262,9 +358,10 @@ public:
 
 	static VJSNetEvent	*Create (VJSEventEmitter *inEventEmitter, const XBOX::VString &inEventName);
 
-	// If event is discarded, inData memory will be freed by VJSNetEvent code. Otherwise, it is to be freed by the Buffer object.
+	// Data is taken from the socket object when the event is processed (see VJSNetSocketObject::_TakeBufferedData()). 
+	// It is then to be freed by the Buffer object.
 	
-	static VJSNetEvent	*CreateData (VJSNetSocketObject *inSocketObject, uBYTE *inData, sLONG inSize);
+	static VJSNetEvent	*CreateData (VJSNetSocketObject *inSocketObject);
 
 	static VJSNetEvent	*CreateError (VJSEventEmitter *inEventEmitter, const XBOX::VString &inExceptionName);
 	
@@ -298,6 +395,8 @@ private:
 
 	uBYTE						*fData;				// eTYPE_DATA only.
 	sLONG						fSize;				
+	VJSBufferObject::FreeFunction	fFreeFunction;
+	bool						fHasTakenData;
 
 	XBOX::VString				fExceptionName;		// eTYPE_ERROR only.
 
@@ -125,7 +125,11 @@ VJSGlobalObject::VJSGlobalObject( JS4D::GlobalContextRef inContext, VJSContextGr
 , fLastGarbageCollection( 0)
 , fContextUseTaskID( NULL_TASK_ID)
 , fContextUseCount( 0)
+, fExtraMemorySinceCollection( 0)
+, fEventsSinceCollection( 0)
+, fLastCollectionTime( VSystem::GetCurrentTime())
 {
+	::memset( &fStatistics, 0, sizeof( fStatistics));
 }
 
 
@@ -254,13 +258,19 @@ bool VJSGlobalObject::TryToUseContext ()
 }
 
 void VJSGlobalObject::GarbageCollect()
+{
+	_GarbageCollect( false);
+}
+
+
+void VJSGlobalObject::_GarbageCollect( bool inIsIdle)
 {
 	fUseMutex.Lock();
 	if (fContextUseTaskID == NULL_TASK_ID)
 	{
 		// no one is using the context.
 		// one must keep the use mutex until the end of garbage collection.
-		JSGarbageCollect( fContext);
+		_Collect( inIsIdle);
 		fLastGarbageCollection = fGarbageCollectionPending;
 		fUseMutex.Unlock();
 	}
@@ -271,7 +281,7 @@ void VJSGlobalObject::GarbageCollect()
 		// release the mutex early so that the cache manager can call us without latency.
 		fUseMutex.Unlock();
 		fLastGarbageCollection = fGarbageCollectionPending;
-		JSGarbageCollect( fContext);
+		_Collect( inIsIdle);
 	}
 	else
 	{
@@ -289,10 +299,58 @@ void VJSGlobalObject::GarbageCollectIfNecessary()
 	if (fLastGarbageCollection != fGarbageCollectionPending)
 	{
 		fLastGarbageCollection = fGarbageCollectionPending;
-		JSGarbageCollect( fContext);
+		_Collect( false);
 	}
 }
 
+
+bool VJSGlobalObject::IsIdleGarbageCollectionNeeded( sLONG inIdleDuration) const
+{
+	if (fEventsSinceCollection == 0)
+		return false;	// nothing ran since last collection, there can't be much garbage.
+
+	if (inIdleDuration >= 0 && inIdleDuration < kIdleCollectionMinimumIdle)
+		return false;	// a collection would delay the next event.
+
+	return fExtraMemorySinceCollection >= kIdleCollectionHeapGrowth
+		|| VSystem::GetCurrentTime() - fLastCollectionTime >= kIdleCollectionInterval;
+}
+
+
+void VJSGlobalObject::GetGarbageCollectionStatistics( SGarbageCollectionStatistics *outStatistics)
+{
+	xbox_assert( outStatistics != NULL);
+
+	VTaskLock lock( &fStatisticsMutex);
+
+	*outStatistics = fStatistics;
+}
+
+
+void VJSGlobalObject::_Collect( bool inIsIdle)
+{
+	uLONG	startTime = VSystem::GetCurrentTime();
+
+	JSGarbageCollect( fContext);
+
+	uLONG	endTime = VSystem::GetCurrentTime();
+	sLONG	pause = (sLONG) (endTime - startTime);
+
+	fExtraMemorySinceCollection = 0;
+	fEventsSinceCollection = 0;
+	fLastCollectionTime = endTime;
+
+	VTaskLock lock( &fStatisticsMutex);
+
+	fStatistics.fCount++;
+	if (inIsIdle)
+		fStatistics.fIdleCount++;
+	fStatistics.fTotalPause += pause;
+	fStatistics.fLastPause = pause;
+	if (pause > fStatistics.fMaximumPause)
+		fStatistics.fMaximumPause = pause;
+}
+
 XBOX::VJSObject VJSGlobalObject::RequireNative (const XBOX::VJSContext &inContext, const XBOX::VString &inClassName)
 {
 	XBOX::VJSObject	object(inContext);
@@ -332,12 +390,13 @@ void VJSGlobalClass::Initialize( const VJSParms_initialize& inParms, VJSGlobalOb
 
 	// VJSGlobalClass::CreateGlobalClasses() is not called before by Wakanda Studio.
 
-	// Add Buffer, SystemWorker, Folder, File, and TextStream object constructors.
+	// Add Buffer, SharedArrayBuffer, SystemWorker, Folder, File, and TextStream object constructors.
 
 	XBOX::VJSContext	context(inParms.GetContext());
 	XBOX::VJSObject		globalObject(inParms.GetObject());
 
 	globalObject.SetProperty("Buffer", VJSBufferClass::MakeConstructor(context), JS4D::PropertyAttributeDontDelete | JS4D::PropertyAttributeReadOnly); 
+	globalObject.SetProperty("SharedArrayBuffer", VJSSharedArrayBuffer::MakeConstructor(context), JS4D::PropertyAttributeDontDelete | JS4D::PropertyAttributeReadOnly); 
 	globalObject.SetProperty("SystemWorker", VJSSystemWorkerClass::MakeConstructor(context), JS4D::PropertyAttributeDontDelete | JS4D::PropertyAttributeReadOnly); 
 	globalObject.SetProperty("Folder", VJSFolderIterator::MakeConstructor(context), JS4D::PropertyAttributeDontDelete | JS4D::PropertyAttributeReadOnly); 
 	globalObject.SetProperty("File", VJSFileIterator::MakeConstructor(context), JS4D::PropertyAttributeDontDelete | JS4D::PropertyAttributeReadOnly); 
@@ -450,6 +509,7 @@ void VJSGlobalClass::_CheckInitStaticFunctions()
 		_PushBackStaticFunction( "JSONToXml", js_callStaticFunction<do_JSONToXml>, JS4D::PropertyAttributeNone); // string : JSONToXml( string : JSON text, "simpleJson" "fullJson");
 		_PushBackStaticFunction( "loadImage", js_callStaticFunction<do_loadImage>, JS4D::PropertyAttributeNone); // Picture : LoadImage(File)
 		_PushBackStaticFunction( "garbageCollect", js_callStaticFunction<do_garbageCollect>, JS4D::PropertyAttributeNone); 
+		_PushBackStaticFunction( "getGarbageCollectionStatistics", js_callStaticFunction<do_getGarbageCollectionStatistics>, JS4D::PropertyAttributeNone); // object : getGarbageCollectionStatistics()
 		_PushBackStaticFunction( "isoToDate", js_callStaticFunction<do_isoToDate>, JS4D::PropertyAttributeNone); 
 		_PushBackStaticFunction( "dateToIso", js_callStaticFunction<do_dateToIso>, JS4D::PropertyAttributeNone); 
 		_PushBackStaticFunction( "Mutex", js_callStaticFunction<do_AtomicSection>, JS4D::PropertyAttributeNone); 
@@ -858,6 +918,24 @@ void VJSGlobalClass::do_garbageCollect(VJSParms_callStaticFunction& ioParms, VJS
 }
 
 
+void VJSGlobalClass::do_getGarbageCollectionStatistics(VJSParms_callStaticFunction& ioParms, VJSGlobalObject* inGlobalObject)
+{
+	VJSGlobalObject::SGarbageCollectionStatistics	statistics;
+	VJSObject										result(ioParms.GetContext());
+
+	inGlobalObject->GetGarbageCollectionStatistics( &statistics);
+
+	result.MakeEmpty();
+	result.SetProperty( "count", statistics.fCount);
+	result.SetProperty( "idleCount", statistics.fIdleCount);
+	result.SetProperty( "totalPause", (Real) statistics.fTotalPause);
+	result.SetProperty( "maximumPause", statistics.fMaximumPause);
+	result.SetProperty( "lastPause", statistics.fLastPause);
+	result.SetProperty( "heapGrowth", (Real) inGlobalObject->GetHeapGrowth());
+	ioParms.ReturnValue( result);
+}
+
+
 void VJSGlobalClass::do_isoToDate(VJSParms_callStaticFunction& ioParms, VJSGlobalObject*)
 {
 	VTime dd;
@@ -126,6 +126,34 @@ public:
 											// Not thread safe! Must be called from the thread using the context like any other method of this class except GarbageCollect().
 			void							GarbageCollectIfNecessary();
 
+											// Idle garbage collection scheduling, used by the worker event loop before it blocks with no pending event.
+											// inIdleDuration is the expected idle time in milliseconds (negative if unlimited).
+											// A collection is wanted if some events have been processed since the last one and either the heap has grown enough,
+											// or it hasn't been done for a long time. Not thread safe, like GarbageCollectIfNecessary().
+			bool							IsIdleGarbageCollectionNeeded( sLONG inIdleDuration) const;
+			void							IdleGarbageCollect()			{ _GarbageCollect( true);}
+
+											// Heap growth tracking. The JavaScriptCore API doesn't expose the heap size, so growth is estimated from the native
+											// memory (Buffer data, etc.) reported as allocated by scripts since the last collection. Not thread safe.
+			void							ReportExtraMemory( VSize inSize)	{ fExtraMemorySinceCollection += inSize;}
+			VSize							GetHeapGrowth() const			{ return fExtraMemorySinceCollection;}
+
+											// Count events processed by the worker event loop since the last collection. Not thread safe.
+			void							NoteEventProcessed()			{ ++fEventsSinceCollection;}
+
+											// Garbage collection pause statistics, in milliseconds. Thread safe.
+			typedef struct {
+
+				sLONG						fCount;				// All collections, including explicit and deferred ones.
+				sLONG						fIdleCount;			// Collections triggered by idle scheduling.
+				sLONG8						fTotalPause;
+				sLONG						fMaximumPause;
+				sLONG						fLastPause;
+
+			} SGarbageCollectionStatistics;
+
+			void							GetGarbageCollectionStatistics( SGarbageCollectionStatistics *outStatistics);
+
 											// the context is being marked as 'in use' by VJSGlobalContext::EvaluateScript.
 											// this is to track the use of a context by a thread and synchronize the calls to GarbageCollect.
 			void							UseContext();
@@ -151,6 +179,15 @@ private:
 
 			void							AskDeferredGarbageCollection()	{ XBOX::VInterlocked::Increment( &fGarbageCollectionPending);}
 
+			void							_GarbageCollect( bool inIsIdle);
+
+											// Actually collect and record pause statistics, context must be usable by current thread.
+			void							_Collect( bool inIsIdle);
+
+	static	const VSize						kIdleCollectionHeapGrowth	= 8 * 1024 * 1024;	// Collect when idle if that much native memory has been allocated,
+	static	const uLONG						kIdleCollectionInterval		= 60 * 1000;		// or if last collection is older than that (milliseconds).
+	static	const sLONG						kIdleCollectionMinimumIdle	= 100;				// Don't collect if next event is due sooner (milliseconds).
+
 	typedef	unordered_map_VString<VRefPtr<VFile> >				MapOfIncludedFile;
 	typedef	std::vector< std::pair< VRefPtr<VFile>, VTime> >	VectorOfFileModificationTime;
 
@@ -166,6 +203,12 @@ private:
 			VTaskID							fContextUseTaskID;		// task id of the task that marked the context in use
 			sLONG							fGarbageCollectionPending;	// incremented each time a deferred garbage collection is being asked
 			sLONG							fLastGarbageCollection;	// the deferred garbage collection stamp read during last garbage collect
+
+			VSize							fExtraMemorySinceCollection;	// native memory reported since last collection
+			sLONG							fEventsSinceCollection;			// events processed by the worker since last collection
+			uLONG							fLastCollectionTime;			// VSystem::GetCurrentTime() of last collection
+			VCriticalSection				fStatisticsMutex;
+			SGarbageCollectionStatistics	fStatistics;
 		
 			class CCompare {
 
@@ -230,6 +273,7 @@ public:
 	static	void	do_loadImage(VJSParms_callStaticFunction& ioParms, VJSGlobalObject*);
 
 	static	void	do_garbageCollect(VJSParms_callStaticFunction& ioParms, VJSGlobalObject*);
+	static	void	do_getGarbageCollectionStatistics(VJSParms_callStaticFunction& ioParms, VJSGlobalObject* inGlobalObject);
 	static	void	do_isoToDate(VJSParms_callStaticFunction& ioParms, VJSGlobalObject*);
 	static	void	do_dateToIso(VJSParms_callStaticFunction& ioParms, VJSGlobalObject*);
 	
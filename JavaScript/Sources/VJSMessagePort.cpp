@@ -210,8 +210,28 @@ void VJSMessagePort::PostMessageMethod (XBOX::VJSParms_callStaticFunction &ioPar
 
 	}
 
+	// Optional second argument is an array of Buffer or ArrayBuffer objects to transfer instead of copying.
+
+	std::vector<XBOX::VJSValue>	transferList;
+
+	if (ioParms.CountParams() >= 2 && !ioParms.IsNullParam(2) && !ioParms.GetParamValue(2).IsUndefined()) {
+
+		XBOX::VJSArray	array(ioParms.GetContext());
+
+		if (!ioParms.GetParamArray(2, array)) {
+
+			XBOX::vThrowError(XBOX::VE_JVSC_WRONG_PARAMETER_TYPE_ARRAY, "2");
+			return;
+
+		}
+		for (size_t i = 0; i < array.GetLength(); i++)
+
+			transferList.push_back(array.GetValueAt(i));
+
+	}
+
 	XBOX::VJSValue		value		= ioParms.GetParamValue(1);
-	VJSStructuredClone	*message	= VJSStructuredClone::RetainClone(value);
+	VJSStructuredClone	*message	= VJSStructuredClone::RetainClone(value, &transferList);
 
 	if (message != NULL) {
 
@@ -91,8 +91,8 @@ public:
 										const XBOX::VString &inFileName, 
 										sLONG inLineNumber);
 
-	// Implementation of the postMessage() method (web worker proxies, message port objects, or global for 
-	// dedicated workers).
+	// Implementation of the postMessage(message [, transferList]) method (web worker proxies, message port objects, 
+	// or global for dedicated workers). Buffer and ArrayBuffer objects of transferList are moved, not copied.
 	
 	static void				PostMessageMethod (XBOX::VJSParms_callStaticFunction &ioParms, VJSMessagePort *inMessagePort);
 
@@ -27,6 +27,7 @@
 
 #include "VJSContext.h"
 #include "VJSGlobalClass.h"
+#include "VJSScriptCache.h"
 
 USING_TOOLBOX_NAMESPACE
 
@@ -141,29 +142,22 @@ VJSModuleState *VJSModuleState::CreateModuleState (const XBOX::VJSContext &inCon
 	return moduleState;
 }
 
-XBOX::VError VJSModuleState::LoadScript (const XBOX::VString &inFullPath, XBOX::VURL *outURL, XBOX::VString *outScript)
+XBOX::VError VJSModuleState::LoadScript (const XBOX::VString &inFullPath, XBOX::VURL *outURL, XBOX::VString *outScript, XBOX::JS4D::StringRef *outModuleFunction)
 {
-	xbox_assert(outURL != NULL && outScript != NULL);
+	xbox_assert(outURL != NULL && (outScript != NULL || outModuleFunction != NULL));
 
 	outURL->FromFilePath(inFullPath, eURL_POSIX_STYLE, CVSTR("file://"));
-	outScript->Clear();
+	if (outScript != NULL)
+		outScript->Clear();
+	if (outModuleFunction != NULL)
+		*outModuleFunction = NULL;
 
 	XBOX::VError	error;
 	XBOX::VFilePath	path;
 					
 	if (outURL->GetFilePath(path) && path.IsFile()) {
 
-		XBOX::VFile			file(path);			
-		XBOX::VFileStream	stream(&file);
-						
-		if ((error = stream.OpenReading()) == XBOX::VE_OK
-		&& (error = stream.GuessCharSetFromLeadingBytes(XBOX::VTC_DefaultTextExport)) == XBOX::VE_OK) {
-
-			stream.SetCarriageReturnMode(XBOX::eCRM_NATIVE);
-			error = stream.GetText(*outScript);
-
-		}
-		stream.CloseReading();	// Ignore closing error, if any.
+		error = XBOX::VJSScriptCache::GetScript(path, XBOX::VJSScriptCache::eFORM_MODULE_FUNCTION, outScript, outModuleFunction);
 
 		if (error == XBOX::VE_STREAM_EOF)
 
@@ -422,11 +416,11 @@ void VJSRequireClass::_evaluate (VJSParms_callStaticFunction &ioParms, VJSModule
 
 	}
 
-	XBOX::VError	error;
-	XBOX::VURL		url;
-	XBOX::VString	script;
+	XBOX::VError			error;
+	XBOX::VURL				url;
+	XBOX::JS4D::StringRef	functionScript;
 		
-	if ((error = VJSModuleState::LoadScript(fullPath, &url, &script)) != XBOX::VE_OK) {
+	if ((error = VJSModuleState::LoadScript(fullPath, &url, NULL, &functionScript)) != XBOX::VE_OK) {
 
 		if (error == XBOX::VE_JVSC_SCRIPT_NOT_FOUND) {
 
@@ -451,15 +445,14 @@ void VJSRequireClass::_evaluate (VJSParms_callStaticFunction &ioParms, VJSModule
 
 			context.GetGlobalObjectPrivateInstance()->RegisterIncludedFile(file);
 
-			XBOX::VString				functionScript;
 			XBOX::VJSValue				functionResult(context);
 			XBOX::JS4D::ExceptionRef	exception;			
 
-			// Make a function of the module script, then call it.
+			// Make a function of the module script (already wrapped by the script cache), then call it.
 			
-			functionScript.AppendString("(function (exports, module) {");
-			functionScript.AppendString(script);
-			functionScript.AppendString("})");
+			if (functionScript == NULL)
+
+				functionScript = XBOX::JS4D::VStringToString(CVSTR("(function (exports, module) {})"));	// Empty module file.
 
 			if (!context.EvaluateScript(functionScript, &url, &functionResult, &exception)) {
 						
@@ -493,6 +486,7 @@ void VJSRequireClass::_evaluate (VJSParms_callStaticFunction &ioParms, VJSModule
 		}
 
 	}	
+	XBOX::JS4D::ReleaseString(functionScript);
 }
 
 // Actually returns the directory of the currently executing script.
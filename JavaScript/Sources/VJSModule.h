@@ -41,9 +41,10 @@ public:
 
 	XBOX::JS4D::ObjectRef			GetRequireFunctionRef ()	{	return fRequireFunctionRef;	}
 
-	// Load a script file, inFullPath must be a POSIX path.
+	// Load a script file, inFullPath must be a POSIX path. If not NULL, outModuleFunction is set to the script wrapped as a
+	// "(function (exports, module) {...})" expression (NULL for an empty file), it must be released using JS4D::ReleaseString().
 
-	static XBOX::VError				LoadScript (const XBOX::VString &inFullPath, XBOX::VURL *outURL, XBOX::VString *outScript);
+	static XBOX::VError				LoadScript (const XBOX::VString &inFullPath, XBOX::VURL *outURL, XBOX::VString *outScript, XBOX::JS4D::StringRef *outModuleFunction = NULL);
 
 private:
 
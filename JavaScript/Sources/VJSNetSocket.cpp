@@ -32,6 +32,114 @@ USING_TOOLBOX_NAMESPACE
 XBOX::VCriticalSection	VJSNetSocketObject::sMutex;
 XBOX::VTCPSelectIOPool	*VJSNetSocketObject::sSelectIOPool	= NULL;
 
+XBOX::VCriticalSection						VJSNetBufferPool::sMutex;
+std::vector<VJSNetBufferPool::SHeader *>	VJSNetBufferPool::sFreeBlocks[VJSNetBufferPool::kSizeClassCount];
+VSize										VJSNetBufferPool::sPooledSize	= 0;
+sLONG										VJSNetBufferPool::sIsClosed		= 0;
+VJSNetBufferPool::SCloser					VJSNetBufferPool::sCloser;		// Must be defined last.
+
+uBYTE *VJSNetBufferPool::Allocate (uLONG inSize)
+{
+	xbox_assert(inSize <= kMaximumSize);
+
+	uLONG	sizeClass, size;
+
+	for (sizeClass = 0, size = kMinimumSize; size < inSize && sizeClass < kSizeClassCount - 1; sizeClass++)
+
+		size <<= 1;
+
+	SHeader	*header	= NULL;
+
+	if (!XBOX::VInterlocked::AtomicGet(&sIsClosed)) {
+
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
+
+		if (!sFreeBlocks[sizeClass].empty()) {
+
+			header = sFreeBlocks[sizeClass].back();
+			sFreeBlocks[sizeClass].pop_back();
+			sPooledSize -= size;
+
+		}
+	}
+
+	if (header == NULL) {
+
+		if ((header = (SHeader *) ::malloc(sizeof(SHeader) + size)) == NULL)
+
+			return NULL;
+
+		header->fSizeClass = sizeClass;
+
+	}
+
+	return (uBYTE *) (header + 1);
+}
+
+void VJSNetBufferPool::Free (void *inBuffer)
+{
+	if (inBuffer == NULL)
+
+		return;
+
+	SHeader	*header	= (SHeader *) inBuffer - 1;
+	uLONG	size	= GetSize(inBuffer);
+
+	xbox_assert(header->fSizeClass < kSizeClassCount);
+
+	if (!XBOX::VInterlocked::AtomicGet(&sIsClosed)) {
+
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
+
+		// Re-check, the pool may have been closed while waiting for the lock.
+
+		if (!sIsClosed && sPooledSize + size <= kMaximumPooledSize) {
+
+			sFreeBlocks[header->fSizeClass].push_back(header);
+			sPooledSize += size;
+			header = NULL;
+
+		}
+	}
+
+	if (header != NULL)
+
+		::free(header);
+}
+
+uLONG VJSNetBufferPool::GetSize (const void *inBuffer)
+{
+	xbox_assert(inBuffer != NULL);
+
+	return kMinimumSize << ((const SHeader *) inBuffer - 1)->fSizeClass;
+}
+
+void VJSNetBufferPool::Clear ()
+{
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
+
+	for (uLONG i = 0; i < kSizeClassCount; i++) {
+
+		std::vector<SHeader *>::iterator	j;
+
+		for (j = sFreeBlocks[i].begin(); j != sFreeBlocks[i].end(); j++)
+
+			::free(*j);
+
+		sFreeBlocks[i].clear();
+
+	}
+	sPooledSize = 0;
+}
+
+VJSNetBufferPool::SCloser::~SCloser ()
+{
+	// Other static members are still valid. Close first, so that no block is pooled once cleared.
+
+	XBOX::VInterlocked::Exchange(&sIsClosed, 1);
+	Clear();
+}
+
 void VJSNetSocketObject::ForceClose ()
 {
 	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
@@ -49,12 +157,9 @@ void VJSNetSocketObject::ForceClose ()
 
 	std::list<SPacket>::iterator	i;
 
-	for (i = fBufferedData.begin(); i != fBufferedData.end(); i++) {
-
-		xbox_assert(i->fBuffer != NULL);
-		::free(i->fBuffer);
+	for (i = fBufferedData.begin(); i != fBufferedData.end(); i++) 
 
-	}
+		_FreePacket(&*i);
 
 	fBufferedData.clear();
 }
@@ -74,7 +179,9 @@ VJSNetSocketObject::VJSNetSocketObject (bool inIsSynchronous, sLONG inType, bool
 	fWorker = NULL;
 
 	fIsPaused = false;
+	fIsDataEventQueued = false;
 	fBufferedData.clear();
+	fReadSize = VJSNetBufferPool::kMinimumSize;
 
 	fBytesRead = fBytesWritten = 0;
 }
@@ -124,13 +231,13 @@ bool VJSNetSocketObject::_ReadSocket ()
 	uLONG			length;
 	XBOX::VError	error;
 
-	if ((buffer = (uBYTE *) ::malloc(VJSNetSocketObject::kReadBufferSize)) == NULL) {
+	if ((buffer = VJSNetBufferPool::Allocate(fReadSize)) == NULL) {
 
 		XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
 		return false;
 
 	}
-	length = VJSNetSocketObject::kReadBufferSize;
+	length = fReadSize;
 
 	XBOX::VErrorTaskContext	*taskErrorContext;	
 	XBOX::VErrorContext		*context;
@@ -158,7 +265,7 @@ bool VJSNetSocketObject::_ReadSocket ()
 
 	if (error != XBOX::VE_OK)  {
 
-		::free(buffer);
+		VJSNetBufferPool::Free(buffer);
 		isOk = false;
 
 		if (error == XBOX::VE_SOCK_WOULD_BLOCK) {
@@ -197,30 +304,55 @@ bool VJSNetSocketObject::_ReadSocket ()
 			// Do not support "half close", consider them as "full" close. 
 			// Queue both events.
 
+			VJSNetBufferPool::Free(buffer);
+
 			fWorker->QueueEvent(VJSNetEvent::Create(this, "end"));
 			fWorker->QueueEvent(VJSNetEvent::CreateClose(this, false));
 
 			isOk = false;
 			
-		} else if (fIsPaused) {
+		} else {
 
 			fBytesRead += length;
 
+			// Adapt size of next read.
+
+			if (length == fReadSize && fReadSize < VJSNetBufferPool::kMaximumSize)
+
+				fReadSize <<= 1;
+
+			else if (length < fReadSize / kCopyRatio && fReadSize > VJSNetBufferPool::kMinimumSize)
+
+				fReadSize >>= 1;
+
 			SPacket	packet;
 
-			packet.fBuffer = buffer;
 			packet.fLength = length;
+			if (length >= VJSNetBufferPool::GetSize(buffer) / kCopyRatio) {
 
-			fBufferedData.push_back(packet);
-			
-			isOk = true;
+				// Buffer object will wrap pooled memory directly.
 
-		} else {
-			
-			fBytesRead += length;
+				packet.fBuffer = buffer;
+				packet.fFreeFunction = VJSNetBufferPool::Free;
+
+			} else if ((packet.fBuffer = (uBYTE *) ::malloc(length)) != NULL) {
+
+				::memcpy(packet.fBuffer, buffer, length);
+				packet.fFreeFunction = NULL;
+				VJSNetBufferPool::Free(buffer);
+
+			} else {
+
+				VJSNetBufferPool::Free(buffer);
+				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+				return false;
 
-			_FlushBufferedData();
-			fWorker->QueueEvent(VJSNetEvent::CreateData(this, buffer, length));
+			}
+
+			fBufferedData.push_back(packet);
+			if (!fIsPaused)
+
+				_FlushBufferedData();
 
 			isOk = true;
 
@@ -235,13 +367,87 @@ void VJSNetSocketObject::_FlushBufferedData()
 {
 	// fMutex must have been acquired.
 
+	if (!fIsDataEventQueued && !fBufferedData.empty()) {
+
+		fIsDataEventQueued = true;
+		fWorker->QueueEvent(VJSNetEvent::CreateData(this));
+
+	}
+}
+
+bool VJSNetSocketObject::_TakeBufferedData (uBYTE **outBuffer, sLONG *outLength, VJSBufferObject::FreeFunction *outFreeFunction)
+{
+	xbox_assert(outBuffer != NULL && outLength != NULL && outFreeFunction != NULL);
+
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
+
+	fIsDataEventQueued = false;
+	if (fIsPaused || fBufferedData.empty()) 
+
+		return false;
+
+	if (fBufferedData.size() == 1) {
+
+		*outBuffer = fBufferedData.front().fBuffer;
+		*outLength = fBufferedData.front().fLength;
+		*outFreeFunction = fBufferedData.front().fFreeFunction;
+		fBufferedData.clear();
+		return true;
+
+	}
+
 	std::list<SPacket>::iterator	i;
+	sLONG							length;
+	uBYTE							*p;
 
-	for (i = fBufferedData.begin(); i != fBufferedData.end(); i++) 
+	for (length = 0, i = fBufferedData.begin(); i != fBufferedData.end(); i++)
+
+		length += i->fLength;
+
+	if ((*outBuffer = p = (uBYTE *) ::malloc(length)) == NULL) {
+
+		// Keep data, a "data" event will be queued again on next read or resume().
 
-		fWorker->QueueEvent(VJSNetEvent::CreateData(this, i->fBuffer, i->fLength));
+		XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+		return false;
+
+	}
 
+	for (i = fBufferedData.begin(); i != fBufferedData.end(); i++) {
+
+		::memcpy(p, i->fBuffer, i->fLength);
+		p += i->fLength;
+		_FreePacket(&*i);
+
+	}
 	fBufferedData.clear();
+
+	*outLength = length;
+	*outFreeFunction = NULL;
+
+	return true;
+}
+
+void VJSNetSocketObject::_DataEventDiscarded ()
+{
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
+
+	fIsDataEventQueued = false;
+}
+
+void VJSNetSocketObject::_FreePacket (SPacket *ioPacket)
+{
+	xbox_assert(ioPacket != NULL && ioPacket->fBuffer != NULL);
+
+	if (ioPacket->fFreeFunction != NULL)
+
+		ioPacket->fFreeFunction(ioPacket->fBuffer);
+
+	else
+
+		::free(ioPacket->fBuffer);
+
+	ioPacket->fBuffer = NULL;
 }
 
 void VJSNetSocketClass::GetDefinition (ClassDefinition &outDefinition)
@@ -28,6 +28,64 @@
 
 BEGIN_TOOLBOX_NAMESPACE
 
+// Pool of read buffers, shared by all sockets. Blocks have power of two sizes, from kMinimumSize to kMaximumSize. 
+// Freed blocks are kept for reuse, up to kMaximumPooledSize bytes in total. At static destruction, the pool is cleared
+// and closed: sockets closed afterwards free their blocks directly.
+
+class XTOOLBOX_API VJSNetBufferPool
+{
+public:
+
+	static const uLONG		kMinimumSize		= 4096;
+	static const uLONG		kMaximumSize		= 65536;
+	static const VSize		kMaximumPooledSize	= 4 * 1024 * 1024;
+
+	// Return a block of inSize bytes (rounded up to a power of two), NULL if out of memory.
+
+	static uBYTE			*Allocate (uLONG inSize);
+
+	// Give a block back to the pool, can be used as VJSBufferObject::FreeFunction.
+
+	static void				Free (void *inBuffer);
+
+	static uLONG			GetSize (const void *inBuffer);
+
+	// Free all pooled blocks, done by VJSWorker::TerminateAll(). The pool remains usable.
+
+	static void				Clear ();
+
+private:
+
+	enum {
+
+		kSizeClassCount	= 5,	// 4KB, 8KB, 16KB, 32KB, and 64KB.
+
+	};
+
+	// Each block is preceded by a header, which size keeps data aligned as ::malloc() does.
+
+	struct SHeader {
+
+		uLONG				fSizeClass;
+		uLONG				fReserved[3];
+
+	};
+
+	// Destroyed before the other static members, closes the pool.
+
+	struct SCloser {
+
+							~SCloser ();
+
+	};
+
+	static XBOX::VCriticalSection	sMutex;
+	static std::vector<SHeader *>	sFreeBlocks[kSizeClassCount];
+	static VSize					sPooledSize;
+	static sLONG					sIsClosed;		// Plain data, valid after static destruction. Accessed with VInterlocked.
+	static SCloser					sCloser;
+};
+
 class XTOOLBOX_API VJSNetSocketObject : public VJSEventEmitter
 {
 friend class VJSNetSocketClass;
@@ -43,13 +101,18 @@ public:
 
 	struct SPacket {
 
-		uBYTE	*fBuffer;
-		sLONG	fLength;
+		uBYTE							*fBuffer;
+		sLONG							fLength;
+		VJSBufferObject::FreeFunction	fFreeFunction;	// NULL if allocated with ::malloc().
 
 	};
 
 	static const uLONG				kReadBufferSize	= 4096;
 
+	// Reads smaller than a fraction of their block are copied, so that a small Buffer doesn't hold a big block.
+
+	static const uLONG				kCopyRatio		= 4;
+
 									VJSNetSocketObject (bool inIsSynchronous, sLONG inType, bool inAllowHalfOpen);
 	virtual							~VJSNetSocketObject ();
 
@@ -76,11 +139,19 @@ public:
 	XBOX::VTCPEndPoint				*GetEndPoint ()	{	return fEndPoint;	}
 
 	// Asynchronous sockets allow data reading to be paused. Implementation is to read and save available data, but not queue "data" events.
-	// When resume() is called, this will queue "data" events for all buffered data.
+	// When resume() is called, this will queue a "data" event for all buffered data.
+	//
+	// Read data is always buffered, and at most one "data" event is queued at a time. When processed, it takes all 
+	// data buffered so far, hence packets read while the worker is busy are coalesced.
 
 	bool							fIsPaused;
+	bool							fIsDataEventQueued;
 	std::list<SPacket>				fBufferedData;
 
+	// Read size adapts to throughput: it doubles when a read fills its block, and halves after small reads.
+
+	uLONG							fReadSize;
+
 	// If not closed yet, force closing of the socket. Can be called repeatedly.
 
 	void							ForceClose ();
@@ -97,9 +168,20 @@ public:
 
 	bool							_ReadSocket ();
 
-	// To not lose data, it is buffered.
+	// Queue a "data" event if there is buffered data and none queued yet. fMutex must have been acquired.
 
 	void							_FlushBufferedData();
+
+	// Take all buffered data (called when processing "data" event). If there is a single packet, it is returned 
+	// as is, otherwise packets are concatenated. Return false if there is no data or if paused.
+
+	bool							_TakeBufferedData (uBYTE **outBuffer, sLONG *outLength, VJSBufferObject::FreeFunction *outFreeFunction);
+
+	// "data" event has been discarded without being processed.
+
+	void							_DataEventDiscarded ();
+
+	static void						_FreePacket (SPacket *ioPacket);
 };
 
 class XTOOLBOX_API VJSNetSocketClass : public XBOX::VJSClass<VJSNetSocketClass, VJSNetSocketObject>
@@ -18,6 +18,7 @@
 #include "VJSValue.h"
 #include "VJSContext.h"
 #include "VJSClass.h"
+#include "VJSBuffer.h"
 
 #include "VJSRuntime_Atomic.h"
 
@@ -213,3 +214,475 @@ void VJSSyncEvent::GetDefinition( ClassDefinition& outDefinition)
 	outDefinition.staticFunctions = functions;
 }
 
+
+
+
+// ----------------------------------------------------------------------------------
+
+
+
+VCriticalSection jsSharedBuffer::sMapMutex;
+jsSharedBuffer::SharedBufferMap jsSharedBuffer::sSharedBuffers;
+
+
+static sLONG8 _GetMilliseconds()
+{
+	VTime time;
+
+	time.FromSystemTime();
+
+	return time.GetMilliseconds();
+}
+
+
+jsSharedBuffer::jsSharedBuffer(VJSBufferObject* inBufferObject)
+{
+	xbox_assert(inBufferObject != NULL);
+
+	fBufferObject = RetainRefCountable(inBufferObject);
+}
+
+
+jsSharedBuffer::~jsSharedBuffer()
+{
+	xbox_assert(fWaitLists.empty());
+
+	ReleaseRefCountable(&fBufferObject);
+}
+
+
+jsSharedBuffer* jsSharedBuffer::Create(VSize inByteLength)
+{
+	jsSharedBuffer* result = nil;
+	VJSBufferObject* bufferObject = new VJSBufferObject(inByteLength);
+	if (bufferObject != nil)
+	{
+		if (inByteLength && bufferObject->GetDataPtr() == NULL)
+		{
+			vThrowError(VE_MEMORY_FULL);
+		}
+		else
+		{
+			::memset(bufferObject->GetDataPtr(), 0, inByteLength);
+			result = new jsSharedBuffer(bufferObject);
+		}
+		bufferObject->Release();
+	}
+	else
+		vThrowError(VE_MEMORY_FULL);
+	return result;
+}
+
+
+jsSharedBuffer* jsSharedBuffer::RetainSharedBuffer(const VString& inName, VSize inByteLength)
+{
+	jsSharedBuffer* result = nil;
+	VTaskLock lock(&sMapMutex);
+	SharedBufferMap::iterator found = sSharedBuffers.find(inName);
+	if (found == sSharedBuffers.end())
+	{
+		jsSharedBuffer* newbuffer = Create(inByteLength);
+		if (newbuffer != nil)
+		{
+			sSharedBuffers[inName] = newbuffer;
+			result = RetainRefCountable(newbuffer);
+		}
+	}
+	else
+	{
+		result = RetainRefCountable(found->second);
+	}
+	return result;
+}
+
+
+void jsSharedBuffer::EraseSharedBuffer(const VString& inName)
+{
+	VTaskLock lock(&sMapMutex);
+	SharedBufferMap::iterator found = sSharedBuffers.find(inName);
+	if (found != sSharedBuffers.end())
+	{
+		found->second->Release();
+		sSharedBuffers.erase(found);
+	}
+}
+
+
+VSize jsSharedBuffer::GetByteLength() const
+{
+	return fBufferObject->GetDataSize();
+}
+
+
+sLONG* jsSharedBuffer::GetInt32Address(sLONG inIndex) const
+{
+	if (inIndex < 0 || inIndex >= GetInt32Count())
+		return NULL;
+	else
+		return (sLONG*) fBufferObject->GetDataPtr() + inIndex;
+}
+
+
+// VInterlocked::AtomicAdd() doesn't return the same value on all platforms, so use compare and exchange loops.
+
+sLONG jsSharedBuffer::Add(sLONG* inAddress, sLONG inValue)
+{
+	sLONG oldValue;
+	do
+	{
+		oldValue = VInterlocked::AtomicGet(inAddress);
+	} while (VInterlocked::CompareExchange(inAddress, oldValue, oldValue + inValue) != oldValue);
+	return oldValue;
+}
+
+
+sLONG jsSharedBuffer::And(sLONG* inAddress, sLONG inValue)
+{
+	sLONG oldValue;
+	do
+	{
+		oldValue = VInterlocked::AtomicGet(inAddress);
+	} while (VInterlocked::CompareExchange(inAddress, oldValue, oldValue & inValue) != oldValue);
+	return oldValue;
+}
+
+
+sLONG jsSharedBuffer::Or(sLONG* inAddress, sLONG inValue)
+{
+	sLONG oldValue;
+	do
+	{
+		oldValue = VInterlocked::AtomicGet(inAddress);
+	} while (VInterlocked::CompareExchange(inAddress, oldValue, oldValue | inValue) != oldValue);
+	return oldValue;
+}
+
+
+sLONG jsSharedBuffer::Xor(sLONG* inAddress, sLONG inValue)
+{
+	sLONG oldValue;
+	do
+	{
+		oldValue = VInterlocked::AtomicGet(inAddress);
+	} while (VInterlocked::CompareExchange(inAddress, oldValue, oldValue ^ inValue) != oldValue);
+	return oldValue;
+}
+
+
+// The value is compared with fWaitMutex locked, and Notify() locks it too. So a store followed by a notify cannot be 
+// missed by a waiter. Waiters on all indexes share the condition variable, wake counts tell which are to return.
+
+sLONG jsSharedBuffer::Wait(sLONG inIndex, sLONG inExpectedValue, sLONG inTimeoutMilliseconds)
+{
+	sLONG* address = GetInt32Address(inIndex);
+	xbox_assert(address != NULL);
+
+	VTaskLock lock(&fWaitMutex);
+	if (VInterlocked::AtomicGet(address) != inExpectedValue)
+		return eWAIT_NOT_EQUAL;
+
+	// Elements of a std::map are not moved, and the list is erased only by its last waiter.
+
+	SWaitList& waitList = fWaitLists[inIndex];
+	waitList.fWaiterCount++;
+
+	sLONG8 deadline = inTimeoutMilliseconds >= 0 ? _GetMilliseconds() + inTimeoutMilliseconds : 0;
+	sLONG result = eWAIT_TIMED_OUT;
+	for (;;)
+	{
+		if (waitList.fWakeCount > 0)
+		{
+			waitList.fWakeCount--;
+			result = eWAIT_OK;
+			break;
+		}
+		if (inTimeoutMilliseconds >= 0)
+		{
+			sLONG8 remaining = deadline - _GetMilliseconds();
+			if (remaining <= 0)
+				break;
+			fWaitCondition.Wait(&fWaitMutex, (sLONG) remaining);
+		}
+		else
+			fWaitCondition.Wait(&fWaitMutex);
+	}
+
+	if (--waitList.fWaiterCount == 0)
+		fWaitLists.erase(inIndex);
+	return result;
+}
+
+
+sLONG jsSharedBuffer::Notify(sLONG inIndex, sLONG inCount)
+{
+	VTaskLock lock(&fWaitMutex);
+	WaitListMap::iterator found = fWaitLists.find(inIndex);
+	if (found == fWaitLists.end())
+		return 0;
+
+	// Don't count those already notified.
+
+	sLONG count = found->second.fWaiterCount - found->second.fWakeCount;
+	if (inCount >= 0 && inCount < count)
+		count = inCount;
+	if (count > 0)
+	{
+		found->second.fWakeCount += count;
+		fWaitCondition.Broadcast();
+	}
+	return count;
+}
+
+
+
+void VJSSharedArrayBuffer::Initialize( const VJSParms_initialize& inParms, jsSharedBuffer* inSharedBuffer)
+{
+	inSharedBuffer->Retain();
+	inParms.GetObject().SetProperty("byteLength", (sLONG) inSharedBuffer->GetByteLength(), JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontDelete);
+	inParms.GetObject().SetProperty("length", inSharedBuffer->GetInt32Count(), JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontDelete);
+}
+
+
+void VJSSharedArrayBuffer::Finalize( const VJSParms_finalize& inParms, jsSharedBuffer* inSharedBuffer)
+{
+	inSharedBuffer->Release();
+}
+
+
+VJSObject VJSSharedArrayBuffer::MakeConstructor( VJSContext inContext)
+{
+	VJSObject constructor(inContext);
+
+	constructor.MakeConstructor(Class(), js_constructor<_Construct>);
+
+	return constructor;
+}
+
+
+void VJSSharedArrayBuffer::_Construct(VJSParms_callAsConstructor& ioParms)
+{
+	VString name;
+	sLONG size = 0;
+	sLONG sizeParam = 1;
+	if (ioParms.IsStringParam(1))
+	{
+		ioParms.GetStringParam(1, name);
+		sizeParam = 2;
+	}
+	if (!ioParms.IsNumberParam(sizeParam) || !ioParms.GetLongParam(sizeParam, &size))
+	{
+		vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, sizeParam == 1 ? "1" : "2");
+		ioParms.ReturnUndefined();
+	}
+	else if (size < 0)
+	{
+		vThrowError(VE_JVSC_WRONG_NUMBER_ARGUMENT, sizeParam == 1 ? "1" : "2");
+		ioParms.ReturnUndefined();
+	}
+	else
+	{
+		jsSharedBuffer* sharedBuffer = name.IsEmpty() ? jsSharedBuffer::Create(size) : jsSharedBuffer::RetainSharedBuffer(name, size);
+		if (sharedBuffer != nil)
+		{
+			ioParms.ReturnConstructedObject(VJSSharedArrayBuffer::CreateInstance(ioParms.GetContextRef(), sharedBuffer));
+			sharedBuffer->Release();
+		}
+		else
+			ioParms.ReturnUndefined();
+	}
+}
+
+
+sLONG* VJSSharedArrayBuffer::_GetOperands(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer, sLONG* outValue)
+{
+	sLONG index;
+	sLONG* address = NULL;
+	if (!ioParms.IsNumberParam(1) || !ioParms.GetLongParam(1, &index))
+	{
+		vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "1");
+	}
+	else if ((address = inSharedBuffer->GetInt32Address(index)) == NULL)
+	{
+		vThrowError(VE_JVSC_TYPED_ARRAY_OUT_OF_BOUND);
+	}
+	else if (outValue != NULL && (!ioParms.IsNumberParam(2) || !ioParms.GetLongParam(2, outValue)))
+	{
+		vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "2");
+		address = NULL;
+	}
+	return address;
+}
+
+
+void VJSSharedArrayBuffer::_Load(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, NULL);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Load(address));
+}
+
+
+void VJSSharedArrayBuffer::_Store(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+	{
+		jsSharedBuffer::Store(address, value);
+		ioParms.ReturnNumber(value);
+	}
+}
+
+
+void VJSSharedArrayBuffer::_Add(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Add(address, value));
+}
+
+
+void VJSSharedArrayBuffer::_Sub(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Add(address, -value));
+}
+
+
+void VJSSharedArrayBuffer::_And(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::And(address, value));
+}
+
+
+void VJSSharedArrayBuffer::_Or(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Or(address, value));
+}
+
+
+void VJSSharedArrayBuffer::_Xor(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Xor(address, value));
+}
+
+
+void VJSSharedArrayBuffer::_Exchange(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+		ioParms.ReturnNumber(jsSharedBuffer::Exchange(address, value));
+}
+
+
+// compareExchange(index, expectedValue, newValue) returns the previous value, it has been replaced if it is expectedValue.
+
+void VJSSharedArrayBuffer::_CompareExchange(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG expectedValue, newValue;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &expectedValue);
+	if (address != NULL)
+	{
+		if (!ioParms.IsNumberParam(3) || !ioParms.GetLongParam(3, &newValue))
+			vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "3");
+		else
+			ioParms.ReturnNumber(jsSharedBuffer::CompareExchange(address, expectedValue, newValue));
+	}
+}
+
+
+// wait(index, value, {timeout}) returns "ok", "not-equal", or "timed-out". Without timeout, waits until notified.
+
+void VJSSharedArrayBuffer::_Wait(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG value;
+	sLONG timeout = -1;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, &value);
+	if (address != NULL)
+	{
+		if (ioParms.CountParams() >= 3 && (!ioParms.IsNumberParam(3) || !ioParms.GetLongParam(3, &timeout)))
+		{
+			vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "3");
+		}
+		else
+		{
+			sLONG index;
+			ioParms.GetLongParam(1, &index);
+			switch (inSharedBuffer->Wait(index, value, timeout < 0 ? -1 : timeout))
+			{
+				case jsSharedBuffer::eWAIT_OK:			ioParms.ReturnString("ok"); break;
+				case jsSharedBuffer::eWAIT_NOT_EQUAL:	ioParms.ReturnString("not-equal"); break;
+				default:								ioParms.ReturnString("timed-out"); break;
+			}
+		}
+	}
+}
+
+
+// notify(index, {count}) returns the number of woken workers. Without count, wakes all of them.
+
+void VJSSharedArrayBuffer::_Notify(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	sLONG count = -1;
+	sLONG* address = _GetOperands(ioParms, inSharedBuffer, NULL);
+	if (address != NULL)
+	{
+		if (ioParms.CountParams() >= 2 && (!ioParms.IsNumberParam(2) || !ioParms.GetLongParam(2, &count)))
+		{
+			vThrowError(VE_JVSC_WRONG_PARAMETER_TYPE_NUMBER, "2");
+		}
+		else
+		{
+			sLONG index;
+			ioParms.GetLongParam(1, &index);
+			ioParms.ReturnNumber(inSharedBuffer->Notify(index, count));
+		}
+	}
+}
+
+
+// Return a Buffer using the shared memory (no copy).
+
+void VJSSharedArrayBuffer::_ToBuffer(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer)
+{
+	ioParms.ReturnValue(VJSBufferClass::CreateInstance(ioParms.GetContext(), inSharedBuffer->GetBufferObject()));
+}
+
+
+void VJSSharedArrayBuffer::GetDefinition( ClassDefinition& outDefinition)
+{
+	static inherited::StaticFunction functions[] = 
+	{
+		{ "load", js_callStaticFunction<_Load>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "store", js_callStaticFunction<_Store>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "add", js_callStaticFunction<_Add>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "sub", js_callStaticFunction<_Sub>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "and", js_callStaticFunction<_And>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "or", js_callStaticFunction<_Or>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "xor", js_callStaticFunction<_Xor>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "exchange", js_callStaticFunction<_Exchange>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "compareExchange", js_callStaticFunction<_CompareExchange>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "wait", js_callStaticFunction<_Wait>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "notify", js_callStaticFunction<_Notify>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ "toBuffer", js_callStaticFunction<_ToBuffer>, JS4D::PropertyAttributeReadOnly | JS4D::PropertyAttributeDontEnum | JS4D::PropertyAttributeDontDelete },
+		{ 0, 0, 0}
+	};
+
+	outDefinition.className = "SharedArrayBuffer";
+	outDefinition.initialize = js_initialize<Initialize>;
+	outDefinition.finalize = js_finalize<Finalize>;
+	outDefinition.staticFunctions = functions;
+}
@@ -21,6 +21,8 @@
 
 BEGIN_TOOLBOX_NAMESPACE
 
+class VJSBufferObject;
+
 
 class XTOOLBOX_API jsAtomicSection : public XBOX::IRefCountable
 {
@@ -95,6 +97,127 @@ public:
 
 
 
+// ------------------------------------------------------------------------------------------------------
+
+
+// Memory shared by several workers (contexts), it is never copied by postMessage(). It is zero initialized. 
+// Atomic operations and waits work on 32-bit integers, indexes are in number of 32-bit integers.
+
+class XTOOLBOX_API jsSharedBuffer : public XBOX::IRefCountable
+{
+public:
+
+	enum {
+
+		eWAIT_OK,				// Woken by Notify().
+		eWAIT_NOT_EQUAL,		// Value wasn't the expected one, didn't wait.
+		eWAIT_TIMED_OUT,
+
+	};
+
+	// Create an anonymous shared buffer, return NULL if out of memory.
+
+	static jsSharedBuffer*	Create(VSize inByteLength);
+
+	// Retrieve a named shared buffer, create it with given length if it doesn't exist yet.
+
+	static jsSharedBuffer*	RetainSharedBuffer(const VString& inName, VSize inByteLength);
+
+	static void				EraseSharedBuffer(const VString& inName);
+
+	VJSBufferObject*		GetBufferObject() const		{ return fBufferObject; }
+	VSize					GetByteLength() const;
+	sLONG					GetInt32Count() const		{ return (sLONG) (GetByteLength() / sizeof(sLONG)); }
+
+	// Return NULL if inIndex is out of bound.
+
+	sLONG*					GetInt32Address(sLONG inIndex) const;
+
+	// All operations but Store() return the previous value.
+
+	static sLONG			Load(sLONG* inAddress)									{ return VInterlocked::AtomicGet(inAddress); }
+	static void				Store(sLONG* inAddress, sLONG inValue)					{ VInterlocked::Exchange(inAddress, inValue); }
+	static sLONG			Exchange(sLONG* inAddress, sLONG inValue)				{ return VInterlocked::Exchange(inAddress, inValue); }
+	static sLONG			CompareExchange(sLONG* inAddress, sLONG inExpectedValue, sLONG inNewValue)	{ return VInterlocked::CompareExchange(inAddress, inExpectedValue, inNewValue); }
+	static sLONG			Add(sLONG* inAddress, sLONG inValue);
+	static sLONG			And(sLONG* inAddress, sLONG inValue);
+	static sLONG			Or(sLONG* inAddress, sLONG inValue);
+	static sLONG			Xor(sLONG* inAddress, sLONG inValue);
+
+	// Futex like: if the integer at inIndex still equals inExpectedValue, block until Notify() or timeout (negative 
+	// for infinite). Return eWAIT_OK, eWAIT_NOT_EQUAL, or eWAIT_TIMED_OUT.
+
+	sLONG					Wait(sLONG inIndex, sLONG inExpectedValue, sLONG inTimeoutMilliseconds);
+
+	// Wake up to inCount (negative for all) threads waiting on inIndex, return the number of woken threads.
+
+	sLONG					Notify(sLONG inIndex, sLONG inCount);
+
+private:
+
+	typedef std::map<XBOX::VString, jsSharedBuffer*> SharedBufferMap;
+
+	// Waiters on an index, and how many of them have been notified but haven't woken up yet.
+
+	struct SWaitList {
+
+		sLONG				fWaiterCount;
+		sLONG				fWakeCount;
+
+	};
+
+	typedef std::map<sLONG, SWaitList> WaitListMap;
+
+	static VCriticalSection sMapMutex;
+	static SharedBufferMap	sSharedBuffers;
+
+	VJSBufferObject*		fBufferObject;
+	VCriticalSection		fWaitMutex;
+	VConditionVariable		fWaitCondition;
+	WaitListMap				fWaitLists;
+
+							jsSharedBuffer(VJSBufferObject* inBufferObject);
+	virtual					~jsSharedBuffer();
+};
+
+
+class XTOOLBOX_API VJSSharedArrayBuffer : public VJSClass<VJSSharedArrayBuffer, jsSharedBuffer>
+{
+public:
+	typedef VJSClass<VJSSharedArrayBuffer, jsSharedBuffer> inherited;
+
+	static	void			Initialize( const VJSParms_initialize& inParms, jsSharedBuffer* inSharedBuffer);
+	static	void			Finalize( const VJSParms_finalize& inParms, jsSharedBuffer* inSharedBuffer);
+	static	void			GetDefinition( ClassDefinition& outDefinition);
+
+	// new SharedArrayBuffer(byteLength) or new SharedArrayBuffer(name, byteLength) to share it by name.
+
+	static	VJSObject		MakeConstructor( VJSContext inContext);
+
+	static void _Construct(VJSParms_callAsConstructor& ioParms);
+
+	static void _Load(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Store(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Add(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Sub(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _And(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Or(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Xor(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Exchange(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _CompareExchange(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Wait(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _Notify(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+	static void _ToBuffer(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer);
+
+private:
+
+	// Get the address of the integer at parameter 1 and the value of parameter 2 (if inValue not NULL), throw an error 
+	// and return NULL if parameters are wrong.
+
+	static sLONG*			_GetOperands(VJSParms_callStaticFunction& ioParms, jsSharedBuffer* inSharedBuffer, sLONG* outValue);
+};
+
+
 
 END_TOOLBOX_NAMESPACE
 
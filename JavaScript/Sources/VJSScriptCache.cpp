@@ -0,0 +1,248 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VJavaScriptPrecompiled.h"
+
+#include "VJSScriptCache.h"
+
+USING_TOOLBOX_NAMESPACE
+
+
+struct ScriptEntry;
+
+// paths are compared strictly: VString::operator< ignores case and diacritics.
+typedef std::map<VString, ScriptEntry*, VStringLessCompareStrict>	MapOfScriptEntry;
+typedef std::list<ScriptEntry*>										ListOfScriptEntry;
+
+typedef struct ScriptEntry
+{
+	VString						fPath;
+	VTime						fModificationTime;
+	sLONG8						fFileSize;
+	VString						fScript;
+	JS4D::StringRef				fJSScript;
+	JS4D::StringRef				fJSModuleFunction;	// built on first use
+	ListOfScriptEntry::iterator	fUsePosition;		// in sUseOrder
+} ScriptEntry;
+
+
+static VCriticalSection		sCacheMutex;
+static MapOfScriptEntry		sEntries;
+static ListOfScriptEntry	sUseOrder;		// least recently used first
+static VSize				sCacheSize = 0;
+static VSize				sCacheMaxSize = 32 * 1024 * 1024;
+static sLONG8				sHitCount = 0;
+static sLONG8				sMissCount = 0;
+
+
+static void _DeleteEntry( ScriptEntry *inEntry)
+{
+	// sCacheMutex must be held, the entry must be removed from sEntries by the caller.
+	sCacheSize -= inEntry->fScript.GetLength();
+	sUseOrder.erase( inEntry->fUsePosition);
+	JS4D::ReleaseString( inEntry->fJSScript);
+	JS4D::ReleaseString( inEntry->fJSModuleFunction);
+	delete inEntry;
+}
+
+
+static void _Purge()
+{
+	// sCacheMutex must be held. Least recently used entries go first but the most recent one is always kept.
+	while( (sCacheSize > sCacheMaxSize) && (sEntries.size() > 1) )
+	{
+		ScriptEntry *oldest = sUseOrder.front();
+		sEntries.erase( oldest->fPath);
+		_DeleteEntry( oldest);
+	}
+}
+
+
+static VError _LoadScriptFile( VFile& inFile, VString& outScript)
+{
+	VFileStream stream( &inFile);
+	VError err = stream.OpenReading();
+	if (err == VE_OK)
+	{
+		err = stream.GuessCharSetFromLeadingBytes( VTC_DefaultTextExport );		// sc 18/03/2011 instead of VTC_UTF_8
+		stream.SetCarriageReturnMode( eCRM_NATIVE );
+		if (err == VE_OK)
+			err = stream.GetText( outScript);
+	}
+	stream.CloseReading();
+	return err;
+}
+
+
+static void _GetOutputs( ScriptEntry *inEntry, VJSScriptCache::EForm inForm, VString *outScript, JS4D::StringRef *outJSScript)
+{
+	// sCacheMutex must be held
+	sUseOrder.splice( sUseOrder.end(), sUseOrder, inEntry->fUsePosition);
+
+	if (outScript != NULL)
+		*outScript = inEntry->fScript;
+
+	if (outJSScript != NULL)
+	{
+		if (inForm == VJSScriptCache::eFORM_MODULE_FUNCTION)
+		{
+			if (inEntry->fJSModuleFunction == NULL)
+			{
+				// see VJSRequireClass::_evaluate()
+				VString functionScript;
+				functionScript.AppendString( "(function (exports, module) {");
+				functionScript.AppendString( inEntry->fScript);
+				functionScript.AppendString( "})");
+				inEntry->fJSModuleFunction = JS4D::VStringToString( functionScript);
+			}
+			*outJSScript = JS4D::RetainString( inEntry->fJSModuleFunction);
+		}
+		else
+		{
+			*outJSScript = JS4D::RetainString( inEntry->fJSScript);
+		}
+	}
+}
+
+
+VError VJSScriptCache::GetScript( const VFilePath& inPath, EForm inForm, VString *outScript, JS4D::StringRef *outJSScript)
+{
+	VTRACE_SCOPE( "js", "VJSScriptCache::GetScript");
+
+	if (outScript != NULL)
+		outScript->Clear();
+	if (outJSScript != NULL)
+		*outJSScript = NULL;
+
+	VFile file( inPath);
+	VTime modificationTime;
+	sLONG8 fileSize = 0;
+	
+	StErrorContextInstaller errorContext( false);
+	VError err = file.GetTimeAttributes( &modificationTime);
+	if (err == VE_OK)
+		err = file.GetSize( &fileSize);
+	if (err != VE_OK)
+		return err;
+
+	const VString& key = inPath.GetPath();
+
+	{
+		StLocker<VCriticalSection> lock( &sCacheMutex);
+
+		MapOfScriptEntry::iterator i = sEntries.find( key);
+		if ( (i != sEntries.end()) && (i->second->fModificationTime == modificationTime) && (i->second->fFileSize == fileSize) )
+		{
+			++sHitCount;
+			_GetOutputs( i->second, inForm, outScript, outJSScript);
+			return VE_OK;
+		}
+	}
+
+	// load outside of the lock, another task may load the same file at the same time, last one wins.
+	ScriptEntry *entry = new ScriptEntry;
+	if (entry == NULL)
+		return VE_MEMORY_FULL;
+
+	entry->fPath = key;
+	entry->fModificationTime = modificationTime;
+	entry->fFileSize = fileSize;
+	entry->fJSModuleFunction = NULL;
+	entry->fJSScript = NULL;
+	err = _LoadScriptFile( file, entry->fScript);
+	if (err != VE_OK)
+	{
+		delete entry;
+		return err;
+	}
+	entry->fJSScript = JS4D::VStringToString( entry->fScript);
+
+	{
+		StLocker<VCriticalSection> lock( &sCacheMutex);
+
+		++sMissCount;
+		
+		MapOfScriptEntry::iterator i = sEntries.find( key);
+		if (i != sEntries.end())
+		{
+			_DeleteEntry( i->second);
+			i->second = entry;
+		}
+		else
+		{
+			sEntries.insert( MapOfScriptEntry::value_type( key, entry));
+		}
+		sCacheSize += entry->fScript.GetLength();
+		entry->fUsePosition = sUseOrder.insert( sUseOrder.end(), entry);
+
+		_GetOutputs( entry, inForm, outScript, outJSScript);
+		_Purge();
+	}
+
+	return VE_OK;
+}
+
+
+void VJSScriptCache::Clear()
+{
+	StLocker<VCriticalSection> lock( &sCacheMutex);
+
+	for( MapOfScriptEntry::iterator i = sEntries.begin() ; i != sEntries.end() ; ++i)
+		_DeleteEntry( i->second);
+	sEntries.clear();
+	xbox_assert( sCacheSize == 0);
+}
+
+
+void VJSScriptCache::Remove( const VFilePath& inPath)
+{
+	StLocker<VCriticalSection> lock( &sCacheMutex);
+
+	MapOfScriptEntry::iterator i = sEntries.find( inPath.GetPath());
+	if (i != sEntries.end())
+	{
+		_DeleteEntry( i->second);
+		sEntries.erase( i);
+	}
+}
+
+
+void VJSScriptCache::SetMaxSize( VSize inMaxSize)
+{
+	StLocker<VCriticalSection> lock( &sCacheMutex);
+
+	sCacheMaxSize = inMaxSize;
+	_Purge();
+}
+
+
+void VJSScriptCache::GetStatistics( Statistics& outStatistics)
+{
+	StLocker<VCriticalSection> lock( &sCacheMutex);
+
+	outStatistics.fHitCount = sHitCount;
+	outStatistics.fMissCount = sMissCount;
+	outStatistics.fEntryCount = (sLONG) sEntries.size();
+	outStatistics.fSize = sCacheSize;
+}
+
+
+void VJSScriptCache::ResetStatistics()
+{
+	StLocker<VCriticalSection> lock( &sCacheMutex);
+
+	sHitCount = 0;
+	sMissCount = 0;
+}
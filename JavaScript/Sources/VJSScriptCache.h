@@ -0,0 +1,71 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VJSScriptCache__
+#define __VJSScriptCache__
+
+#include "JS4D.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+//======================================================
+
+/*
+	Process-wide cache of script files, shared by all global contexts and workers.
+
+	Sources are kept both as VString and as JS4D::StringRef, so that evaluating a cached script
+	neither reads nor transcodes the file nor copies the source again for JavaScriptCore.
+	An entry is validated against the modification time and size of its file at each lookup.
+	JavaScriptCore API doesn't expose its bytecode, so only sources are cached.
+
+	thread safe.
+*/
+class XTOOLBOX_API VJSScriptCache
+{
+public:
+	enum EForm {
+		eFORM_SCRIPT			= 0,	// script as is
+		eFORM_MODULE_FUNCTION	= 1		// script wrapped as "(function (exports, module) {...})", see VJSRequireClass
+	};
+
+	typedef struct Statistics
+	{
+		sLONG8		fHitCount;
+		sLONG8		fMissCount;			// includes reloads of modified files
+		sLONG		fEntryCount;
+		VSize		fSize;				// in UniChars
+	} Statistics;
+
+			// Retrieve the source of a script file, loading it if not cached or if modified.
+			// outScript and outJSScript may be NULL. outJSScript must be released with JS4D::ReleaseString().
+			// Returned errors are those of VFileStream (VE_STREAM_EOF for an empty file), nothing is thrown.
+	static	VError					GetScript( const VFilePath& inPath, EForm inForm, VString *outScript, JS4D::StringRef *outJSScript);
+
+	static	void					Clear();
+	static	void					Remove( const VFilePath& inPath);
+
+			// Least recently used entries are purged when the total size goes above the limit (default is 32M UniChars).
+	static	void					SetMaxSize( VSize inMaxSize);
+
+	static	void					GetStatistics( Statistics& outStatistics);
+	static	void					ResetStatistics();
+
+private:
+									VJSScriptCache();
+};
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -19,195 +19,228 @@
 
 #include "VJSContext.h"
 #include "VJSGlobalClass.h"
+#include "VJSBuffer.h"
+#include "VJSW3CArrayBuffer.h"
+#include "VJSRuntime_Atomic.h"
 
 USING_TOOLBOX_NAMESPACE
 
-VJSStructuredClone *VJSStructuredClone::RetainClone (XBOX::VJSValue inValue)
+VJSStructuredClone *VJSStructuredClone::RetainClone (XBOX::VJSValue inValue, const std::vector<XBOX::VJSValue> *inTransferList)
 {	
-	std::map<JS4D::ValueRef, SNode *>	alreadyCreated;
-	std::list<SEntry>					toDoList;
-	SNode								*root;
+	VCloneBuffer			data;
+	MapOfIndex				alreadyCloned, transferred;
+	std::vector<jsSharedBuffer *>	sharedBuffers;
+	std::vector<SProperty>	stack;
+	bool					isOk	= true;
 
-	if ((root = _ValueToNode(inValue, &alreadyCreated, &toDoList)) == NULL)
+	if (inTransferList != NULL) {
 
-		return NULL;
+		// Check transfer list first, objects are detached only once the clone has succeeded.
 
-	while (!toDoList.empty()) {
+		std::vector<XBOX::VJSValue>::const_iterator	i;
 
-		// Property iterator will also iterate Array object indexes (they are converted into string).
+		for (i = inTransferList->begin(); isOk && i != inTransferList->end(); i++) {
 
-		XBOX::VJSValue				value(inValue.GetContext(), toDoList.front().fValueRef);
-		XBOX::VJSPropertyIterator	i(value.GetObject());
-		SNode						*p, *q, *r;
+			VJSBufferObject			*buffer;
+			VJSArrayBufferObject	*arrayBuffer;
 
-		p = toDoList.front().fNode;
-		xbox_assert(p->fType == eNODE_OBJECT || p->fType == eNODE_ARRAY);
-		
-		toDoList.pop_front();
+			if (!i->IsObject() || transferred.find(i->GetValueRef()) != transferred.end())
 
-		// Object or Array with no attributes?
+				isOk = false;
 
-		if (!i.IsValid()) 
+			else if ((buffer = i->GetObject().GetPrivateData<VJSBufferClass>()) != NULL)
 
-			continue;
+				isOk = buffer->IsTransferable();
 
-		// Get prototype and dump its attribute names.
+			else if ((arrayBuffer = i->GetObject().GetPrivateData<VJSArrayBufferClass>()) != NULL)
 
-		XBOX::VJSObject	prototypeObject	= value.GetObject().GetPrototype(inValue.GetContext());
-		bool			hasPrototype	= prototypeObject.IsObject();
+				isOk = arrayBuffer->IsTransferable();
 
-		// Iterate child(s).
+			else
 
-		for ( ; i.IsValid(); ++i) {
+				isOk = false;
 
-			XBOX::VString	name;
+			if (isOk)
 
-			i.GetPropertyName(name);
-	
-			// Check attribute name: If it is part of prototype, do not clone it.
+				transferred[i->GetValueRef()] = (uLONG) (i - inTransferList->begin());
 
-			if (hasPrototype && prototypeObject.HasProperty(name))
+		}
 
-				continue;
+	}
 
-			value = i.GetProperty();
-			if ((r = _ValueToNode(value, &alreadyCreated, &toDoList)) == NULL) 
+	if (isOk)
 
-				break;
+		isOk = _WriteValue(inValue, &data, &alreadyCloned, &transferred, &sharedBuffers, &stack);
+	while (isOk && !stack.empty()) {
 
-			else if (p->fValue.fFirstChild != NULL) 
-				
-				q->fNextSibling = r;
-						
-			else
-				
-				p->fValue.fFirstChild = r;
+		// Writing the value may push the properties of an object, so pop the property first.
 
-			r->fName = name;
-			q = r;
+		XBOX::VJSValue	value(inValue.GetContext(), stack.back().fValueRef);
 
-		}
+		isOk = _WriteString(stack.back().fName, &data);
+		stack.pop_back();
+		if (isOk)
+
+			isOk = _WriteValue(value, &data, &alreadyCloned, &transferred, &sharedBuffers, &stack);
 
-		if (p->fValue.fFirstChild != NULL) 
+		value.Unprotect();
 
-			q->fNextSibling = NULL;
+	}
 
-		if (i.IsValid()) {
+	// Stacked property values and cloned objects are only referenced from the heap, they have been protected 
+	// from garbage collection (getters, valueOf(), or serialize() may have made them unreachable).
 
-			_FreeNode(root);
-			root = NULL;
-			break;
+	for (std::vector<SProperty>::iterator i = stack.begin(); i != stack.end(); i++) {
+
+		XBOX::VJSValue	value(inValue.GetContext(), i->fValueRef);
 
-		} 	
+		value.Unprotect();
 
 	}
+	for (MapOfIndex::iterator i = alreadyCloned.begin(); i != alreadyCloned.end(); i++) {
 
-	if (root != NULL) {
+		XBOX::VJSValue	value(inValue.GetContext(), i->first);
 
-		VJSStructuredClone	*structuredClone;
+		value.Unprotect();
 
-		if ((structuredClone = new VJSStructuredClone()) != NULL)
+	}
 
-			structuredClone->fRoot = root;
+	VJSStructuredClone	*structuredClone	= _Create(&data, isOk);
 
-		else
+	if (structuredClone != NULL)
+
+		structuredClone->fSharedBuffers.swap(sharedBuffers);
+
+	for (std::vector<jsSharedBuffer *>::iterator i = sharedBuffers.begin(); i != sharedBuffers.end(); i++)
+
+		XBOX::ReleaseRefCountable<jsSharedBuffer>(&*i);
+
+	if (structuredClone != NULL && inTransferList != NULL) {
+
+		// Move memory of transferred objects, even those not part of the cloned value. Buffer objects receiving the 
+		// memory of Buffers are all allocated first: if one fails, nothing has been detached and the clone fails.
+
+		std::vector<XBOX::VJSValue>::const_iterator	i;
+		std::vector<VJSBufferObject *>				destinations;
+
+		destinations.reserve(inTransferList->size());
+		structuredClone->fTransferredBuffers.reserve(inTransferList->size());
+		for (i = inTransferList->begin(); i != inTransferList->end(); i++) {
+
+			VJSBufferObject	*destination	= NULL;
+
+			if (i->GetObject().GetPrivateData<VJSBufferClass>() != NULL
+			&& (destination = new VJSBufferObject(0, NULL)) == NULL) {
+
+				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);	// The clone fails too (DATA_CLONE_ERR).
+				break;
+
+			}
+			destinations.push_back(destination);
+
+		}
+
+		if (destinations.size() != inTransferList->size()) {
+
+			for (std::vector<VJSBufferObject *>::iterator j = destinations.begin(); j != destinations.end(); j++)
+
+				if (*j != NULL)
+
+					XBOX::ReleaseRefCountable<VJSBufferObject>(&*j);
+
+			XBOX::ReleaseRefCountable<VJSStructuredClone>(&structuredClone);
 
-			_FreeNode(root);
+		} else {
 
-		return structuredClone;
+			std::vector<VJSBufferObject *>::iterator	j;
 
-	} else
+			for (i = inTransferList->begin(), j = destinations.begin(); i != inTransferList->end(); i++, j++) {
 
-		return NULL;
+				VJSBufferObject			*buffer;
+				VJSArrayBufferObject	*arrayBuffer;
+
+				if ((buffer = i->GetObject().GetPrivateData<VJSBufferClass>()) != NULL) {
+
+					buffer->Transfer(*j);
+					structuredClone->fTransferredBuffers.push_back(*j);
+
+				} else if ((arrayBuffer = i->GetObject().GetPrivateData<VJSArrayBufferClass>()) != NULL)
+
+					structuredClone->fTransferredBuffers.push_back(arrayBuffer->Transfer());
+
+				else 
+
+					xbox_assert(false);
+
+			}
+
+		}
+
+	}
+
+	return structuredClone;
 }
 
 VJSStructuredClone* VJSStructuredClone::RetainCloneForVValueSingle( const XBOX::VValueSingle& inValue)
 {
-	VJSStructuredClone *structuredClone = NULL;
-
-	SNode *valueNode = _VValueSingleToNode( inValue);
-	if (valueNode != NULL)
-	{	
-		valueNode->fNextSibling = NULL;
-		if ((structuredClone = new VJSStructuredClone()) != NULL)
-			structuredClone->fRoot = valueNode;
-		else
-			_FreeNode( valueNode);
-	}
+	VCloneBuffer	data;
+	bool			isOk = _WriteVValueSingle( inValue, &data);
 
-	return structuredClone;
+	return _Create( &data, isOk);
 }
 
 VJSStructuredClone* VJSStructuredClone::RetainCloneForVBagArray( const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays)
 {
-	VJSStructuredClone *structuredClone = NULL;
-
-	SNode *arrayNode = _VBagArrayToNode( inBagArray, inUniqueElementsAreNotArrays);
-	if (arrayNode != NULL)
-	{	
-		arrayNode->fNextSibling = NULL;
-		if ((structuredClone = new VJSStructuredClone()) != NULL)
-			structuredClone->fRoot = arrayNode;
-		else
-			_FreeNode( arrayNode);
-	}
+	VCloneBuffer	data;
+	uLONG			objectCount = 0;
+	bool			isOk = _WriteVBagArray( inBagArray, inUniqueElementsAreNotArrays, &data, &objectCount);
 
-	return structuredClone;
+	return _Create( &data, isOk);
 }
 	
 VJSStructuredClone* VJSStructuredClone::RetainCloneForVValueBag( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays)
 {
-	VJSStructuredClone *structuredClone = NULL;
-
-	SNode *bagNode = _VValueBagToNode( inBag, inUniqueElementsAreNotArrays);
-	if (bagNode != NULL)
-	{
-		bagNode->fNextSibling = NULL;
-		if ((structuredClone = new VJSStructuredClone()) != NULL)
-			structuredClone->fRoot = bagNode;
-		else
-			_FreeNode( bagNode);
-	}
-
-	return structuredClone;
+	VCloneBuffer	data;
+	uLONG			objectCount = 0;
+	bool			isOk = _WriteVValueBag( inBag, inUniqueElementsAreNotArrays, &data, &objectCount);
 
+	return _Create( &data, isOk);
 }
 
 XBOX::VJSValue VJSStructuredClone::MakeValue (XBOX::VJSContext inContext)
 {
 	XBOX::VJSValue	root(inContext);
 
-	if (fRoot == NULL)
+	if (fData.IsEmpty())
 
 		root.SetUndefined();
 
 	else {
 		
-		std::map<SNode *, JS4D::ValueRef>	alreadyCreated;
-		std::list<SEntry>					toDoList;
+		std::vector<JS4D::ValueRef>	alreadyCreated;
+		std::vector<SFrame>			stack;
+		XBOX::VString				name;
+		const uBYTE					*p	= (const uBYTE *) fData.GetDataPtr();
 
-		xbox_assert(fRoot->fType != eNODE_REFERENCE);
-		root = _NodeToValue(inContext, fRoot, &alreadyCreated, &toDoList);
-		while (!toDoList.empty()) {
+		root = _ReadValue(inContext, &p, &alreadyCreated, &stack, &fTransferredBuffers, &fSharedBuffers);
+		while (!stack.empty()) {
 
-			XBOX::VJSObject	object(inContext);
-			SNode			*p;
+			if (!stack.back().fRemainingCount) {
 
-			object.SetObjectRef((JS4D::ObjectRef) toDoList.front().fValueRef);
-			p = toDoList.front().fNode;
-			xbox_assert(p->fType == eNODE_OBJECT || p->fType == eNODE_ARRAY);
+				stack.pop_back();
+				continue;
 
-			p = p->fValue.fFirstChild;
-			while (p != NULL) {
+			}
+			stack.back().fRemainingCount--;
 
-				object.SetProperty(p->fName, _NodeToValue(inContext, p, &alreadyCreated, &toDoList));
-				p = p->fNextSibling;
+			XBOX::VJSObject	object(inContext);
 
-			}
-			
-			toDoList.pop_front();
+			object.SetObjectRef(stack.back().fObjectRef);
+			_ReadString(&p, &name);
+			object.SetProperty(name, _ReadValue(inContext, &p, &alreadyCreated, &stack, &fTransferredBuffers, &fSharedBuffers));
 
 		}
+		xbox_assert(p == (const uBYTE *) fData.GetDataPtr() + fData.GetDataSize());
 
 	} 
 
@@ -216,231 +249,268 @@ XBOX::VJSValue VJSStructuredClone::MakeValue (XBOX::VJSContext inContext)
 
 VJSStructuredClone::VJSStructuredClone ()
 {
-	fRoot = NULL;
 }
 
 VJSStructuredClone::~VJSStructuredClone ()
 {
-	if (fRoot != NULL)
+	for (std::vector<VJSBufferObject *>::iterator i = fTransferredBuffers.begin(); i != fTransferredBuffers.end(); i++)
+
+		XBOX::ReleaseRefCountable<VJSBufferObject>(&*i);
 
-		_FreeNode(fRoot);
+	for (std::vector<jsSharedBuffer *>::iterator i = fSharedBuffers.begin(); i != fSharedBuffers.end(); i++)
+
+		XBOX::ReleaseRefCountable<jsSharedBuffer>(&*i);
 }
 
-// _ValueToNode() allocate memory for the node, then set fType member, and if needed, set fValue. fName and fNextSibling are untouched.
+VJSStructuredClone *VJSStructuredClone::RetainCloneFromData (const void *inData, VSize inSize)
+{
+	xbox_assert(inData != NULL || !inSize);
 
-VJSStructuredClone::SNode *VJSStructuredClone::_ValueToNode (XBOX::VJSValue inValue, std::map<JS4D::ValueRef, SNode *> *ioAlreadyCloned, std::list<SEntry> *ioToDoList)
+	VCloneBuffer	data;
+	bool			isOk;
+
+	isOk = !inSize || data.PutData(0, inData, inSize);
+	if (!isOk)
+
+		XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+	return _Create(&data, isOk);
+}
+
+VJSStructuredClone *VJSStructuredClone::_Create (VCloneBuffer *ioData, bool inIsValid)
 {
-	xbox_assert(ioAlreadyCloned != NULL && ioToDoList != NULL);
+	xbox_assert(ioData != NULL);
+
+	VJSStructuredClone	*structuredClone;
+
+	if (!inIsValid)
+
+		structuredClone = NULL;
+
+	else if ((structuredClone = new VJSStructuredClone()) != NULL) {
 
-	SNode	*p;
+		structuredClone->fData.SetDataPtr(ioData->GetDataPtr(), ioData->GetDataSize(), ioData->GetAllocatedSize());
+		ioData->ForgetData();
 
-	if ((p = new SNode()) == NULL)
+	}
 
-		return NULL;
+	return structuredClone;
+}
+
+bool VJSStructuredClone::_WriteValue (XBOX::VJSValue inValue, VCloneBuffer *ioData, MapOfIndex *ioAlreadyCloned, const MapOfIndex *inTransferred, std::vector<jsSharedBuffer *> *ioSharedBuffers, std::vector<SProperty> *ioStack)
+{
+	xbox_assert(ioData != NULL && ioAlreadyCloned != NULL && inTransferred != NULL && ioSharedBuffers != NULL && ioStack != NULL);
 
 	switch (inValue.GetType()) {
 
 		case JS4D::eTYPE_UNDEFINED: 
 
-			p->fType = eNODE_UNDEFINED;
-			break;
+			return _WriteTag(eTAG_UNDEFINED, ioData);
 
 		case JS4D::eTYPE_NULL:
 
-			p->fType = eNODE_NULL;
-			break;
+			return _WriteTag(eTAG_NULL, ioData);
 
-		case JS4D::eTYPE_BOOLEAN:
+		case JS4D::eTYPE_BOOLEAN: {
 
-			p->fType = eNODE_BOOLEAN;
-			if (!inValue.GetBool(&p->fValue.fBoolean)) {
+			bool	boolean;
 
-				delete p;
-				p = NULL;
+			return inValue.GetBool(&boolean) && _WriteTag(boolean ? eTAG_TRUE : eTAG_FALSE, ioData);
 
-			}
-			break;
+		}
     	
-		case JS4D::eTYPE_NUMBER:
+		case JS4D::eTYPE_NUMBER: {
 
-			p->fType = eNODE_NUMBER;
-			if (!inValue.GetReal(&p->fValue.fNumber)) {
+			Real	number;
 
-				delete p;
-				p = NULL;
+			return inValue.GetReal(&number) && _WriteTag(eTAG_NUMBER, ioData) && _WriteReal(number, ioData);
 
-			}
-			break;
+		}
 
 		case JS4D::eTYPE_STRING: {
 
 			XBOX::VString	string;
 
-			p->fType = eNODE_STRING;
-			if (!inValue.GetString(string) || (p->fValue.fString = new XBOX::VString(string)) == NULL) {
+			return inValue.GetString(string) && _WriteTag(eTAG_STRING, ioData) && _WriteString(string, ioData);
 
-				delete p;
-				p = NULL;
+		}
 
-			}
+		case JS4D::eTYPE_OBJECT:
 
 			break;
 
-		}
+		default:
 
-		case JS4D::eTYPE_OBJECT: {
+			xbox_assert(false);
+			return false;
 
-			std::vector<VJSValue>	emptyArgument;	
-			XBOX::VString			string;
+	}
 
-			if (inValue.IsInstanceOf("Boolean")) {
+	MapOfIndex::const_iterator	j;
 
-				p->fType = eNODE_BOOLEAN_OBJECT;
-				if (!inValue.GetObject().CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
-				|| !inValue.GetBool(&p->fValue.fBoolean)) {
+	if ((j = ioAlreadyCloned->find(inValue.GetValueRef())) != ioAlreadyCloned->end()) 
 
-					delete p;
-					p = NULL;
+		return _WriteTag(eTAG_REFERENCE, ioData) && _WriteLong(j->second, ioData);
 
-				}
+	XBOX::VJSObject			object			= inValue.GetObject();
+	std::vector<VJSValue>	emptyArgument;	
+	XBOX::VString			string;
+	Real					number;
+	bool					boolean;
+	VJSBufferObject			*buffer;
+	VJSArrayBufferObject	*arrayBuffer;
+	jsSharedBuffer			*sharedBuffer;
 
-			} else if (inValue.IsInstanceOf("Number")) {
+	if (inValue.IsInstanceOf("Boolean")) {
 
-				p->fType = eNODE_NUMBER_OBJECT;
-				if (!inValue.GetObject().CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
-				|| !inValue.GetReal(&p->fValue.fNumber)) {
+		return object.CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
+			&& inValue.GetBool(&boolean)
+			&& _WriteTag(eTAG_BOOLEAN_OBJECT, ioData) 
+			&& _WriteTag(boolean ? 1 : 0, ioData);
 
-					delete p;
-					p = NULL;
+	} else if (inValue.IsInstanceOf("Number")) {
 
-				}
+		return object.CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
+			&& inValue.GetReal(&number)
+			&& _WriteTag(eTAG_NUMBER_OBJECT, ioData) 
+			&& _WriteReal(number, ioData);
 
-			} else if (inValue.IsInstanceOf("String")) {
+	} else if (inValue.IsInstanceOf("String")) {
 
-				p->fType = eNODE_STRING_OBJECT;
-				if (!inValue.GetObject().CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
-				|| !inValue.GetString(string)
-				|| (p->fValue.fString = new XBOX::VString(string)) == NULL) {
-			
-					delete p;
-					p = NULL;
+		return object.CallMemberFunction("valueOf", &emptyArgument, &inValue, NULL)
+			&& inValue.GetString(string)
+			&& _WriteTag(eTAG_STRING_OBJECT, ioData) 
+			&& _WriteString(string, ioData);
 
-				}
+	} else if (inValue.IsInstanceOf("Date")) {
 
-			} else if (inValue.IsInstanceOf("Date")) {
+		// getTime() will return the date as milliseconds since 1-01-1970 (UNIX time).
 
-				// getTime() will return the date as milliseconds since 1-01-1970 (UNIX time).
+		return object.CallMemberFunction("getTime", &emptyArgument, &inValue, NULL)
+			&& inValue.GetReal(&number)
+			&& _WriteTag(eTAG_DATE_OBJECT, ioData) 
+			&& _WriteReal(number, ioData);
 
-				p->fType = eNODE_DATE_OBJECT;
-				if (!inValue.GetObject().CallMemberFunction("getTime", &emptyArgument, &inValue, NULL)
-				|| !inValue.GetReal(&p->fValue.fNumber)) {
-			
-					delete p;
-					p = NULL;
+	} else if (inValue.IsInstanceOf("RegExp")) {
 
-				}
+		// toString() will return the "complete" (along with modifier flag(s)) regular expression. 
 
-			} else if (inValue.IsInstanceOf("RegExp")) {
+		return object.CallMemberFunction("toString", &emptyArgument, &inValue, NULL)
+			&& inValue.GetString(string)
+			&& _WriteTag(eTAG_REG_EXP_OBJECT, ioData) 
+			&& _WriteString(string, ioData);
 
-				// toString() will return the "complete" (along with modifier flag(s)) regular expression. 
-			
-				p->fType = eNODE_REG_EXP_OBJECT;
-				if (!inValue.GetObject().CallMemberFunction("toString", &emptyArgument, &inValue, NULL)
-				|| !inValue.GetString(string)
-				|| (p->fValue.fString = new XBOX::VString(string)) == NULL) {
-			
-					delete p;
-					p = NULL;
+	} else if ((buffer = object.GetPrivateData<VJSBufferClass>()) != NULL) {
 
-				}
-				
-			} else if (_IsSerializable(inValue)) {
-				
-				// Serialize object if possible.
-				
-				p->fType = eNODE_SERIALIZABLE;
-				if ((p->fValue.fSerializationData.fConstructorName = new XBOX::VString()) == NULL) {
-					
-					delete p;
-					p = NULL;
-				
-				} else if ((p->fValue.fSerializationData.fJSON = new XBOX::VString()) == NULL) {
-					
-					delete p->fValue.fSerializationData.fConstructorName;
-					delete p;
-					p = NULL;
-				
-				} else {
-					
-					if (!inValue.GetObject().GetPropertyAsString("constructorName", NULL, *p->fValue.fSerializationData.fConstructorName)
-					|| !inValue.GetObject().CallMemberFunction("serialize", &emptyArgument, &inValue, NULL)
-					|| !inValue.GetString(*p->fValue.fSerializationData.fJSON)) {
-					
-						_FreeNode(p);
-						p = NULL;
-						
-					}					
-					
-				}				
-
-			} else if (inValue.IsFunction()) {
-
-				delete p;
-				p = NULL;
+		// Copy content directly (unless transferred), a Buffer met again is a reference.
 
-			} else {
+		(*ioAlreadyCloned)[inValue.GetValueRef()] = (uLONG) ioAlreadyCloned->size();
+		inValue.Protect();
+		if ((j = inTransferred->find(inValue.GetValueRef())) != inTransferred->end())
 
-				// Object or Array.
+			return _WriteTag(eTAG_TRANSFERRED_BUFFER, ioData) && _WriteLong(j->second, ioData);
 
-				std::map<JS4D::ValueRef, SNode *>::iterator	j;	
+		else
 
-				if ((j = ioAlreadyCloned->find(inValue.GetValueRef())) != ioAlreadyCloned->end()) {
+			return _WriteBytes(eTAG_BUFFER, buffer->GetDataPtr(), buffer->GetDataSize(), ioData);
 
-					// Already cloned.
+	} else if ((arrayBuffer = object.GetPrivateData<VJSArrayBufferClass>()) != NULL) {
 
-					xbox_assert(inValue.IsObject());
+		// A "neutered" ArrayBuffer cannot be cloned (DATA_CLONE_ERR).
 
-					p->fType = eNODE_REFERENCE;
-					p->fValue.fReference = j->second;
+		if (arrayBuffer->IsNeutered())
 
-				} else {
+			return false;
 
-					SEntry	entry;
+		(*ioAlreadyCloned)[inValue.GetValueRef()] = (uLONG) ioAlreadyCloned->size();
+		inValue.Protect();
+		if ((j = inTransferred->find(inValue.GetValueRef())) != inTransferred->end())
 
-					p->fType = inValue.IsArray() ? eNODE_ARRAY : eNODE_OBJECT;
-					p->fValue.fFirstChild = NULL;
-			
-					// Mark as already cloned and add to "todo" list.
-			
-					(*ioAlreadyCloned)[inValue.GetValueRef()] = p;
+			return _WriteTag(eTAG_TRANSFERRED_ARRAY_BUFFER, ioData) && _WriteLong(j->second, ioData);
 
-					entry.fValueRef = inValue.GetValueRef();
-					entry.fNode = p;
-					ioToDoList->push_back(entry);
+		else
 
-				}
+			return _WriteBytes(eTAG_ARRAY_BUFFER, arrayBuffer->GetDataPtr(), arrayBuffer->GetDataSize(), ioData);
+
+	} else if ((sharedBuffer = object.GetPrivateData<VJSSharedArrayBuffer>()) != NULL) {
+
+		// Memory is shared, not copied. A SharedArrayBuffer met again is a reference.
+
+		(*ioAlreadyCloned)[inValue.GetValueRef()] = (uLONG) ioAlreadyCloned->size();
+		inValue.Protect();
+		ioSharedBuffers->push_back(XBOX::RetainRefCountable(sharedBuffer));
+
+		return _WriteTag(eTAG_SHARED_ARRAY_BUFFER, ioData) && _WriteLong((uLONG) ioSharedBuffers->size() - 1, ioData);
+
+	} else if (_IsSerializable(inValue)) {
+		
+		// Serialize object if possible.
+
+		XBOX::VString	constructorName;
+		
+		return object.GetPropertyAsString("constructorName", NULL, constructorName)
+			&& object.CallMemberFunction("serialize", &emptyArgument, &inValue, NULL)
+			&& inValue.GetString(string)
+			&& _WriteTag(eTAG_SERIALIZABLE, ioData)
+			&& _WriteString(constructorName, ioData)
+			&& _WriteString(string, ioData);
+
+	} else if (inValue.IsFunction()) {
+
+		return false;
+
+	} else {
+
+		// Object or Array, mark as already cloned then stack its properties.
+
+		(*ioAlreadyCloned)[inValue.GetValueRef()] = (uLONG) ioAlreadyCloned->size();
+		inValue.Protect();
+
+		// Property iterator will also iterate Array object indexes (they are converted into string).
+
+		XBOX::VJSPropertyIterator	i(object);
+		XBOX::VJSObject				prototypeObject	= object.GetPrototype(inValue.GetContext());
+		bool						hasPrototype	= prototypeObject.IsObject();
+		size_t						first			= ioStack->size();
+
+		for ( ; i.IsValid(); ++i) {
+
+			ioStack->push_back(SProperty());
+
+			SProperty	&property	= ioStack->back();
+
+			i.GetPropertyName(property.fName);
 	
+			// Check attribute name: If it is part of prototype, do not clone it.
+
+			if (hasPrototype && prototypeObject.HasProperty(property.fName))
+
+				ioStack->pop_back();
+
+			else {
+
+				XBOX::VJSValue	value	= i.GetProperty();
+
+				value.Protect();
+				property.fValueRef = value.GetValueRef();
+
 			}
-			break;
 
 		}
 
-		default:
+		// First property must be on top of stack to be written first.
 
-			xbox_assert(false);
-			break;
+		std::reverse(ioStack->begin() + first, ioStack->end());
 
-	}
+		return _WriteTag(inValue.IsArray() ? eTAG_ARRAY : eTAG_OBJECT, ioData)
+			&& _WriteLong((uLONG) (ioStack->size() - first), ioData);
 
-	return p;
+	}
 }
 
-VJSStructuredClone::SNode* VJSStructuredClone::_VValueSingleToNode( const XBOX::VValueSingle& inValue)
+bool VJSStructuredClone::_WriteVValueSingle( const XBOX::VValueSingle& inValue, VCloneBuffer *ioData)
 {
-	SNode *valueNode;
-
-	if ((valueNode = new SNode()) == NULL)
-		return NULL;
+	bool isOk;
 
 	switch (inValue.GetValueKind())
 	{
@@ -449,19 +519,13 @@ VJSStructuredClone::SNode* VJSStructuredClone::_VValueSingleToNode( const XBOX::
 		{
 			XBOX::VString val;
 
-			valueNode->fType = eNODE_STRING;
 			inValue.GetString( val);
-			if ((valueNode->fValue.fString = new XBOX::VString( val)) == NULL)
-			{
-				delete valueNode;
-				valueNode = NULL;
-			}
+			isOk = _WriteTag( eTAG_STRING, ioData) && _WriteString( val, ioData);
 			break;
 		}
 
 		case VK_BOOLEAN:
-			valueNode->fType = eNODE_BOOLEAN;
-			valueNode->fValue.fBoolean = (inValue.GetBoolean()) ? true : false;
+			isOk = _WriteTag( inValue.GetBoolean() ? eTAG_TRUE : eTAG_FALSE, ioData);
 			break;
 
 		case VK_BYTE:
@@ -472,82 +536,70 @@ VJSStructuredClone::SNode* VJSStructuredClone::_VValueSingleToNode( const XBOX::
 		case VK_FLOAT:
 		case VK_TIME:
 		case VK_DURATION:
-			valueNode->fType = eNODE_NUMBER;
-			valueNode->fValue.fNumber = inValue.GetReal();
+			isOk = _WriteTag( eTAG_NUMBER, ioData) && _WriteReal( inValue.GetReal(), ioData);
 			break;
 
 		default:
 			xbox_assert( false);
+			isOk = _WriteTag( eTAG_UNDEFINED, ioData);
 			break;
 	}
 
-	return valueNode;
+	return isOk;
 }
 
-VJSStructuredClone::SNode* VJSStructuredClone::_VBagArrayToNode( const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays)
+bool VJSStructuredClone::_WriteVBagArray( const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays, VCloneBuffer *ioData, uLONG *ioObjectCount)
 {
-	SNode *arrayNode;
-	
-	if ((arrayNode = new SNode()) == NULL)
-		return NULL;
-	
-	arrayNode->fType = eNODE_ARRAY;
-	arrayNode->fValue.fFirstChild = NULL;
+	++*ioObjectCount;
+	if (!_WriteTag( eTAG_ARRAY, ioData))
+		return false;
 
-	SNode *curNode = NULL;
+	// Property count is known at the end.
+	VSize countOffset = ioData->GetDataSize();
+	uLONG count = 0;
+	if (!_WriteLong( count, ioData))
+		return false;
 
 	VIndex elementsCount = inBagArray.GetCount();
 	VIndex jsArrayIndex = 0;
-	VString propertyName;
+	VString propertyName, indexName;
 	for (VIndex elementIter = 1 ; elementIter <= elementsCount ; ++elementIter)
 	{
 		const VValueBag *elementBag = inBagArray.GetNth( elementIter);
 		if (elementBag != NULL)
 		{
-			SNode *elemNode = _VValueBagToNode( *elementBag, inUniqueElementsAreNotArrays);
-			if (elemNode != NULL)
-			{
-				elemNode->fName.FromLong( jsArrayIndex++);
-				elemNode->fNextSibling = NULL;
+			uLONG elementIndex = *ioObjectCount;
 
-				if (curNode == NULL)
-					curNode = arrayNode->fValue.fFirstChild = elemNode;
-				else
-					curNode = curNode->fNextSibling = elemNode;
+			indexName.FromLong( jsArrayIndex++);
+			if (!_WriteString( indexName, ioData) || !_WriteVValueBag( *elementBag, inUniqueElementsAreNotArrays, ioData, ioObjectCount))
+				return false;
+			++count;
 
-				if (elementBag->GetAttribute( L"____property_name_in_jsarray", propertyName))
-				{
-					// Append a property which reference the array element
-					elemNode = new SNode();
-					if (elemNode != NULL)
-					{
-						elemNode->fType = eNODE_REFERENCE;
-						elemNode->fName.FromString( propertyName);
-						elemNode->fValue.fReference = curNode;
-						elemNode->fNextSibling = NULL;
-
-						curNode = curNode->fNextSibling = elemNode;
-					}
-				}
+			if (elementBag->GetAttribute( L"____property_name_in_jsarray", propertyName))
+			{
+				// Append a property which reference the array element
+				if (!_WriteString( propertyName, ioData) || !_WriteTag( eTAG_REFERENCE, ioData) || !_WriteLong( elementIndex, ioData))
+					return false;
+				++count;
 			}
 		}
 	}
 		
-	return arrayNode;
+	return ioData->PutData( countOffset, &count, sizeof(count));
 }
 
-VJSStructuredClone::SNode* VJSStructuredClone::_VValueBagToNode( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays)
+bool VJSStructuredClone::_WriteVValueBag( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays, VCloneBuffer *ioData, uLONG *ioObjectCount)
 {
 	// inspired from VValueBag::GetJSONString
-	SNode *bagNode = NULL;
-	
-	if ((bagNode = new SNode()) == NULL)
-		return NULL;
-	
-	bagNode->fType = eNODE_OBJECT;
-	bagNode->fValue.fFirstChild = NULL;
-	
-	SNode *curNode = NULL;
+	++*ioObjectCount;
+	if (!_WriteTag( eTAG_OBJECT, ioData))
+		return false;
+
+	// Property count is known at the end.
+	VSize countOffset = ioData->GetDataSize();
+	uLONG count = 0;
+	if (!_WriteLong( count, ioData))
+		return false;
 
 	// Iterate the attributes
 	VString attName;
@@ -557,31 +609,26 @@ VJSStructuredClone::SNode* VJSStructuredClone::_VValueBagToNode( const XBOX::VVa
 		const VValueSingle *attValue = inBag.GetNthAttribute( attIndex, &attName);
 		if ((attName != L"____objectunic") && (attName != L"____property_name_in_jsarray"))
 		{
-			SNode *attNode = NULL;
-
-			if (attValue != NULL)
-			{
-				attNode = _VValueSingleToNode( *attValue);
-			}
-			else
-			{
-				VString emptyString;
-				attNode = _VValueSingleToNode( emptyString);
-			}
+			VValueBag::StKey CDataBagKey( attName);
+			if (CDataBagKey.Equal( VValueBag::CDataAttributeName()))
+				attName = "__cdata";
 
-			if (attNode != NULL)
+			bool isOk = _WriteString( attName, ioData);
+			if (isOk)
 			{
-				VValueBag::StKey CDataBagKey( attName);
-				if (CDataBagKey.Equal( VValueBag::CDataAttributeName()))
-					attName = "__cdata";
-
-				attNode->fName.FromString( attName);
-				attNode->fNextSibling = NULL;
-				if (curNode == NULL)
-					curNode = bagNode->fValue.fFirstChild = attNode;
+				if (attValue != NULL)
+				{
+					isOk = _WriteVValueSingle( *attValue, ioData);
+				}
 				else
-					curNode = curNode->fNextSibling = attNode;
+				{
+					VString emptyString;
+					isOk = _WriteVValueSingle( emptyString, ioData);
+				}
 			}
+			if (!isOk)
+				return false;
+			++count;
 		}
 	}
 
@@ -593,149 +640,256 @@ VJSStructuredClone::SNode* VJSStructuredClone::_VValueBagToNode( const XBOX::VVa
 		const VBagArray* bagArray = inBag.GetNthElementName( elementNamesIndex, &elementName);
 		if (bagArray != NULL)
 		{
-			SNode *elemNode = NULL;
-
-			if ((bagArray->GetCount() == 1) && inUniqueElementsAreNotArrays)
-			{
-				elemNode = _VValueBagToNode( *bagArray->GetNth(1), inUniqueElementsAreNotArrays);
-			}
-			else if (bagArray->GetNth(1)->GetAttribute("____objectunic") != NULL)
-			{
-				elemNode = _VValueBagToNode( *bagArray->GetNth(1), inUniqueElementsAreNotArrays);
-			}
-			else
-			{
-				elemNode = _VBagArrayToNode( *bagArray, inUniqueElementsAreNotArrays);
-			}
-
-			if (elemNode != NULL)
+			bool isOk = _WriteString( elementName, ioData);
+			if (isOk)
 			{
-				elemNode->fName.FromString( elementName);
-				elemNode->fNextSibling = NULL;
-
-				if (curNode == NULL)
-					curNode = bagNode->fValue.fFirstChild = elemNode;
+				if ((bagArray->GetCount() == 1) && inUniqueElementsAreNotArrays)
+				{
+					isOk = _WriteVValueBag( *bagArray->GetNth(1), inUniqueElementsAreNotArrays, ioData, ioObjectCount);
+				}
+				else if (bagArray->GetNth(1)->GetAttribute("____objectunic") != NULL)
+				{
+					isOk = _WriteVValueBag( *bagArray->GetNth(1), inUniqueElementsAreNotArrays, ioData, ioObjectCount);
+				}
 				else
-					curNode = curNode->fNextSibling = elemNode;
+				{
+					isOk = _WriteVBagArray( *bagArray, inUniqueElementsAreNotArrays, ioData, ioObjectCount);
+				}
 			}
+			if (!isOk)
+				return false;
+			++count;
 		}
 	}
 
-	return bagNode;
+	return ioData->PutData( countOffset, &count, sizeof(count));
+}
+
+bool VJSStructuredClone::_WriteString (const XBOX::VString &inString, VCloneBuffer *ioData)
+{
+	uLONG	length	= inString.GetLength();
+
+	return _WriteLong(length, ioData) 
+		&& ioData->PutDataAmortized(ioData->GetDataSize(), inString.GetCPointer(), length * sizeof(UniChar));
+}
+
+bool VJSStructuredClone::_WriteBytes (uBYTE inTag, const void *inBytes, VSize inSize, VCloneBuffer *ioData)
+{
+	uLONG8	size	= inSize;
+
+	return _WriteTag(inTag, ioData)
+		&& ioData->PutDataAmortized(ioData->GetDataSize(), &size, sizeof(size))
+		&& ioData->PutDataAmortized(ioData->GetDataSize(), inBytes, inSize);
 }
 
-XBOX::VJSValue VJSStructuredClone::_NodeToValue (XBOX::VJSContext inContext, SNode *inNode, std::map<SNode *, JS4D::ValueRef> *ioAlreadyCreated, std::list<SEntry> *ioToDoList)
+XBOX::VJSValue VJSStructuredClone::_ReadValue (XBOX::VJSContext inContext, const uBYTE **ioPosition, std::vector<JS4D::ValueRef> *ioAlreadyCreated, std::vector<SFrame> *ioStack, std::vector<VJSBufferObject *> *ioTransferredBuffers, const std::vector<jsSharedBuffer *> *inSharedBuffers)
 {
-	xbox_assert(ioAlreadyCreated != NULL && ioToDoList != NULL);
+	xbox_assert(ioPosition != NULL && ioAlreadyCreated != NULL && ioStack != NULL && ioTransferredBuffers != NULL && inSharedBuffers != NULL);
 
 	XBOX::VJSValue	value(inContext);
+	XBOX::VString	string;
+	uBYTE			tag		= *(*ioPosition)++;
 
-	switch (inNode->fType) {
+	switch (tag) {
 
-		case eNODE_UNDEFINED:
+		case eTAG_UNDEFINED:
 	
 			value.SetUndefined();
 			break;
 
-		case eNODE_NULL:
+		case eTAG_NULL:
 
 			value.SetNull();
 			break;
 
-		case eNODE_BOOLEAN:
+		case eTAG_FALSE:
+		case eTAG_TRUE:
 				
-			value.SetBool(inNode->fValue.fBoolean);
+			value.SetBool(tag == eTAG_TRUE);
 			break;
 
-		case eNODE_NUMBER:
+		case eTAG_NUMBER:
 
-			value.SetNumber<Real>(inNode->fValue.fNumber);
+			value.SetNumber<Real>(_ReadReal(ioPosition));
 			break;
 
-		case eNODE_STRING:
+		case eTAG_STRING:
 
-			value.SetString(*inNode->fValue.fString);
+			_ReadString(ioPosition, &string);
+			value.SetString(string);
 			break;
 
-		case eNODE_BOOLEAN_OBJECT: 
+		case eTAG_BOOLEAN_OBJECT: 
 
-			value.SetBool(inNode->fValue.fBoolean);
+			value.SetBool(*(*ioPosition)++ != 0);
 			value = _ConstructObject(inContext, "Boolean", value);
 			break;
 
-		case eNODE_NUMBER_OBJECT:
+		case eTAG_NUMBER_OBJECT:
 
-			value.SetNumber(inNode->fValue.fNumber);
+			value.SetNumber(_ReadReal(ioPosition));
 			value = _ConstructObject(inContext, "Number", value);
 			break;
 
-		case eNODE_STRING_OBJECT:
-		case eNODE_REG_EXP_OBJECT: 
+		case eTAG_STRING_OBJECT:
+		case eTAG_REG_EXP_OBJECT: 
 
-			value.SetString(*inNode->fValue.fString);
-			value = _ConstructObject(inContext, inNode->fType == eNODE_STRING_OBJECT ? "String" : "RegExp", value);
+			_ReadString(ioPosition, &string);
+			value.SetString(string);
+			value = _ConstructObject(inContext, tag == eTAG_STRING_OBJECT ? "String" : "RegExp", value);
 			break;
 
-		case eNODE_DATE_OBJECT: 
+		case eTAG_DATE_OBJECT: 
 
-			value.SetNumber(inNode->fValue.fNumber);
+			value.SetNumber(_ReadReal(ioPosition));
 			value = _ConstructObject(inContext, "Date", value);
 			break;
 			
-		case eNODE_SERIALIZABLE:
-			
-			value.SetString(*inNode->fValue.fSerializationData.fJSON);
-			value = _ConstructObject(inContext, *inNode->fValue.fSerializationData.fConstructorName, value);
+		case eTAG_SERIALIZABLE: {
+
+			XBOX::VString	constructorName;
+
+			_ReadString(ioPosition, &constructorName);
+			_ReadString(ioPosition, &string);
+			value.SetString(string);
+			value = _ConstructObject(inContext, constructorName, value);
 			break;
 
-		case eNODE_OBJECT: {
+		}
 
-			XBOX::VJSObject	emptyObject(inContext);
-			SEntry			entry;
+		case eTAG_OBJECT: 
+		case eTAG_ARRAY: {
 
-			emptyObject.MakeEmpty();
-			value.SetValueRef((JS4D::ValueRef) emptyObject.GetObjectRef());
+			SFrame	frame;
 
-			xbox_assert(ioAlreadyCreated->find(inNode->fValue.fReference) == ioAlreadyCreated->end());
+			if (tag == eTAG_OBJECT) {
 
-			(*ioAlreadyCreated)[inNode] = value.GetValueRef();
+				XBOX::VJSObject	emptyObject(inContext);
 
-			entry.fValueRef = value.GetValueRef();
-			entry.fNode = inNode;
-			ioToDoList->push_back(entry);
+				emptyObject.MakeEmpty();
+				frame.fObjectRef = emptyObject.GetObjectRef();
 
+			} else {
+
+				XBOX::VJSArray	emptyArray(inContext);
+
+				frame.fObjectRef = emptyArray.GetObjectRef();
+
+			}
+			frame.fRemainingCount = _ReadLong(ioPosition);
+
+			value.SetValueRef((JS4D::ValueRef) frame.fObjectRef);
+			ioAlreadyCreated->push_back(value.GetValueRef());
+			ioStack->push_back(frame);
 			break;
 
 		}
 
-		case eNODE_ARRAY: {
+		case eTAG_REFERENCE: {
 
-			XBOX::VJSArray	emptyArray(inContext);
-			SEntry			entry;
+			uLONG	index	= _ReadLong(ioPosition);
 
-			value.SetValueRef((JS4D::ValueRef) emptyArray.GetObjectRef());
+			xbox_assert(index < ioAlreadyCreated->size());
 
-			xbox_assert(ioAlreadyCreated->find(inNode->fValue.fReference) == ioAlreadyCreated->end());
+			value.SetValueRef((*ioAlreadyCreated)[index]);
+			break;
 
-			(*ioAlreadyCreated)[inNode] = value.GetValueRef();
+		}
 
-			entry.fValueRef = value.GetValueRef();
-			entry.fNode = inNode;
-			ioToDoList->push_back(entry);
-			
+		case eTAG_BUFFER:
+		case eTAG_ARRAY_BUFFER: {
+
+			uLONG8	size;
+			void	*bytes;
+
+			::memcpy(&size, *ioPosition, sizeof(size));
+			*ioPosition += sizeof(size);
+
+			// Created object takes ownership of the ::malloc()-ed copy.
+
+			if (!size)
+
+				bytes = NULL;
+
+			else if ((bytes = ::malloc((size_t) size)) != NULL)
+
+				::memcpy(bytes, *ioPosition, (size_t) size);
+
+			if (size && bytes == NULL) {
+
+				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+				value.SetUndefined();
+
+			} else {
+
+				XBOX::VJSObject	object	= tag == eTAG_BUFFER 
+										? VJSBufferClass::NewInstance(inContext, (VSize) size, bytes)
+										: VJSArrayBufferClass::NewInstance(inContext, (VSize) size, bytes);
+
+				value.SetValueRef((JS4D::ValueRef) object.GetObjectRef());
+
+			}
+			*ioPosition += size;
+
+			ioAlreadyCreated->push_back(value.GetValueRef());
 			break;
 
 		}
 
-		case eNODE_REFERENCE: {
+		case eTAG_TRANSFERRED_BUFFER:
+		case eTAG_TRANSFERRED_ARRAY_BUFFER: {
+
+			uLONG			index			= _ReadLong(ioPosition);
+			VJSBufferObject	*bufferObject;
+
+			xbox_assert(index < ioTransferredBuffers->size());
+
+			// Memory is given to the created object, a value made again gets a zero length object.
+
+			bufferObject = (*ioTransferredBuffers)[index];
+			(*ioTransferredBuffers)[index] = NULL;
+			if (bufferObject == NULL && (bufferObject = new VJSBufferObject(0, NULL)) == NULL) {
 
-			std::map<SNode *, JS4D::ValueRef>::iterator it;
+				XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+				value.SetUndefined();
 
-			it = ioAlreadyCreated->find(inNode->fValue.fReference);
-			xbox_assert(it != ioAlreadyCreated->end());
+			} else if (tag == eTAG_TRANSFERRED_BUFFER) {
 
-			value.SetValueRef(it->second);
+				value.SetValueRef((JS4D::ValueRef) VJSBufferClass::CreateInstance(inContext, bufferObject).GetObjectRef());
+
+			} else {
+
+				VJSArrayBufferObject	*arrayBuffer;
+
+				if ((arrayBuffer = new VJSArrayBufferObject(bufferObject)) == NULL) {
+
+					XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+					value.SetUndefined();
+
+				} else {
+
+					value.SetValueRef((JS4D::ValueRef) VJSArrayBufferClass::CreateInstance(inContext, arrayBuffer).GetObjectRef());
+					arrayBuffer->Release();
+
+				}
 
+			}
+			XBOX::ReleaseRefCountable<VJSBufferObject>(&bufferObject);
+
+			ioAlreadyCreated->push_back(value.GetValueRef());
+			break;
+
+		}
+
+		case eTAG_SHARED_ARRAY_BUFFER: {
+
+			uLONG	index	= _ReadLong(ioPosition);
+
+			xbox_assert(index < inSharedBuffers->size());
+
+			value.SetValueRef((JS4D::ValueRef) VJSSharedArrayBuffer::CreateInstance(inContext, (*inSharedBuffers)[index]).GetObjectRef());
+
+			ioAlreadyCreated->push_back(value.GetValueRef());
 			break;
 
 		}
@@ -751,6 +905,35 @@ XBOX::VJSValue VJSStructuredClone::_NodeToValue (XBOX::VJSContext inContext, SNo
 	return value;
 }
 
+uLONG VJSStructuredClone::_ReadLong (const uBYTE **ioPosition)
+{
+	uLONG	value;
+
+	::memcpy(&value, *ioPosition, sizeof(value));
+	*ioPosition += sizeof(value);
+
+	return value;
+}
+
+Real VJSStructuredClone::_ReadReal (const uBYTE **ioPosition)
+{
+	Real	value;
+
+	::memcpy(&value, *ioPosition, sizeof(value));
+	*ioPosition += sizeof(value);
+
+	return value;
+}
+
+void VJSStructuredClone::_ReadString (const uBYTE **ioPosition, XBOX::VString *outString)
+{
+	uLONG	length	= _ReadLong(ioPosition);
+
+	outString->Clear();
+	outString->AppendUniChars((const UniChar *) *ioPosition, length);
+	*ioPosition += length * sizeof(UniChar);
+}
+
 bool VJSStructuredClone::_IsSerializable (XBOX::VJSValue inValue)
 {
 	xbox_assert(inValue.IsObject());
@@ -784,73 +967,3 @@ XBOX::VJSValue VJSStructuredClone::_ConstructObject (XBOX::VJSContext inContext,
 
 	return value;
 }
-
-// Tree "under" the root SNode inNode, must be fully correct (all pointers properly set in particular).
-
-void VJSStructuredClone::_FreeNode (SNode *inNode)
-{
-	xbox_assert(inNode != NULL);
-
-	std::list<SNode *>	toFree;
-	SNode				*p, *q;
-
-	p = inNode;
-	for ( ; ; ) {
-		
-		switch (p->fType) {
-
-			case eNODE_UNDEFINED:
-			case eNODE_NULL:
-			case eNODE_BOOLEAN:
-			case eNODE_NUMBER:
-			case eNODE_BOOLEAN_OBJECT:
-			case eNODE_NUMBER_OBJECT:
-			case eNODE_DATE_OBJECT:
-			case eNODE_REFERENCE:
-
-				break;
-
-			case eNODE_STRING:
-			case eNODE_STRING_OBJECT:
-			case eNODE_REG_EXP_OBJECT:
-				
-				delete p->fValue.fString;
-				break;
-
-			case eNODE_SERIALIZABLE:		
-
-				delete p->fValue.fSerializationData.fConstructorName;
-				delete p->fValue.fSerializationData.fJSON;
-				break;
-				
-			case eNODE_OBJECT:
-			case eNODE_ARRAY:
-
-				q = p->fValue.fFirstChild;
-				while (q != NULL) {			
-			
-					toFree.push_front(q);
-					q = q->fNextSibling;
-
-				}
-				break;
-
-			default:	
-
-				xbox_assert(false);
-				break;
-		
-		}				
-
-		delete p;
-		if (!toFree.empty()) {
-
-			p = toFree.front();
-			toFree.pop_front();
-
-		} else
-			
-			break;
-
-	}
-}
\ No newline at end of file
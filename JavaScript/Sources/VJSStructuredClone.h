@@ -21,13 +21,23 @@
 
 BEGIN_TOOLBOX_NAMESPACE
 
+class VJSBufferObject;
+class jsSharedBuffer;
+
 class XTOOLBOX_API VJSStructuredClone : public XBOX::IRefCountable
 {
 public:
 
 	// Return NULL if unable to apply structured clone algorithm (DATA_CLONE_ERR).
+	//
+	// Buffer and ArrayBuffer objects of the optional transfer list have their memory moved to the clone instead of 
+	// being copied, and are "detached" (zero length or neutered). The transfer fails (DATA_CLONE_ERR) if an object is 
+	// listed twice, is not a Buffer or an ArrayBuffer, or if its memory is shared (slice, toBuffer(), toArrayBuffer()).
+	// Nothing is detached if the clone fails. Transferred memory goes to the value made by the first MakeValue().
+	//
+	// SharedArrayBuffer objects are never copied, values made from the clone use the same memory.
 	
-	static VJSStructuredClone	*RetainClone (XBOX::VJSValue inValue);
+	static VJSStructuredClone	*RetainClone (XBOX::VJSValue inValue, const std::vector<XBOX::VJSValue> *inTransferList = NULL);
 
 	static VJSStructuredClone	*RetainCloneForVValueSingle( const XBOX::VValueSingle& inValue);
 
@@ -39,102 +49,127 @@ public:
 	
 	XBOX::VJSValue				MakeValue (XBOX::VJSContext inContext);
 
+	// A clone can be saved (see sessionStorage log) if it holds neither transferred memory nor SharedArrayBuffer. 
+	// Serialized data is in native byte order, it can only be read back on the same architecture. RetainCloneFromData()
+	// copies the data, it doesn't check it: it must come from GetData() of a persistable clone.
+
+	bool						IsPersistable () const	{	return fTransferredBuffers.empty() && fSharedBuffers.empty();	}
+	const void					*GetData () const		{	return fData.GetDataPtr();										}
+	VSize						GetDataSize () const	{	return fData.GetDataSize();										}
+
+	static VJSStructuredClone	*RetainCloneFromData (const void *inData, VSize inSize);
+
 private:
 
+	// A clone is serialized in a single buffer, as a sequence of tagged values. Numbers and lengths are stored in native 
+	// byte order (clones never leave the process), strings as their length in UniChars followed by their UTF-16 data.
+	//
+	// An object or array is stored as its property count, followed by the name and value of each property (depth first).
+	// Objects and arrays are numbered in order of serialization, an object met again is stored as a reference to that 
+	// index, hence cycles are preserved. Buffer and ArrayBuffer contents are copied as raw bytes, SharedArrayBuffer are
+	// retained by the clone.
+	//
+	// Hence writing a clone is one (amortized) allocation and reading it is a linear scan.
+
 	enum {
 
 		// Primitive values.
 
-		eNODE_UNDEFINED,
-		eNODE_NULL,
-		eNODE_BOOLEAN,
-		eNODE_NUMBER,
-		eNODE_STRING,
+		eTAG_UNDEFINED,
+		eTAG_NULL,
+		eTAG_FALSE,
+		eTAG_TRUE,
+		eTAG_NUMBER,				// Real.
+		eTAG_STRING,				// String.
 
 		// Primitive objects.
 
-		eNODE_BOOLEAN_OBJECT,
-		eNODE_NUMBER_OBJECT,
-		eNODE_STRING_OBJECT,
-		eNODE_DATE_OBJECT,
-		eNODE_REG_EXP_OBJECT,		
+		eTAG_BOOLEAN_OBJECT,		// uBYTE.
+		eTAG_NUMBER_OBJECT,			// Real.
+		eTAG_STRING_OBJECT,			// String.
+		eTAG_DATE_OBJECT,			// Real, UNIX time in milliseconds.
+		eTAG_REG_EXP_OBJECT,		// String, "complete" regular expression (with modifier flags).
 		
 		// A serializable object implements a serialize() method to convert its full state into a JSON string.
 		// It also has a constructorName attribute to use to re-create it from the JSON string.
 		
-		eNODE_SERIALIZABLE,
+		eTAG_SERIALIZABLE,			// String (constructor name) and string (JSON).
 
 		// Object or array.
 
-		eNODE_OBJECT,
-		eNODE_ARRAY,
+		eTAG_OBJECT,				// uLONG property count and properties.
+		eTAG_ARRAY,					// uLONG property count and properties.
 
 		// Reference to an object or array.
 
-		eNODE_REFERENCE,
+		eTAG_REFERENCE,				// uLONG index.
 		
 		// Native objects.
 
-//**	TODO: Decide which native C++ objects to clone.
+		eTAG_BUFFER,				// uLONG8 size and bytes.
+		eTAG_ARRAY_BUFFER,			// uLONG8 size and bytes.
+		eTAG_TRANSFERRED_BUFFER,	// uLONG index in fTransferredBuffers.
+		eTAG_TRANSFERRED_ARRAY_BUFFER,	// uLONG index in fTransferredBuffers.
+		eTAG_SHARED_ARRAY_BUFFER,	// uLONG index in fSharedBuffers.
+
+//**	TODO: Decide which other native C++ objects to clone.
 
 	};
 
-	struct SNode {
+	typedef XBOX::VMemoryBuffer<>	VCloneBuffer;
 
-		sLONG					fType;
+	struct SProperty {
 
-		XBOX::VString			fName;				// "Root" node has empty name.
-	
-		union {
-
-			bool				fBoolean;			// Both primitive and object Boolean.
-			
-			Real				fNumber;			// Both primitive and object Number, also store Date in UNIX time.
-			
-			XBOX::VString		*fString;			// Both primitive and object String. also store RegExp.
-			
-			struct {
-				
-				XBOX::VString	*fConstructorName;	// Constructor name to use.
-				XBOX::VString	*fJSON;				// JSON argument (full state of the cloned object).
-				
-			} fSerializationData;
-			
-			struct SNode		*fFirstChild;		// First child of object or Array.
-			
-			struct SNode		*fReference;		// Reference to an object or an Array.
-			
-		} fValue;
-
-		struct SNode			*fNextSibling;		// Not used by "root" node.
+		XBOX::VString			fName;
+		JS4D::ValueRef			fValueRef;
 
 	};
-	
-	struct SEntry {
 
-		JS4D::ValueRef			fValueRef;
-		SNode					*fNode;
+	struct SFrame {
+
+		JS4D::ObjectRef			fObjectRef;
+		uLONG					fRemainingCount;	// Properties still to read.
 
 	};
-	
-	SNode						*fRoot;
+
+	typedef std::map<JS4D::ValueRef, uLONG>		MapOfIndex;
+
+	VCloneBuffer				fData;
+	std::vector<VJSBufferObject *>	fTransferredBuffers;	// Memory of transferred objects, NULL once made into a value.
+	std::vector<jsSharedBuffer *>	fSharedBuffers;			// Retained.
 
 								VJSStructuredClone ();
 	virtual						~VJSStructuredClone ();
 
-	// Create a node from a value, return NULL if erroneous.
+	// Take ownership of serialized data, return NULL if ioData is erroneous or if out of memory.
+
+	static VJSStructuredClone	*_Create (VCloneBuffer *ioData, bool inIsValid);
 
-	static SNode				*_ValueToNode (XBOX::VJSValue inValue, std::map<JS4D::ValueRef, SNode *> *ioAlreadyCloned, std::list<SEntry> *ioToDoList);
+	// Serialize a value. Properties of an object are pushed on ioStack (last to be written on top). Return false if 
+	// unable to clone.
 
-	static SNode				*_VValueSingleToNode( const XBOX::VValueSingle& inValue);
+	static bool					_WriteValue (XBOX::VJSValue inValue, VCloneBuffer *ioData, MapOfIndex *ioAlreadyCloned, const MapOfIndex *inTransferred, std::vector<jsSharedBuffer *> *ioSharedBuffers, std::vector<SProperty> *ioStack);
 
-	static SNode				*_VBagArrayToNode( const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays);
+	static bool					_WriteVValueSingle (const XBOX::VValueSingle& inValue, VCloneBuffer *ioData);
 
-	static SNode				*_VValueBagToNode( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays);
+	static bool					_WriteVBagArray (const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays, VCloneBuffer *ioData, uLONG *ioObjectCount);
 
-	// Create a value from a node.
+	static bool					_WriteVValueBag (const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays, VCloneBuffer *ioData, uLONG *ioObjectCount);
 
-	static XBOX::VJSValue		_NodeToValue (XBOX::VJSContext inContext, SNode *inNode, std::map<SNode *, JS4D::ValueRef> *ioAlreadyCreated, std::list<SEntry> *ioToDoList);
+	static bool					_WriteTag (uBYTE inTag, VCloneBuffer *ioData)							{	return ioData->PutDataAmortized(ioData->GetDataSize(), &inTag, sizeof(inTag));			}
+	static bool					_WriteLong (uLONG inValue, VCloneBuffer *ioData)						{	return ioData->PutDataAmortized(ioData->GetDataSize(), &inValue, sizeof(inValue));		}
+	static bool					_WriteReal (Real inValue, VCloneBuffer *ioData)							{	return ioData->PutDataAmortized(ioData->GetDataSize(), &inValue, sizeof(inValue));		}
+	static bool					_WriteString (const XBOX::VString &inString, VCloneBuffer *ioData);
+	static bool					_WriteBytes (uBYTE inTag, const void *inBytes, VSize inSize, VCloneBuffer *ioData);
+
+	// Create a value from serialized data at *ioPosition, which is advanced. An object or array is created empty and 
+	// pushed on ioStack, its properties are to be read next.
+
+	static XBOX::VJSValue		_ReadValue (XBOX::VJSContext inContext, const uBYTE **ioPosition, std::vector<JS4D::ValueRef> *ioAlreadyCreated, std::vector<SFrame> *ioStack, std::vector<VJSBufferObject *> *ioTransferredBuffers, const std::vector<jsSharedBuffer *> *inSharedBuffers);
+
+	static uLONG				_ReadLong (const uBYTE **ioPosition);
+	static Real					_ReadReal (const uBYTE **ioPosition);
+	static void					_ReadString (const uBYTE **ioPosition, XBOX::VString *outString);
 	
 	// Return true if VJSValue is serializable (has a constructorName attribute and a serialize() method);
 	
@@ -143,10 +178,6 @@ private:
 	// Call a constructor with a single argument, return constructed object or undefined if failed.
 
 	static XBOX::VJSValue		_ConstructObject (XBOX::VJSContext inContext, const XBOX::VString &inConstructorName, XBOX::VJSValue inArgument);
-
-	// Free a node and all its children (but not its sibling(s)).
-
-	static void					_FreeNode (SNode *inNode);
 };
 
 END_TOOLBOX_NAMESPACE
@@ -189,55 +189,26 @@ void VJSSystemWorker::_DoRun ()
 				
 		XBOX::VInterlocked::Increment((sLONG *) &VJSSystemWorker::sNumberRunning);
 
-		uBYTE	*readBuffer;
-
-		readBuffer = (uBYTE *) ::malloc(kBufferSize);
-		xbox_assert(readBuffer != NULL);
+		sLONG	stdOutBufferSize	= kMinimumBufferSize;
+		sLONG	stdErrBufferSize	= kMinimumBufferSize;
 
 		while (!fIsTerminated) {
 
 			bool	hasProducedData;
-			sLONG	size;
 			
 			hasProducedData	= false;
 				
 			fCriticalSection.Lock();		
 
-			// Data on stdout?
+			// Data on stdout? On stderr?
 			
-			if (!fPanicTermination 
-			&& (size = fProcessLauncher.ReadFromChild((char *) readBuffer, kBufferSize - 1)) > 0) {
-
-				fCriticalSection.Unlock();
+			if (!fPanicTermination && _ReadPipe(false, &stdOutBufferSize))
 
-				readBuffer[size] = '\0';
-				fWorker->QueueEvent(VJSSystemWorkerEvent::Create(this, VJSSystemWorkerEvent::eTYPE_STDOUT_DATA, fThis, readBuffer, size));
 				hasProducedData = true;
 
-				readBuffer = (uBYTE *) ::malloc(kBufferSize);
-				xbox_assert(readBuffer != NULL);
-				
-				fCriticalSection.Lock();
-
-			}
-			
-			// Data on stderr?
-
-			if (!fPanicTermination 
-			&& (size = fProcessLauncher.ReadErrorFromChild((char *) readBuffer, kBufferSize - 1)) > 0) {
+			if (!fPanicTermination && _ReadPipe(true, &stdErrBufferSize))
 
-				fCriticalSection.Unlock();
-				
-				readBuffer[size] = '\0';
-				fWorker->QueueEvent(VJSSystemWorkerEvent::Create(this, VJSSystemWorkerEvent::eTYPE_STDERR_DATA, fThis, readBuffer, size));
 				hasProducedData = true;
-
-				readBuffer = (uBYTE *) ::malloc(kBufferSize);
-				xbox_assert(readBuffer != NULL);
-				
-				fCriticalSection.Lock();
-							
-			}
 			
 			// Check for termination condition. 
 			
@@ -267,25 +238,23 @@ void VJSSystemWorker::_DoRun ()
 
 				} else {
 				
-					// No data, sleep then poll later.
+					// No data, wait for it (or for pipes to close at process termination).
+					// Wait is bounded so termination requests are handled.
 				
 					fCriticalSection.Unlock();
-					XBOX::VTask::Sleep(kPollingInterval);
+					fProcessLauncher.WaitForData(kPollingInterval, XBOX::VProcessLauncher::eVPLBothFlags);
 				
 				}
 			
 			} else {
 			
-				// Data has been produced, just yield. Try to flush read buffers. 
+				// Data has been produced, read again right away. 
 				
 				fCriticalSection.Unlock();
-				XBOX::VTask::Yield();
 
 			}
 
 		}
-
-		::free(readBuffer);
 				
 		XBOX::VInterlocked::Decrement((sLONG *) &VJSSystemWorker::sNumberRunning);
 		
@@ -319,6 +288,104 @@ void VJSSystemWorker::_DoRun ()
 	Release();
 }
 
+bool VJSSystemWorker::_ReadPipe (bool inIsStdErr, sLONG *ioBufferSize)
+{
+	xbox_assert(ioBufferSize != NULL);
+
+	uBYTE	*buffer;
+	sLONG	size;
+
+	if ((buffer = (uBYTE *) ::malloc(*ioBufferSize)) == NULL)
+
+		return false;
+
+	// Keep room for terminating zero.
+
+	if (inIsStdErr)
+
+		size = fProcessLauncher.ReadErrorFromChild((char *) buffer, *ioBufferSize - 1);
+
+	else
+
+		size = fProcessLauncher.ReadFromChild((char *) buffer, *ioBufferSize - 1);
+
+	if (size <= 0) {
+
+		::free(buffer);
+		return false;
+
+	}
+
+	if (size == *ioBufferSize - 1) {
+
+		if (*ioBufferSize < kMaximumBufferSize)
+
+			*ioBufferSize <<= 1;
+
+	} else if (size < *ioBufferSize / 4) {
+
+		// Don't keep a big buffer for little data.
+
+		uBYTE	*shrunk;
+
+		if ((shrunk = (uBYTE *) ::realloc(buffer, size + 1)) != NULL)
+
+			buffer = shrunk;
+
+		if (*ioBufferSize > kMinimumBufferSize)
+
+			*ioBufferSize >>= 1;
+
+	}
+
+	fCriticalSection.Unlock();
+
+	buffer[size] = '\0';
+	fWorker->QueueEvent(VJSSystemWorkerEvent::Create(this, inIsStdErr ? VJSSystemWorkerEvent::eTYPE_STDERR_DATA : VJSSystemWorkerEvent::eTYPE_STDOUT_DATA, fThis, buffer, size));
+
+	fCriticalSection.Lock();
+
+	return true;
+}
+
+bool VJSSystemWorker::_WriteToStdIn (const void *inData, VSize inSize)
+{
+	const uBYTE	*p	= (const uBYTE *) inData;
+
+	while (inSize) {
+
+		sLONG	size;
+
+		size = inSize > kWriteSliceSize ? kWriteSliceSize : (sLONG) inSize;
+
+		fCriticalSection.Lock();
+		size = fIsTerminated ? -1 : fProcessLauncher.TryWriteToChild(p, size);
+		fCriticalSection.Unlock();
+
+		if (size < 0) 
+
+			return false;
+
+		else if (!size) {
+
+			// Pipe is full, wait for the external process to read it. Meanwhile, _DoRun() reads its output.
+
+			if (fProcessLauncher.WaitForData(kPollingInterval, XBOX::VProcessLauncher::eVPLStdInFlag) == XBOX::VProcessLauncher::eVPLError)
+
+				return false;
+
+		} else {
+
+			p += size;
+			inSize -= size;
+
+		}
+
+	}
+
+	return true;
+}
+
 sLONG VJSSystemWorker::_RunProc (XBOX::VTask *inVTask)
 {
 	((VJSSystemWorker *) inVTask->GetKindData())->_DoRun();	
@@ -490,8 +557,7 @@ void VJSSystemWorkerClass::_postMessage (XBOX::VJSParms_callStaticFunction &ioPa
 			
 			if ((size = (sLONG) subString.ToBlock(buffer, BUFFER_SIZE, XBOX::VTC_StdLib_char, true, false)) > 0) {
 		
-				inSystemWorker->fCriticalSection.Lock();
-				if ((size = inSystemWorker->fProcessLauncher.WriteToChild(buffer, size)) < 0) {
+				if (!inSystemWorker->_WriteToStdIn(buffer, size)) {
 				
 					totalWritten = 0;
 					break;
@@ -499,8 +565,6 @@ void VJSSystemWorkerClass::_postMessage (XBOX::VJSParms_callStaticFunction &ioPa
 				} else 
 					
 					totalWritten += size;
-
-				inSystemWorker->fCriticalSection.Unlock();
 				
 			}
 			
@@ -508,30 +572,11 @@ void VJSSystemWorkerClass::_postMessage (XBOX::VJSParms_callStaticFunction &ioPa
 
 	} else {
 
-		VSize	totalSize, size;
-		uBYTE	*p;
-		
-		totalSize = bufferObject->GetDataSize();
-		p = (uBYTE *) bufferObject->GetDataPtr();
-		while (totalWritten < totalSize) {
-
-			size = totalSize - totalWritten > SLICE_SIZE ? SLICE_SIZE : totalSize - totalWritten;
-
-			inSystemWorker->fCriticalSection.Lock();
-			if (inSystemWorker->fProcessLauncher.WriteToChild(p, (uLONG) size) < 0) {
-			
-				totalWritten = 0;
-				break;
-				
-			} else {
-					
-				totalWritten += size;
-				p += size;
+		// Written by slices of kWriteSliceSize bytes.
 
-			}
-			inSystemWorker->fCriticalSection.Unlock();
+		if (inSystemWorker->_WriteToStdIn(bufferObject->GetDataPtr(), bufferObject->GetDataSize()))
 
-		}
+			totalWritten = bufferObject->GetDataSize();
 
 	}
 	ioParms.ReturnNumber(totalWritten);
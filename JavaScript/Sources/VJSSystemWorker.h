@@ -41,14 +41,19 @@ private:
 friend class VJSSystemWorkerClass;
 friend class VJSSystemWorkerEvent;
 
-	// Events (data available on stdout or stderr, process termination) are polled at regular interval. 
-	// Default is 100ms. Use a smaller interval to reduce latency.
+	// Data on stdout or stderr is delivered as soon as the pipes are ready. Termination requests and process 
+	// termination (if pipes are kept open) are checked at this interval.
 
 	static const sLONG		kPollingInterval			= 100;
 
-	// Buffer size.
+	// Read buffer size adapts to throughput: it doubles when a read fills the buffer, and halves after small reads.
 
-	static const sLONG		kBufferSize					= 4096;
+	static const sLONG		kMinimumBufferSize			= 4096;
+	static const sLONG		kMaximumBufferSize			= 256 * 1024;
+
+	// postMessage() writes to stdin by slices, waiting for the pipe to be ready.
+
+	static const sLONG		kWriteSliceSize				= 64 * 1024;
 
 	// If a SystemWorker object is to be destroyed, termination is automatically requested. 
 	// Wait for a limited delay only, so program will not be stuck. 
@@ -79,10 +84,20 @@ friend class VJSSystemWorkerEvent;
 					VJSSystemWorker (const XBOX::VString &inCommandLine, const XBOX::VString &inFolderPath, VJSWorker *inWorker);
 	virtual			~VJSSystemWorker ();
 
-	// Will poll the external process for data.
+	// Will wait for data from the external process.
 
 	void			_DoRun();
 
+	// Read from stdout or stderr into a buffer of *ioBufferSize bytes, queue a data event if any. Adapt *ioBufferSize.
+	// fCriticalSection must be locked. Return true if data has been read.
+
+	bool			_ReadPipe (bool inIsStdErr, sLONG *ioBufferSize);
+
+	// Write to stdin without blocking fCriticalSection, so stdout and stderr can still be read meanwhile (a child 
+	// process like "cat" would otherwise deadlock on a full pipe). Return false if failed.
+
+	bool			_WriteToStdIn (const void *inData, VSize inSize);
+
 	// Will call _DoRun().
 
 	static sLONG	_RunProc (XBOX::VTask *inVTask);	
@@ -157,6 +157,7 @@ VJSTimer::VJSTimer (XBOX::VJSObject &inFunctionObject, sLONG inInterval)
 	fID = -1;
 	fInterval = inInterval;
 	fFunctionObject = inFunctionObject.GetObjectRef();	
+	fTimerEvent = NULL;
 }
 
 VJSTimer::~VJSTimer ()
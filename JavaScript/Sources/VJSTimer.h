@@ -28,6 +28,7 @@ class VJSGlobalObject;
 class VJSWorker;
 
 class VJSTimer;
+class VJSTimerEvent;
 
 // All timers (context) of a JavaScript execution.
 
@@ -98,6 +99,7 @@ friend class VJSTimerEvent;
 	sLONG					fID;
 	sLONG					fInterval;
 	XBOX::JS4D::ObjectRef	fFunctionObject;	
+	VJSTimerEvent			*fTimerEvent;		// Event of timer, NULL if discarded.
 							
 				VJSTimer (XBOX::VJSObject &inFunctionObject, sLONG inInterval);
 	virtual		~VJSTimer ();
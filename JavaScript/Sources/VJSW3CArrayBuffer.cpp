@@ -62,6 +62,17 @@ VJSArrayBufferObject::VJSArrayBufferObject ()
 	fBufferObject = NULL;
 }
 
+VJSBufferObject *VJSArrayBufferObject::Transfer ()
+{
+	xbox_assert(IsTransferable());
+
+	VJSBufferObject	*bufferObject	= fBufferObject;
+
+	fBufferObject = NULL;
+
+	return bufferObject;
+}
+
 VJSArrayBufferObject::~VJSArrayBufferObject ()
 {
 	if (fBufferObject != NULL)
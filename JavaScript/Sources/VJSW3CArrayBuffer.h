@@ -46,6 +46,15 @@ public:
 	VSize			GetDataSize () const		{	return fBufferObject != NULL ? fBufferObject->GetDataSize() : 0;	}
 	void			*GetDataPtr () const		{	return fBufferObject != NULL ? fBufferObject->GetDataPtr() : 0;		}
 
+	// An ArrayBuffer can be transferred if its buffer object is not shared (not obtained from a Buffer's toArrayBuffer(), 
+	// neither converted by toBuffer()).
+
+	bool			IsTransferable () const		{	return fBufferObject != NULL && fBufferObject->IsTransferable();	}
+
+	// Neuter the ArrayBuffer and return its buffer object (to be released).
+
+	VJSBufferObject	*Transfer ();
+
 private:
 
 friend class VJSArrayBufferClass;
@@ -21,81 +21,144 @@
 
 USING_TOOLBOX_NAMESPACE
 
-VJSSessionStorageObject::VJSSessionStorageObject ()
+VJSSessionStorageObject::VJSSessionStorageObject (XBOX::VFile *inLogFile)
 {
+	for (sLONG i = 0; i < kNumberShards; i++)
+
+		fShards[i].fLastVersion = 0;
+
+	fUserLockOwner = XBOX::NULL_TASK_ID;
+	fUserLockCount = 0;
+
+	fLogFile = NULL;
+	fLogDesc = NULL;
+	fLogSize = fLiveSize = 0;
+	fIsCompactionNeeded = false;
+
+	if (inLogFile != NULL)
+
+		_OpenLog(inLogFile);
 }
 
 VJSSessionStorageObject::~VJSSessionStorageObject ()
 {
-	xbox_assert(fMutex.GetOwnerTaskID() == XBOX::NULL_TASK_ID);
+	xbox_assert(fUserLockOwner == XBOX::NULL_TASK_ID);
+
+	// Close log first, clearing must not be logged.
+
+	_CloseLog();
 	
 	Clear();
 }
 
 sLONG VJSSessionStorageObject::NumberKeysValues () 
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
+	XBOX::StReadLocker	userLock(&fUserLock);
+	sLONG				count;
+
+	count = 0;
+	for (sLONG i = 0; i < kNumberShards; i++) {
+
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&fShards[i].fMutex);
 
-	return (sLONG) fKeysValues.size();
+		count += (sLONG) fShards[i].fKeysValues.size();
+
+	}
+	return count;
 }
 
 bool VJSSessionStorageObject::HasKey (const XBOX::VString &inKey)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
+	XBOX::StReadLocker						userLock(&fUserLock);
+	SShard									&shard	= _GetShard(inKey);
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&shard.fMutex);
 
-	return fKeysValues.find(inKey) != fKeysValues.end();
+	return shard.fKeysValues.find(inKey) != shard.fKeysValues.end();
 }
 
 void VJSSessionStorageObject::GetKeyValue (const XBOX::VString &inKey, XBOX::VJSValue *outValue)
 {
 	xbox_assert(outValue != NULL);
 
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	SMap::iterator							it;
+	// Retain the clone and make the value outside of the locks, a clone is never modified once created. Making
+	// the value may run constructors which use the storage again, and the read lock is not recursive.
 
-	if ((it = fKeysValues.find(inKey)) == fKeysValues.end())
+	VRefPtr<VJSStructuredClone>	clone;
+
+	{
+		XBOX::StReadLocker						userLock(&fUserLock);
+		SShard									&shard	= _GetShard(inKey);
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&shard.fMutex);
+		SMap::iterator							it;
+
+		if ((it = shard.fKeysValues.find(inKey)) != shard.fKeysValues.end())
+
+			clone = it->second.fValue;
+
+	}
+
+	if (clone.Get() == NULL)
 
 		outValue->SetNull();
 
 	else
 
-		*outValue = it->second->MakeValue(outValue->GetContext());
+		*outValue = clone->MakeValue(outValue->GetContext());
 }
 
 void VJSSessionStorageObject::GetKeyValue (sLONG inIndex, XBOX::VJSValue *outValue)
 {
 	xbox_assert(outValue != NULL);
 
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	
-	if (inIndex < 0 || inIndex >= fKeysValues.size())
+	VRefPtr<VJSStructuredClone>	clone;
 
-		outValue->SetNull();
+	{
+		XBOX::StReadLocker	userLock(&fUserLock);
+		sLONG				i;
 
-	else {
+		// Iterative, slow! Index is over all shards, in shard order.
 
-		SMap::iterator	it;
-		sLONG			i;
+		for (i = 0; inIndex >= 0 && i < kNumberShards && clone.Get() == NULL; i++) {
 
-		// Iterative, slow! 
+			XBOX::StLocker<XBOX::VCriticalSection>	lock(&fShards[i].fMutex);
+			SMap									&map	= fShards[i].fKeysValues;
 
-		for (it = fKeysValues.begin(), i = 0; i < inIndex; it++, i++)
+			if (inIndex >= (sLONG) map.size()) 
 
-			;
+				inIndex -= (sLONG) map.size();
 
-		*outValue = it->second->MakeValue(outValue->GetContext());
+			else {
+
+				SMap::iterator	it;
+
+				for (it = map.begin(); inIndex > 0; it++, inIndex--)
+
+					;
+
+				clone = it->second.fValue;
+
+			}
+
+		}
 
 	}
+
+	if (clone.Get() == NULL)
+
+		outValue->SetNull();
+
+	else
+
+		*outValue = clone->MakeValue(outValue->GetContext());
 }
 
 void VJSSessionStorageObject::SetKeyValue (const XBOX::VString &inKey, const XBOX::VJSValue inValue)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	VJSStructuredClone						*clone;
+	VJSStructuredClone	*clone;
 	
 	if ((clone = VJSStructuredClone::RetainClone(inValue)) != NULL) {
 	
-		fKeysValues[inKey] = VRefPtr<VJSStructuredClone>(clone);
+		_SetClone(inKey, clone);
 		ReleaseRefCountable( &clone);
 
 		//**	TODO: Notify set event.
@@ -103,104 +166,164 @@ void VJSSessionStorageObject::SetKeyValue (const XBOX::VString &inKey, const XBO
 	}
 }
 
-bool VJSSessionStorageObject::RemoveKeyValue (const XBOX::VString &inKey)
+bool VJSSessionStorageObject::SetKeyValueIfVersion (const XBOX::VString &inKey, const XBOX::VJSValue inValue, sLONG8 inExpectedVersion)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	SMap::iterator							it;
+	VJSStructuredClone	*clone;
+	bool				isSet;
+	
+	if ((clone = VJSStructuredClone::RetainClone(inValue)) != NULL) {
 	
-	if ((it = fKeysValues.find(inKey)) != fKeysValues.end()) {
+		isSet = _SetClone(inKey, clone, inExpectedVersion >= 0 ? inExpectedVersion : 0);
+		ReleaseRefCountable( &clone);
+		
+	} else
 
-		fKeysValues.erase(it);
+		isSet = false;
 
-		//** TODO: Notify remove event.	 
+	return isSet;
+}
 
-		return true;
+sLONG8 VJSSessionStorageObject::GetKeyVersion (const XBOX::VString &inKey)
+{
+	XBOX::StReadLocker						userLock(&fUserLock);
+	SShard									&shard	= _GetShard(inKey);
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&shard.fMutex);
+	SMap::iterator							it;
 
-	} else
+	return (it = shard.fKeysValues.find(inKey)) != shard.fKeysValues.end() ? it->second.fVersion : 0;
+}
 
-		return false;
+bool VJSSessionStorageObject::RemoveKeyValue (const XBOX::VString &inKey)
+{
+	//** TODO: Notify remove event.	 
+
+	return _SetClone(inKey, NULL);
 }
 
 void VJSSessionStorageObject::Clear ()
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	SMap::iterator							it;
+	XBOX::StReadLocker	userLock(&fUserLock);
+	sLONG				i;
+
+	for (i = 0; i < kNumberShards; i++)
+
+		fShards[i].fMutex.Lock();
+
+	for (i = 0; i < kNumberShards; i++)
+
+		fShards[i].fKeysValues.clear();
 
-	fKeysValues.clear();
+	{
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&fLogMutex);
+
+		_AppendRecord(eRECORD_CLEAR, XBOX::VString(), 0, NULL);
+		fLiveSize = 0;
+
+	}
+
+	for (i = kNumberShards - 1; i >= 0; i--)
+
+		fShards[i].fMutex.Unlock();
 
 	//** TODO: Notify clear event.
+
+	_CompactLogIfNeeded();
 }
 
 void VJSSessionStorageObject::GetKeys (XBOX::VJSParms_getPropertyNames &ioParms)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	SMap::iterator							it;
+	XBOX::StReadLocker	userLock(&fUserLock);
+
+	for (sLONG i = 0; i < kNumberShards; i++) {
 
-	for (it = fKeysValues.begin(); it != fKeysValues.end(); it++)
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&fShards[i].fMutex);
+		SMap::iterator							it;
 
-		ioParms.AddPropertyName(it->first);
+		for (it = fShards[i].fKeysValues.begin(); it != fShards[i].fKeysValues.end(); it++)
+
+			ioParms.AddPropertyName(it->first);
+
+	}
 }
 
 bool VJSSessionStorageObject::TryLock ()
 {
-	return fMutex.TryToLock();
+	if (fUserLock.TryToLockWrite()) {
+
+		fUserLockOwner = XBOX::VTask::GetCurrentID();
+		fUserLockCount++;
+		return true;
+
+	} else
+
+		return false;
 }
 
 void VJSSessionStorageObject::Lock ()
 {
-	fMutex.Lock();
+	fUserLock.LockWrite();
+	fUserLockOwner = XBOX::VTask::GetCurrentID();
+	fUserLockCount++;
 }
 
 void VJSSessionStorageObject::Unlock ()
 {
-	// If not owner of the mutex, do nothing.
+	// If not owner of the lock, do nothing.
 
-	if (fMutex.GetOwnerTaskID() == XBOX::VTask::GetCurrentID())
+	if (fUserLockOwner == XBOX::VTask::GetCurrentID()) {
+
+		if (--fUserLockCount == 0)
+
+			fUserLockOwner = XBOX::NULL_TASK_ID;
 	
-		fMutex.Unlock();
+		fUserLock.UnlockWrite();
+
+	}
 }
 
 void VJSSessionStorageObject::ForceUnlock ()
 {
-	if (fMutex.GetOwnerTaskID() == XBOX::VTask::GetCurrentID())
+	if (fUserLockOwner == XBOX::VTask::GetCurrentID()) {
+
+		sLONG	count;
+
+		count = fUserLockCount;
+		fUserLockCount = 0;
+		fUserLockOwner = XBOX::NULL_TASK_ID;
 	
-		while (fMutex.GetUseCount())
+		while (count--)
 
-			fMutex.Unlock();
+			fUserLock.UnlockWrite();
+
+	}
 }
 
 void VJSSessionStorageObject::SetKeyVValueSingle( const XBOX::VString &inKey,  const XBOX::VValueSingle& inValue)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-
 	VJSStructuredClone *clone = VJSStructuredClone::RetainCloneForVValueSingle( inValue);
 	if (clone != NULL)
 	{
-		fKeysValues[inKey] = VRefPtr<VJSStructuredClone>(clone);
+		_SetClone( inKey, clone);
 		ReleaseRefCountable( &clone);
 	}
 }
 
 void VJSSessionStorageObject::SetKeyVBagArray( const XBOX::VString &inKey, const XBOX::VBagArray& inBagArray, bool inUniqueElementsAreNotArrays)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-
 	VJSStructuredClone *clone = VJSStructuredClone::RetainCloneForVBagArray( inBagArray, inUniqueElementsAreNotArrays);
 	if (clone != NULL)
 	{
-		fKeysValues[inKey] = VRefPtr<VJSStructuredClone>(clone);
+		_SetClone( inKey, clone);
 		ReleaseRefCountable( &clone);
 	}
 }
 
 void VJSSessionStorageObject::SetKeyVValueBag( const XBOX::VString &inKey, const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-
 	VJSStructuredClone *clone = VJSStructuredClone::RetainCloneForVValueBag( inBag, inUniqueElementsAreNotArrays);
 	if (clone != NULL)
 	{
-		fKeysValues[inKey] = VRefPtr<VJSStructuredClone>(clone);
+		_SetClone( inKey, clone);
 		ReleaseRefCountable( &clone);
 	}
 }
@@ -208,7 +331,7 @@ void VJSSessionStorageObject::SetKeyVValueBag( const XBOX::VString &inKey, const
 void VJSSessionStorageObject::FillWithVValueBag( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays)
 {
 	// inspired from VValueBag::GetJSONString
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
+	// each key is set on its own (shards are locked one at a time)
 
 	// Iterate the attributes
 	VString attName;
@@ -236,7 +359,7 @@ void VJSSessionStorageObject::FillWithVValueBag( const XBOX::VValueBag& inBag, b
 				if (CDataBagKey.Equal( VValueBag::CDataAttributeName()))
 					attName = "__cdata";
 
-				fKeysValues[attName] = VRefPtr<VJSStructuredClone>(clone);
+				_SetClone( attName, clone);
 				ReleaseRefCountable( &clone);
 			}
 		}
@@ -267,13 +390,569 @@ void VJSSessionStorageObject::FillWithVValueBag( const XBOX::VValueBag& inBag, b
 
 			if (clone != NULL)
 			{
-				fKeysValues[elementName] = VRefPtr<VJSStructuredClone>(clone);
+				_SetClone( elementName, clone);
 				ReleaseRefCountable( &clone);
 			}
 		}
 	}
 }
 
+bool VJSSessionStorageObject::IsPersistent ()
+{
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fLogMutex);
+
+	return fLogDesc != NULL;
+}
+
+XBOX::VError VJSSessionStorageObject::CompactLog ()
+{
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fCompactionMutex);
+
+	return _CompactLog();
+}
+
+XBOX::VError VJSSessionStorageObject::_OpenLog (XBOX::VFile *inLogFile)
+{
+	xbox_assert(inLogFile != NULL);
+
+	XBOX::VError	error;
+	XBOX::VFileDesc	*fileDesc;
+
+	if ((error = inLogFile->Open(XBOX::FA_READ_WRITE, &fileDesc, XBOX::FO_CreateIfNotFound)) != XBOX::VE_OK)
+
+		return error;
+
+	// Read the whole log and replay it, this is fine as it is never much bigger than its data (see compaction).
+
+	sLONG8	size, validSize;
+	uBYTE	*data;
+
+	size = fileDesc->GetSize();
+	validSize = 0;
+	data = NULL;
+	if (size > 0) {
+
+		if ((data = (uBYTE *) ::malloc((size_t) size)) == NULL) 
+
+			error = XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+		else if ((error = fileDesc->GetData(data, (VSize) size, 0)) == XBOX::VE_OK) 
+
+			validSize = _Replay(data, size);
+
+		if (data != NULL)
+
+			::free(data);
+
+	}
+
+	// Write header if new or invalid log, drop an invalid tail.
+
+	if (error == XBOX::VE_OK && !validSize) {
+
+		uLONG	header[2]	= { kLogSignature, kLogFormatVersion };
+
+		validSize = sizeof(header);
+		error = fileDesc->PutData(header, sizeof(header), 0);
+
+	}
+	if (error == XBOX::VE_OK && validSize != size)
+
+		error = fileDesc->SetSize(validSize);
+	
+	if (error != XBOX::VE_OK) {
+
+		delete fileDesc;
+		return error;
+
+	}
+
+	{
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&fLogMutex);
+
+		fLogFile = XBOX::RetainRefCountable(inLogFile);
+		fLogDesc = fileDesc;
+		fLogSize = validSize;
+		fIsCompactionNeeded = validSize > kCompactionMinimumSize;
+
+	}
+
+	_CompactLogIfNeeded();
+
+	return XBOX::VE_OK;
+}
+
+void VJSSessionStorageObject::_CloseLog ()
+{
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fLogMutex);
+
+	if (fLogDesc != NULL) {
+
+		fLogDesc->Flush();
+		delete fLogDesc;
+		fLogDesc = NULL;
+
+	}
+	XBOX::ReleaseRefCountable(&fLogFile);
+
+	fLogSize = 0;
+	fIsCompactionNeeded = false;
+}
+
+bool VJSSessionStorageObject::_SetClone (const XBOX::VString &inKey, VJSStructuredClone *inClone, sLONG8 inExpectedVersion)
+{
+	bool	isDone;
+
+	{
+		XBOX::StReadLocker						userLock(&fUserLock);
+		SShard									&shard	= _GetShard(inKey);
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&shard.fMutex);
+		SMap::iterator							it;
+		sLONG8									version;
+
+		it = shard.fKeysValues.find(inKey);
+		version = it != shard.fKeysValues.end() ? it->second.fVersion : 0;
+		if (inExpectedVersion >= 0 && inExpectedVersion != version) 
+
+			isDone = false;
+
+		else if (inClone == NULL) {
+
+			if ((isDone = it != shard.fKeysValues.end())) {
+
+				XBOX::StLocker<XBOX::VCriticalSection>	logLock(&fLogMutex);
+
+				_AppendRecord(eRECORD_REMOVE, inKey, ++shard.fLastVersion, NULL);
+				fLiveSize -= it->second.fRecordSize;
+				shard.fKeysValues.erase(it);
+
+			}
+
+		} else {
+
+			SEntry	&entry	= it != shard.fKeysValues.end() ? it->second : shard.fKeysValues[inKey];
+
+			entry.fValue = inClone;
+			entry.fVersion = ++shard.fLastVersion;
+
+			XBOX::StLocker<XBOX::VCriticalSection>	logLock(&fLogMutex);
+
+			fLiveSize -= entry.fRecordSize;
+			entry.fRecordSize = _AppendRecord(eRECORD_SET, inKey, entry.fVersion, inClone);
+			fLiveSize += entry.fRecordSize;
+
+			isDone = true;
+
+		}
+
+	}
+
+	_CompactLogIfNeeded();
+
+	return isDone;
+}
+
+VSize VJSSessionStorageObject::_AppendRecord (uBYTE inType, const XBOX::VString &inKey, sLONG8 inVersion, VJSStructuredClone *inClone)
+{
+	if (fLogDesc == NULL)
+
+		return 0;
+
+	// A value which can't be saved is logged as a removal, so that an older value isn't restored.
+
+	if (inType == eRECORD_SET && !inClone->IsPersistable()) {
+
+		inType = eRECORD_REMOVE;
+		inClone = NULL;
+
+	}
+
+	XBOX::VMemoryBuffer<>	record;
+	XBOX::VError			error;
+
+	if (!_MakeRecord(inType, inKey, inVersion, inClone, &record)) 
+
+		error = XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+	else 
+
+		error = fLogDesc->PutData(record.GetDataPtr(), record.GetDataSize(), fLogSize);
+
+	if (error != XBOX::VE_OK) {
+
+		// Stop persistence rather than having a log missing changes.
+
+		delete fLogDesc;
+		fLogDesc = NULL;
+		XBOX::ReleaseRefCountable(&fLogFile);
+		return 0;
+
+	}
+
+	fLogSize += record.GetDataSize();
+	if (fLogSize > kCompactionMinimumSize && fLogSize > kCompactionRatio * fLiveSize)
+
+		fIsCompactionNeeded = true;
+	
+	return inType == eRECORD_SET ? record.GetDataSize() : 0;
+}
+
+bool VJSSessionStorageObject::_MakeRecord (uBYTE inType, const XBOX::VString &inKey, sLONG8 inVersion, VJSStructuredClone *inClone, XBOX::VMemoryBuffer<> *outRecord)
+{
+	xbox_assert(outRecord != NULL);
+
+	// Record is: uLONG size of what follows, type, version, key length and UniChars, clone data, and uLONG checksum 
+	// of all after size.
+
+	uLONG	size, keyLength, checksum;
+	VSize	dataSize;
+
+	keyLength = inKey.GetLength();
+	dataSize = inClone != NULL ? inClone->GetDataSize() : 0;
+	size = (uLONG) (sizeof(uBYTE) + sizeof(sLONG8) + sizeof(uLONG) + keyLength * sizeof(UniChar) + dataSize + sizeof(uLONG));
+
+	if (!outRecord->SetSize(sizeof(uLONG) + size))
+
+		return false;
+
+	uBYTE	*p;
+
+	p = (uBYTE *) outRecord->GetDataPtr();
+	::memcpy(p, &size, sizeof(uLONG));
+	p += sizeof(uLONG);
+	*p++ = inType;
+	::memcpy(p, &inVersion, sizeof(sLONG8));
+	p += sizeof(sLONG8);
+	::memcpy(p, &keyLength, sizeof(uLONG));
+	p += sizeof(uLONG);
+	::memcpy(p, inKey.GetCPointer(), keyLength * sizeof(UniChar));
+	p += keyLength * sizeof(UniChar);
+	if (dataSize) {
+
+		::memcpy(p, inClone->GetData(), dataSize);
+		p += dataSize;
+
+	}
+	checksum = _Checksum((const uBYTE *) outRecord->GetDataPtr() + sizeof(uLONG), size - sizeof(uLONG));
+	::memcpy(p, &checksum, sizeof(uLONG));
+
+	return true;
+}
+
+uLONG VJSSessionStorageObject::_Checksum (const uBYTE *inData, VSize inSize)
+{
+	// FNV-1a.
+
+	uLONG	hash;
+
+	for (hash = 2166136261U; inSize; inSize--)
+
+		hash = (hash ^ *inData++) * 16777619U;
+
+	return hash;
+}
+
+sLONG8 VJSSessionStorageObject::_Replay (const uBYTE *inData, sLONG8 inSize)
+{
+	xbox_assert(inData != NULL);
+
+	uLONG	header[2];
+
+	if (inSize < sizeof(header))
+
+		return 0;
+
+	::memcpy(header, inData, sizeof(header));
+	if (header[0] != kLogSignature || header[1] != kLogFormatVersion)
+
+		return 0;
+
+	const uBYTE	*p, *end;
+
+	for (p = inData + sizeof(header), end = inData + inSize; ; ) {
+
+		uLONG		size, keyLength, checksum;
+		const uBYTE	*record;
+
+		// Stop at first truncated or corrupted record.
+
+		if (end - p < sizeof(uLONG))
+
+			break;
+
+		::memcpy(&size, p, sizeof(uLONG));
+		record = p + sizeof(uLONG);
+		if (size < sizeof(uBYTE) + sizeof(sLONG8) + 2 * sizeof(uLONG) || end - record < size)
+
+			break;
+
+		::memcpy(&checksum, record + size - sizeof(uLONG), sizeof(uLONG));
+		if (checksum != _Checksum(record, size - sizeof(uLONG)))
+
+			break;
+
+		uBYTE	type;
+		sLONG8	version;
+
+		type = record[0];
+		::memcpy(&version, record + sizeof(uBYTE), sizeof(sLONG8));
+		::memcpy(&keyLength, record + sizeof(uBYTE) + sizeof(sLONG8), sizeof(uLONG));
+
+		const uBYTE	*key, *data;
+		VSize		dataSize;
+
+		key = record + sizeof(uBYTE) + sizeof(sLONG8) + sizeof(uLONG);
+		data = key + keyLength * sizeof(UniChar);
+		if (keyLength > size || data > record + size - sizeof(uLONG))
+
+			break;
+
+		dataSize = (record + size - sizeof(uLONG)) - data;
+		p = record + size;
+
+		// Storage is being opened, but lock anyway (lock order is respected).
+
+		if (type == eRECORD_CLEAR) {
+
+			for (sLONG i = 0; i < kNumberShards; i++) {
+
+				XBOX::StLocker<XBOX::VCriticalSection>	lock(&fShards[i].fMutex);
+
+				fShards[i].fKeysValues.clear();
+
+			}
+			fLiveSize = 0;
+			continue;
+
+		} else if (type == eRECORD_LAST_VERSION) {
+
+			for (sLONG i = 0; i < kNumberShards; i++) {
+
+				XBOX::StLocker<XBOX::VCriticalSection>	lock(&fShards[i].fMutex);
+
+				if (version > fShards[i].fLastVersion)
+
+					fShards[i].fLastVersion = version;
+
+			}
+			continue;
+
+		}
+
+		XBOX::VString							keyString;
+
+		keyString.AppendUniChars((const UniChar *) key, keyLength);
+
+		SShard									&shard	= _GetShard(keyString);
+		XBOX::StLocker<XBOX::VCriticalSection>	lock(&shard.fMutex);
+		SMap::iterator							it;
+
+		if (version > shard.fLastVersion)
+
+			shard.fLastVersion = version;
+
+		it = shard.fKeysValues.find(keyString);
+		if (it != shard.fKeysValues.end()) {
+
+			fLiveSize -= it->second.fRecordSize;
+			shard.fKeysValues.erase(it);
+
+		}
+
+		if (type == eRECORD_SET) {
+
+			VJSStructuredClone	*clone;
+
+			if ((clone = VJSStructuredClone::RetainCloneFromData(data, dataSize)) != NULL) {
+
+				SEntry	&entry	= shard.fKeysValues[keyString];
+
+				entry.fValue = clone;
+				entry.fVersion = version;
+				entry.fRecordSize = sizeof(uLONG) + size;
+				fLiveSize += entry.fRecordSize;
+
+				XBOX::ReleaseRefCountable(&clone);
+
+			}
+
+		}
+
+	}
+
+	return p - inData;
+}
+
+void VJSSessionStorageObject::_CompactLogIfNeeded ()
+{
+	// Unlocked read, compaction will be done at next change if missed. Changes don't wait for a running compaction.
+
+	if (fIsCompactionNeeded && fCompactionMutex.TryToLock()) {
+
+		_CompactLog();
+		fCompactionMutex.Unlock();
+
+	}
+}
+
+XBOX::VError VJSSessionStorageObject::_CompactLog ()
+{
+	// Copy current values and the highest version issued, along with the log size: the copy is the state the log 
+	// has reached at that point. Values are retained, a clone is never modified once created.
+
+	SEntries		entries;
+	sLONG8			lastVersion, copySize;
+	XBOX::VFile		*logFile;
+	sLONG			i;
+
+	for (i = 0; i < kNumberShards; i++)
+
+		fShards[i].fMutex.Lock();
+
+	fLogMutex.Lock();
+
+	logFile = fLogDesc != NULL ? XBOX::RetainRefCountable(fLogFile) : NULL;
+	copySize = fLogSize;
+	lastVersion = 0;
+	fIsCompactionNeeded = false;
+	for (i = 0; i < kNumberShards && logFile != NULL; i++) {
+
+		SMap::iterator	it;
+
+		if (fShards[i].fLastVersion > lastVersion)
+
+			lastVersion = fShards[i].fLastVersion;
+
+		for (it = fShards[i].fKeysValues.begin(); it != fShards[i].fKeysValues.end(); it++)
+
+			if (it->second.fValue->IsPersistable())
+
+				entries.push_back(SEntries::value_type(it->first, it->second));
+
+	}
+
+	fLogMutex.Unlock();
+
+	for (i = kNumberShards - 1; i >= 0; i--)
+
+		fShards[i].fMutex.Unlock();
+
+	if (logFile == NULL) 
+
+		return XBOX::VE_OK;
+
+	// Write the copy to a new file, then replace log with it. If anything fails, old log is kept. Removals aren't 
+	// written, the highest version is, so that versions aren't issued again after a restart.
+
+	XBOX::VString	path;
+
+	logFile->GetPath(path);
+	path.AppendCString(".compact");
+	XBOX::ReleaseRefCountable(&logFile);
+
+	XBOX::VFile		compactFile(path);
+	XBOX::VFileDesc	*fileDesc;
+	XBOX::VError	error;
+
+	if ((error = compactFile.Open(XBOX::FA_READ_WRITE, &fileDesc, XBOX::FO_CreateIfNotFound | XBOX::FO_Overwrite)) != XBOX::VE_OK)
+
+		return error;
+
+	XBOX::VMemoryBuffer<>	record;
+	uLONG					header[2]	= { kLogSignature, kLogFormatVersion };
+	sLONG8					size;
+
+	size = sizeof(header);
+	if ((error = fileDesc->PutData(header, sizeof(header), 0)) == XBOX::VE_OK) {
+
+		if (!_MakeRecord(eRECORD_LAST_VERSION, XBOX::VString(), lastVersion, NULL, &record))
+
+			error = XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+		else if ((error = fileDesc->PutData(record.GetDataPtr(), record.GetDataSize(), size)) == XBOX::VE_OK)
+
+			size += record.GetDataSize();
+
+	}
+	for (SEntries::iterator it = entries.begin(); it != entries.end() && error == XBOX::VE_OK; it++) {
+
+		if (!_MakeRecord(eRECORD_SET, it->first, it->second.fVersion, it->second.fValue, &record))
+
+			error = XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+		else if ((error = fileDesc->PutData(record.GetDataPtr(), record.GetDataSize(), size)) == XBOX::VE_OK)
+
+			size += record.GetDataSize();
+
+	}
+
+	// Changes have been appended to the log meanwhile: copy them, and replace the log while changes wait. 
+	// Give up if persistence has been stopped meanwhile (failed write).
+
+	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fLogMutex);
+	bool									isStopped;
+
+	isStopped = fLogDesc == NULL;
+	if (error == XBOX::VE_OK && !isStopped && fLogSize > copySize) {
+
+		VSize	appendedSize;
+		void	*appended;
+
+		appendedSize = (VSize) (fLogSize - copySize);
+		if ((appended = ::malloc(appendedSize)) == NULL)
+
+			error = XBOX::vThrowError(XBOX::VE_MEMORY_FULL);
+
+		else {
+
+			if ((error = fLogDesc->GetData(appended, appendedSize, copySize)) == XBOX::VE_OK
+			&& (error = fileDesc->PutData(appended, appendedSize, size)) == XBOX::VE_OK)
+
+				size += appendedSize;
+
+			::free(appended);
+
+		}
+
+	}
+	if (error == XBOX::VE_OK)
+
+		error = fileDesc->Flush();
+
+	delete fileDesc;
+
+	if (error != XBOX::VE_OK || isStopped) {
+
+		compactFile.Delete();
+		return error;
+
+	}
+
+	// Rename is atomic, but may fail if the destination exists on some platforms. Sizes of the records of current 
+	// values are unchanged, so is fLiveSize.
+	
+	delete fLogDesc;
+	fLogDesc = NULL;
+	if ((error = compactFile.Move(fLogFile->GetPath(), NULL, XBOX::FCP_Overwrite)) != XBOX::VE_OK
+	&& fLogFile->Delete() == XBOX::VE_OK)
+
+		error = compactFile.Move(fLogFile->GetPath(), NULL, XBOX::FCP_Overwrite);
+
+	if (error == XBOX::VE_OK
+	&& (error = fLogFile->Open(XBOX::FA_READ_WRITE, &fLogDesc, XBOX::FO_CreateIfNotFound)) == XBOX::VE_OK) 
+
+		fLogSize = size;
+
+	else {
+
+		fLogDesc = NULL;
+		XBOX::ReleaseRefCountable(&fLogFile);
+
+	}
+
+	return error;
+}
+
 const char *VJSStorageClass::kMethodNames[kNumberMethods] = {
 
 	// Order is not important.
@@ -284,6 +963,9 @@ const char *VJSStorageClass::kMethodNames[kNumberMethods] = {
 	"removeItem",
 	"clear",		
 
+	"getItemVersion",
+	"setItemIfVersion",
+
 	"tryLock",
 	"lock",
 	"unlock",
@@ -300,6 +982,9 @@ void VJSStorageClass::GetDefinition (ClassDefinition &outDefinition)
 		{	"removeItem",	js_callStaticFunction<_removeItem>,	JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
 		{	"clear",		js_callStaticFunction<_clear>,		JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
 
+		{	"getItemVersion",	js_callStaticFunction<_getItemVersion>,		JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
+		{	"setItemIfVersion",	js_callStaticFunction<_setItemIfVersion>,	JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
+
 		{	"tryLock",		js_callStaticFunction<_tryLock>,	JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
 		{	"lock",			js_callStaticFunction<_lock>,		JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
 		{	"unlock",		js_callStaticFunction<_unlock>,		JS4D::PropertyAttributeDontDelete |	JS4D::PropertyAttributeDontEnum	},
@@ -534,6 +1219,38 @@ void VJSStorageClass::_clear (VJSParms_callStaticFunction &ioParms, VJSStorageOb
 	inStorageObject->Clear();
 }
 
+void VJSStorageClass::_getItemVersion (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject)
+{
+	xbox_assert(inStorageObject != NULL);
+
+	XBOX::VString	name;
+
+	if (ioParms.CountParams() && ioParms.IsStringParam(1) && ioParms.GetStringParam(1, name))
+
+		ioParms.ReturnNumber((Real) inStorageObject->GetKeyVersion(name));
+
+	else
+
+		ioParms.ReturnNullValue();
+}
+
+void VJSStorageClass::_setItemIfVersion (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject)
+{
+	xbox_assert(inStorageObject != NULL);
+
+	XBOX::VString	name;
+	Real			version;
+
+	if (ioParms.CountParams() >= 3 && ioParms.IsStringParam(1) && ioParms.GetStringParam(1, name)
+	&& ioParms.IsNumberParam(3) && ioParms.GetRealParam(3, &version)) 
+
+		ioParms.ReturnBool(inStorageObject->SetKeyValueIfVersion(name, ioParms.GetParamValue(2), (sLONG8) version));
+
+	else
+
+		ioParms.ReturnBool(false);
+}
+
 void VJSStorageClass::_tryLock (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject)
 {
 	xbox_assert(inStorageObject != NULL);
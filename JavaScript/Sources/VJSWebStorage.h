@@ -45,6 +45,12 @@ public:
 
 	virtual void	GetKeys (XBOX::VJSParms_getPropertyNames &ioParms) = 0;
 
+	// Each change of a key increases its version, zero means "no such key". SetKeyValueIfVersion() sets the value 
+	// only if the key is still at inExpectedVersion (optimistic alternative to lock()/unlock()), return true if set.
+
+	virtual sLONG8	GetKeyVersion (const XBOX::VString &inKey) = 0;
+	virtual bool	SetKeyValueIfVersion (const XBOX::VString &inKey, const XBOX::VJSValue inValue, sLONG8 inExpectedVersion) = 0;
+
 	// Return true if lock is successful. TryLock() and Lock() can be called recursively, Unlock() 
 	// must then be matched. If lock hasn't been acquired, Unlock() will do nothing.
 	
@@ -63,7 +69,10 @@ class XTOOLBOX_API VJSSessionStorageObject : public VJSStorageObject
 {
 public:
 
-					VJSSessionStorageObject ();
+	// If inLogFile isn't NULL, the storage is persistent (see below). Opening the log may fail (error thrown), the
+	// storage is then only in memory, see IsPersistent().
+
+					VJSSessionStorageObject (XBOX::VFile *inLogFile = NULL);
 	virtual			~VJSSessionStorageObject ();
 	
 	virtual sLONG	NumberKeysValues ();
@@ -79,6 +88,9 @@ public:
 
 	virtual void	GetKeys (XBOX::VJSParms_getPropertyNames &ioParms);
 
+	virtual sLONG8	GetKeyVersion (const XBOX::VString &inKey);
+	virtual bool	SetKeyValueIfVersion (const XBOX::VString &inKey, const XBOX::VJSValue inValue, sLONG8 inExpectedVersion);
+
 	virtual bool	TryLock ();
 	virtual void	Lock ();
 	virtual void	Unlock ();
@@ -104,13 +116,110 @@ public:
 			void	SetKeyVValueBag( const XBOX::VString &inKey, const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays = true);
 
 			void	FillWithVValueBag( const XBOX::VValueBag& inBag, bool inUniqueElementsAreNotArrays = true);
+
+			// Persistence (optional). Once the constructor has replayed the log file, every change is appended to it, 
+			// hence the storage survives restarts. The log is compacted (rewritten with current values only) when it gets 
+			// more than kCompactionRatio times bigger than needed, or by CompactLog(). Values holding SharedArrayBuffer(s) 
+			// are not saved. Records are checksummed, a truncated or corrupted tail (crash during a write) is discarded. 
+			// Data is in native byte order, a log file can't be moved to a different architecture. Writes are not flushed
+			// to disk one by one (only at compaction and destruction).
+
+			bool			IsPersistent ();
+			XBOX::VError	CompactLog ();
 	
 private:
 
-	typedef unordered_map_VString<VRefPtr<VJSStructuredClone> >	SMap;
-	
-	XBOX::VCriticalSection	fMutex;
-	SMap					fKeysValues;
+	// Keys are spread over shards by hash, each shard having its own mutex, so that workers accessing different keys
+	// don't serialize. lock()/tryLock() use another mutex: while a task holds it, accesses from other tasks wait for 
+	// its release (same semantic as when everything was behind a single mutex), otherwise they go straight to the shard. 
+	//
+	// Lock order is: compaction, shard(s) in increasing index, then log.
+
+	enum {
+
+		kNumberShards	= 16
+
+	};
+
+	enum {
+
+		eRECORD_SET		= 1,	// Version, key, and structured clone data.
+		eRECORD_REMOVE,			// Version and key.
+		eRECORD_CLEAR,
+		eRECORD_LAST_VERSION,	// Version only: highest version issued when compacted, as removals aren't kept.
+
+	};
+
+	static const uLONG	kLogSignature			= ('J' << 24) | ('S' << 16) | ('S' << 8) | 'L';
+	static const uLONG	kLogFormatVersion		= 1;
+	static const sLONG8	kCompactionMinimumSize	= 1024 * 1024;
+	static const sLONG	kCompactionRatio		= 2;
+
+	struct SEntry {
+
+		VRefPtr<VJSStructuredClone>	fValue;
+		sLONG8						fVersion;
+		VSize						fRecordSize;	// Size of its record in log, zero if not logged.
+
+									SEntry () : fVersion(0), fRecordSize(0)	{}
+
+	};
+
+	typedef unordered_map_VString<SEntry>					SMap;
+	typedef std::vector<std::pair<XBOX::VString, SEntry> >	SEntries;
+
+	typedef struct {
+
+		XBOX::VCriticalSection	fMutex;
+		SMap					fKeysValues;
+		sLONG8					fLastVersion;		// Versions are per shard, a key always goes to the same shard.
+
+	} SShard;
+
+	SShard					fShards[kNumberShards];
+
+	// lock()/tryLock() take fUserLock for writing, all other operations take it for reading for their duration, 
+	// so they are excluded while another task holds the storage locked. Owner and count are only modified by the 
+	// writer, XBOX::NULL_TASK_ID if not locked.
+
+	XBOX::VReaderWriterLock	fUserLock;
+	XBOX::VTaskID			fUserLockOwner;
+	sLONG					fUserLockCount;
+
+	XBOX::VCriticalSection	fCompactionMutex;
+	XBOX::VCriticalSection	fLogMutex;
+	XBOX::VFile				*fLogFile;
+	XBOX::VFileDesc			*fLogDesc;				// NULL if not persistent.
+	sLONG8					fLogSize;
+	sLONG8					fLiveSize;				// Size of records of current values.
+	bool					fIsCompactionNeeded;
+
+	SShard					&_GetShard (const XBOX::VString &inKey)	{	return fShards[inKey.GetHashValue() % kNumberShards];	}
+
+	// Set or remove (inClone is NULL) a key, only if its version is inExpectedVersion (if not negative). Return true
+	// if done. Changes are logged.
+
+	bool					_SetClone (const XBOX::VString &inKey, VJSStructuredClone *inClone, sLONG8 inExpectedVersion = -1);
+
+	// Log a record, fLogMutex must be locked. Return record size, zero if not logged.
+
+	VSize					_AppendRecord (uBYTE inType, const XBOX::VString &inKey, sLONG8 inVersion, VJSStructuredClone *inClone);
+
+	static bool				_MakeRecord (uBYTE inType, const XBOX::VString &inKey, sLONG8 inVersion, VJSStructuredClone *inClone, XBOX::VMemoryBuffer<> *outRecord);
+	static uLONG			_Checksum (const uBYTE *inData, VSize inSize);
+
+	// Apply records of a log file, return size of valid part.
+
+	sLONG8					_Replay (const uBYTE *inData, sLONG8 inSize);
+
+	XBOX::VError			_OpenLog (XBOX::VFile *inLogFile);
+	void					_CloseLog ();
+
+	// Values are copied under the locks, the new log is written without holding any but fCompactionMutex, then the 
+	// records appended meanwhile are copied to it under fLogMutex.
+
+	void					_CompactLogIfNeeded ();
+	XBOX::VError			_CompactLog ();			// fCompactionMutex must be locked.
 };
 
 // Storage interface implementation (see section 4.1 "The Storage interface" of specification).
@@ -127,7 +236,7 @@ private:
 
 	enum {
 		
-		kNumberMethods	= 8,
+		kNumberMethods	= 10,
 
 	};
 
@@ -149,6 +258,11 @@ private:
 	static void			_removeItem (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject);
 	static void			_clear (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject);
 
+	// Add-ons: versioned access, see VJSStorageObject::SetKeyValueIfVersion().
+
+	static void			_getItemVersion (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject);
+	static void			_setItemIfVersion (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject);
+
 	// Add-ons, not in specification.
 
 	static void			_tryLock (VJSParms_callStaticFunction &ioParms, VJSStorageObject *inStorageObject);
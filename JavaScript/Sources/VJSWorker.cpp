@@ -25,14 +25,17 @@
 #include "VJSWorkerProxy.h"
 
 #include "VJSW3CFileSystem.h"
+#include "VJSContextPool.h"
+#include "VJSNetSocket.h"
 
 USING_TOOLBOX_NAMESPACE
 
-XBOX::VCriticalSection	VJSWorker::sMutex;				
+XBOX::VReaderWriterLock	VJSWorker::sMutex;				
 std::list<VJSWorker *>	VJSWorker::sDedicatedWorkers;	
 std::list<VJSWorker *>	VJSWorker::sSharedWorkers;
 std::list<VJSWorker *>	VJSWorker::sRootWorkers;
 IJSWorkerDelegate*		VJSWorker::sDelegate = NULL;
+VJSContextPool*			VJSWorker::sContextPool = NULL;
 
 VJSHasEventMessage::VJSHasEventMessage (VJSWorker *inWorker)
 {
@@ -58,17 +61,23 @@ void VJSWorker::SetDelegate (IJSWorkerDelegate *inDelegate)
 	sDelegate = inDelegate;
 }
 
+void VJSWorker::SetContextPool (VJSContextPool *inContextPool)
+{
+	XBOX::StWriteLocker	lock(&sMutex);
+
+	XBOX::CopyRefCountable<VJSContextPool>(&sContextPool, inContextPool);
+}
+
 VJSWorker::VJSWorker (XBOX::VJSContext &inParentContext, const XBOX::VString &inURL, bool inReUseContext)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
-	XBOX::VError							error;
+	XBOX::StWriteLocker						lock(&sMutex);
 	
 	fStartTime.FromSystemTime();	
 	
 	fInsideWaitCount = 0;
 	fTotalIdleDuration.Clear();
 	
-	fGlobalContext = sDelegate->RetainJSContext(error, inParentContext, inReUseContext);
+	_RetainGlobalContext(inParentContext, inReUseContext);
 	
 	fClosingFlag = fIsLockedWaiting = fExitWaitFlag = false;
 
@@ -99,19 +108,29 @@ VJSWorker *VJSWorker::RetainSharedWorker (XBOX::VJSContext &inParentContext,
 										const XBOX::VString &inURL, const XBOX::VString &inName, bool inReUseContext, 
 										bool *outCreatedWorker)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);	
-	std::list<VJSWorker *>::iterator		i;
-	
-	for (i = sSharedWorkers.begin(); i != sSharedWorkers.end(); i++) {
+	VJSWorker	*worker;
 
-		xbox_assert((*i)->fWorkerType == TYPE_SHARED);
-		if ((*i)->fURL.EqualToString(inURL) && (*i)->fName.EqualToString(inName)) {
+	{
+		XBOX::StReadLocker	lock(&sMutex);	
+
+		if ((worker = _FindSharedWorker(inURL, inName)) != NULL) {
 
-			(*i)->Retain();
+			worker->Retain();
 			*outCreatedWorker = false;
-			return *i;
+			return worker;
 
 		}
+	}
+
+	// Not found, re-check with write lock acquired (race condition avoidance).
+
+	XBOX::StWriteLocker	lock(&sMutex);	
+
+	if ((worker = _FindSharedWorker(inURL, inName)) != NULL) {
+
+		worker->Retain();
+		*outCreatedWorker = false;
+		return worker;
 
 	}
 
@@ -119,6 +138,24 @@ VJSWorker *VJSWorker::RetainSharedWorker (XBOX::VJSContext &inParentContext,
 	return new VJSWorker(inParentContext, inURL, inName, inReUseContext);
 }
 
+// sMutex must be locked (read or write).
+
+VJSWorker *VJSWorker::_FindSharedWorker (const XBOX::VString &inURL, const XBOX::VString &inName)
+{
+	std::list<VJSWorker *>::iterator	i;
+	
+	for (i = sSharedWorkers.begin(); i != sSharedWorkers.end(); i++) {
+
+		xbox_assert((*i)->fWorkerType == TYPE_SHARED);
+		if ((*i)->fURL.EqualToString(inURL) && (*i)->fName.EqualToString(inName)) 
+
+			return *i;
+
+	}
+
+	return NULL;
+}
+
 void VJSWorker::SetMessagePorts (VJSMessagePort *inMessagePort, VJSMessagePort *inErrorPort)
 {
 	xbox_assert(IsDedicatedWorker() && inMessagePort != NULL && inErrorPort != NULL);
@@ -201,7 +238,7 @@ void VJSWorker::Run ()
 		// Script failed to execute (either loading or syntax check failed).
 
 		xbox_assert(fGlobalContext != NULL);
-		sDelegate->ReleaseJSContext(fGlobalContext);
+		_ReleaseGlobalContext();
 
 		Release();
 
@@ -214,10 +251,10 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 	
 	fInsideWaitCount++;
 
-	bool		isEventMatched;
+	bool		isEventMatched, isIdleCollectionTried;
 	XBOX::VTime	endTime, currentTime;
 	
-	isEventMatched = false;		
+	isEventMatched = isIdleCollectionTried = false;		
 	if (inWaitingDuration >= 0) {
 
 		endTime.FromSystemTime();
@@ -231,12 +268,9 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 		
 		// If there is an event to be triggered, process it.
 		
-		if (!fEventQueue.empty() && currentTime >= fEventQueue.front()->GetTriggerTime()) {
+		IJSEvent	*event;
 
-			IJSEvent	*event;
-
-			event = fEventQueue.front();
-			fEventQueue.pop_front();
+		if ((event = fEventQueue.PopReadyEvent(currentTime)) != NULL) {
 
 			// If an event generator and event type has been specified, check if the event to process is matching.
 
@@ -253,12 +287,17 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 				VJSContext	context(fGlobalContext);
 
 				event->Process(context, this);
+				context.GetGlobalObjectPrivateInstance()->NoteEventProcessed();
 
-			} else
+			} else {
 
 				event->Process(inContext, this);
+				inContext.GetGlobalObjectPrivateInstance()->NoteEventProcessed();
+
+			}
 
 			fMutex.Lock();
+			isIdleCollectionTried = false;
 
 			// Event has been matched, exit.
 
@@ -295,7 +334,7 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 		uLONG			waitDuration;
 						
 		isTimedOutWait = true;
-		if (fEventQueue.empty()) {
+		if (fEventQueue.IsEmpty()) {
 
 			if (inWaitingDuration > 0) {
 
@@ -316,7 +355,7 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 
 			XBOX::VTime	minimum;
 
-			minimum = fEventQueue.front()->GetTriggerTime();
+			fEventQueue.GetNextTriggerTime(&minimum);
 			if (inWaitingDuration > 0 && minimum > endTime)
 
 				minimum = endTime;
@@ -326,6 +365,27 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 			
 		}
 
+		// Worker is going idle, this is the best time to collect garbage (instead of during an event). Try only once per 
+		// idle period, collection may have been deferred. Events may have been queued meanwhile, so loop again if done.
+
+		if (!isIdleCollectionTried) {
+
+			bool	isCollected;
+
+			isIdleCollectionTried = true;
+			fMutex.Unlock();
+			isCollected = _IdleGarbageCollect(inContext, isTimedOutWait ? (sLONG) waitDuration : -1);
+			fMutex.Lock();
+
+			if (isCollected) {
+
+				currentTime.FromSystemTime();
+				continue;
+
+			}
+
+		}
+
 		// Wait until it's time to trigger next event.
 		
 		XBOX::VTime	waitStartTime;
@@ -396,6 +456,38 @@ sLONG VJSWorker::WaitFor (XBOX::VJSContext &inContext, sLONG inWaitingDuration,
 		return fClosingFlag ? 1 : 0;
 }
 
+bool VJSWorker::_IdleGarbageCollect (XBOX::VJSContext &inContext, sLONG inIdleDuration)
+{
+	XBOX::VJSGlobalObject	*globalObject;
+
+	if ((JS4D::ContextRef) inContext == NULL) {
+
+		if (fGlobalContext == NULL)
+
+			return false;
+
+		VJSContext	context(fGlobalContext);
+
+		globalObject = context.GetGlobalObjectPrivateInstance();
+		if (!globalObject->IsIdleGarbageCollectionNeeded(inIdleDuration))
+
+			return false;
+
+		globalObject->IdleGarbageCollect();
+
+	} else {
+
+		globalObject = inContext.GetGlobalObjectPrivateInstance();
+		if (!globalObject->IsIdleGarbageCollectionNeeded(inIdleDuration))
+
+			return false;
+
+		globalObject->IdleGarbageCollect();
+
+	}
+	return true;
+}
+
 void VJSWorker::Terminate ()
 {
 	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
@@ -413,20 +505,29 @@ void VJSWorker::Terminate ()
 
 void VJSWorker::TerminateAll ()
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
-	std::list<VJSWorker *>::iterator		i;
+	// Terminate() can release the last reference of a worker, and its destructor takes sMutex for writing 
+	// to remove it from the lists. Read locks can't be upgraded, so the (recursive) write lock must be held here.
+	// Iterate over a copy, as the lists can shrink under our feet.
+
+	XBOX::StWriteLocker		lock(&sMutex);
+	std::list<VJSWorker *>	*lists[3]	= { &sDedicatedWorkers, &sSharedWorkers, &sRootWorkers };
 
-	for (i = sDedicatedWorkers.begin(); i != sDedicatedWorkers.end(); i++)
+	for (sLONG i = 0; i < 3; i++) {
 
-		(*i)->Terminate();
+		std::vector<VJSWorker *>			workers(lists[i]->begin(), lists[i]->end());
+		std::vector<VJSWorker *>::iterator	j;
 
-	for (i = sSharedWorkers.begin(); i != sSharedWorkers.end(); i++)
+		for (j = workers.begin(); j != workers.end(); j++) 
 
-		(*i)->Terminate();
+			if (std::find(lists[i]->begin(), lists[i]->end(), *j) != lists[i]->end())
 
-	for (i = sRootWorkers.begin(); i != sRootWorkers.end(); i++)
+				(*j)->Terminate();
 
-		(*i)->Terminate();
+	}
+
+	// Sockets are closed along with the workers, the read buffers they pooled can be freed.
+
+	VJSNetBufferPool::Clear();
 }
 
 VJSWorker *VJSWorker::RetainWorker (const XBOX::VJSContext &inContext)
@@ -443,7 +544,7 @@ VJSWorker *VJSWorker::RetainWorker (const XBOX::VJSContext &inContext)
 
 	if ((worker = (VJSWorker *) globalObject->GetSpecific((VJSSpecifics::key_type) kSpecificKey)) == NULL) {
 
-		XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
+		XBOX::StWriteLocker	lock(&sMutex);
 	
 		// Re-check with mutex acquired (race condition avoidance).
 
@@ -474,17 +575,10 @@ void VJSWorker::QueueEvent (IJSEvent *inEvent)
 	xbox_assert(inEvent != NULL);
 
 	XBOX::StLocker<XBOX::VCriticalSection>	lock(&fMutex);
-	std::list<IJSEvent *>::iterator			i;
 	
-	for (i = fEventQueue.begin(); i != fEventQueue.end(); i++) 
-
-		// If two events have identical trigger time, first queued will be processed first.
-		
-		if ((*i)->GetTriggerTime() > inEvent->GetTriggerTime())
-
-			break;
+	// If two events have identical trigger time, first queued will be processed first.
 
-	fEventQueue.insert(i, inEvent);	
+	fEventQueue.Insert(inEvent);	
 
 	// Send a VMessage to running VTask, only in studio and for SystemWorker events.
 
@@ -603,24 +697,14 @@ sLONG VJSWorker::GetWaitDuration (VJSParms_callStaticFunction &ioParms)
 
 bool VJSWorker::IsSharedWorkerRunning (const XBOX::VString &inURL, const XBOX::VString &inName)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);	// C++ std is not thread safe.
-	std::list<VJSWorker *>::const_iterator	i;
-	
-	for (i = sSharedWorkers.begin(); i != sSharedWorkers.end(); i++) {
-
-		xbox_assert((*i)->fWorkerType == TYPE_SHARED);
-		if ((*i)->fURL.EqualToString(inURL) && (*i)->fName.EqualToString(inName)) 
-			
-			return true;
+	XBOX::StReadLocker	lock(&sMutex);	// C++ std is not thread safe.
 
-	}
-
-	return false;
+	return _FindSharedWorker(inURL, inName) != NULL;
 }
 
 sLONG VJSWorker::GetNumberRunning (sLONG inType)
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);	// C++ std is not thread safe.
+	XBOX::StReadLocker	lock(&sMutex);	// C++ std is not thread safe.
 
 	if (inType == TYPE_ROOT) 
 
@@ -646,7 +730,7 @@ void VJSWorker::ExecuteHasEventMessage (VJSHasEventMessage *inMessage)
 {
 	if (fWaitForMutex.TryToLock()) {
 	
-		if (!fInsideWaitCount && fEventQueue.size()) {
+		if (!fInsideWaitCount && !fEventQueue.IsEmpty()) {
 
 			XBOX::VJSContext		context((XBOX::JS4D::ContextRef) fRootGlobalContext);
 			XBOX::VJSGlobalObject	*globalObject	= context.GetGlobalObjectPrivateInstance();
@@ -674,14 +758,12 @@ void VJSWorker::ExecuteHasEventMessage (VJSHasEventMessage *inMessage)
 
 VJSWorker::VJSWorker (XBOX::VJSContext &inParentContext, const XBOX::VString &inURL, const XBOX::VString &inName, bool inReUseContext)
 {
-	XBOX::VError	error;
-	
 	fStartTime.FromSystemTime();	
 	
 	fInsideWaitCount = 0;
 	fTotalIdleDuration.Clear();
 	
-	fGlobalContext = sDelegate->RetainJSContext(error, inParentContext, inReUseContext);
+	_RetainGlobalContext(inParentContext, inReUseContext);
 
 	fClosingFlag = fIsLockedWaiting = fExitWaitFlag = false;
 
@@ -719,6 +801,7 @@ VJSWorker::VJSWorker (XBOX::VJSContext &inParentContext, const XBOX::VString &in
 VJSWorker::VJSWorker (const XBOX::VJSContext &inContext) 
 {
 	fGlobalContext = NULL;
+	fContextPool = NULL;
 
 	fStartTime.FromSystemTime();	
 	
@@ -745,11 +828,11 @@ VJSWorker::VJSWorker (const XBOX::VJSContext &inContext)
 
 VJSWorker::~VJSWorker ()
 {
-	XBOX::StLocker<XBOX::VCriticalSection>	lock(&sMutex);
+	XBOX::StWriteLocker	lock(&sMutex);
 
 	// All references should have been released.
 	
-	xbox_assert(fEventQueue.empty());
+	xbox_assert(fEventQueue.IsEmpty());
 
 	// Free VTask and remove worker from dedicated, shared, or root worker list.
 
@@ -878,6 +961,40 @@ void VJSWorker::_PopulateGlobalObject (XBOX::VJSContext inContext)
 		_SetSpecificDestructor);		
 }
 
+// sMutex must be locked (write).
+
+void VJSWorker::_RetainGlobalContext (XBOX::VJSContext &inParentContext, bool inReUseContext)
+{
+	XBOX::VError	error;
+
+	fGlobalContext = NULL;
+	fContextPool = NULL;
+	if (inReUseContext && sContextPool != NULL) {
+
+		// sMutex is held: only take an idle context, neither create one (require() bootstrap) nor wait for one.
+
+		if ((fGlobalContext = sContextPool->TryRetainIdleContext()) != NULL) 
+
+			fContextPool = XBOX::RetainRefCountable<VJSContextPool>(sContextPool);
+
+	}
+	if (fGlobalContext == NULL)
+
+		fGlobalContext = sDelegate->RetainJSContext(error, inParentContext, inReUseContext);
+}
+
+void VJSWorker::_ReleaseGlobalContext ()
+{
+	if (fContextPool != NULL) {
+
+		fContextPool->ReleaseContext(fGlobalContext);
+		XBOX::ReleaseRefCountable<VJSContextPool>(&fContextPool);
+
+	} else
+
+		sDelegate->ReleaseJSContext(fGlobalContext);
+}
+
 void VJSWorker::_SetSpecificDestructor (void *p) 
 {	
 	VJSWorker	*worker;
@@ -1041,7 +1158,7 @@ void VJSWorker::_DoRun ()
 	}
 
 	xbox_assert(fGlobalContext != NULL);
-	sDelegate->ReleaseJSContext(fGlobalContext);
+	_ReleaseGlobalContext();
 
 	Release();	
 }
@@ -1062,12 +1179,13 @@ void VJSWorker::_ReleaseAllReferences ()
 {
 	// Discard all events.
 
-	while (!fEventQueue.empty()) {
+	std::vector<IJSEvent *>				events;
+	std::vector<IJSEvent *>::iterator	j;
 
-		fEventQueue.front()->Discard();
-		fEventQueue.pop_front();
+	fEventQueue.RemoveAll(&events);
+	for (j = events.begin(); j != events.end(); j++)
 
-	}
+		(*j)->Discard();
 	
 	// Release all error ports, requesting termination of "child" dedicated workers if needed.
 
@@ -22,6 +22,7 @@
 #include "VJSClass.h"
 #include "VJSValue.h"
 #include "VJSTimer.h"
+#include "VJSEvent.h"
 
 BEGIN_TOOLBOX_NAMESPACE
 
@@ -29,6 +30,7 @@ class VJSMessagePort;
 class IJSEvent;
 class IJSEventGenerator;
 class VJSLocalFileSystem;
+class VJSContextPool;
 
 class XTOOLBOX_API IJSWorkerDelegate
 {
@@ -80,6 +82,11 @@ public:
 	static void					SetDelegate (IJSWorkerDelegate *inDelegate);
 	static IJSWorkerDelegate	*GetDelegate ()	{	return sDelegate;	}
 
+	// Optional pool serving the contexts of workers created with context reuse. A context is taken from the pool 
+	// only if one is available without waiting, the delegate is asked otherwise. Set to NULL when finishing.
+
+	static void					SetContextPool (VJSContextPool *inContextPool);
+
 	// Create a dedicated worker.
 
 						VJSWorker (XBOX::VJSContext &inParentContext, const XBOX::VString &inURL, bool inReUseContext);
@@ -111,6 +118,7 @@ public:
 	void				Run ();
 
 	// Process events during inWaitingDuration milliseconds. Zero millisecond means "polling": execute all pending events but do not wait. 
+	// Before blocking with no ready event, the worker may run an idle garbage collection (see VJSGlobalObject). 
 	// Use a negative value for no limit in duration. Set inEventGenerator and inEventType to the event generator object and event type to
 	// match. Set inEventGenerator to NULL if no matching is needed. 
 	// Return 1 if terminated (close flag is set), return 0 if waiting time elapsed, or return -1 if an event has been matched.
@@ -182,13 +190,14 @@ private:
 
 	static const uLONG						kSpecificKey	= ('J' << 24) | ('S' << 16) | ('W' << 8) | 'W'; 
 	
-	static XBOX::VCriticalSection			sMutex;
+	static XBOX::VReaderWriterLock			sMutex;					// Read-mostly: lookups take the read lock, creation and destruction the write lock.
 
 	static std::list<VJSWorker *>			sDedicatedWorkers;
 	static std::list<VJSWorker *>			sSharedWorkers;
 	static std::list<VJSWorker *>			sRootWorkers;				// Several "root" workers can run simultaneously.
 
 	static IJSWorkerDelegate				*sDelegate;
+	static VJSContextPool					*sContextPool;
 
 	XBOX::VCriticalSection					fMutex;
 	XBOX::VCriticalSection					fWaitForMutex;				// Prevent two threads from executing a WaitFor(). 
@@ -200,11 +209,12 @@ private:
 	XBOX::JS4D::GlobalContextRef			fRootGlobalContext;			// Only for root worker.
 
 	XBOX::VJSGlobalContext					*fGlobalContext;			// "Child" (dedicated or shared) workers only. 
+	VJSContextPool							*fContextPool;				// Pool fGlobalContext comes from, NULL if from delegate.
 
 	bool									fClosingFlag, fExitWaitFlag;
 	XBOX::VSyncEvent						fSyncEvent;
 	bool									fIsLockedWaiting;			// True if locked waiting on fSyncEvent.
-	std::list<IJSEvent *>					fEventQueue;		
+	VJSEventQueue							fEventQueue;				// Pending events (timers, messages, etc.).
 	std::list< VRefPtr<VJSMessagePort> >	fMessagePorts;				// List of all message ports (any type), they may be "duplicated" elsewhere.
 	VJSTimerContext							fTimerContext;				// All timers.
 	
@@ -240,6 +250,11 @@ private:
 	// Add worker attributes and functions to global object.
 
 	void			_PopulateGlobalObject (XBOX::VJSContext inContext);
+
+	// Get fGlobalContext from the context pool or the delegate, and give it back.
+
+	void			_RetainGlobalContext (XBOX::VJSContext &inParentContext, bool inReUseContext);
+	void			_ReleaseGlobalContext ();
 	static void		_SetSpecificDestructor (void *p);
 
 	// Load and check script, return true if successful. 
@@ -249,8 +264,17 @@ private:
 	// Execute script then service events.
 
 	static sLONG	_RunProc (XBOX::VTask *inVTask);
+
+	// Find a running shared worker, sMutex must be locked.
+
+	static VJSWorker	*_FindSharedWorker (const XBOX::VString &inURL, const XBOX::VString &inName);
 	void			_DoRun ();
 
+	// Called by WaitFor() before blocking, collect garbage if the idle scheduling policy of the global object 
+	// asks for it. inIdleDuration is the expected idle time (negative if unknown). Return true if collected.
+
+	bool			_IdleGarbageCollect (XBOX::VJSContext &inContext, sLONG inIdleDuration);
+
 	// Dedicated workers only.
 	
 	static void		_PostMessage (VJSParms_callStaticFunction &ioParms, VJSGlobalObject *inGlobalObject);
@@ -278,6 +278,8 @@ XBOX::VError XMLHttpRequest::OnReadyStateChange(XBOX::VJSObject inReceiver, cons
 
 XBOX::VError XMLHttpRequest::Send(const XBOX::VString& inData, XBOX::VError* outImplErr)
 {
+    VTRACE_SCOPE("http", "XMLHttpRequest::Send");
+
     if(fReadyState!=OPENED)
         return VE_XHRQ_INVALID_STATE_ERROR;
 
@@ -39,6 +39,8 @@
 #include "Sources/VJSProcess.h"
 
 #include "Sources/VJSWorker.h"
+#include "Sources/VJSScriptCache.h"
+#include "Sources/VJSContextPool.h"
 #include "Sources/VJSWebStorage.h"
 #include "Sources/VJSJSON.h"
 #include "Sources/VJSBuffer.h"
@@ -17,6 +17,9 @@
 #include "VArchiveStream.h"
 #include "VStream.h"
 #include "VErrorContext.h"
+#include "VSystem.h"
+
+#include <zlib.h>
 
 #if VERSIONMAC
 #include <mach-o/loader.h>
@@ -24,7 +27,240 @@
 
 const char* PRESERVE_PARENT_OPTION = "preserve_parent";
 
-VArchiveCatalog::VArchiveCatalog( VFile *inFile, sLONG8 inDataFileSize, sLONG8 inResFileSize, VString &inStoredPath, VString &inFileExtra, uLONG inKind, uLONG inCreator )
+/* archive format version, compressed archives use the second one */
+const uBYTE kArchiveVersion = 4;
+const uBYTE kArchiveVersionCompressed = 5;
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+/*
+	One block of a compressed file.
+	fRaw holds the uncompressed bytes, fPacked the bytes as stored in the archive.
+	When compression doesn't shrink a block, it is stored as is (fMethod is ac_None) and fPacked is not used.
+*/
+class VArchiveBlock : public VObject
+{
+public:
+								VArchiveBlock():fRaw( NULL), fRawCapacity( 0), fRawSize( 0), fPacked( NULL), fPackedCapacity( 0), fPackedSize( 0), fMethod( ac_None), fChecksum( 0), fError( VE_OK)	{}
+	virtual						~VArchiveBlock()									{ delete[] fRaw; delete[] fPacked; }
+
+			char*				ReserveRaw( VSize inSize)							{ _Reserve( &fRaw, &fRawCapacity, inSize); return fRaw; }
+			char*				ReservePacked( VSize inSize)						{ _Reserve( &fPacked, &fPackedCapacity, inSize); return fPacked; }
+
+			void				Compress();
+			void				Decompress();
+
+			char				*fRaw;
+			VSize				fRawCapacity;
+			VSize				fRawSize;
+			char				*fPacked;
+			VSize				fPackedCapacity;
+			VSize				fPackedSize;
+			eArchiveCompression	fMethod;
+			uLONG				fChecksum;	/* crc32 of uncompressed bytes */
+			VError				fError;
+
+private:
+	static	void				_Reserve( char **ioBuffer, VSize *ioCapacity, VSize inSize)
+								{
+									if (*ioCapacity < inSize)
+									{
+										delete[] *ioBuffer;
+										*ioBuffer = new char[inSize];
+										*ioCapacity = (*ioBuffer != NULL) ? inSize : 0;
+									}
+								}
+};
+
+
+void VArchiveBlock::Compress()
+{
+	fError = VE_OK;
+	fChecksum = (uLONG) ::crc32( 0L, (const Bytef*) fRaw, (uInt) fRawSize);
+
+	uLongf packedSize = ::compressBound( (uLong) fRawSize);
+	if (ReservePacked( packedSize) == NULL)
+	{
+		fError = VE_MEMORY_FULL;
+	}
+	else if (::compress2( (Bytef*) fPacked, &packedSize, (const Bytef*) fRaw, (uLong) fRawSize, Z_DEFAULT_COMPRESSION) != Z_OK)
+	{
+		fError = VE_STREAM_COMPRESSION_FAILED;
+	}
+	else if (packedSize < fRawSize)
+	{
+		fMethod = ac_Deflate;
+		fPackedSize = packedSize;
+	}
+	else
+	{
+		// already compressed data: store it as is
+		fMethod = ac_None;
+		fPackedSize = fRawSize;
+	}
+}
+
+
+void VArchiveBlock::Decompress()
+{
+	fError = VE_OK;
+	if (fMethod == ac_Deflate)
+	{
+		uLongf rawSize = (uLongf) fRawSize;
+		if (ReserveRaw( fRawSize) == NULL)
+			fError = VE_MEMORY_FULL;
+		else if ( (::uncompress( (Bytef*) fRaw, &rawSize, (const Bytef*) fPacked, (uLong) fPackedSize) != Z_OK) || (rawSize != fRawSize) )
+			fError = VE_STREAM_BAD_CHECKSUM;
+	}
+	else if (fMethod != ac_None)
+	{
+		fError = VE_STREAM_BAD_VERSION;
+	}
+
+	if ( (fError == VE_OK) && ((uLONG) ::crc32( 0L, (const Bytef*) fRaw, (uInt) fRawSize) != fChecksum) )
+		fError = VE_STREAM_BAD_CHECKSUM;
+}
+
+
+/*
+	Set of tasks compressing or decompressing a batch of blocks.
+	The calling task takes part in the work and Process() returns once every block of the batch is done,
+	so that the caller can write the blocks in their original order.
+*/
+class VArchiveBlockWorkers : public VObject
+{
+public:
+								VArchiveBlockWorkers( sLONG inWorkerCount, bool inCompress);
+	virtual						~VArchiveBlockWorkers();
+
+			// number of blocks worth submitting to one Process() call
+			sLONG				GetBatchSize() const								{ return fWorkerCount * 2; }
+
+			void				Process( VArchiveBlock **inBlocks, sLONG inCount);
+
+private:
+	static	sLONG				_TaskProc( VTask *inTask);
+			void				_ProcessBlocks();
+
+			std::vector<VTask*>	fTasks;
+			sLONG				fWorkerCount;
+			bool				fCompress;
+			sLONG				fStopping;		/* read by the tasks, accessed with VInterlocked */
+			VSemaphore			fWorkAvailable;
+			VSyncEvent			fBatchDone;
+			VCriticalSection	fLock;			/* protects fBlocks, fCount and fNext */
+			VArchiveBlock		**fBlocks;
+			sLONG				fCount;
+			sLONG				fNext;
+			sLONG				fRemaining;
+};
+
+
+VArchiveBlockWorkers::VArchiveBlockWorkers( sLONG inWorkerCount, bool inCompress)
+: fWorkerCount( (inWorkerCount > 0) ? inWorkerCount : Max<sLONG>( VSystem::GetNumberOfProcessors(), 1))
+, fCompress( inCompress)
+, fStopping( 0)
+, fWorkAvailable( 0, Max<sLONG>( fWorkerCount - 1, 1))
+, fBlocks( NULL)
+, fCount( 0)
+, fNext( 0)
+, fRemaining( 0)
+{
+	// the calling task is one of the workers
+	for( sLONG i = 1 ; i < fWorkerCount ; ++i)
+	{
+		VTask *task = new VTask( this, 0, eTaskStylePreemptive, _TaskProc);
+		if (task != NULL)
+		{
+			task->SetKindData( (sLONG_PTR) this);
+			task->SetName( CVSTR( "Archive block worker"));
+			if (task->Run())
+				fTasks.push_back( task);
+			else
+				task->Release();
+		}
+	}
+}
+
+
+VArchiveBlockWorkers::~VArchiveBlockWorkers()
+{
+	VInterlocked::Exchange( &fStopping, 1);
+	for( std::vector<VTask*>::iterator i = fTasks.begin() ; i != fTasks.end() ; ++i)
+	{
+		(*i)->Kill();
+		fWorkAvailable.Unlock();
+	}
+	for( std::vector<VTask*>::iterator i = fTasks.begin() ; i != fTasks.end() ; ++i)
+	{
+		(*i)->WaitForDeath( 10000);
+		(*i)->Release();
+	}
+}
+
+
+void VArchiveBlockWorkers::Process( VArchiveBlock **inBlocks, sLONG inCount)
+{
+	if (inCount <= 0)
+		return;
+
+	fLock.Lock();
+	fBlocks = inBlocks;
+	fCount = inCount;
+	fNext = 0;
+	fRemaining = inCount;
+	fBatchDone.Reset();
+	fLock.Unlock();
+
+	// the calling task takes a block too: wake no more tasks than there are other blocks,
+	// so that tokens don't pile up when the caller drains the batch alone
+	sLONG wakeCount = Min<sLONG>( (sLONG) fTasks.size(), inCount - 1);
+	for( sLONG i = 0 ; i < wakeCount ; ++i)
+		fWorkAvailable.Unlock();
+
+	_ProcessBlocks();
+
+	fBatchDone.Lock();
+}
+
+
+void VArchiveBlockWorkers::_ProcessBlocks()
+{
+	for(;;)
+	{
+		VArchiveBlock *block = NULL;
+		fLock.Lock();
+		if (fNext < fCount)
+			block = fBlocks[fNext++];
+		fLock.Unlock();
+
+		if (block == NULL)
+			break;
+
+		if (fCompress)
+			block->Compress();
+		else
+			block->Decompress();
+
+		if (VInterlocked::Decrement( &fRemaining) == 0)
+			fBatchDone.Unlock();
+	}
+}
+
+
+sLONG VArchiveBlockWorkers::_TaskProc( VTask *inTask)
+{
+	VArchiveBlockWorkers *workers = (VArchiveBlockWorkers*) inTask->GetKindData();
+	while( workers->fWorkAvailable.Lock() && (VInterlocked::AtomicGet( &workers->fStopping) == 0))
+		workers->_ProcessBlocks();
+	return 0;
+}
+
+END_TOOLBOX_NAMESPACE
+
+
+VArchiveCatalog::VArchiveCatalog( VFile *inFile, sLONG8 inDataFileSize, sLONG8 inResFileSize, VString &inStoredPath, VString &inFileExtra, uLONG inKind, uLONG inCreator, eArchiveCompression inCompression, uLONG inBlockSize )
 {
 	inFile->Retain();
 	fFile = inFile;
@@ -35,6 +271,8 @@ VArchiveCatalog::VArchiveCatalog( VFile *inFile, sLONG8 inDataFileSize, sLONG8 i
 	fExtract = true;
 	fKind = inKind;
 	fCreator = inCreator;
+	fCompression = inCompression;
+	fBlockSize = inBlockSize;
 }
 
 VArchiveCatalog::~VArchiveCatalog()
@@ -87,12 +325,26 @@ uLONG VArchiveCatalog::GetCreator()
 	return fCreator;
 }
 
+eArchiveCompression VArchiveCatalog::GetCompression()
+{
+	return fCompression;
+}
+
+uLONG VArchiveCatalog::GetBlockSize()
+{
+	return fBlockSize;
+}
+
 VArchiveStream::VArchiveStream()
 {
 	fDestinationFile = NULL;
 	fStream = NULL;
 	fCallBack = NULL;
 	fUniqueFilesCollection = NULL;
+	fCompression = ac_None;
+	fWorkerCount = 0;
+	fBlockSize = 1024*1024;
+	fWorkers = NULL;
 
 	fUniqueFilesCollection = new SetOfVFilePath();
 }
@@ -253,8 +505,19 @@ void VArchiveStream::SetProgressCallBack( CB_VArchiveStream inProgressCallBack )
 	fCallBack = inProgressCallBack;
 }
 
+void VArchiveStream::SetCompression( eArchiveCompression inCompression, sLONG inWorkerCount, uLONG inBlockSize )
+{
+	xbox_assert( inBlockSize > 0 );
+	fCompression = inCompression;
+	fWorkerCount = inWorkerCount;
+	fBlockSize = (inBlockSize > 0) ? inBlockSize : 1024*1024;
+}
+
 VError VArchiveStream::_WriteFile( const VFileDesc* inFileDesc, char* buffToUse, VSize buffSize, uLONG8 &ioPartialByteCount, uLONG8 inTotalByteCount )
 {
+	if ( fWorkers != NULL )
+		return _WriteCompressedFile( inFileDesc, ioPartialByteCount, inTotalByteCount );
+
 	bool userAbort = false;
 	VSize byteCount = 0;
 	sLONG8 offset = 0;
@@ -288,6 +551,71 @@ VError VArchiveStream::_WriteFile( const VFileDesc* inFileDesc, char* buffToUse,
 	return result;
 }
 
+/*
+	compressed layout: uncompressed file size, then for each block:
+	raw size, stored size, compression method, crc32 of raw data, stored data
+*/
+VError VArchiveStream::_WriteCompressedFile( const VFileDesc* inFileDesc, uLONG8 &ioPartialByteCount, uLONG8 inTotalByteCount )
+{
+	bool userAbort = false;
+	sLONG8 offset = 0;
+	sLONG8 fileSize = inFileDesc->GetSize();
+	VError result = fStream->PutLong8(fileSize);
+
+	std::vector<VArchiveBlock*> blocks( fWorkers->GetBatchSize(), NULL );
+	for( std::vector<VArchiveBlock*>::iterator i = blocks.begin() ; i != blocks.end() ; ++i )
+		*i = new VArchiveBlock;
+
+	while ( offset < fileSize && result == VE_OK )
+	{
+		/* read a batch of blocks sequentially */
+		sLONG count = 0;
+		for( ; count < (sLONG) blocks.size() && offset < fileSize && result == VE_OK ; ++count )
+		{
+			VArchiveBlock *block = blocks[count];
+			block->fRawSize = (VSize) Min<sLONG8>( fileSize - offset, (sLONG8) fBlockSize );
+			if ( block->ReserveRaw( fBlockSize ) == NULL )
+				result = VE_MEMORY_FULL;
+			else
+				result = inFileDesc->GetData( block->fRaw, block->fRawSize, offset );
+			offset += block->fRawSize;
+		}
+
+		if ( result == VE_OK )
+			fWorkers->Process( &blocks[0], count );
+
+		/* and write them back in order */
+		for( sLONG i = 0 ; i < count && result == VE_OK ; ++i )
+		{
+			VArchiveBlock *block = blocks[i];
+			result = block->fError;
+			if ( result == VE_OK )
+				result = fStream->PutLong( (uLONG) block->fRawSize );
+			if ( result == VE_OK )
+				result = fStream->PutLong( (uLONG) block->fPackedSize );
+			if ( result == VE_OK )
+				result = fStream->PutByte( (uBYTE) block->fMethod );
+			if ( result == VE_OK )
+				result = fStream->PutLong( block->fChecksum );
+			if ( result == VE_OK )
+				result = fStream->PutData( (block->fMethod == ac_None) ? block->fRaw : block->fPacked, block->fPackedSize );
+			ioPartialByteCount += block->fRawSize;
+
+			if ( fCallBack )
+			{
+				fCallBack(CB_UpdateProgress,ioPartialByteCount,inTotalByteCount,userAbort);
+				if ( userAbort )
+					result = VE_STREAM_USER_ABORTED;
+			}
+		}
+	}
+
+	for( std::vector<VArchiveBlock*>::iterator i = blocks.begin() ; i != blocks.end() ; ++i )
+		delete *i;
+
+	return result;
+}
+
 VError VArchiveStream::_AddFile(VFile& inFile,const VFilePath& inSourceFolder,const VString& inExtraInfo)
 {
 	XBOX::VError result = VE_FILE_NOT_FOUND;
@@ -424,6 +752,12 @@ VError VArchiveStream::_WriteCatalog( const VFile* inFile, const XBOX::VFilePath
 			inFile->MAC_GetCreator( &osType );
 			result = fStream->PutLong( osType );
 	#endif
+			if ( fCompression != ac_None )
+			{
+				result = fStream->PutLong( (uLONG) fCompression );
+				if ( result == VE_OK )
+					result = fStream->PutLong( fBlockSize );
+			}
 		}
 	}
 	return result;
@@ -471,7 +805,7 @@ VError VArchiveStream::Proceed()
 			/* put the backup file signature */
 			fStream->PutLong('FPBK');
 			/* put the current version of the file */
-			fStream->PutByte(4);
+			fStream->PutByte( (fCompression != ac_None) ? kArchiveVersionCompressed : kArchiveVersion );
 			/* put the number of file stored in this archive */
 			sLONG8 storedObjCount = (sLONG8)fFileList.size();
 			storedObjCount += (sLONG8)fFileDescList.size();
@@ -509,6 +843,9 @@ VError VArchiveStream::Proceed()
 			VSize bufferSize = 1024*1024;
 			char *buffer = new char[bufferSize];
 
+			if ( fCompression != ac_None )
+				fWorkers = new VArchiveBlockWorkers( fWorkerCount, true );
+
 			/* writing file descriptor that we have to the archive files */
 			/* nota : filedesc passed to the archivestream is considered as data fork */
 			//ACI0077162, Jul 11th 2012, O.R.: _WriteFile() in charge of calling progress CB to give reactivity to upper layers
@@ -574,7 +911,8 @@ VError VArchiveStream::Proceed()
 			}
 			delete[] buffer;
 
-			
+			delete fWorkers;
+			fWorkers = NULL;
 
 			fStream->CloseWriting();
 		}
@@ -594,6 +932,8 @@ VArchiveUnStream::VArchiveUnStream()
 {
 	fCallBack = NULL;
 	fSourceFile = NULL;
+	fWorkerCount = 0;
+	fWorkers = NULL;
 }
 
 VArchiveUnStream::~VArchiveUnStream()
@@ -633,6 +973,11 @@ void VArchiveUnStream::SetProgressCallBack( CB_VArchiveStream inProgressCallBack
 	fCallBack = inProgressCallBack;
 }
 
+void VArchiveUnStream::SetWorkerCount( sLONG inWorkerCount )
+{
+	fWorkerCount = inWorkerCount;
+}
+
 VError VArchiveUnStream::ProceedCatalog()
 {
 	VError result = VE_OK;
@@ -648,14 +993,17 @@ VError VArchiveUnStream::ProceedCatalog()
 		VString storedPath;
 		uLONG kind = 0;
 		uLONG creator = 0;
+		uLONG compression = ac_None;
+		uLONG blockSize = 0;
 		sLONG8 dataFileSize = 0;
 		sLONG8 resFileSize = 0;
 		uBYTE version = fStream->GetByte();
 		uLONG8 fileCount = fStream->GetLong8();
 		fTotalByteCount = 0;
 
-
-		if ( fStream->GetLong() == 'LIST' )
+		if ( version > kArchiveVersionCompressed )
+			result = VE_STREAM_BAD_VERSION;
+		else if ( fStream->GetLong() == 'LIST' )
 		{
 			for ( uLONG i = 0; i < fileCount && result == VE_OK; i++ )
 			{
@@ -685,8 +1033,14 @@ VError VArchiveUnStream::ProceedCatalog()
 						kind = fStream->GetLong();
 						creator = fStream->GetLong();
 
+						if ( version >= kArchiveVersionCompressed )
+						{
+							compression = fStream->GetLong();
+							blockSize = fStream->GetLong();
+						}
+
 						VFile *file = new VFile(filePath);
-						fFileCatalog.push_back(new VArchiveCatalog(file,dataFileSize,resFileSize,storedPath,fileExtra,kind,creator));
+						fFileCatalog.push_back(new VArchiveCatalog(file,dataFileSize,resFileSize,storedPath,fileExtra,kind,creator,(eArchiveCompression)compression,blockSize));
 						ReleaseRefCountable( &file);
 					}
 				}
@@ -740,6 +1094,9 @@ bool VArchiveUnStream::_IsExecutable(char* buffToUse, VSize buffSize)
 
 VError VArchiveUnStream::_ExtractFile( VArchiveCatalog *inCatalog, const VFileDesc* inFileDesc, char* buffToUse, VSize buffSize, uLONG8 &ioPartialByteCount )
 {
+	if ( inCatalog->GetCompression() != ac_None )
+		return _ExtractCompressedFile( inCatalog, inFileDesc, ioPartialByteCount );
+
 	VError result = VE_OK;
 	bool userAbort = false;
 	sLONG8 offset = 0;
@@ -788,6 +1145,99 @@ VError VArchiveUnStream::_ExtractFile( VArchiveCatalog *inCatalog, const VFileDe
 	return result;
 }
 
+VError VArchiveUnStream::_ExtractCompressedFile( VArchiveCatalog *inCatalog, const VFileDesc* inFileDesc, uLONG8 &ioPartialByteCount )
+{
+	VError result = VE_OK;
+	bool userAbort = false;
+	sLONG8 offset = 0;
+	sLONG8 fileSize = fStream->GetLong8();
+	sLONG8 blockSize = inCatalog->GetBlockSize();
+	bool extract = inCatalog->GetExtractFlag() && ( inFileDesc != NULL );
+
+	if ( fWorkers == NULL )
+		fWorkers = new VArchiveBlockWorkers( fWorkerCount, false );
+
+	std::vector<VArchiveBlock*> blocks( fWorkers->GetBatchSize(), NULL );
+	for( std::vector<VArchiveBlock*>::iterator i = blocks.begin() ; i != blocks.end() ; ++i )
+		*i = new VArchiveBlock;
+
+	while ( offset < fileSize && result == VE_OK )
+	{
+		/* read a batch of blocks sequentially */
+		sLONG count = 0;
+		sLONG8 batchSize = 0;
+		for( ; count < (sLONG) blocks.size() && offset + batchSize < fileSize && result == VE_OK ; ++count )
+		{
+			VArchiveBlock *block = blocks[count];
+			sLONG8 rawSize = (uLONG) fStream->GetLong();
+			sLONG8 packedSize = (uLONG) fStream->GetLong();
+			block->fMethod = (eArchiveCompression) fStream->GetByte();
+			block->fChecksum = fStream->GetLong();
+			result = fStream->GetLastError();
+
+			/* never trust the sizes found in the stream before allocating */
+			if ( result == VE_OK && ( rawSize == 0 || rawSize > blockSize || offset + batchSize + rawSize > fileSize ) )
+				result = VE_STREAM_BAD_SIGNATURE;
+			if ( result == VE_OK && packedSize > fStream->GetSize() - fStream->GetPos() )
+				result = VE_STREAM_BAD_SIGNATURE;
+			if ( result == VE_OK && block->fMethod == ac_None && packedSize != rawSize )
+				result = VE_STREAM_BAD_SIGNATURE;
+			if ( result == VE_OK && block->fMethod == ac_Deflate && packedSize > (sLONG8) ::compressBound( (uLong) rawSize) )
+				result = VE_STREAM_BAD_SIGNATURE;
+			if ( result == VE_OK )
+			{
+				block->fRawSize = (VSize) rawSize;
+				block->fPackedSize = (VSize) packedSize;
+				char *data = ( block->fMethod == ac_None ) ? block->ReserveRaw( block->fPackedSize ) : block->ReservePacked( block->fPackedSize );
+				if ( data == NULL )
+					result = VE_MEMORY_FULL;
+				else
+					result = fStream->GetData( data, block->fPackedSize );
+			}
+			batchSize += rawSize;
+		}
+
+		/* decompress and verify them in parallel */
+		if ( result == VE_OK && extract )
+			fWorkers->Process( &blocks[0], count );
+
+		/* and write them back in order */
+		for( sLONG i = 0 ; i < count && result == VE_OK ; ++i )
+		{
+			VArchiveBlock *block = blocks[i];
+			if ( extract )
+			{
+				result = block->fError;
+#if VERSIONMAC
+				if ( result == VE_OK && offset == 0 && _IsExecutable( block->fRaw, block->fRawSize ) )
+				{
+					uWORD mode;
+					inCatalog->GetFile()->MAC_GetPermissions( &mode );
+					mode |= 0111;
+					inCatalog->GetFile()->MAC_SetPermissions(mode);
+				}
+#endif
+				if ( result == VE_OK )
+					result = inFileDesc->PutData( block->fRaw, block->fRawSize, offset );
+			}
+			ioPartialByteCount += block->fRawSize;
+			offset += (sLONG8) block->fRawSize;
+
+			if ( fCallBack )
+			{
+				fCallBack(CB_UpdateProgress,ioPartialByteCount,fTotalByteCount,userAbort);
+				if ( userAbort )
+					result = VE_STREAM_USER_ABORTED;
+			}
+		}
+	}
+
+	for( std::vector<VArchiveBlock*>::iterator i = blocks.begin() ; i != blocks.end() ; ++i )
+		delete *i;
+
+	return result;
+}
+
 VError VArchiveUnStream::ProceedFile()
 {
 	VError result = VE_OK;
@@ -857,6 +1307,9 @@ VError VArchiveUnStream::ProceedFile()
 	}
 	delete[] buffer;
 
+	delete fWorkers;
+	fWorkers = NULL;
+
 	if ( fCallBack )
 		fCallBack(CB_CloseProgress,partialByteCount,fTotalByteCount,userAbort);
 
@@ -37,10 +37,21 @@ typedef enum eFileSizeType
 	fst_Both = fst_Data | fst_Resource
 } eFileSizeType;
 
+/*
+	Compression applied to file contents stored in an archive.
+	Compressed files are cut in fixed size blocks that are compressed independently
+	so that they can be processed by several tasks, each block carrying its own crc32.
+*/
+typedef enum eArchiveCompression
+{
+	ac_None = 0,
+	ac_Deflate = 1
+} eArchiveCompression;
+
 class XTOOLBOX_API VArchiveCatalog : public VObject
 {
 public:
-	VArchiveCatalog( VFile *inFile, sLONG8 inDataFileSize, sLONG8 inResFileSize, VString &inStoredPath, VString &inFileExtra, uLONG inKind, uLONG inCreator );
+	VArchiveCatalog( VFile *inFile, sLONG8 inDataFileSize, sLONG8 inResFileSize, VString &inStoredPath, VString &inFileExtra, uLONG inKind, uLONG inCreator, eArchiveCompression inCompression = ac_None, uLONG inBlockSize = 0 );
 	~VArchiveCatalog();
 
 	VFile*		GetFile();
@@ -51,6 +62,8 @@ public:
 	void		SetExtractFlag( Boolean inExtract );
 	uLONG		GetKind();
 	uLONG		GetCreator();
+	eArchiveCompression	GetCompression();
+	uLONG		GetBlockSize();
 
 protected:
 	VFile *fFile;
@@ -61,8 +74,12 @@ protected:
 	Boolean fExtract;
 	uLONG fKind;
 	uLONG fCreator;
+	eArchiveCompression fCompression;
+	uLONG fBlockSize;
 };
 
+class VArchiveBlockWorkers;
+
 typedef std::vector<VArchiveCatalog*> ArchiveCatalog;
 typedef std::vector<VString> VectorOfVString;
 typedef std::vector<VFileDesc*> VectorOfFileDesc;
@@ -106,6 +123,14 @@ public:
 			void	SetStreamer( VStream* inStream );
 			void	SetProgressCallBack( CB_VArchiveStream inProgressCallBack );
 
+			/**
+			 * \brief selects compression of the stored files
+			 * \param inCompression ac_None keeps the legacy raw format
+			 * \param inWorkerCount number of tasks compressing blocks (0 means one per processor)
+			 * \param inBlockSize uncompressed size of each block
+			 */
+			void	SetCompression( eArchiveCompression inCompression, sLONG inWorkerCount = 0, uLONG inBlockSize = 1024*1024 );
+
 	virtual	VError	Proceed();
 
 protected:
@@ -115,6 +140,7 @@ protected:
 	
 	virtual VError	_WriteCatalog( const VFile* inFile,const VFilePath& inStorageFolder, const VString &inExtraInfo, uLONG8 &ioTotalByteCount );
 	virtual VError	_WriteFile( const VFileDesc* inFileDesc, char* buffToUse, VSize buffSize, uLONG8 &ioPartialByteCount, uLONG8 inTotalByteCount );
+			VError	_WriteCompressedFile( const VFileDesc* inFileDesc, uLONG8 &ioPartialByteCount, uLONG8 inTotalByteCount );
 
 	VFile				*fDestinationFile;	/* file archive */
 	VFilePath			fRelativeFolder;	/* file path stored in the archive is relative to this folder */
@@ -136,6 +162,11 @@ protected:
 
 	VStream				*fStream;			/* streaming used for pushing data */
 	CB_VArchiveStream	fCallBack;			/* compression progress call back */
+
+	eArchiveCompression	fCompression;		/* compression of stored files */
+	sLONG				fWorkerCount;		/* number of tasks compressing blocks */
+	uLONG				fBlockSize;			/* uncompressed size of a block */
+	VArchiveBlockWorkers	*fWorkers;		/* tasks compressing blocks while an archive is being written */
 };
 
 class XTOOLBOX_API VArchiveUnStream : public VObject
@@ -150,6 +181,9 @@ public:
 	virtual	void			SetStreamer( VStream* inStream );
 	virtual	void			SetProgressCallBack( CB_VArchiveStream inProgressCallBack );
 
+			// number of tasks decompressing blocks of compressed archives (0 means one per processor)
+			void			SetWorkerCount( sLONG inWorkerCount );
+
 	virtual	VError			Proceed();
 
 	virtual	VError			ProceedCatalog();
@@ -160,6 +194,7 @@ public:
 protected:
 
 	virtual	VError			_ExtractFile( VArchiveCatalog *inCatalog, const VFileDesc* inFileDesc, char* buffToUse, VSize buffSize, uLONG8 &ioPartialByteCount );
+			VError			_ExtractCompressedFile( VArchiveCatalog *inCatalog, const VFileDesc* inFileDesc, uLONG8 &ioPartialByteCount );
 	#if VERSIONMAC
 	static bool				_IsExecutable(char* buffToUse, VSize buffSize);
 	#endif
@@ -173,7 +208,8 @@ protected:
 	VStream				*fStream;
 	CB_VArchiveStream	fCallBack;			/* compression progress call back */
 
-
+	sLONG				fWorkerCount;		/* number of tasks decompressing blocks */
+	VArchiveBlockWorkers	*fWorkers;		/* tasks decompressing blocks while an archive is being extracted */
 };
 END_TOOLBOX_NAMESPACE
 
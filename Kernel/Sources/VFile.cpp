@@ -23,6 +23,7 @@
 #include "VValueBag.h"
 #include "VTime.h"
 #include "VTextConverter.h"
+#include "VTraceProfiler.h"
 
 
 BEGIN_TOOLBOX_NAMESPACE
@@ -100,6 +101,8 @@ VError VFileDesc::GetData( void *outData, VSize inCount, sLONG8 inOffset, VSize
 {
 	xbox_assert( inCount >= 0);
 
+	VTRACE_SCOPE( "file", "VFileDesc::GetData");
+
 	VSize size = inCount;
 	VError err = fImpl.GetData( outData, size, inOffset, true);
 	xbox_assert( (size == inCount) || (err != VE_OK) );
@@ -128,6 +131,8 @@ VError VFileDesc::GetDataAtPos( void *outData, VSize inCount, sLONG8 inOffset, V
 {
 	xbox_assert( inCount >= 0);
 
+	VTRACE_SCOPE( "file", "VFileDesc::GetDataAtPos");
+
 	VSize size = inCount;
 	VError err = fImpl.GetData( outData, size, inOffset, false);
 	xbox_assert( (size == inCount) || (err != VE_OK) );
@@ -160,6 +165,8 @@ VError VFileDesc::PutData( const void *inData, VSize inCount, sLONG8 inOffset, V
 {
 	xbox_assert( inCount >= 0);
 	
+	VTRACE_SCOPE( "file", "VFileDesc::PutData");
+
 	VSize size = inCount;
 	VError err = fImpl.PutData( inData, size, inOffset, true);
 	xbox_assert( (size == inCount) || (err != VE_OK) );
@@ -188,6 +195,8 @@ VError VFileDesc::PutDataAtPos( const void *inData, VSize inCount, sLONG8 inOffs
 {
 	xbox_assert( inCount >= 0);
 
+	VTRACE_SCOPE( "file", "VFileDesc::PutDataAtPos");
+
 	VSize size = inCount;
 	VError err = fImpl.PutData( inData, size, inOffset, false);
 	xbox_assert( (size == inCount) || (err != VE_OK) );
@@ -265,6 +274,8 @@ VError VFileDesc::SetPos( sLONG8 inOffset, bool inFromStart ) const
 
 VError VFileDesc::Flush() const
 {
+	VTRACE_SCOPE( "file", "VFileDesc::Flush");
+
 	VError err = fImpl.Flush();
 
 	if (IS_NATIVE_VERROR( err))
@@ -1381,18 +1392,23 @@ VFileKind *VFileKindManager::RetainFileKind( const VString& inID)
 {
 	VRefPtr<VFileKind> ptr_kind;
 
-	MapOfVFileKind::const_iterator i = fMap.find( inID);
-	if (i != fMap.end())
 	{
-		ptr_kind = i->second;
+		StReadLocker lock( &fLock);
+		MapOfVFileKind::const_iterator i = fMap.find( inID);
+		if (i != fMap.end())
+			ptr_kind = i->second;
 	}
-	else
+	
+	if (ptr_kind == NULL)
 	{
 		// see if that's a public kind not already registered
 		ptr_kind.Adopt( XFileImpl::CreatePublicFileKind( inID));
 		if (ptr_kind != NULL)
 		{
-			fMap[inID] = ptr_kind;
+			StWriteLocker lock( &fLock);
+			std::pair<MapOfVFileKind::iterator,bool> i = fMap.insert( MapOfVFileKind::value_type( inID, ptr_kind));
+			if (!i.second)
+				ptr_kind = i.first->second;	// registered by another task in the meantime
 		}
 	}
 
@@ -1434,6 +1450,7 @@ void VFileKindManager::RegisterPrivateFileKind( const VString& inID, const Vecto
 	VRefPtr<VFileKind> ptr_kind( VFileKind::Create( inID, inOsKind, inDescription, inExtensions, inParentIDs, false), false);
 #endif	
 	
+	StWriteLocker lock( &fLock);
 	fMap[inID] = ptr_kind;
 }
 
@@ -1442,6 +1459,7 @@ void VFileKindManager::RegisterLocalizedString(long inWhich,const VString& inStr
 {
 	if (inString.GetLength() > 0)
 	{
+		StWriteLocker lock( &fLock);
 		if (inWhich == VFileKindManager::STRING_ALL)
 			fStringAll = inString;
 		else if (inWhich == VFileKindManager::STRING_ALL_READABLE_DOCUMENTS)
@@ -1451,6 +1469,7 @@ void VFileKindManager::RegisterLocalizedString(long inWhich,const VString& inStr
 
 void VFileKindManager::GetLocalizedString(long inWhich,VString &outString)
 {
+	StReadLocker lock( &fLock);
 	if (inWhich == VFileKindManager::STRING_ALL)
 		outString = fStringAll;
 	else if (inWhich == VFileKindManager::STRING_ALL_READABLE_DOCUMENTS)
@@ -1460,6 +1479,7 @@ void VFileKindManager::GetLocalizedString(long inWhich,VString &outString)
 VFileKind* VFileKindManager::RetainFirstFileKindMatchingWithExtension( const VString& inExtension )
 {
 	VFileKind *result = NULL;
+	fLock.LockRead();
 	for ( MapOfVFileKind::const_iterator iter = fMap.begin(); iter != fMap.end(); ++iter )
 	{
 		if ( iter->second->MatchExtension(inExtension) )
@@ -1469,13 +1489,16 @@ VFileKind* VFileKindManager::RetainFirstFileKindMatchingWithExtension( const VSt
 			break;
 		}
 	}
+	fLock.UnlockRead();
 
 	if (result == NULL)
 	{
 		result = XFileImpl::CreatePublicFileKindFromExtension( inExtension);
 		if (result != NULL)
 		{
-			if (testAssert( fMap.find(result->GetID()) == fMap.end() ))
+			StWriteLocker lock( &fLock);
+			// another task may have registered it in the meantime
+			if (fMap.find(result->GetID()) == fMap.end())
 			{
 				fMap[result->GetID()] = VRefPtr<VFileKind>(result);		// sc 27/09/2011 optimization
 			}
@@ -1488,6 +1511,7 @@ VFileKind* VFileKindManager::RetainFirstFileKindMatchingWithExtension( const VSt
 VFileKind* VFileKindManager::RetainFirstFileKindMatchingWithOsKind( const VString& inOsKind )
 {
 	VFileKind *result = NULL;
+	fLock.LockRead();
 	for ( MapOfVFileKind::const_iterator iter = fMap.begin(); iter != fMap.end(); ++iter )
 	{
 		if ( iter->second->MatchOsKind( inOsKind ) )
@@ -1497,6 +1521,7 @@ VFileKind* VFileKindManager::RetainFirstFileKindMatchingWithOsKind( const VStrin
 			break;
 		}
 	}
+	fLock.UnlockRead();
 
 	if (result == NULL)
 		result = XFileImpl::CreatePublicFileKindFromOsKind( inOsKind );
@@ -370,6 +370,7 @@ public:
 private:
 	static	VFileKindManager*			sManager;
 
+	mutable	VReaderWriterLock			fLock;		// protects fMap and localized strings
 			MapOfVFileKind				fMap;
 			VString fStringAll;
 			VString fStringAllReadableDocuments;
@@ -18,6 +18,7 @@
 #include "VString.h"
 #include "VTime.h"
 #include "VStream.h"
+#include "VErrorContext.h"
 #include "VMemoryCpp.h"
 #include "M_APM/m_apm.h"
 
@@ -26,6 +27,599 @@ inline int finite( double a) { return _finite( a);}
 #endif
 
 
+//=======================================================================================================================================
+//	Inline decimal support
+//
+//	Most values (money, quantities) fit in 38 significant digits: they are held in a VFloatDecimal
+//	so that construction, copy, add, subtract, multiply, compare, round and serialization don't go through M_APM.
+//	Results are the exact same ones as M_APM ones. Other operations convert to M_APM.
+//=======================================================================================================================================
+
+#define kDECIMAL_MAX_DIGITS			38
+#define kDECIMAL_MAX_EXPONENT		100000000		// keeps exponent arithmetic far from sLONG overflow
+#define kDECIMAL_APM_DATA_SIZE		40				// serialization writes m_apm_datalength bytes
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+// M_APM value of an inline decimal, stored on stack
+struct VFloatAPMView
+{
+	M_APM_struct	fAPM;
+	UCHAR			fData[kDECIMAL_APM_DATA_SIZE];
+};
+
+END_TOOLBOX_NAMESPACE
+
+
+// 10^0 .. 10^38 (high, low)
+static const uLONG8 sPow10[kDECIMAL_MAX_DIGITS+1][2] =
+{
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0000000000000001) },	// 10^0
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x000000000000000A) },	// 10^1
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0000000000000064) },	// 10^2
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00000000000003E8) },	// 10^3
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0000000000002710) },	// 10^4
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00000000000186A0) },	// 10^5
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00000000000F4240) },	// 10^6
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0000000000989680) },	// 10^7
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0000000005F5E100) },	// 10^8
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x000000003B9ACA00) },	// 10^9
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00000002540BE400) },	// 10^10
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x000000174876E800) },	// 10^11
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x000000E8D4A51000) },	// 10^12
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x000009184E72A000) },	// 10^13
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00005AF3107A4000) },	// 10^14
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x00038D7EA4C68000) },	// 10^15
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x002386F26FC10000) },	// 10^16
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x016345785D8A0000) },	// 10^17
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x0DE0B6B3A7640000) },	// 10^18
+	{ XBOX_LONG8(0x0000000000000000), XBOX_LONG8(0x8AC7230489E80000) },	// 10^19
+	{ XBOX_LONG8(0x0000000000000005), XBOX_LONG8(0x6BC75E2D63100000) },	// 10^20
+	{ XBOX_LONG8(0x0000000000000036), XBOX_LONG8(0x35C9ADC5DEA00000) },	// 10^21
+	{ XBOX_LONG8(0x000000000000021E), XBOX_LONG8(0x19E0C9BAB2400000) },	// 10^22
+	{ XBOX_LONG8(0x000000000000152D), XBOX_LONG8(0x02C7E14AF6800000) },	// 10^23
+	{ XBOX_LONG8(0x000000000000D3C2), XBOX_LONG8(0x1BCECCEDA1000000) },	// 10^24
+	{ XBOX_LONG8(0x0000000000084595), XBOX_LONG8(0x161401484A000000) },	// 10^25
+	{ XBOX_LONG8(0x000000000052B7D2), XBOX_LONG8(0xDCC80CD2E4000000) },	// 10^26
+	{ XBOX_LONG8(0x00000000033B2E3C), XBOX_LONG8(0x9FD0803CE8000000) },	// 10^27
+	{ XBOX_LONG8(0x00000000204FCE5E), XBOX_LONG8(0x3E25026110000000) },	// 10^28
+	{ XBOX_LONG8(0x00000001431E0FAE), XBOX_LONG8(0x6D7217CAA0000000) },	// 10^29
+	{ XBOX_LONG8(0x0000000C9F2C9CD0), XBOX_LONG8(0x4674EDEA40000000) },	// 10^30
+	{ XBOX_LONG8(0x0000007E37BE2022), XBOX_LONG8(0xC0914B2680000000) },	// 10^31
+	{ XBOX_LONG8(0x000004EE2D6D415B), XBOX_LONG8(0x85ACEF8100000000) },	// 10^32
+	{ XBOX_LONG8(0x0000314DC6448D93), XBOX_LONG8(0x38C15B0A00000000) },	// 10^33
+	{ XBOX_LONG8(0x0001ED09BEAD87C0), XBOX_LONG8(0x378D8E6400000000) },	// 10^34
+	{ XBOX_LONG8(0x0013426172C74D82), XBOX_LONG8(0x2B878FE800000000) },	// 10^35
+	{ XBOX_LONG8(0x00C097CE7BC90715), XBOX_LONG8(0xB34B9F1000000000) },	// 10^36
+	{ XBOX_LONG8(0x0785EE10D5DA46D9), XBOX_LONG8(0x00F436A000000000) },	// 10^37
+	{ XBOX_LONG8(0x4B3B4CA85A86C47A), XBOX_LONG8(0x098A224000000000) },	// 10^38
+};
+
+
+static inline sLONG _Compare128( uLONG8 inHigh1, uLONG8 inLow1, uLONG8 inHigh2, uLONG8 inLow2)
+{
+	if (inHigh1 != inHigh2)
+		return (inHigh1 < inHigh2) ? -1 : 1;
+	if (inLow1 != inLow2)
+		return (inLow1 < inLow2) ? -1 : 1;
+	return 0;
+}
+
+
+static inline bool _IsBelowMaxCoefficient( uLONG8 inHigh, uLONG8 inLow)
+{
+	return _Compare128( inHigh, inLow, sPow10[kDECIMAL_MAX_DIGITS][0], sPow10[kDECIMAL_MAX_DIGITS][1]) < 0;
+}
+
+
+static inline bool _IsExponentInRange( sLONG inExponent)
+{
+	return (inExponent >= -kDECIMAL_MAX_EXPONENT) && (inExponent <= kDECIMAL_MAX_EXPONENT);
+}
+
+
+static inline void _Add128( uLONG8& ioHigh, uLONG8& ioLow, uLONG8 inHigh, uLONG8 inLow)
+{
+	uLONG8 low = ioLow + inLow;
+	ioHigh += inHigh + ((low < ioLow) ? 1 : 0);
+	ioLow = low;
+}
+
+
+static inline void _Sub128( uLONG8& ioHigh, uLONG8& ioLow, uLONG8 inHigh, uLONG8 inLow)
+{
+	uLONG8 low = ioLow - inLow;
+	ioHigh -= inHigh + ((low > ioLow) ? 1 : 0);
+	ioLow = low;
+}
+
+
+// 64 x 64 -> 128 bits
+static inline void _Mul64( uLONG8 inA, uLONG8 inB, uLONG8& outHigh, uLONG8& outLow)
+{
+	uLONG8 aLow = inA & 0xFFFFFFFF, aHigh = inA >> 32;
+	uLONG8 bLow = inB & 0xFFFFFFFF, bHigh = inB >> 32;
+
+	uLONG8 lowLow = aLow * bLow;
+	uLONG8 highLow = aHigh * bLow;
+	uLONG8 lowHigh = aLow * bHigh;
+	uLONG8 highHigh = aHigh * bHigh;
+
+	uLONG8 middle = (lowLow >> 32) + (highLow & 0xFFFFFFFF) + (lowHigh & 0xFFFFFFFF);
+
+	outLow = (middle << 32) | (lowLow & 0xFFFFFFFF);
+	outHigh = highHigh + (highLow >> 32) + (lowHigh >> 32) + (middle >> 32);
+}
+
+
+// 128 x 64 bits, returns false if the result doesn't fit in 128 bits
+static bool _MulSmall( uLONG8& ioHigh, uLONG8& ioLow, uLONG8 inFactor)
+{
+	uLONG8 high1, low1, high2, low2;
+	_Mul64( ioLow, inFactor, high1, low1);
+	_Mul64( ioHigh, inFactor, high2, low2);
+	if (high2 != 0)
+		return false;
+
+	uLONG8 high = low2 + high1;
+	if (high < low2)
+		return false;
+
+	ioHigh = high;
+	ioLow = low1;
+	return true;
+}
+
+
+// 128 / 32 bits, returns the remainder
+static uLONG _DivSmall( uLONG8& ioHigh, uLONG8& ioLow, uLONG inDivisor)
+{
+	uLONG8 limbs[4] = { ioHigh >> 32, ioHigh & 0xFFFFFFFF, ioLow >> 32, ioLow & 0xFFFFFFFF };
+	uLONG8 remainder = 0;
+	for( sLONG i = 0 ; i < 4 ; ++i)
+	{
+		uLONG8 current = (remainder << 32) | limbs[i];
+		limbs[i] = current / inDivisor;
+		remainder = current % inDivisor;
+	}
+	ioHigh = (limbs[0] << 32) | limbs[1];
+	ioLow = (limbs[2] << 32) | limbs[3];
+	return (uLONG) remainder;
+}
+
+
+// divides by 10^inDigits, tells if some non zero digits were dropped and returns the last dropped digit
+static void _DivPow10( uLONG8& ioHigh, uLONG8& ioLow, sLONG inDigits, bool *outHasRemainder, uLONG *outLastDigit)
+{
+	bool hasRemainder = false;
+	uLONG lastDigit = 0;
+	if (inDigits > kDECIMAL_MAX_DIGITS)
+	{
+		// coefficients are lower than 10^38
+		hasRemainder = (ioHigh != 0) || (ioLow != 0);
+		lastDigit = 0;
+		ioHigh = ioLow = 0;
+	}
+	else
+	{
+		while (inDigits > 0)
+		{
+			sLONG step = Min( inDigits, (sLONG) 9);
+			if (outLastDigit != NULL && step == inDigits)
+			{
+				// keep the most significant dropped digit apart
+				if (step > 1)
+					hasRemainder |= (_DivSmall( ioHigh, ioLow, (uLONG) sPow10[step-1][1]) != 0);
+				lastDigit = _DivSmall( ioHigh, ioLow, 10);
+			}
+			else
+			{
+				hasRemainder |= (_DivSmall( ioHigh, ioLow, (uLONG) sPow10[step][1]) != 0);
+			}
+			inDigits -= step;
+		}
+	}
+	if (outHasRemainder != NULL)
+		*outHasRemainder = hasRemainder || (lastDigit != 0);
+	if (outLastDigit != NULL)
+		*outLastDigit = lastDigit;
+}
+
+
+// multiplies by 10^inDigits, returns false if the result is not lower than 10^38
+static bool _ScaleUp( uLONG8& ioHigh, uLONG8& ioLow, sLONG inDigits)
+{
+	if ( (ioHigh == 0) && (ioLow == 0) )
+		return true;
+	if (inDigits > kDECIMAL_MAX_DIGITS)
+		return false;
+	while (inDigits > 0)
+	{
+		sLONG step = Min( inDigits, (sLONG) 19);
+		if (!_MulSmall( ioHigh, ioLow, sPow10[step][1]))
+			return false;
+		inDigits -= step;
+	}
+	return _IsBelowMaxCoefficient( ioHigh, ioLow);
+}
+
+
+// number of decimal digits (0 for 0)
+static sLONG _CountDigits( uLONG8 inHigh, uLONG8 inLow)
+{
+	sLONG digits = (inHigh == 0) ? 0 : 19;
+	while ( (digits <= kDECIMAL_MAX_DIGITS) && (_Compare128( inHigh, inLow, sPow10[digits][0], sPow10[digits][1]) >= 0) )
+		++digits;
+	return digits;
+}
+
+
+static inline void _SetDecimalZero( VFloatDecimal& outDecimal)
+{
+	outDecimal.fLow = 0;
+	outDecimal.fHigh = 0;
+	outDecimal.fExponent = 0;
+	outDecimal.fSign = 0;
+}
+
+
+static void _SetDecimalFromLong8( VFloatDecimal& outDecimal, sLONG8 inValue)
+{
+	outDecimal.fHigh = 0;
+	outDecimal.fExponent = 0;
+	if (inValue == 0)
+	{
+		outDecimal.fLow = 0;
+		outDecimal.fSign = 0;
+	}
+	else if (inValue < 0)
+	{
+		outDecimal.fLow = ~((uLONG8) inValue) + 1;
+		outDecimal.fSign = -1;
+	}
+	else
+	{
+		outDecimal.fLow = (uLONG8) inValue;
+		outDecimal.fSign = 1;
+	}
+}
+
+
+// removes trailing zeros of the coefficient
+static void _NormalizeDecimal( VFloatDecimal& ioDecimal)
+{
+	if (ioDecimal.fSign == 0)
+	{
+		_SetDecimalZero( ioDecimal);
+		return;
+	}
+	for( uLONG divisor = 1000000000, digits = 9 ; digits > 0 ; divisor /= 10, --digits)
+	{
+		while (true)
+		{
+			uLONG8 high = ioDecimal.fHigh, low = ioDecimal.fLow;
+			if (_DivSmall( high, low, divisor) != 0)
+				break;
+			ioDecimal.fHigh = high;
+			ioDecimal.fLow = low;
+			ioDecimal.fExponent += (sLONG) digits;
+		}
+		if (digits == 1)
+			break;
+	}
+}
+
+
+static sLONG _CompareDecimals( const VFloatDecimal& inDecimal1, const VFloatDecimal& inDecimal2)
+{
+	if (inDecimal1.fSign != inDecimal2.fSign)
+		return (inDecimal1.fSign < inDecimal2.fSign) ? -1 : 1;
+	if (inDecimal1.fSign == 0)
+		return 0;
+
+	uLONG8 high1 = inDecimal1.fHigh, low1 = inDecimal1.fLow;
+	uLONG8 high2 = inDecimal2.fHigh, low2 = inDecimal2.fLow;
+	sLONG digits1 = _CountDigits( high1, low1);
+	sLONG digits2 = _CountDigits( high2, low2);
+
+	sLONG result;
+	if (digits1 + inDecimal1.fExponent != digits2 + inDecimal2.fExponent)
+	{
+		result = (digits1 + inDecimal1.fExponent < digits2 + inDecimal2.fExponent) ? -1 : 1;
+	}
+	else
+	{
+		// same magnitude: give both coefficients the same number of digits
+		if (digits1 < digits2)
+			_ScaleUp( high1, low1, digits2 - digits1);
+		else if (digits2 < digits1)
+			_ScaleUp( high2, low2, digits1 - digits2);
+		result = _Compare128( high1, low1, high2, low2);
+	}
+	return (inDecimal1.fSign > 0) ? result : -result;
+}
+
+
+static bool _AddDecimals( const VFloatDecimal& inDecimal1, const VFloatDecimal& inDecimal2, VFloatDecimal& outResult)
+{
+	if (inDecimal1.fSign == 0)
+	{
+		outResult = inDecimal2;
+		return true;
+	}
+	if (inDecimal2.fSign == 0)
+	{
+		outResult = inDecimal1;
+		return true;
+	}
+
+	// align on the lowest exponent
+	VFloatDecimal x = inDecimal1, y = inDecimal2;
+	if (x.fExponent > y.fExponent)
+	{
+		if (!_ScaleUp( x.fHigh, x.fLow, x.fExponent - y.fExponent))
+			return false;
+		x.fExponent = y.fExponent;
+	}
+	else if (y.fExponent > x.fExponent)
+	{
+		if (!_ScaleUp( y.fHigh, y.fLow, y.fExponent - x.fExponent))
+			return false;
+		y.fExponent = x.fExponent;
+	}
+
+	if (x.fSign == y.fSign)
+	{
+		// both are lower than 10^38 so the sum fits in 128 bits
+		_Add128( x.fHigh, x.fLow, y.fHigh, y.fLow);
+		if (!_IsBelowMaxCoefficient( x.fHigh, x.fLow))
+			return false;
+		outResult = x;
+	}
+	else
+	{
+		sLONG compare = _Compare128( x.fHigh, x.fLow, y.fHigh, y.fLow);
+		if (compare == 0)
+		{
+			_SetDecimalZero( outResult);
+		}
+		else if (compare > 0)
+		{
+			_Sub128( x.fHigh, x.fLow, y.fHigh, y.fLow);
+			outResult = x;
+		}
+		else
+		{
+			_Sub128( y.fHigh, y.fLow, x.fHigh, x.fLow);
+			outResult = y;
+		}
+	}
+	return true;
+}
+
+
+static bool _MultiplyDecimals( const VFloatDecimal& inDecimal1, const VFloatDecimal& inDecimal2, VFloatDecimal& outResult)
+{
+	if ( (inDecimal1.fSign == 0) || (inDecimal2.fSign == 0) )
+	{
+		_SetDecimalZero( outResult);
+		return true;
+	}
+
+	uLONG8 high, low;
+	if (inDecimal1.fHigh == 0)
+	{
+		high = inDecimal2.fHigh;
+		low = inDecimal2.fLow;
+		if (!_MulSmall( high, low, inDecimal1.fLow))
+			return false;
+	}
+	else if (inDecimal2.fHigh == 0)
+	{
+		high = inDecimal1.fHigh;
+		low = inDecimal1.fLow;
+		if (!_MulSmall( high, low, inDecimal2.fLow))
+			return false;
+	}
+	else
+	{
+		return false;
+	}
+
+	sLONG exponent = inDecimal1.fExponent + inDecimal2.fExponent;
+	if (!_IsBelowMaxCoefficient( high, low) || !_IsExponentInRange( exponent))
+		return false;
+
+	outResult.fHigh = high;
+	outResult.fLow = low;
+	outResult.fExponent = exponent;
+	outResult.fSign = (sBYTE) (inDecimal1.fSign * inDecimal2.fSign);
+	return true;
+}
+
+
+// same as m_apm_round: keeps inToDigits+1 significant digits, rounding half away from zero
+static bool _RoundDecimal( const VFloatDecimal& inDecimal, sLONG inToDigits, VFloatDecimal& outResult)
+{
+	if (inToDigits < 0)
+		return false;
+
+	VFloatDecimal result = inDecimal;
+	_NormalizeDecimal( result);
+
+	sLONG digits = _CountDigits( result.fHigh, result.fLow);
+	if (digits > inToDigits + 1)
+	{
+		sLONG dropped = digits - (inToDigits + 1);
+		uLONG lastDigit = 0;
+		_DivPow10( result.fHigh, result.fLow, dropped, NULL, &lastDigit);
+		if (lastDigit >= 5)
+			_Add128( result.fHigh, result.fLow, 0, 1);
+		result.fExponent += dropped;
+		if (!_IsBelowMaxCoefficient( result.fHigh, result.fLow) || !_IsExponentInRange( result.fExponent))
+			return false;
+	}
+	outResult = result;
+	return true;
+}
+
+
+// integer part: inFloor true rounds toward -infinity, false toward +infinity
+static bool _RoundDecimalToInteger( const VFloatDecimal& inDecimal, bool inFloor, VFloatDecimal& outResult)
+{
+	VFloatDecimal result = inDecimal;
+	if ( (result.fSign != 0) && (result.fExponent < 0) )
+	{
+		bool hasRemainder = false;
+		_DivPow10( result.fHigh, result.fLow, -result.fExponent, &hasRemainder, NULL);
+		result.fExponent = 0;
+		if (hasRemainder && ((result.fSign < 0) == inFloor))
+			_Add128( result.fHigh, result.fLow, 0, 1);
+		if ( (result.fHigh == 0) && (result.fLow == 0) )
+			_SetDecimalZero( result);
+		if (!_IsBelowMaxCoefficient( result.fHigh, result.fLow))
+			return false;
+	}
+	outResult = result;
+	return true;
+}
+
+
+// integer part of the value rounded to exponent+3 significant digits (see _APMToIntegerString) converted to sLONG8
+static bool _GetDecimalLong8( const VFloatDecimal& inDecimal, sLONG8& outValue)
+{
+	VFloatDecimal value = inDecimal;
+	sLONG digits = _CountDigits( value.fHigh, value.fLow);
+	sLONG exponent = digits + value.fExponent;		// m_apm_exponent
+	if ( (value.fSign == 0) || (exponent <= 0) )
+	{
+		outValue = 0;
+		return true;
+	}
+
+	// rounds to exponent+3 significant digits before truncating
+	if (!_RoundDecimal( value, exponent + 2, value))
+		return false;
+
+	if (value.fExponent < 0)
+		_DivPow10( value.fHigh, value.fLow, -value.fExponent, NULL, NULL);
+	else if (!_ScaleUp( value.fHigh, value.fLow, value.fExponent))
+		return false;
+
+	if ( (value.fHigh != 0) || (value.fLow > (uLONG8) XBOX_LONG8(0x7FFFFFFFFFFFFFFF)) )
+		return false;
+
+	outValue = (value.fSign < 0) ? -(sLONG8) value.fLow : (sLONG8) value.fLow;
+	return true;
+}
+
+
+// m_apm_to_integer_string rounds to exponent+3 significant digits but counts the integer digits before rounding,
+// so a carry into a new digit drops the last one (99.999953 gives 10): round first so that the exponent is right
+static void _APMToIntegerString( char *outString, M_APM inValue)
+{
+	if ( (inValue->m_apm_sign == 0) || (inValue->m_apm_exponent <= 0) )
+	{
+		m_apm_to_integer_string( outString, inValue);
+		return;
+	}
+
+	M_APM rounded = m_apm_init();
+	m_apm_round( rounded, inValue->m_apm_exponent + 2, inValue);
+	m_apm_to_integer_string( outString, rounded);
+	m_apm_free( rounded);
+}
+
+
+static bool _DecimalFromAPM( const M_APM_struct& inValue, VFloatDecimal& outDecimal)
+{
+	if (inValue.m_apm_sign == 0)
+	{
+		_SetDecimalZero( outDecimal);
+		return true;
+	}
+
+	sLONG digits = (sLONG) inValue.m_apm_datalength;
+	if ( (digits <= 0) || (digits > kDECIMAL_MAX_DIGITS) )
+		return false;
+
+	sLONG exponent = (sLONG) (inValue.m_apm_exponent - digits);
+	if ( (inValue.m_apm_exponent - digits != exponent) || !_IsExponentInRange( exponent))
+		return false;
+
+	uLONG8 high = 0, low = 0;
+	sLONG index = 0;
+	while (index < digits)
+	{
+		// accumulate up to 18 digits at a time
+		sLONG count = Min( digits - index, (sLONG) 18);
+		uLONG8 chunk = 0;
+		for( sLONG i = index ; i < index + count ; ++i)
+		{
+			UCHAR pair = inValue.m_apm_data[i >> 1];
+			chunk = chunk * 10 + (((i & 1) == 0) ? (pair / 10) : (pair % 10));
+		}
+		_MulSmall( high, low, sPow10[count][1]);
+		_Add128( high, low, 0, chunk);
+		index += count;
+	}
+
+	outDecimal.fHigh = high;
+	outDecimal.fLow = low;
+	outDecimal.fExponent = exponent;
+	outDecimal.fSign = (inValue.m_apm_sign < 0) ? -1 : 1;
+	return true;
+}
+
+
+static void _DecimalToAPM( const VFloatDecimal& inDecimal, VFloatAPMView& outView)
+{
+	::memset( outView.fData, 0, sizeof( outView.fData));
+	outView.fAPM.m_apm_id = 0;
+	outView.fAPM.m_apm_malloclength = sizeof( outView.fData);
+	outView.fAPM.m_apm_data = outView.fData;
+
+	VFloatDecimal value = inDecimal;
+	_NormalizeDecimal( value);
+
+	if (value.fSign == 0)
+	{
+		// same as m_apm_set_long( 0)
+		outView.fAPM.m_apm_datalength = 1;
+		outView.fAPM.m_apm_exponent = 0;
+		outView.fAPM.m_apm_sign = 0;
+		return;
+	}
+
+	// decimal digits, least significant first
+	UCHAR digits[kDECIMAL_MAX_DIGITS + 9];
+	sLONG count = 0;
+	uLONG8 high = value.fHigh, low = value.fLow;
+	while ( (high != 0) || (low != 0) )
+	{
+		uLONG chunk = _DivSmall( high, low, 1000000000);
+		for( sLONG i = 0 ; i < 9 ; ++i, chunk /= 10)
+			digits[count++] = (UCHAR) (chunk % 10);
+	}
+	while ( (count > 0) && (digits[count-1] == 0) )
+		--count;
+
+	for( sLONG i = 0 ; i < count ; ++i)
+	{
+		UCHAR digit = digits[count - 1 - i];
+		if ((i & 1) == 0)
+			outView.fData[i >> 1] = (UCHAR) (10 * digit);
+		else
+			outView.fData[i >> 1] += digit;
+	}
+
+	outView.fAPM.m_apm_datalength = count;
+	outView.fAPM.m_apm_exponent = count + value.fExponent;
+	outView.fAPM.m_apm_sign = value.fSign;
+}
+
+
 // This is the default number of digits to use for 1-ary functions like sin, cos, tan, etc.
 //	It's the larger of my digits and cpp_min_precision.
 inline sLONG _digits(M_APM inValue)
@@ -147,55 +741,117 @@ VSize VFloat_info::GetAvgSpace() const
 
 VFloat::VFloat()
 {
-	fValue = m_apm_init();
+	fValue = NULL;
+	_SetDecimalZero( fDecimal);
+	fIsDecimal = true;
 }
 
 
 VFloat::VFloat(uBYTE* inDataPtr, Boolean /*inInit*/)
 {
-	fValue = m_apm_init();
+	fValue = NULL;
+	_SetDecimalZero( fDecimal);
+	fIsDecimal = true;
 	LoadFromPtr(inDataPtr);
 }
 
 
 VFloat::VFloat(const VFloat& inOriginal)
 {
-	fValue = m_apm_init();
-	m_apm_copy(fValue, inOriginal.fValue);
+	fValue = NULL;
+	_SetDecimalZero( fDecimal);
+	fIsDecimal = true;
+	if (inOriginal.fIsDecimal)
+		_SetDecimal( inOriginal.fDecimal);
+	else
+		m_apm_copy(_GetAPMForWrite(), inOriginal.fValue);
 }
 
 
 VFloat::VFloat(Real inValue):VValueSingle( finite( inValue) == 0)
 {
-	fValue = m_apm_init();
+	fValue = NULL;
+	_SetDecimalZero( fDecimal);
+	fIsDecimal = true;
 	if (!IsNull())
-		m_apm_set_double(fValue, inValue);
+	{
+		m_apm_set_double(_GetAPMForWrite(), inValue);
+		_TryDecimalFromAPM();
+	}
 }
 
 
 VFloat::VFloat(sLONG inValue)
 {
-	fValue = m_apm_init();
-	m_apm_set_long(fValue, inValue);
+	fValue = NULL;
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 }
 
 
 VFloat::VFloat(sLONG8 inValue)
 {
-	fValue = m_apm_init();
-	VStr<32> str;
-	str.FromLong8(inValue);
-	FromString(str);
+	fValue = NULL;
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 }
 
 
 VFloat::~VFloat()
 {
-	m_apm_free(fValue);
+	if (fValue != NULL)
+		m_apm_free(fValue);
+}
+
+
+M_APM VFloat::_GetAPM( VFloatAPMView& ioView) const
+{
+	if (fIsDecimal)
+	{
+		_DecimalToAPM( fDecimal, ioView);
+		return &ioView.fAPM;
+	}
+	return fValue;
+}
+
+
+M_APM VFloat::_GetAPMForWrite()
+{
+	if (fValue == NULL)
+		fValue = m_apm_init();
+	fIsDecimal = false;
+	return fValue;
+}
+
+
+void VFloat::_SetFromAPM( const M_APM_struct& inValue)
+{
+	VFloatDecimal decimal;
+	if (_DecimalFromAPM( inValue, decimal))
+		_SetDecimal( decimal);
+	else
+		m_apm_copy(_GetAPMForWrite(), const_cast<M_APM>( &inValue));
+}
+
+
+void VFloat::_TryDecimalFromAPM()
+{
+	if (!fIsDecimal && _DecimalFromAPM( *fValue, fDecimal))
+		fIsDecimal = true;
+}
+
+
+int VFloat::_Compare( const VFloat& inValue) const
+{
+	if (fIsDecimal && inValue.fIsDecimal)
+		return _CompareDecimals( fDecimal, inValue.fDecimal);
+
+	VFloatAPMView view1, view2;
+	return m_apm_compare(_GetAPM( view1), inValue._GetAPM( view2));
 }
 
 
-VFloat* VFloat::Clone() const 
+VFloat* VFloat::Clone() const
 {
 	return new VFloat(*this);
 }
@@ -218,8 +874,8 @@ CompareResult VFloat::CompareTo (const VValueSingle& inValue, Boolean /*inDiacri
 	VFloat val;
 	inValue.GetFloat(val);
 
-	int result = m_apm_compare(fValue, val.fValue) ;
-		 
+	int result = _Compare(val);
+
 	if (result > 0)
 		return CR_BIGGER;
 	else if (result < 0)
@@ -231,12 +887,16 @@ CompareResult VFloat::CompareTo (const VValueSingle& inValue, Boolean /*inDiacri
 
 void VFloat::Clear()
 {
-	m_apm_set_long(fValue, 0);
+	VFloatDecimal zero;
+	_SetDecimalZero( zero);
+	_SetDecimal( zero);
 }
 
 
 Boolean VFloat::GetBoolean() const
 {
+	if (fIsDecimal)
+		return fDecimal.fSign != 0;
 	return (0 != m_apm_compare(fValue, MM_Zero));
 }
 
@@ -249,17 +909,27 @@ sWORD VFloat::GetWord() const
 
 sLONG VFloat::GetLong() const
 {
+	sLONG8 value;
+	if (fIsDecimal && _GetDecimalLong8( fDecimal, value) && (value >= kMIN_sLONG) && (value <= kMAX_sLONG))
+		return (sLONG) value;
+
+	VFloatAPMView view;
 	char str[1024];
-	m_apm_to_integer_string(str, fValue);
+	_APMToIntegerString(str, _GetAPM( view));
 	return (sLONG) atol(str);
 }
 
 
 sLONG8 VFloat::GetLong8() const
 {
+	sLONG8 value;
+	if (fIsDecimal && _GetDecimalLong8( fDecimal, value))
+		return value;
+
+	VFloatAPMView view;
 	char str[1024];
-	m_apm_to_integer_string(str, fValue);
-	
+	_APMToIntegerString(str, _GetAPM( view));
+
 	VString vstr;
 	vstr.FromCString(str);
 	return vstr.GetLong8();
@@ -268,8 +938,9 @@ sLONG8 VFloat::GetLong8() const
 
 Real VFloat::GetReal() const
 {
+	VFloatAPMView view;
 	char str[1024];
-	m_apm_to_string(str, -1, fValue);
+	m_apm_to_string(str, -1, _GetAPM( view));
 	return atof(str);
 }
 
@@ -277,7 +948,10 @@ Real VFloat::GetReal() const
 void VFloat::GetFloat(VFloat& outValue) const
 {
 	outValue.SetNull(IsNull());
-	m_apm_copy(outValue.fValue, fValue);
+	if (fIsDecimal)
+		outValue._SetDecimal( fDecimal);
+	else if (&outValue != this)
+		m_apm_copy(outValue._GetAPMForWrite(), fValue);
 }
 
 
@@ -298,8 +972,9 @@ void VFloat::GetString(VString& outValue) const
 	}
 	else
 	{
+		VFloatAPMView view;
 		char str[10000];
-		m_apm_to_fixpt_string(str, -1, fValue);
+		m_apm_to_fixpt_string(str, -1, _GetAPM( view));
 		//m_apm_to_string(str, -1, fValue);
 		outValue.FromCString(str);
 	}
@@ -316,31 +991,33 @@ void VFloat::FromBoolean(Boolean inValue)
 {
 	SetNull(false);
 	if (inValue)
-		m_apm_set_long(fValue, 1);
+		FromLong(1);
 	else
-		m_apm_set_long(fValue, 0);
+		FromLong(0);
 }
 
 
 void VFloat::FromWord(sWORD inValue)
 {
 	SetNull(false);
-	m_apm_set_long(fValue, (sLONG) inValue);
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 }
 
 
 void VFloat::FromLong(sLONG inValue)
 {
 	SetNull(false);
-	m_apm_set_long(fValue, inValue);
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 }
 
 
 void VFloat::FromLong8(sLONG8 inValue)
 {
-	VString str;
-	str.FromLong8(inValue);
-	FromString(str);
+	SetNull(false);
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 }
 
 
@@ -348,7 +1025,8 @@ void VFloat::FromReal(Real inValue)
 {
 	if (finite( inValue))	// mapm crash on inf on mac.
 	{
-		m_apm_set_double(fValue, inValue);
+		m_apm_set_double(_GetAPMForWrite(), inValue);
+		_TryDecimalFromAPM();
 		GotValue();
 	}
 	else
@@ -361,7 +1039,10 @@ void VFloat::FromReal(Real inValue)
 void VFloat::FromFloat(const VFloat& inValue)
 {
 	SetNull(inValue.IsNull());
-	m_apm_copy(fValue, inValue.fValue);
+	if (inValue.fIsDecimal)
+		_SetDecimal( inValue.fDecimal);
+	else if (&inValue != this)
+		m_apm_copy(_GetAPMForWrite(), inValue.fValue);
 }
 
 
@@ -381,7 +1062,8 @@ void VFloat::FromString(const VString& inValue)
 	{
 		SetNull(false);
 		VStringConvertBuffer convert(inValue, VTC_StdLib_char);
-		m_apm_set_string(fValue, (char*) convert.GetCPointer());
+		m_apm_set_string(_GetAPMForWrite(), (char*) convert.GetCPointer());
+		_TryDecimalFromAPM();
 	}
 }
 
@@ -394,7 +1076,8 @@ void VFloat::FromValue(const VValueSingle& inValue)
 
 VSize VFloat::GetSpace(VSize /* inMax */) const
 {
-	return sizeof(sLONG) + sizeof(sBYTE) + sizeof(sLONG) + fValue->m_apm_datalength;
+	VFloatAPMView view;
+	return sizeof(sLONG) + sizeof(sBYTE) + sizeof(sLONG) + _GetAPM( view)->m_apm_datalength;
 }
 
 
@@ -408,12 +1091,12 @@ void* VFloat::LoadFromPtr(const void* inDataPtr, Boolean /*inRefOnly*/)
 
 	tmp.m_apm_sign = *(sBYTE*) ptr;
 	ptr += sizeof(sBYTE);
-	
+
 	tmp.m_apm_datalength = *(sLONG*) ptr;
 	ptr += sizeof(sLONG);
 
 	tmp.m_apm_data = ptr;
-	m_apm_copy(fValue, &tmp);
+	_SetFromAPM(tmp);
 
 	return ptr + tmp.m_apm_datalength;
 }
@@ -421,50 +1104,69 @@ void* VFloat::LoadFromPtr(const void* inDataPtr, Boolean /*inRefOnly*/)
 
 void* VFloat::WriteToPtr(void* inDataPtr, Boolean /*inRefOnly*/, VSize inMax) const
 {
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
 	uBYTE*	ptr = (uBYTE*) inDataPtr;
 
-	*(sLONG*) ptr = (sLONG) fValue->m_apm_exponent;
+	*(sLONG*) ptr = (sLONG) value->m_apm_exponent;
 	ptr += sizeof(sLONG);
 
-	*(sBYTE*) ptr = fValue->m_apm_sign;
+	*(sBYTE*) ptr = value->m_apm_sign;
 	ptr += sizeof(sBYTE);
-	
-	*(sLONG*) ptr = (sLONG) fValue->m_apm_datalength;
+
+	*(sLONG*) ptr = (sLONG) value->m_apm_datalength;
 	ptr += sizeof(sLONG);
-	
-	VMemory::CopyBlock(fValue->m_apm_data, ptr, fValue->m_apm_datalength);
 
-	return ptr + fValue->m_apm_datalength;
+	VMemory::CopyBlock(value->m_apm_data, ptr, value->m_apm_datalength);
+
+	return ptr + value->m_apm_datalength;
 }
 
 
 VError VFloat::ReadFromStream(VStream* inStream, sLONG /*inParam*/)
 {
 	M_APM_struct tmp;
+	UCHAR buffer[kDECIMAL_APM_DATA_SIZE];
 
 	tmp.m_apm_exponent   = inStream->GetLong();
 	tmp.m_apm_sign       = inStream->GetByte();
 	tmp.m_apm_datalength = inStream->GetLong();
-	
-	tmp.m_apm_data = (uBYTE*) vMalloc(tmp.m_apm_datalength, 'mapm');
-	
-	inStream->GetData( tmp.m_apm_data, tmp.m_apm_datalength);
-	m_apm_copy(fValue, &tmp);
-	
-	vFree(tmp.m_apm_data);
 
-	return inStream->GetLastError();
+	VError err = inStream->GetLastError();
+	if (err != VE_OK)
+		return err;
+
+	// an M_APM value always has at least one digit
+	if (tmp.m_apm_datalength <= 0)
+		return vThrowError( VE_STREAM_CANNOT_READ);
+
+	// most values fit in the stack buffer
+	if (tmp.m_apm_datalength <= kDECIMAL_APM_DATA_SIZE)
+		tmp.m_apm_data = buffer;
+	else if ((tmp.m_apm_data = (uBYTE*) vMalloc(tmp.m_apm_datalength, 'mapm')) == NULL)
+		return vThrowError( VE_MEMORY_FULL);
+
+	err = inStream->GetData( tmp.m_apm_data, tmp.m_apm_datalength);
+	if (err == VE_OK)
+		_SetFromAPM(tmp);
+
+	if (tmp.m_apm_data != buffer)
+		vFree(tmp.m_apm_data);
+
+	return err;
 }
 
 
 VError VFloat::WriteToStream(VStream* inStream, sLONG inParam) const
 {
 	VValue::WriteToStream(inStream, inParam);
-	
-	inStream->PutLong((sLONG) fValue->m_apm_exponent);
-	inStream->PutByte(fValue->m_apm_sign);
-	inStream->PutLong((sLONG) fValue->m_apm_datalength);
-	inStream->PutData(fValue->m_apm_data, fValue->m_apm_datalength);
+
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	inStream->PutLong((sLONG) value->m_apm_exponent);
+	inStream->PutByte(value->m_apm_sign);
+	inStream->PutLong((sLONG) value->m_apm_datalength);
+	inStream->PutData(value->m_apm_data, value->m_apm_datalength);
 
 	return inStream->GetLastError();
 }
@@ -472,9 +1174,10 @@ VError VFloat::WriteToStream(VStream* inStream, sLONG inParam) const
 
 CompareResult VFloat::CompareToSameKindPtr(const void* inPtrToValueData, Boolean /*inDiacritical*/) const
 {
+	VFloatAPMView view;
 	M_APM_struct tmp;
 	makeTmp_M_APM_FromPtr(tmp, inPtrToValueData);
-	int res = m_apm_compare(fValue, &tmp);
+	int res = m_apm_compare(_GetAPM( view), &tmp);
 	if (res > 0)
 		return CR_BIGGER;
 	else
@@ -489,9 +1192,10 @@ CompareResult VFloat::CompareToSameKindPtr(const void* inPtrToValueData, Boolean
 
 Boolean VFloat::EqualToSameKindPtr(const void* inPtrToValueData, Boolean /*inDiacritical*/) const
 {
+	VFloatAPMView view;
 	M_APM_struct tmp;
 	makeTmp_M_APM_FromPtr(tmp, inPtrToValueData);
-	return m_apm_compare(fValue, &tmp) == 0;
+	return m_apm_compare(_GetAPM( view), &tmp) == 0;
 }
 
 
@@ -500,8 +1204,8 @@ CompareResult VFloat::CompareToSameKind(const VValue* inValue, Boolean /*inDiacr
 	XBOX_ASSERT_KINDOF(VFloat, inValue);
 	const VFloat* theValue = reinterpret_cast<const VFloat*>(inValue);
 
-	int result = m_apm_compare(fValue, theValue->fValue) ;
-		 
+	int result = _Compare(*theValue);
+
 	if (result > 0)
 		return CR_BIGGER;
 	else if (result < 0)
@@ -516,7 +1220,7 @@ Boolean VFloat::EqualToSameKind(const VValue* inValue, Boolean /*inDiacritical*/
 	XBOX_ASSERT_KINDOF(VFloat, inValue);
 	const VFloat* theValue = reinterpret_cast<const VFloat*>(inValue);
 
-	return 0 == m_apm_compare(fValue, theValue->fValue);
+	return 0 == _Compare(*theValue);
 }
 
 
@@ -525,8 +1229,8 @@ CompareResult VFloat::CompareToSameKindWithOptions( const VValue* inValue, const
 	XBOX_ASSERT_KINDOF(VFloat, inValue);
 	const VFloat* theValue = reinterpret_cast<const VFloat*>(inValue);
 
-	int result = m_apm_compare(fValue, theValue->fValue) ;
-		 
+	int result = _Compare(*theValue);
+
 	if (result > 0)
 		return CR_BIGGER;
 	else if (result < 0)
@@ -541,15 +1245,16 @@ bool VFloat::EqualToSameKindWithOptions( const VValue* inValue, const VCompareOp
 	XBOX_ASSERT_KINDOF(VFloat, inValue);
 	const VFloat* theValue = reinterpret_cast<const VFloat*>(inValue);
 
-	return 0 == m_apm_compare(fValue, theValue->fValue);
+	return 0 == _Compare(*theValue);
 }
 
 
 CompareResult VFloat::CompareToSameKindPtrWithOptions( const void* inPtrToValueData, const VCompareOptions& inOptions) const
 {
+	VFloatAPMView view;
 	M_APM_struct tmp;
 	makeTmp_M_APM_FromPtr(tmp, inPtrToValueData);
-	int res = m_apm_compare(fValue, &tmp);
+	int res = m_apm_compare(_GetAPM( view), &tmp);
 	if (res > 0)
 		return CR_BIGGER;
 	else
@@ -564,9 +1269,10 @@ CompareResult VFloat::CompareToSameKindPtrWithOptions( const void* inPtrToValueD
 
 bool VFloat::EqualToSameKindPtrWithOptions( const void* inPtrToValueData, const VCompareOptions& inOptions) const
 {
+	VFloatAPMView view;
 	M_APM_struct tmp;
 	makeTmp_M_APM_FromPtr(tmp, inPtrToValueData);
-	return m_apm_compare(fValue, &tmp) == 0;
+	return m_apm_compare(_GetAPM( view), &tmp) == 0;
 }
 
 
@@ -575,7 +1281,10 @@ Boolean VFloat::FromValueSameKind(const VValue* inValue)
 	XBOX_ASSERT_KINDOF(VFloat, inValue);
 	const VFloat* theValue = reinterpret_cast<const VFloat*>(inValue);
 
-	m_apm_copy(fValue, theValue->fValue);
+	if (theValue->fIsDecimal)
+		_SetDecimal( theValue->fDecimal);
+	else if (theValue != this)
+		m_apm_copy(_GetAPMForWrite(), theValue->fValue);
 	GotValue(theValue->IsNull());
 	return true;
 }
@@ -583,7 +1292,10 @@ Boolean VFloat::FromValueSameKind(const VValue* inValue)
 
 VFloat& VFloat::operator=(const VFloat &inValue)
 {
-	m_apm_copy(fValue, inValue.fValue);
+	if (inValue.fIsDecimal)
+		_SetDecimal( inValue.fDecimal);
+	else if (&inValue != this)
+		m_apm_copy(_GetAPMForWrite(), inValue.fValue);
 	GotValue(inValue.IsNull());
 	return *this;
 }
@@ -591,22 +1303,15 @@ VFloat& VFloat::operator=(const VFloat &inValue)
 
 VFloat& VFloat::operator=(Real inValue)
 {
-	if (finite( inValue))	// mapm crash on inf on mac.
-	{
-		m_apm_set_double(fValue, inValue);
-		GotValue();
-	}
-	else
-	{
-		SetNull( true);
-	}
+	FromReal(inValue);
 	return *this;
 }
 
 
 VFloat& VFloat::operator=(sLONG inValue)
 {
-	m_apm_set_long(fValue, inValue);
+	_SetDecimalFromLong8( fDecimal, inValue);
+	fIsDecimal = true;
 	GotValue();
 	return *this;
 }
@@ -614,246 +1319,412 @@ VFloat& VFloat::operator=(sLONG inValue)
 
 bool VFloat::operator == (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) == 0;
+	return _Compare(inValue) == 0;
 }
 
 
 bool VFloat::operator != (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) != 0;
+	return _Compare(inValue) != 0;
 }
 
 
 bool VFloat::operator < (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) < 0;
+	return _Compare(inValue) < 0;
 }
 
 
 bool VFloat::operator <= (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) <= 0;
+	return _Compare(inValue) <= 0;
 }
 
 
 bool VFloat::operator > (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) > 0;
+	return _Compare(inValue) > 0;
 }
 
 
 bool VFloat::operator >= (const VFloat &inValue) const
 {
-	return m_apm_compare(fValue, inValue.fValue) >= 0;
+	return _Compare(inValue) >= 0;
 }
 
 
 void VFloat::Add(VFloat& outResult, const VFloat& inValue)
 {
-	m_apm_add(outResult.fValue, fValue, inValue.fValue);
+	VFloatDecimal result;
+	if (fIsDecimal && inValue.fIsDecimal && _AddDecimals( fDecimal, inValue.fDecimal, result))
+	{
+		outResult._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view1, view2;
+		M_APM value1 = _GetAPM( view1), value2 = inValue._GetAPM( view2);
+		m_apm_add(outResult._GetAPMForWrite(), value1, value2);
+		outResult._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::Sub(VFloat& outResult, const VFloat& inValue)
 {
-	m_apm_subtract(outResult.fValue, fValue, inValue.fValue);
+	VFloatDecimal result, negated = inValue.fDecimal;
+	negated.fSign = -negated.fSign;
+	if (fIsDecimal && inValue.fIsDecimal && _AddDecimals( fDecimal, negated, result))
+	{
+		outResult._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view1, view2;
+		M_APM value1 = _GetAPM( view1), value2 = inValue._GetAPM( view2);
+		m_apm_subtract(outResult._GetAPMForWrite(), value1, value2);
+		outResult._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::Divide(VFloat& outResult, const VFloat& inValue)
 {
-	m_apm_divide(outResult.fValue, _digits(fValue), fValue, inValue.fValue);
+	VFloatAPMView view1, view2;
+	M_APM value1 = _GetAPM( view1), value2 = inValue._GetAPM( view2);
+	m_apm_divide(outResult._GetAPMForWrite(), _digits(value1), value1, value2);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Multiply(VFloat& outResult, const VFloat& inValue)
 {
-	m_apm_multiply(outResult.fValue, fValue, inValue.fValue);
+	VFloatDecimal result;
+	if (fIsDecimal && inValue.fIsDecimal && _MultiplyDecimals( fDecimal, inValue.fDecimal, result))
+	{
+		outResult._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view1, view2;
+		M_APM value1 = _GetAPM( view1), value2 = inValue._GetAPM( view2);
+		m_apm_multiply(outResult._GetAPMForWrite(), value1, value2);
+		outResult._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::Pi(VFloat& outResult)
 {
-	m_apm_copy(outResult.fValue, MM_PI);
+	m_apm_copy(outResult._GetAPMForWrite(), MM_PI);
 }
 
 
 sWORD VFloat::Sign() const
 {
+	if (fIsDecimal)
+		return fDecimal.fSign;
 	return (sWORD) m_apm_sign(fValue);
 }
 
 
-sLONG VFloat::Exponent() const 
+sLONG VFloat::Exponent() const
 {
+	if (fIsDecimal)
+		return (fDecimal.fSign == 0) ? 0 : _CountDigits( fDecimal.fHigh, fDecimal.fLow) + fDecimal.fExponent - 1;
 	return m_apm_exponent(fValue);
 }
 
 
-sLONG VFloat::SignificantDigits() const 
+sLONG VFloat::SignificantDigits() const
 {
+	if (fIsDecimal)
+	{
+		VFloatDecimal value = fDecimal;
+		_NormalizeDecimal( value);
+		return (value.fSign == 0) ? 1 : _CountDigits( value.fHigh, value.fLow);
+	}
 	return m_apm_significant_digits(fValue);
 }
 
 
-Boolean VFloat::IsInteger() const 
+Boolean VFloat::IsInteger() const
 {
+	if (fIsDecimal)
+	{
+		VFloatDecimal value = fDecimal;
+		_NormalizeDecimal( value);
+		return value.fExponent >= 0;
+	}
 	return 0 != m_apm_is_integer(fValue);
 }
 
 
 void VFloat::Abs(VFloat& outFloat) const
 {
-	m_apm_absolute_value(outFloat.fValue, fValue);
+	if (fIsDecimal)
+	{
+		VFloatDecimal result = fDecimal;
+		result.fSign = (sBYTE) ((result.fSign < 0) ? -result.fSign : result.fSign);
+		outFloat._SetDecimal( result);
+	}
+	else
+	{
+		m_apm_absolute_value(outFloat._GetAPMForWrite(), fValue);
+	}
 }
 
 
 void VFloat::Negate(VFloat& outFloat) const
 {
-	m_apm_negate(outFloat.fValue, fValue);
+	if (fIsDecimal)
+	{
+		VFloatDecimal result = fDecimal;
+		result.fSign = -result.fSign;
+		outFloat._SetDecimal( result);
+	}
+	else
+	{
+		m_apm_negate(outFloat._GetAPMForWrite(), fValue);
+	}
 }
 
 
 void VFloat::Round(VFloat& outFloat, sLONG inToDigits) const
 {
-	m_apm_round(outFloat.fValue, inToDigits, fValue);
+	VFloatDecimal result;
+	if (fIsDecimal && _RoundDecimal( fDecimal, inToDigits, result))
+	{
+		outFloat._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view;
+		M_APM value = _GetAPM( view);
+		m_apm_round(outFloat._GetAPMForWrite(), inToDigits, value);
+		outFloat._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::Sqrt(VFloat& outResult)
 {
-	m_apm_sqrt(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_sqrt(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Cbrt(VFloat& outResult)
 {
-	m_apm_cbrt(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_cbrt(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Log(VFloat& outResult)
 {
-	m_apm_log(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_log(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Exp(VFloat& outResult)
 {
-	m_apm_exp(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_exp(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Log10(VFloat& outResult)
 {
-	m_apm_log10(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_log10(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Sin(VFloat& outResult)
 {
-	m_apm_sin(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_sin(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Asin(VFloat& outResult)
 {
-	m_apm_asin(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_asin(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Cos(VFloat& outResult)
 {
-	m_apm_cos(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_cos(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Acos(VFloat& outResult)
 {
-	m_apm_acos(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_acos(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Tan(VFloat& outResult)
 {
-	m_apm_tan(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_tan(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Atan(VFloat& outResult)
 {
-	m_apm_atan(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_atan(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Sinh(VFloat& outResult)
 {
-	m_apm_sinh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_sinh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Asinh(VFloat& outResult)
 {
-	m_apm_asinh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_asinh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Cosh(VFloat& outResult)
 {
-	m_apm_cosh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_cosh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Acosh(VFloat& outResult)
 {
-	m_apm_acosh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_acosh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Tanh(VFloat& outResult)
 {
-	m_apm_tanh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_tanh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Atanh(VFloat& outResult)
 {
-	m_apm_atanh(outResult.fValue, _digits(fValue), fValue);
+	VFloatAPMView view;
+	M_APM value = _GetAPM( view);
+	m_apm_atanh(outResult._GetAPMForWrite(), _digits(value), value);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Pow(VFloat& outValue, const VFloat &inPower) const
 {
-	m_apm_pow(outValue.fValue, _digits(fValue, inPower), fValue, inPower.fValue);
+	VFloatAPMView view1, view2;
+	M_APM value = _GetAPM( view1), power = inPower._GetAPM( view2);
+	m_apm_pow(outValue._GetAPMForWrite(), _digits(value, inPower), value, power);
+	outValue._TryDecimalFromAPM();
 }
 
 
-void VFloat::Random(VFloat& outResult) 
+void VFloat::Random(VFloat& outResult)
 {
-	m_apm_get_random(outResult.fValue);
+	m_apm_get_random(outResult._GetAPMForWrite());
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::Floor(VFloat& outResult) const
 {
-	m_apm_floor(outResult.fValue, fValue);
+	VFloatDecimal result;
+	if (fIsDecimal && _RoundDecimalToInteger( fDecimal, true, result))
+	{
+		outResult._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view;
+		M_APM value = _GetAPM( view);
+		m_apm_floor(outResult._GetAPMForWrite(), value);
+		outResult._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::Ceil(VFloat& outResult) const
 {
-	m_apm_ceil(outResult.fValue, fValue);
+	VFloatDecimal result;
+	if (fIsDecimal && _RoundDecimalToInteger( fDecimal, false, result))
+	{
+		outResult._SetDecimal( result);
+	}
+	else
+	{
+		VFloatAPMView view;
+		M_APM value = _GetAPM( view);
+		m_apm_ceil(outResult._GetAPMForWrite(), value);
+		outResult._TryDecimalFromAPM();
+	}
 }
 
 
 void VFloat::IntegerDivide(VFloat& outResult, const VFloat &inDenom) const
 {
-	m_apm_integer_divide(outResult.fValue, fValue, inDenom.fValue);
+	VFloatAPMView view1, view2;
+	M_APM value1 = _GetAPM( view1), value2 = inDenom._GetAPM( view2);
+	m_apm_integer_divide(outResult._GetAPMForWrite(), value1, value2);
+	outResult._TryDecimalFromAPM();
 }
 
 
 void VFloat::IntegerDivRemainder(const VFloat &outResult, const VFloat &inDenom) const
 {
 	VFloat q;
-	m_apm_integer_div_rem(q.fValue, outResult.fValue, fValue, inDenom.fValue);
+	VFloat& result = const_cast<VFloat&>( outResult);
+	VFloatAPMView view1, view2;
+	M_APM value1 = _GetAPM( view1), value2 = inDenom._GetAPM( view2);
+	m_apm_integer_div_rem(q._GetAPMForWrite(), result._GetAPMForWrite(), value1, value2);
+	result._TryDecimalFromAPM();
 }
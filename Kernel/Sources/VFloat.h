@@ -26,6 +26,24 @@ BEGIN_TOOLBOX_NAMESPACE
 // Defined bellow
 class VFloat;
 
+// Defined in VFloat.cpp
+struct VFloatAPMView;
+
+
+/*
+	Inline decimal value of a VFloat: fSign * fCoefficient * 10^fExponent.
+	The coefficient (fHigh:fLow) is lower than 10^38 so that it holds 38 significant digits.
+	The coefficient may have trailing zeros: values are normalized only when serialized.
+*/
+typedef struct VFloatDecimal
+{
+	uLONG8	fLow;
+	uLONG8	fHigh;
+	sLONG	fExponent;
+	sBYTE	fSign;		// -1, 0 or 1 (the coefficient is 0 if fSign is 0)
+} VFloatDecimal;
+
+
 
 class XTOOLBOX_API VFloat_info : public VValueInfo_default<VFloat, VK_FLOAT>
 {
@@ -164,7 +182,22 @@ public:
 	static void	Pi (VFloat& outResult);
 
 protected:
-	::M_APM_struct*	fValue;
+	::M_APM_struct*	fValue;		// M_APM value, allocated on first need and kept for reuse
+	VFloatDecimal	fDecimal;
+	bool			fIsDecimal;	// true if the value is held by fDecimal (fValue is then irrelevant)
+
+private:
+	// returns the M_APM value, using ioView storage if the value is held by fDecimal
+	::M_APM_struct*	_GetAPM( VFloatAPMView& ioView) const;
+
+	// switches to the M_APM value for writing
+	::M_APM_struct*	_GetAPMForWrite();
+
+	void			_SetDecimal( const VFloatDecimal& inDecimal)		{ fDecimal = inDecimal; fIsDecimal = true; }
+	void			_SetFromAPM( const ::M_APM_struct& inValue);
+	void			_TryDecimalFromAPM();
+
+	int				_Compare( const VFloat& inValue) const;
 };
 
 END_TOOLBOX_NAMESPACE
@@ -18,6 +18,10 @@
 
 #include "VInterlocked.h"
 
+#if VERSIONWIN && !ARCH_64
+#include <intrin.h>
+#endif
+
 
 sLONG VInterlocked::Increment( sLONG* inValue)
 {
@@ -37,6 +41,33 @@ sLONG VInterlocked::Increment( sLONG* inValue)
 }
 
 
+sLONG8 VInterlocked::Increment( sLONG8* inValue)
+{
+#if VERSIONWIN
+
+#if ARCH_64
+    return ::InterlockedIncrement64( inValue);
+#else
+	// the intrinsic compiles to cmpxchg8b and doesn't need InterlockedCompareExchange64 from the system
+	sLONG8 val;
+	do {
+		val = *inValue;
+	} while( ::_InterlockedCompareExchange64( inValue, val + 1, val) != val);
+	return val + 1;
+#endif
+
+#elif VERSIONMAC
+
+    return ::OSAtomicAdd64Barrier( 1, reinterpret_cast<int64_t*>( inValue));
+
+#elif VERSION_LINUX
+
+    return __sync_add_and_fetch(inValue, 1);
+
+#endif
+}
+
+
 sLONG VInterlocked::Decrement( sLONG* inValue)
 {
 #if VERSIONWIN
@@ -36,6 +36,7 @@ public:
 	
 	// returns the value after increment / decrement
 	static	sLONG		Increment           (sLONG* inValue);
+	static	sLONG8		Increment           (sLONG8* inValue);
 	static	sLONG		Decrement           (sLONG* inValue);
 	static  sLONG		AtomicAdd           (sLONG* inValue, sLONG inAddValue);
 
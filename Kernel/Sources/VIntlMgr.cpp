@@ -402,6 +402,58 @@ static int usascii_stricmp( const char *s1, const char *s2)
 }
 
 
+BEGIN_TOOLBOX_NAMESPACE
+
+/*
+	Locale data of a VIntlMgr, shared by all its clones.
+	It is filled when the first manager is built and never modified afterwards.
+*/
+class VIntlMgrCore : public VObject, public IRefCountable
+{
+public:
+	VIntlMgrCore( DialectCode inDialect)
+	: fCollator( NULL)
+	#if USE_ICU
+	, fLocale( new xbox_icu::Locale( VIntlMgr::GetISO6391LanguageCode( inDialect), VIntlMgr::GetISO3166RegionCode( inDialect)))
+	#endif
+	{
+	}
+
+	virtual ~VIntlMgrCore()
+	{
+		ReleaseRefCountable( &fCollator);
+		#if USE_ICU
+		delete fLocale;
+		#endif
+	}
+
+			VCollator*				fCollator;	// each manager uses its own clone
+
+			#if USE_ICU
+			xbox_icu::Locale*		fLocale;
+			#endif
+
+			VString					fAMString;
+			VString					fPMString;
+
+			VString					fDecimalSeparator;
+			VString					fThousandsSeparator;
+			VString					fDateSeparator;
+			VString					fTimeSeparator;
+			VString					fCurrency;
+
+			VString					fShortDatePattern;
+			VString					fMediumDatePattern;
+			VString					fLongDatePattern;
+
+			VString					fShortTimePattern;
+			VString					fMediumTimePattern;
+			VString					fLongTimePattern;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
 // Class statics
 //VIntlMgr*	VIntlMgr::sDefaultMgr = NULL;
 bool VIntlMgr::sICU_Available = false;
@@ -414,11 +466,14 @@ class IMecabModel* VIntlMgr::sMecabModel = NULL;
 VIntlMgr::VIntlMgr( DialectCode inDialect, EKeyWordOptions inKeyWordOptions)
 : fDialect( inDialect)
 , fImpl( inDialect)
+, fCore( new VIntlMgrCore( inDialect))
 , fUseICUCollator( false)
 , fKeyWordOptions( inKeyWordOptions)
+, fUsingAmPm( false)
+, fDateOrder( DO_MONTH_DAY_YEAR)
 , fCollator( NULL)
+, fWildChar( VCollator::GetDefaultWildChar())
 #if USE_ICU
-, fLocale( new xbox_icu::Locale( GetISO6391LanguageCode( inDialect), GetISO3166RegionCode( inDialect)))
 , fUpperStripDiacriticsTransformation( NULL)
 , fLowerStripDiacriticsTransformation( NULL)
 , fBreakIterator( NULL)
@@ -434,26 +489,14 @@ VIntlMgr::VIntlMgr( DialectCode inDialect, EKeyWordOptions inKeyWordOptions)
 VIntlMgr::VIntlMgr( const VIntlMgr& inMgr)
 : fUseICUCollator( inMgr.fUseICUCollator)
 , fImpl( inMgr.fImpl)
+, fCore( RetainRefCountable( inMgr.fCore))
 , fKeyWordOptions( inMgr.fKeyWordOptions)
 , fDialect( inMgr.fDialect)
-, fAMString( inMgr.fAMString)
-, fPMString( inMgr.fPMString)
 , fUsingAmPm( inMgr.fUsingAmPm)
-, fDecimalSeparator( inMgr.fDecimalSeparator)
-, fThousandsSeparator( inMgr.fThousandsSeparator)
-, fDateSeparator( inMgr.fDateSeparator)
-, fTimeSeparator( inMgr.fTimeSeparator)
-, fCurrency( inMgr.fCurrency)
-, fShortDatePattern( inMgr.fShortDatePattern)
-, fMediumDatePattern( inMgr.fMediumDatePattern)
-, fLongDatePattern( inMgr.fLongDatePattern)
-, fShortTimePattern( inMgr.fShortTimePattern)
-, fMediumTimePattern( inMgr.fMediumTimePattern)
-, fLongTimePattern( inMgr.fLongTimePattern)
 , fDateOrder( inMgr.fDateOrder)
-, fCollator( inMgr.fCollator->Clone())
+, fCollator( NULL)
+, fWildChar( inMgr.GetWildChar())
 #if USE_ICU
-, fLocale( inMgr.fLocale->clone())
 , fUpperStripDiacriticsTransformation( NULL)
 , fLowerStripDiacriticsTransformation( NULL)
 , fBreakIterator( NULL)
@@ -469,9 +512,9 @@ VIntlMgr::VIntlMgr( const VIntlMgr& inMgr)
 VIntlMgr::~VIntlMgr()
 {
 	ReleaseRefCountable( &fCollator);
+	ReleaseRefCountable( &fCore);
 
 	#if USE_ICU
-	delete fLocale;
 	delete fUpperStripDiacriticsTransformation;
 	delete fLowerStripDiacriticsTransformation;
 	if (fBreakIterator)
@@ -508,8 +551,8 @@ VIntlMgr *VIntlMgr::Create( DialectCode inDialect, DialectCode inDialectForColla
 	VIntlMgr *currentTaskManager = VTask::GetCurrentIntlManager();
 	if ( (currentTaskManager != NULL)
 		&& (currentTaskManager->GetDialectCode() == dialect)
-		&& (currentTaskManager->GetCollator()->GetDialectCode() == dialectForCollator)
-		&& (currentTaskManager->GetCollator()->GetOptions() == inCollatorOptions) )
+		&& (currentTaskManager->_GetSharedCollator()->GetDialectCode() == dialectForCollator)
+		&& (currentTaskManager->_GetSharedCollator()->GetOptions() == inCollatorOptions) )
 	{
 		manager = currentTaskManager->Clone();
 
@@ -545,7 +588,7 @@ VIntlMgr *VIntlMgr::Create( DialectCode inDialect, DialectCode inDialectForColla
 			bool ok = true;
 			
 			#if USE_ICU
-			ok = (manager->fLocale != NULL) && !manager->fLocale->isBogus();
+			ok = (manager->fCore->fLocale != NULL) && !manager->fCore->fLocale->isBogus();
 			#endif
 			
 			if (ok)
@@ -574,7 +617,107 @@ VIntlMgr* VIntlMgr::Clone()
 
 void VIntlMgr::Reset()
 {
-	GetCollator()->Reset();
+	fWildChar = VCollator::GetDefaultWildChar();
+	if (fCollator != NULL)
+		fCollator->Reset();
+}
+
+
+VCollator* VIntlMgr::_GetSharedCollator() const
+{
+	return fCore->fCollator;
+}
+
+
+VCollator* VIntlMgr::_CreateCollator() const
+{
+	xbox_assert( fCollator == NULL);
+
+	// the shared collator itself is never used to compare strings so that any task may clone it
+	VCollator *collator = fCore->fCollator->Clone();
+	if (collator->GetWildChar() != fWildChar)
+		collator->SetWildChar( fWildChar);
+	fCollator = collator;
+
+	return fCollator;
+}
+
+
+const VString& VIntlMgr::GetAMString() const
+{
+	return fCore->fAMString;
+}
+
+
+const VString& VIntlMgr::GetPMString() const
+{
+	return fCore->fPMString;
+}
+
+
+const VString& VIntlMgr::GetDateSeparator() const
+{
+	return fCore->fDateSeparator;
+}
+
+
+const VString& VIntlMgr::GetTimeSeparator() const
+{
+	return fCore->fTimeSeparator;
+}
+
+
+const VString& VIntlMgr::GetThousandsSeparator() const
+{
+	return fCore->fThousandsSeparator;
+}
+
+
+const VString& VIntlMgr::GetDecimalSeparator() const
+{
+	return fCore->fDecimalSeparator;
+}
+
+
+const VString& VIntlMgr::GetCurrency() const
+{
+	return fCore->fCurrency;
+}
+
+
+const VString& VIntlMgr::GetLongDatePattern() const
+{
+	return fCore->fLongDatePattern;
+}
+
+
+const VString& VIntlMgr::GetMediumDatePattern() const
+{
+	return fCore->fMediumDatePattern;
+}
+
+
+const VString& VIntlMgr::GetShortDatePattern() const
+{
+	return fCore->fShortDatePattern;
+}
+
+
+const VString& VIntlMgr::GetLongTimePattern() const
+{
+	return fCore->fLongTimePattern;
+}
+
+
+const VString& VIntlMgr::GetMediumTimePattern() const
+{
+	return fCore->fMediumTimePattern;
+}
+
+
+const VString& VIntlMgr::GetShortTimePattern() const
+{
+	return fCore->fShortTimePattern;
 }
 
 
@@ -955,17 +1098,17 @@ bool VIntlMgr::_InitLocaleVariables()
 	{
 		// Decimal separator
 		CFStringRef value=(CFStringRef)::CFLocaleGetValue(userLocale,kCFLocaleDecimalSeparator);
-		fDecimalSeparator.MAC_FromCFString(value);
+		fCore->fDecimalSeparator.MAC_FromCFString(value);
 		
 		// Thousands separator
 		value=(CFStringRef)::CFLocaleGetValue(userLocale,kCFLocaleGroupingSeparator);
-		fThousandsSeparator.MAC_FromCFString(value);
+		fCore->fThousandsSeparator.MAC_FromCFString(value);
 		
 		// Currency symbol
 		value=(CFStringRef)::CFLocaleGetValue(userLocale,kCFLocaleCurrencySymbol);
-		fCurrency.MAC_FromCFString(value);
-		if ((fCurrency.GetLength()==1) && (fCurrency[0]==0xa4))
-			fCurrency=(UniChar)0x20ac;
+		fCore->fCurrency.MAC_FromCFString(value);
+		if ((fCore->fCurrency.GetLength()==1) && (fCore->fCurrency[0]==0xa4))
+			fCore->fCurrency=(UniChar)0x20ac;
 
 		// Values for time variables
 		CFDateFormatterRef p_TimeFormatter=::CFDateFormatterCreate(NULL,userLocale,kCFDateFormatterNoStyle,kCFDateFormatterShortStyle);
@@ -973,12 +1116,12 @@ bool VIntlMgr::_InitLocaleVariables()
 		{
 			// AM String
 			CFStringRef p_value=(CFStringRef)::CFDateFormatterCopyProperty(p_TimeFormatter,kCFDateFormatterAMSymbol);
-			fAMString.MAC_FromCFString(p_value);
+			fCore->fAMString.MAC_FromCFString(p_value);
 			::CFRelease(p_value);
 			
 			// PM String
 			p_value=(CFStringRef)::CFDateFormatterCopyProperty(p_TimeFormatter,kCFDateFormatterPMSymbol);
-			fPMString.MAC_FromCFString(p_value);
+			fCore->fPMString.MAC_FromCFString(p_value);
 			::CFRelease(p_value);
 			
 			// Time format
@@ -1009,9 +1152,9 @@ bool VIntlMgr::_InitLocaleVariables()
 					break;
 					
 				default:
-					if (fTimeSeparator.IsEmpty() && (((c<'A') || (c>'z')) || ((c>'Z') && (c<'a'))))
+					if (fCore->fTimeSeparator.IsEmpty() && (((c<'A') || (c>'z')) || ((c>'Z') && (c<'a'))))
 					{
-						fTimeSeparator=c;
+						fCore->fTimeSeparator=c;
 					}
 				}
 			}
@@ -1054,9 +1197,9 @@ bool VIntlMgr::_InitLocaleVariables()
 					break;
 					
 				default:
-					if (fDateSeparator.IsEmpty() && (((c<'A') || (c>'z')) || ((c>'Z') && (c<'a'))))
+					if (fCore->fDateSeparator.IsEmpty() && (((c<'A') || (c>'z')) || ((c>'Z') && (c<'a'))))
 					{
-						fDateSeparator=c;
+						fCore->fDateSeparator=c;
 					}
 				}
 			}
@@ -1087,12 +1230,12 @@ bool VIntlMgr::_InitLocaleVariables()
 			VString* pStringToInit;
 		} DateTimeFormatInitializer;
 		DateTimeFormatInitializer initializer[]={
-			{kCFDateFormatterNoStyle,kCFDateFormatterShortStyle,&fShortTimePattern},
-			{kCFDateFormatterNoStyle,kCFDateFormatterMediumStyle,&fMediumTimePattern},
-			{kCFDateFormatterNoStyle,kCFDateFormatterLongStyle,&fLongTimePattern},
-			{kCFDateFormatterShortStyle,kCFDateFormatterNoStyle,&fShortDatePattern},
-			{kCFDateFormatterMediumStyle,kCFDateFormatterNoStyle,&fMediumDatePattern},
-			{kCFDateFormatterLongStyle,kCFDateFormatterNoStyle,&fLongDatePattern}
+			{kCFDateFormatterNoStyle,kCFDateFormatterShortStyle,&fCore->fShortTimePattern},
+			{kCFDateFormatterNoStyle,kCFDateFormatterMediumStyle,&fCore->fMediumTimePattern},
+			{kCFDateFormatterNoStyle,kCFDateFormatterLongStyle,&fCore->fLongTimePattern},
+			{kCFDateFormatterShortStyle,kCFDateFormatterNoStyle,&fCore->fShortDatePattern},
+			{kCFDateFormatterMediumStyle,kCFDateFormatterNoStyle,&fCore->fMediumDatePattern},
+			{kCFDateFormatterLongStyle,kCFDateFormatterNoStyle,&fCore->fLongDatePattern}
 		};
 		// Date and time patterns loop.
 		for (int i=0; i<(sizeof(initializer)/sizeof(DateTimeFormatInitializer));i++)
@@ -1112,43 +1255,43 @@ bool VIntlMgr::_InitLocaleVariables()
 
 #elif VERSION_LINUX
 
-    xbox_assert(fLocale!=NULL);
+    xbox_assert(fCore->fLocale!=NULL);
 
-    if(fLocale)
-        GetImpl().Init(*fLocale);
+    if(fCore->fLocale)
+        GetImpl().Init(*fCore->fLocale);
 
-    fDecimalSeparator   = GetImpl().GetDecimalSeparator();
-    fThousandsSeparator = GetImpl().GetThousandSeparator();
-    fDateSeparator      = GetImpl().GetDateSeparator();
-    fTimeSeparator      = GetImpl().GetTimeSeparator();
-    fCurrency           = GetImpl().GetCurrency();
-    fLongDatePattern    = GetImpl().GetLongDatePattern();
-    fShortDatePattern   = GetImpl().GetShortDatePattern();
+    fCore->fDecimalSeparator   = GetImpl().GetDecimalSeparator();
+    fCore->fThousandsSeparator = GetImpl().GetThousandSeparator();
+    fCore->fDateSeparator      = GetImpl().GetDateSeparator();
+    fCore->fTimeSeparator      = GetImpl().GetTimeSeparator();
+    fCore->fCurrency           = GetImpl().GetCurrency();
+    fCore->fLongDatePattern    = GetImpl().GetLongDatePattern();
+    fCore->fShortDatePattern   = GetImpl().GetShortDatePattern();
     fDateOrder          = GetImpl().GetDateOrder();
-	fLongTimePattern    = GetImpl().GetLongTimePattern();
-	fMediumTimePattern  = GetImpl().GetMediumTimePattern();
-	fShortTimePattern   = GetImpl().GetShortTimePattern();
-    fAMString           = GetImpl().GetAMString();
-    fPMString           = GetImpl().GetPMString();
+	fCore->fLongTimePattern    = GetImpl().GetLongTimePattern();
+	fCore->fMediumTimePattern  = GetImpl().GetMediumTimePattern();
+	fCore->fShortTimePattern   = GetImpl().GetShortTimePattern();
+    fCore->fAMString           = GetImpl().GetAMString();
+    fCore->fPMString           = GetImpl().GetPMString();
     fUsingAmPm          = GetImpl().UseAmPm();
 
 #elif VERSIONWIN
 	
-	GetImpl().GetLocaleInfo( LOCALE_SDECIMAL, fDecimalSeparator);
-	GetImpl().GetLocaleInfo( LOCALE_STHOUSAND, fThousandsSeparator);
-	GetImpl().GetLocaleInfo( LOCALE_SDATE, fDateSeparator);
-	GetImpl().GetLocaleInfo( LOCALE_STIME, fTimeSeparator);
-	GetImpl().GetLocaleInfo( LOCALE_SCURRENCY, fCurrency);
-	GetImpl().GetLocaleInfo( LOCALE_SLONGDATE, fLongDatePattern);
-	GetImpl().GetLocaleInfo( LOCALE_SSHORTDATE, fShortDatePattern);
-	GetImpl().GetLocaleInfo( LOCALE_STIMEFORMAT, fLongTimePattern);
-	GetImpl().GetLocaleInfo( LOCALE_SDATE, fDateSeparator);
-	GetImpl().GetLocaleInfo( LOCALE_S1159, fAMString);
-	GetImpl().GetLocaleInfo( LOCALE_S2359, fPMString);
+	GetImpl().GetLocaleInfo( LOCALE_SDECIMAL, fCore->fDecimalSeparator);
+	GetImpl().GetLocaleInfo( LOCALE_STHOUSAND, fCore->fThousandsSeparator);
+	GetImpl().GetLocaleInfo( LOCALE_SDATE, fCore->fDateSeparator);
+	GetImpl().GetLocaleInfo( LOCALE_STIME, fCore->fTimeSeparator);
+	GetImpl().GetLocaleInfo( LOCALE_SCURRENCY, fCore->fCurrency);
+	GetImpl().GetLocaleInfo( LOCALE_SLONGDATE, fCore->fLongDatePattern);
+	GetImpl().GetLocaleInfo( LOCALE_SSHORTDATE, fCore->fShortDatePattern);
+	GetImpl().GetLocaleInfo( LOCALE_STIMEFORMAT, fCore->fLongTimePattern);
+	GetImpl().GetLocaleInfo( LOCALE_SDATE, fCore->fDateSeparator);
+	GetImpl().GetLocaleInfo( LOCALE_S1159, fCore->fAMString);
+	GetImpl().GetLocaleInfo( LOCALE_S2359, fCore->fPMString);
 	
-	fMediumDatePattern = fShortDatePattern;
-	fMediumTimePattern = fLongTimePattern;
-	fShortTimePattern = fLongTimePattern;
+	fCore->fMediumDatePattern = fCore->fShortDatePattern;
+	fCore->fMediumTimePattern = fCore->fLongTimePattern;
+	fCore->fShortTimePattern = fCore->fLongTimePattern;
 	
 	VString s;
 	GetImpl().GetLocaleInfo( LOCALE_IDATE, s);
@@ -1181,34 +1324,34 @@ bool VIntlMgr::_InitLocaleVariables()
 
 CompareResult VIntlMgr::CompareString_Like(const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
-	return fCollator->CompareString_Like(inText1, inSize1, inText2, inSize2, inWithDiacritics);
+	return GetCollator()->CompareString_Like(inText1, inSize1, inText2, inSize2, inWithDiacritics);
 }
 
 
 CompareResult VIntlMgr::CompareString(const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
-	return fCollator->CompareString( inText1, inSize1, inText2, inSize2, inWithDiacritics);
+	return GetCollator()->CompareString( inText1, inSize1, inText2, inSize2, inWithDiacritics);
 }
 
 
 CompareResult VIntlMgr::CompareString (const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, const VCompareOptions& inOptions)
 {
 	if (inOptions.IsLike())
-		return fCollator->CompareString_Like(inText1, inSize1, inText2, inSize2, inOptions.IsDiacritical());
+		return GetCollator()->CompareString_Like(inText1, inSize1, inText2, inSize2, inOptions.IsDiacritical());
 	else
-		return fCollator->CompareString(inText1, inSize1, inText2, inSize2, inOptions.IsDiacritical());
+		return GetCollator()->CompareString(inText1, inSize1, inText2, inSize2, inOptions.IsDiacritical());
 }
 
 
 bool VIntlMgr::EqualString(const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
-	return fCollator->EqualString(inText1, inSize1, inText2, inSize2, inWithDiacritics);
+	return GetCollator()->EqualString(inText1, inSize1, inText2, inSize2, inWithDiacritics);
 }
 
 
 bool VIntlMgr::EqualString_Like(const UniChar* inText1, sLONG inSize1, const UniChar* inText2, sLONG inSize2, bool inWithDiacritics)
 {
-	return fCollator->EqualString_Like(inText1, inSize1, inText2, inSize2, inWithDiacritics);
+	return GetCollator()->EqualString_Like(inText1, inSize1, inText2, inSize2, inWithDiacritics);
 }
 
 
@@ -1410,13 +1553,13 @@ UniChar* VIntlMgr::_FillOneRangesArray(UniChar* inArray, uBYTE inMatchFlag)
 
 bool VIntlMgr::_InitCollator( DialectCode inDialectForCollator, CollatorOptions inCollatorOptions)
 {
-	xbox_assert( (fCollator == NULL) && !fUseICUCollator);
+	xbox_assert( (fCore->fCollator == NULL) && !fUseICUCollator);
 
 	#if USE_ICU
 	if (inCollatorOptions & COL_ICU)
 	{
-		fCollator = VICUCollator::Create( inDialectForCollator, (fDialect == inDialectForCollator) ? fLocale : NULL, inCollatorOptions);
-		if (fCollator != NULL)
+		fCore->fCollator = VICUCollator::Create( inDialectForCollator, (fDialect == inDialectForCollator) ? fCore->fLocale : NULL, inCollatorOptions);
+		if (fCore->fCollator != NULL)
 		{
 			fUseICUCollator = true;
 			//DebugMsg( "**** USING ICU ****\r\n");
@@ -1425,14 +1568,14 @@ bool VIntlMgr::_InitCollator( DialectCode inDialectForCollator, CollatorOptions
 	#endif
 
     #if !VERSION_LINUX
-	if (fCollator == NULL)
+	if (fCore->fCollator == NULL)
 	{
-		fCollator = VCollator_system::Create( inDialectForCollator, (fDialect == inDialectForCollator) ? this : NULL);
+		fCore->fCollator = VCollator_system::Create( inDialectForCollator, (fDialect == inDialectForCollator) ? this : NULL);
 		DebugMsg( "**** USING SYSTEM SORT TABLE ****\r\n");
 	}
     #endif
 
-	return (fCollator != NULL);
+	return (fCore->fCollator != NULL);
 }
 
 
@@ -1537,12 +1680,12 @@ void VIntlMgr::ToUpperLowerCase( VString& ioText, bool inStripDiac, bool inIsUpp
 					}
 					else
 					{
-						string.toUpper( *fLocale);
+						string.toUpper( *fCore->fLocale);
 					}
 				}
 				else
 				{
-					string.toUpper( *fLocale);
+					string.toUpper( *fCore->fLocale);
 				}
 			}
 			else
@@ -1557,12 +1700,12 @@ void VIntlMgr::ToUpperLowerCase( VString& ioText, bool inStripDiac, bool inIsUpp
 					}
 					else
 					{
-						string.toLower( *fLocale);
+						string.toLower( *fCore->fLocale);
 					}
 				}
 				else
 				{
-					string.toLower( *fLocale);
+					string.toLower( *fCore->fLocale);
 				}
 			}
 			
@@ -1682,7 +1825,7 @@ bool VIntlMgr::_HasApostropheSecondFollowedByVowel( const VString& inText, VInde
 #if USE_ICU
 xbox_icu::Locale* VIntlMgr::_GetICUCollatorLocale()
 {
-	return fUseICUCollator ? dynamic_cast<VICUCollator*>( fCollator)->GetLocale() : NULL;
+	return fUseICUCollator ? dynamic_cast<VICUCollator*>( fCore->fCollator)->GetLocale() : NULL;
 }
 #endif
 
@@ -1867,7 +2010,7 @@ bool VIntlMgr::FindWord( const VString& inText, const VString& inPattern, const
 	
 	// need expensive algo when asked for pattern matching or when there's no icu or when using MeCab
 
-	if ( (inOptions.IsLike() && (inPattern.FindUniChar( fCollator->GetWildChar()) > 0)) || (fKeyWordOptions & eKW_UseMeCab) )
+	if ( (inOptions.IsLike() && (inPattern.FindUniChar( GetCollator()->GetWildChar()) > 0)) || (fKeyWordOptions & eKW_UseMeCab) )
 	{
 		VectorOfStringSlice boundaries;
 		ok = GetWordBoundaries( inText, boundaries);
@@ -1876,7 +2019,7 @@ bool VIntlMgr::FindWord( const VString& inText, const VString& inPattern, const
 			// on ne peut faire de recherche dichotomique avec une pattern
 			ok = false;
 			for( VectorOfStringSlice::const_iterator i = boundaries.begin() ; (i != boundaries.end()) && !ok ; ++i)
-				ok = fCollator->EqualString_Like( inText.GetCPointer() + i->first - 1, i->second, inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical());
+				ok = GetCollator()->EqualString_Like( inText.GetCPointer() + i->first - 1, i->second, inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical());
 		}
 	}
 	else
@@ -1891,7 +2034,7 @@ bool VIntlMgr::FindWord( const VString& inText, const VString& inPattern, const
 
 			do 
 			{
-				pos = fCollator->FindString( pString, lenString, inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical(), &matchedLength);
+				pos = GetCollator()->FindString( pString, lenString, inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical(), &matchedLength);
 				if (pos > 0)
 				{
 					// see if the found string is enclosed by dead chars
@@ -1929,7 +2072,7 @@ bool VIntlMgr::FindWord( const VString& inText, const VString& inPattern, const
 
 				do 
 				{
-					pos = fCollator->FindString((pString + absolutePos), (lenString - absolutePos), inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical(), &matchedLength);
+					pos = GetCollator()->FindString((pString + absolutePos), (lenString - absolutePos), inPattern.GetCPointer(), inPattern.GetLength(), inOptions.IsDiacritical(), &matchedLength);
 					if (pos > 0)
 					{
 						// see if the found string is enclosed by dead chars
@@ -2118,7 +2261,7 @@ void VIntlMgr::GetDialectsHavingCollator( VectorOfNamedDialect& outDialects)
 		std::vector<const char*> locales;
 		std::vector<VString> names;
 
-		VICUCollator::GetLocalesHavingCollator( *fLocale, locales, names);
+		VICUCollator::GetLocalesHavingCollator( *fCore->fLocale, locales, names);
 		
 		// pour chaque locale retournee, il faut trouver son dialectcode
 		outDialects.reserve( locales.size());
@@ -2286,18 +2429,18 @@ bool VIntlMgr::GetLocalizedLanguageName( DialectCode inDialect, VString& outLang
 	bool ok = false;
 	
 	#if USE_ICU
-	if (fLocale != NULL)
+	if (fCore->fLocale != NULL)
 	{
 		// suivant le dialecte, on recupere l'ISO6391_ISO3166 (xx_XX)
 		xbox_icu::Locale locale( GetISO6391LanguageCode( inDialect), GetISO3166RegionCode( inDialect));
 		
 		// recuperation du langage
 		UnicodeString displayName;
-		locale.getDisplayLanguage( *fLocale, displayName);
+		locale.getDisplayLanguage( *fCore->fLocale, displayName);
 		
 		// recuperation de la region
 		UnicodeString displayCountry;
-		locale.getDisplayCountry( *fLocale, displayCountry);
+		locale.getDisplayCountry( *fCore->fLocale, displayCountry);
 		UnicodeString displayEntireName;
 
 		if(displayCountry.length() == 0)
@@ -2665,7 +2808,7 @@ VFile *VIntlMgr::RetainLocalizationFile( const VFilePath& inResourcesFolderPath,
 
 UniChar VIntlMgr::GetWildChar() const
 {
-	return fCollator->GetWildChar();
+	return (fCollator != NULL) ? fCollator->GetWildChar() : fWildChar;
 }
 
 
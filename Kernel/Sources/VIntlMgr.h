@@ -100,6 +100,7 @@ BEGIN_TOOLBOX_NAMESPACE
 class VArrayLong;
 class VArrayString;
 class VIntlMgr;
+class VIntlMgrCore;
 class VCollator;
 
 typedef std::vector<std::pair<VString,DialectCode> >	VectorOfNamedDialect;
@@ -115,7 +116,7 @@ public:
 	static	VIntlMgr*			Create( DialectCode inDialect, DialectCode inDialectForCollator, CollatorOptions inCollatorOptions);
 	static	VIntlMgr*			Create( DialectCode inDialect, CollatorOptions inCollatorOptions = COL_ICU) { return Create( inDialect, inDialect, inCollatorOptions);}
 			
-			/** @brief the only thread-safe method **/
+			/** @brief the only thread-safe method. The clone shares the locale data of this manager. **/
 								VIntlMgr*		Clone();
 
 			// Collation info
@@ -133,7 +134,8 @@ public:
 
 			void				ToUpperLowerCase( VString& ioText, bool inStripDiac, bool inIsUpper);
 			
-			VCollator*			GetCollator() const			{ return fCollator;}
+			// the collator is cloned from the shared one on first use
+			VCollator*			GetCollator() const			{ return (fCollator != NULL) ? fCollator : _CreateCollator();}
 			UniChar				GetWildChar() const;
 	
 	// Char analysis utilities
@@ -236,24 +238,24 @@ public:
 	static	bool				IsAMacCharacter( uBYTE inChar, uBYTE inCharSet);
 			bool				IsUsingAmPm() const				{ return fUsingAmPm; }
 	
-			const VString&		GetAMString() const				{ return fAMString; }
-			const VString&		GetPMString() const				{ return fPMString; }
+			const VString&		GetAMString() const;
+			const VString&		GetPMString() const;
 	
 			DateOrder			GetDateOrder() const			{ return fDateOrder; }
 
-			const VString&		GetDateSeparator() const		{ return fDateSeparator; }
-			const VString&		GetTimeSeparator() const		{ return fTimeSeparator; }
+			const VString&		GetDateSeparator() const;
+			const VString&		GetTimeSeparator() const;
 
-			const VString&		GetThousandsSeparator() const	{ return fThousandsSeparator; }
-			const VString&		GetDecimalSeparator() const		{ return fDecimalSeparator; }
-			const VString&		GetCurrency() const				{ return fCurrency;}
+			const VString&		GetThousandsSeparator() const;
+			const VString&		GetDecimalSeparator() const;
+			const VString&		GetCurrency() const;
 	
-			const VString&		GetLongDatePattern() const		{ return fLongDatePattern; }
-			const VString&		GetMediumDatePattern() const	{ return fMediumDatePattern; }
-			const VString&		GetShortDatePattern() const		{ return fShortDatePattern; }
-			const VString&		GetLongTimePattern() const		{ return fLongTimePattern; }
-			const VString&		GetMediumTimePattern() const	{ return fMediumTimePattern; }
-			const VString&		GetShortTimePattern() const		{ return fShortTimePattern; }
+			const VString&		GetLongDatePattern() const;
+			const VString&		GetMediumDatePattern() const;
+			const VString&		GetShortDatePattern() const;
+			const VString&		GetLongTimePattern() const;
+			const VString&		GetMediumTimePattern() const;
+			const VString&		GetShortTimePattern() const;
 
 			void				FormatDate( const VTime& inDate,VString& outDate,EOSFormats inFormat, bool inUseGMTTimeZoneForDisplay);
 			void				FormatTime( const VTime& inDate,VString& outDate,EOSFormats inFormat, bool inUseGMTTimeZoneForDisplay);
@@ -308,32 +310,19 @@ private:
 	
 			XIntlMgrImpl			fImpl;
 			
+			// locale data shared by all clones, never modified once the manager is built
+			VIntlMgrCore*			fCore;
+
 			bool					fUseICUCollator;
 			EKeyWordOptions			fKeyWordOptions;
-			VCollator*				fCollator;
 			DialectCode				fDialect;
-			VString					fAMString;
-			VString					fPMString;
 			bool					fUsingAmPm;
-
-			VString					fDecimalSeparator;
-			VString					fThousandsSeparator;
-			VString					fDateSeparator;
-			VString					fTimeSeparator;
-			VString					fCurrency;
-
-			VString					fShortDatePattern;
-			VString					fMediumDatePattern;
-			VString					fLongDatePattern;
-
-			VString					fShortTimePattern;
-			VString					fMediumTimePattern;
-			VString					fLongTimePattern;
-
 			DateOrder				fDateOrder;
 
+	mutable	VCollator*				fCollator;		// cloned from the shared collator on first use
+			UniChar					fWildChar;		// wild char to set on fCollator when it gets created
+
 			#if USE_ICU
-			xbox_icu::Locale*			fLocale;
 			xbox_icu::Transliterator*	fUpperStripDiacriticsTransformation;
 			xbox_icu::Transliterator*	fLowerStripDiacriticsTransformation;
 			xbox_icu::BreakIterator*	fBreakIterator;
@@ -347,6 +336,8 @@ private:
 			bool					_InitLocaleVariables ();
 			void					_InitSortTables ();
 			bool					_InitCollator( DialectCode inDialectForCollator, CollatorOptions inCollatorOptions);
+			VCollator*				_CreateCollator() const;
+			VCollator*				_GetSharedCollator() const;
 	
 			bool					_CharTest (UniChar inChar, const UniChar* inRangesArray) const;
 			
@@ -63,6 +63,8 @@ DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 216, VE_STREAM_CANNOT_PUT_DATA)
 DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 217, VE_STREAM_CANNOT_FLUSH)
 DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 218, VE_STREAM_CANNOT_GET_SIZE)
 DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 219, VE_STREAM_CANNOT_SET_SIZE)
+DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 220, VE_STREAM_BAD_CHECKSUM)	// data read from a stream doesn't match its stored checksum
+DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 221, VE_STREAM_COMPRESSION_FAILED)
 
 // International Utilities Errors: 300->399
 DECLARE_VERROR( kCOMPONENT_XTOOLBOX, 300, VE_INTL_TEXT_CONVERSION_FAILED)
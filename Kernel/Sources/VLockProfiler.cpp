@@ -0,0 +1,426 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VKernelPrecompiled.h"
+#include "VLockProfiler.h"
+#include "VString.h"
+#include "VValueBag.h"
+#include "VTask.h"
+
+
+bool									VLockProfiler::sRunning = false;
+VSystemCriticalSection					VLockProfiler::sMutex;
+VLockProfiler::LockStatistics*			VLockProfiler::sTable = NULL;
+sLONG									VLockProfiler::sTableSize = 0;
+sLONG									VLockProfiler::sTableCount = 0;
+VLockProfiler::TaskStatistics*			VLockProfiler::sTaskTable = NULL;
+sLONG									VLockProfiler::sTaskTableSize = 0;
+sLONG8									VLockProfiler::sDroppedCount = 0;
+sLONG8									VLockProfiler::sFrequency = 0;
+
+
+static bool _CompareWaitTime( const VLockProfiler::LockStatistics& inFirst, const VLockProfiler::LockStatistics& inSecond)
+{
+	return inFirst.fTotalWaitMicroseconds > inSecond.fTotalWaitMicroseconds;
+}
+
+
+static bool _CompareBlockedTime( const VLockProfiler::TaskStatistics& inFirst, const VLockProfiler::TaskStatistics& inSecond)
+{
+	return inFirst.fBlockedMicroseconds > inSecond.fBlockedMicroseconds;
+}
+
+
+static uLONG _HashLock( const void *inLock)
+{
+	return (uLONG) (((uLONG8) (uLONG_PTR) inLock >> 3) * 2654435761UL);
+}
+
+
+static sLONG _GetHistogramBucket( sLONG8 inWaitMicroseconds)
+{
+	sLONG bucket = 0;
+	while( (bucket < VLockProfiler::kHistogramBucketCount - 1) && (inWaitMicroseconds >= (((sLONG8) 1) << bucket)) )
+		++bucket;
+	return bucket;
+}
+
+
+void VLockProfiler::_Allocate( sLONG inMaxLocks, sLONG inMaxTasks)
+{
+	// sMutex must be held
+	if (sTable == NULL)
+	{
+		sTable = new LockStatistics[inMaxLocks];
+		sTableSize = (sTable != NULL) ? inMaxLocks : 0;
+		sTableCount = 0;
+		sFrequency = VSystem::GetProfilingFrequency();
+		sDroppedCount = 0;
+		if (sTable != NULL)
+			::memset( sTable, 0, sTableSize * sizeof( LockStatistics));
+	}
+	if (sTaskTable == NULL)
+	{
+		sTaskTable = new TaskStatistics[inMaxTasks];
+		sTaskTableSize = (sTaskTable != NULL) ? inMaxTasks : 0;
+		if (sTaskTable != NULL)
+			::memset( sTaskTable, 0, sTaskTableSize * sizeof( TaskStatistics));
+	}
+}
+
+
+void VLockProfiler::Start( sLONG inMaxLocks, sLONG inMaxTasks)
+{
+	xbox_assert( inMaxLocks > 0 && inMaxTasks > 0);
+
+	sMutex.Lock();
+	_Allocate( inMaxLocks, inMaxTasks);
+	sRunning = (sTable != NULL) && (sTaskTable != NULL);
+	sMutex.Unlock();
+}
+
+
+void VLockProfiler::Stop()
+{
+	// statistics remain available until next Start()
+	sRunning = false;
+}
+
+
+void VLockProfiler::Reset()
+{
+	sMutex.Lock();
+	
+	// entries are never removed because _Lookup() doesn't take sMutex
+	for( sLONG i = 0 ; i < sTableSize ; ++i)
+	{
+		LockStatistics *stats = &sTable[i];
+		stats->fAcquisitionCount = 0;
+		stats->fContentionCount = 0;
+		stats->fTotalWaitMicroseconds = 0;
+		stats->fMaxWaitMicroseconds = 0;
+		::memset( stats->fWaitHistogram, 0, sizeof( stats->fWaitHistogram));
+	}
+	if (sTaskTable != NULL)
+		::memset( sTaskTable, 0, sTaskTableSize * sizeof( TaskStatistics));
+	sDroppedCount = 0;
+	sMutex.Unlock();
+}
+
+
+VLockProfiler::LockStatistics* VLockProfiler::_Find( const void *inLock)
+{
+	// sMutex must be held.
+	// open addressing, linear probing
+	uLONG hash = _HashLock( inLock);
+	for( sLONG i = 0 ; i < sTableSize ; ++i)
+	{
+		LockStatistics *stats = &sTable[(hash + i) % sTableSize];
+		if (stats->fLock == inLock)
+			return stats;
+		if (stats->fLock == NULL)
+		{
+			// publish the entry last for _Lookup()
+			VInterlocked::ExchangeVoidPtr( (void**) &stats->fLock, const_cast<void*>( inLock));
+			++sTableCount;
+			return stats;
+		}
+	}
+	return NULL;
+}
+
+
+VLockProfiler::LockStatistics* VLockProfiler::_Lookup( const void *inLock)
+{
+	// doesn't take sMutex and never creates an entry.
+	// entries are only added by _Find() and never removed so that a concurrent probe remains valid.
+	uLONG hash = _HashLock( inLock);
+	for( sLONG i = 0 ; i < sTableSize ; ++i)
+	{
+		LockStatistics *stats = &sTable[(hash + i) % sTableSize];
+		const void *lock = stats->fLock;
+		if (lock == inLock)
+			return stats;
+		if (lock == NULL)
+			break;
+	}
+	return NULL;
+}
+
+
+VLockProfiler::TaskStatistics* VLockProfiler::_FindTask( VTaskID inTaskID)
+{
+	// sMutex must be held
+	if (inTaskID == NULL_TASK_ID)
+		return NULL;
+
+	uLONG hash = (uLONG) inTaskID * 2654435761UL;
+	for( sLONG i = 0 ; i < sTaskTableSize ; ++i)
+	{
+		TaskStatistics *stats = &sTaskTable[(hash + i) % sTaskTableSize];
+		if (stats->fTaskID == inTaskID)
+			return stats;
+		if (stats->fTaskID == NULL_TASK_ID)
+		{
+			stats->fTaskID = inTaskID;
+			return stats;
+		}
+	}
+	return NULL;
+}
+
+
+void VLockProfiler::SetLockName( const void *inLock, const char *inName)
+{
+	if (!testAssert( inLock != NULL && inName != NULL))
+		return;
+	
+	sMutex.Lock();
+	_Allocate( 4096, 1024);
+	LockStatistics *stats = (sTable != NULL) ? _Find( inLock) : NULL;
+	if (stats != NULL)
+	{
+		::strncpy( stats->fName, inName, kMaxNameLength);
+		stats->fName[kMaxNameLength] = 0;
+	}
+	sMutex.Unlock();
+}
+
+
+void VLockProfiler::_RecordAcquisition( const void *inLock)
+{
+	if (sTable == NULL)
+		return;
+
+	LockStatistics *stats = _Lookup( inLock);
+	if ( (stats == NULL) && (sTableCount < sTableSize - sTableSize / 4) )
+	{
+		// first acquisition of this lock since the profiler started
+		sMutex.Lock();
+		if (sTableCount < sTableSize - sTableSize / 4)
+			stats = _Find( inLock);
+		sMutex.Unlock();
+	}
+	if (stats != NULL)
+		VInterlocked::Increment( &stats->fAcquisitionCount);
+}
+
+
+void VLockProfiler::RecordContention( const void *inLock, sLONG8 inWaitStartTimeStamp)
+{
+	if (!sRunning)
+		return;
+	
+	sLONG8 waitMicroseconds = ((GetTimeStamp() - inWaitStartTimeStamp) * 1000000) / sFrequency;
+	VTaskID taskID = VTask::GetCurrentID();
+
+	sMutex.Lock();
+	LockStatistics *stats = (sTable != NULL) ? _Find( inLock) : NULL;
+	if (stats != NULL)
+	{
+		++stats->fContentionCount;
+		stats->fTotalWaitMicroseconds += waitMicroseconds;
+		if (waitMicroseconds > stats->fMaxWaitMicroseconds)
+			stats->fMaxWaitMicroseconds = waitMicroseconds;
+		++stats->fWaitHistogram[_GetHistogramBucket( waitMicroseconds)];
+	}
+	else
+	{
+		++sDroppedCount;
+	}
+	
+	TaskStatistics *taskStats = (sTaskTable != NULL) ? _FindTask( taskID) : NULL;
+	if (taskStats != NULL)
+	{
+		++taskStats->fWaitCount;
+		taskStats->fBlockedMicroseconds += waitMicroseconds;
+	}
+	else if (taskID != NULL_TASK_ID)
+	{
+		++sDroppedCount;
+	}
+	sMutex.Unlock();
+}
+
+
+void VLockProfiler::GetStatistics( std::vector<LockStatistics>& outStatistics)
+{
+	outStatistics.clear();
+
+	sMutex.Lock();
+	for( sLONG i = 0 ; i < sTableSize ; ++i)
+	{
+		if (sTable[i].fLock != NULL)
+			outStatistics.push_back( sTable[i]);
+	}
+	sMutex.Unlock();
+
+	std::sort( outStatistics.begin(), outStatistics.end(), _CompareWaitTime);
+}
+
+
+void VLockProfiler::GetTaskStatistics( std::vector<TaskStatistics>& outStatistics)
+{
+	outStatistics.clear();
+
+	sMutex.Lock();
+	for( sLONG i = 0 ; i < sTaskTableSize ; ++i)
+	{
+		if (sTaskTable[i].fTaskID != NULL_TASK_ID)
+			outStatistics.push_back( sTaskTable[i]);
+	}
+	sMutex.Unlock();
+
+	std::sort( outStatistics.begin(), outStatistics.end(), _CompareBlockedTime);
+}
+
+
+sLONG8 VLockProfiler::GetDroppedCount()
+{
+	sMutex.Lock();
+	sLONG8 count = sDroppedCount;
+	sMutex.Unlock();
+	return count;
+}
+
+
+void VLockProfiler::GetSnapshot( VValueBag& outBag)
+{
+	std::vector<LockStatistics> statistics;
+	GetStatistics( statistics);
+
+	std::vector<TaskStatistics> taskStatistics;
+	GetTaskStatistics( taskStatistics);
+
+	outBag.SetBool( "running", sRunning);
+	outBag.SetLong8( "dropped", GetDroppedCount());
+
+	for( std::vector<LockStatistics>::const_iterator i = statistics.begin() ; i != statistics.end() ; ++i)
+	{
+		// skip anonymous locks that were never contended
+		if ( (i->fContentionCount == 0) && (i->fName[0] == 0) )
+			continue;
+
+		VValueBag *lockBag = new VValueBag;
+		if (lockBag != NULL)
+		{
+			lockBag->SetLong8( "address", (sLONG8) (uLONG_PTR) i->fLock);
+			lockBag->SetString( "name", VString( i->fName));
+			lockBag->SetLong8( "acquisitions", i->fAcquisitionCount);
+			lockBag->SetLong8( "contentions", i->fContentionCount);
+			if (i->fAcquisitionCount > 0)
+				lockBag->SetReal( "contention_rate", (Real) i->fContentionCount / (Real) i->fAcquisitionCount);
+			lockBag->SetLong8( "total_wait", i->fTotalWaitMicroseconds);
+			lockBag->SetLong8( "max_wait", i->fMaxWaitMicroseconds);
+
+			for( sLONG bucket = 0 ; bucket < kHistogramBucketCount ; ++bucket)
+			{
+				if (i->fWaitHistogram[bucket] == 0)
+					continue;
+				VValueBag *bucketBag = new VValueBag;
+				if (bucketBag != NULL)
+				{
+					bucketBag->SetLong8( "max_wait", (bucket < kHistogramBucketCount - 1) ? (((sLONG8) 1) << bucket) : -1);
+					bucketBag->SetLong8( "count", i->fWaitHistogram[bucket]);
+					lockBag->AddElement( "bucket", bucketBag);
+					bucketBag->Release();
+				}
+			}
+
+			outBag.AddElement( "lock", lockBag);
+			lockBag->Release();
+		}
+	}
+
+	for( std::vector<TaskStatistics>::const_iterator i = taskStatistics.begin() ; i != taskStatistics.end() ; ++i)
+	{
+		VValueBag *taskBag = new VValueBag;
+		if (taskBag != NULL)
+		{
+			taskBag->SetLong( "id", i->fTaskID);
+
+			VTask *task = VTaskMgr::Get()->RetainTaskByID( i->fTaskID);
+			if (task != NULL)
+			{
+				VString name;
+				task->GetName( name);
+				taskBag->SetString( "name", name);
+				task->Release();
+			}
+
+			taskBag->SetLong8( "waits", i->fWaitCount);
+			taskBag->SetLong8( "blocked_time", i->fBlockedMicroseconds);
+			outBag.AddElement( "task", taskBag);
+			taskBag->Release();
+		}
+	}
+}
+
+
+VError VLockProfiler::GetSnapshotAsJSON( VString& outJSON)
+{
+	VValueBag bag;
+	GetSnapshot( bag);
+	return bag.GetJSONString( outJSON);
+}
+
+
+void VLockProfiler::DumpStats()
+{
+	std::vector<LockStatistics> statistics;
+	GetStatistics( statistics);
+
+	for( std::vector<LockStatistics>::const_iterator i = statistics.begin() ; i != statistics.end() ; ++i)
+	{
+		if (i->fContentionCount == 0)
+			continue;
+
+		VString	string( "lock ");
+		if (i->fName[0] != 0)
+			string += i->fName;
+		else
+			string.AppendULong8( (uLONG8) (uLONG_PTR) i->fLock);
+		string += " : ";
+		string.AppendLong8( i->fContentionCount);
+		string += " contentions";
+		if (i->fAcquisitionCount > 0)
+		{
+			string += " for ";
+			string.AppendLong8( i->fAcquisitionCount);
+			string += " acquisitions";
+		}
+		string += ", total wait ";
+		string.AppendLong8( i->fTotalWaitMicroseconds);
+		string += " us, max wait ";
+		string.AppendLong8( i->fMaxWaitMicroseconds);
+		string += " us\r\n";
+		DebugMsg( string);
+	}
+
+	std::vector<TaskStatistics> taskStatistics;
+	GetTaskStatistics( taskStatistics);
+
+	for( std::vector<TaskStatistics>::const_iterator i = taskStatistics.begin() ; i != taskStatistics.end() ; ++i)
+	{
+		VString	string( "task ");
+		string.AppendLong( i->fTaskID);
+		string += " : blocked ";
+		string.AppendLong8( i->fBlockedMicroseconds);
+		string += " us in ";
+		string.AppendLong8( i->fWaitCount);
+		string += " waits\r\n";
+		DebugMsg( string);
+	}
+}
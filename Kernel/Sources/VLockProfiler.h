@@ -0,0 +1,131 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VLockProfiler__
+#define __VLockProfiler__
+
+#include "Kernel/Sources/VSyncObject.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VValueBag;
+
+/*
+	Opt-in contention profiler for VCriticalSection, VSmallCriticalSection, VConditionVariable and VReaderWriterLock.
+
+	Only contended acquisitions are timed (the fast path only tests IsRunning()) so that
+	the profiler can be left compiled in release builds.
+	Locks are identified by their address: a lock allocated where a destroyed one was adds to its statistics.
+	
+	A lock may be given a name with SetLockName() so that it can be found in the reports.
+	Blocking acquisitions of VCriticalSection and VReaderWriterLock are counted from the first one that happens
+	while the profiler is running, so that a contention rate can be computed. A lock is registered on that first
+	acquisition as long as the table is less than 3/4 full, the remaining entries being kept for contended locks.
+
+	Each wait is also added to a log2 histogram of the lock (bucket i counts waits shorter than 2^i microseconds,
+	the last bucket counting all longer waits) and to the blocked time of the waiting task.
+	
+	The statistics tables are allocated by Start() or by the first SetLockName() and never grow so that recording
+	doesn't allocate memory (the memory manager itself uses critical sections).
+*/
+class XTOOLBOX_API VLockProfiler
+{
+public:
+	enum {
+		kHistogramBucketCount	= 16,
+		kMaxNameLength			= 31
+	};
+
+	typedef struct LockStatistics
+	{
+		const void*		fLock;
+		char			fName[kMaxNameLength+1];	// empty if anonymous
+		sLONG8			fAcquisitionCount;			// blocking acquisitions, see above
+		sLONG8			fContentionCount;			// number of acquisitions that had to wait
+		sLONG8			fTotalWaitMicroseconds;
+		sLONG8			fMaxWaitMicroseconds;
+		sLONG8			fWaitHistogram[kHistogramBucketCount];
+	} LockStatistics;
+
+	typedef struct TaskStatistics
+	{
+		VTaskID			fTaskID;
+		sLONG8			fWaitCount;
+		sLONG8			fBlockedMicroseconds;
+	} TaskStatistics;
+
+	static	void				Start( sLONG inMaxLocks = 4096, sLONG inMaxTasks = 1024);
+	static	void				Stop();
+	static	void				Reset();		// clears counters but keeps lock names
+	static	bool				IsRunning()										{ return sRunning; }
+
+	// names are truncated to kMaxNameLength characters.
+	static	void				SetLockName( const void *inLock, const char *inName);
+
+	// called by the locks when they are about to wait, then once they acquired the lock.
+	static	sLONG8				GetTimeStamp()									{ sLONG8 stamp; VSystem::GetProfilingCounter( stamp); return stamp; }
+	static	void				RecordContention( const void *inLock, sLONG8 inWaitStartTimeStamp);
+
+	// called by the locks once they acquired the lock (not for recursive acquisitions).
+	static	void				RecordAcquisition( const void *inLock)			{ if (sRunning) _RecordAcquisition( inLock); }
+
+	// statistics sorted by decreasing total wait time
+	static	void				GetStatistics( std::vector<LockStatistics>& outStatistics);
+	
+	// statistics sorted by decreasing blocked time
+	static	void				GetTaskStatistics( std::vector<TaskStatistics>& outStatistics);
+	
+	// number of contentions that could not be recorded because a table was full
+	static	sLONG8				GetDroppedCount();
+
+	/*
+		snapshot of all statistics as a bag:
+		<lock_statistics running="" dropped="">
+			<lock address="" name="" acquisitions="" contentions="" contention_rate="" total_wait="" max_wait="">
+				<bucket max_wait="" count=""/>
+			</lock>
+			<task id="" name="" waits="" blocked_time=""/>
+		</lock_statistics>
+		all times are in microseconds. Only non empty histogram buckets are reported (max_wait is -1 for the last one).
+	*/
+	static	void				GetSnapshot( VValueBag& outBag);
+	static	VError				GetSnapshotAsJSON( VString& outJSON);
+
+	// dumps statistics using DebugMsg
+	static	void				DumpStats();
+
+private:
+								VLockProfiler();
+
+	static	void				_Allocate( sLONG inMaxLocks, sLONG inMaxTasks);
+	static	LockStatistics*		_Find( const void *inLock);
+	static	LockStatistics*		_Lookup( const void *inLock);
+	static	TaskStatistics*		_FindTask( VTaskID inTaskID);
+	static	void				_RecordAcquisition( const void *inLock);
+
+	static	bool				sRunning;
+	static	VSystemCriticalSection	sMutex;
+	static	LockStatistics*		sTable;
+	static	sLONG				sTableSize;
+	static	sLONG				sTableCount;		// number of used entries
+	static	TaskStatistics*		sTaskTable;
+	static	sLONG				sTaskTableSize;
+	static	sLONG8				sDroppedCount;
+	static	sLONG8				sFrequency;
+};
+
+END_TOOLBOX_NAMESPACE
+
+#endif
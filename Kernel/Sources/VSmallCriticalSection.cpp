@@ -20,6 +20,151 @@
 #include "VSyncObject.h"
 
 
+#if VSmallCriticalSection_USE_FUTEX
+
+VNonVirtualCriticalSection::VNonVirtualCriticalSection()
+{
+	fLockWord = 0;
+	fOwner = NULL_TASK_ID;
+	fUseCount = 0;
+}
+
+
+Boolean VNonVirtualCriticalSection::TryToLock()
+{
+	VTaskID	currentTaskID = VTask::GetCurrentID();
+
+	if (fOwner == currentTaskID)
+	{
+		++fUseCount;
+	}
+	else if (XLinuxAdaptiveLock::TryToLock( &fLockWord))
+	{
+		fOwner = currentTaskID;
+		assert(fUseCount == 0);
+		fUseCount = 1;
+	}
+
+	return (fOwner == currentTaskID);
+}
+
+
+Boolean VNonVirtualCriticalSection::Lock()
+{
+	VTaskID	currentTaskID = VTask::GetCurrentID();
+
+	if (fOwner == currentTaskID)
+	{
+		++fUseCount;
+	}
+	else
+	{
+		XLinuxAdaptiveLock::Lock( &fLockWord, this);
+		fOwner = currentTaskID;
+		assert(fUseCount == 0);
+		fUseCount = 1;
+	}
+	
+	return true;
+}
+
+
+Boolean VNonVirtualCriticalSection::Unlock()
+{
+	assert((fOwner == VTask::GetCurrentID()) && (fUseCount > 0) && (fUseCount < 32000L));
+
+	if (--fUseCount == 0)
+	{
+		fOwner = NULL_TASK_ID;
+		XLinuxAdaptiveLock::Unlock( &fLockWord);
+	}
+	
+	return true;
+}
+
+
+VNonVirtualCriticalSection::~VNonVirtualCriticalSection()
+{
+	assert(fUseCount == 0 && fOwner == NULL_TASK_ID && fLockWord == 0);
+
+	while (fUseCount > 0)
+		Unlock();
+}
+
+
+#pragma mark-
+
+VSmallCriticalSection::VSmallCriticalSection()
+{
+	fLockWord = 0;
+	fOwner = NULL_TASK_ID;
+	fUseCount = 0;
+}
+
+
+Boolean VSmallCriticalSection::TryToLock()
+{
+	sWORD currentTaskID = (sWORD)VTask::GetCurrentID();
+
+	if (fOwner == currentTaskID)
+	{
+		++fUseCount;
+	}
+	else if (XLinuxAdaptiveLock::TryToLock( &fLockWord))
+	{
+		fOwner = currentTaskID;
+		assert(fUseCount == 0);
+		fUseCount = 1;
+	}
+
+	return (fOwner == currentTaskID);
+}
+
+
+Boolean VSmallCriticalSection::Lock()
+{
+	sWORD currentTaskID = (sWORD)VTask::GetCurrentID();
+
+	if (fOwner == currentTaskID)
+	{
+		++fUseCount;
+	}
+	else
+	{
+		XLinuxAdaptiveLock::Lock( &fLockWord, this);
+		fOwner = currentTaskID;
+		assert(fUseCount == 0);
+		fUseCount = 1;
+	}
+	
+	return true;
+}
+
+
+Boolean VSmallCriticalSection::Unlock()
+{
+	assert(fUseCount > 0);
+
+	// Unlock or another successfull lock can only be called from same thead (so no contention can occur on fUseCount)
+	if (--fUseCount == 0)
+	{
+		fOwner = NULL_TASK_ID;
+		XLinuxAdaptiveLock::Unlock( &fLockWord);
+	}
+	return true;
+}
+
+
+VSmallCriticalSection::~VSmallCriticalSection()
+{
+	assert(fUseCount == 0 && fOwner == NULL_TASK_ID && fLockWord == 0);
+
+	while (fUseCount > 0)
+		Unlock();
+}
+
+#else
+
 // Class statics
 sLONG	VSmallCriticalSection::sUnlockCount = 0;
 sLONG	VNonVirtualCriticalSection::sUnlockCount = 0;
@@ -283,3 +428,5 @@ VSmallCriticalSection::~VSmallCriticalSection()
 	while (fUseCount > 0)
 		Unlock();
 }
+
+#endif
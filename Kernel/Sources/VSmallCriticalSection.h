@@ -18,6 +18,9 @@
 
 BEGIN_TOOLBOX_NAMESPACE
 
+// On linux, both classes are built upon XLinuxAdaptiveLock instead of a lazily allocated VSyncEvent
+#define VSmallCriticalSection_USE_FUTEX VERSION_LINUX
+
 // Defined bellow
 class VNonVirtualCriticalSection;
 class VSmallCriticalSection;
@@ -36,11 +39,17 @@ public:
 	sLONG	GetUseCount() const	{ return fUseCount; };	// No protection - may be called only if Lock() returns true
 
 private:
+#if VSmallCriticalSection_USE_FUTEX
+	sLONG		fLockWord;	// XLinuxAdaptiveLock held by fOwner
+#else
 	VSyncEvent*	fEvent;
+#endif
 	VTaskID		fOwner;
 	sLONG		fUseCount;
 
+#if !VSmallCriticalSection_USE_FUTEX
 	static sLONG	sUnlockCount;
+#endif
 };
 
 
@@ -57,11 +66,17 @@ public:
 	sLONG	GetUseCount () const { return fUseCount; };	// No protection - may be called only if Lock() returns true
 	
 protected:
+#if VSmallCriticalSection_USE_FUTEX
+	sLONG		fLockWord;	// XLinuxAdaptiveLock held by fOwner
+	sWORD		fOwner;
+	sWORD		fUseCount;
+#else
 	VSyncEvent*	fEvent;
 	sWORD		fOwner;		// CAUTION: Assumes fOwner and fUseCount are contiguous
 	sWORD		fUseCount;	//	and ordered.
 
 	static sLONG	sUnlockCount;
+#endif
 };
 
 END_TOOLBOX_NAMESPACE
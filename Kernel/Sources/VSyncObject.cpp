@@ -17,6 +17,7 @@
 #include "VSyncObject.h"
 #include "VTask.h"
 #include "VInterlocked.h"
+#include "VLockProfiler.h"
 
 
 // Class macros
@@ -24,7 +25,7 @@
 
 
 // Class statics
-#if !VCriticalSection_USE_SPINLOCK
+#if !VCriticalSection_USE_SPINLOCK && !VCriticalSection_USE_FUTEX
 sLONG	VCriticalSection::sUnlockCount = 0;
 #endif
 
@@ -33,7 +34,10 @@ sLONG	VCriticalSection::sUnlockCount = 0;
 
 VCriticalSection::VCriticalSection()
 : fOwner( NULL_TASK_ID)
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+, fLockWord( 0)
+, fUseCount( 0)
+#elif VCriticalSection_USE_SPINLOCK
 , fSpinLockAndUseCount( 0)
 #else
 , fUseCount( 0)
@@ -41,7 +45,7 @@ VCriticalSection::VCriticalSection()
 {
 #if DEBUG_SEMA
 	fEvent = reinterpret_cast<VSyncEvent*>(new VSystemCriticalSection);
-#else
+#elif !VCriticalSection_USE_FUTEX
 	fEvent = NULL;
 #endif
 }
@@ -51,6 +55,13 @@ VCriticalSection::~VCriticalSection()
 {
 #if DEBUG_SEMA
 	reinterpret_cast<VSystemCriticalSection*>(fEvent)->Release();
+#elif VCriticalSection_USE_FUTEX
+	xbox_assert( GetUseCount() == 0 && fOwner == NULL_TASK_ID && fLockWord == 0);
+	
+	while (GetUseCount() > 0)
+	{
+		Unlock();
+	}
 #else
 	xbox_assert( GetUseCount() == 0 && fOwner == NULL_TASK_ID && fEvent == NULL);
 	
@@ -69,7 +80,26 @@ bool VCriticalSection::TryToLock()
 #else
 	VTaskID currentTaskID = VTask::GetCurrentID();
 
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+	bool ok;
+	if (fOwner == currentTaskID)
+	{
+		++fUseCount;
+		ok = true;
+	}
+	else if (XLinuxAdaptiveLock::TryToLock( &fLockWord))
+	{
+		fOwner = currentTaskID;
+		xbox_assert(fUseCount == 0);
+		fUseCount = 1;
+		ok = true;
+	}
+	else
+	{
+		ok = false;
+	}
+	return ok;
+#elif VCriticalSection_USE_SPINLOCK
 	bool ok;
 	_Lock();
 	VTaskID owner = fOwner;
@@ -123,7 +153,22 @@ bool VCriticalSection::Lock()
 	
 	
 	VTaskID currentTaskID = VTask::GetCurrentID();
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+	if (fOwner == currentTaskID)
+	{
+		// We are already the owner
+		++fUseCount;
+	}
+	else
+	{
+		// spins then parks if currently used by some other task
+		XLinuxAdaptiveLock::Lock( &fLockWord, this);
+		fOwner = currentTaskID;
+		xbox_assert(fUseCount == 0);
+		fUseCount = 1;
+	}
+#elif VCriticalSection_USE_SPINLOCK
+	sLONG8 waitStart = 0;
 	_Lock();
 	do {
 		VTaskID	owner = fOwner;
@@ -134,6 +179,8 @@ bool VCriticalSection::Lock()
 			xbox_assert(GetUseCount() == 0);
 			++fSpinLockAndUseCount;
 			_Unlock();
+			if (waitStart != 0)
+				VLockProfiler::RecordContention( this, waitStart);
 			break;
 		}
 		else if (fOwner == currentTaskID)
@@ -148,6 +195,8 @@ bool VCriticalSection::Lock()
 			// Currently used by some other task.
 			// We have to use a VSyncEvent to block on.
 			// if there's one let's retain it
+			if ( (waitStart == 0) && VLockProfiler::IsRunning())
+				waitStart = VLockProfiler::GetTimeStamp();
 			VSyncEvent*	event = fEvent;
 			if (event != NULL)
 			{
@@ -173,6 +222,8 @@ bool VCriticalSection::Lock()
 						++fSpinLockAndUseCount;
 						_Unlock();
 						event->Release();
+						if (waitStart != 0)
+							VLockProfiler::RecordContention( this, waitStart);
 						break;
 					}
 					else if (fEvent == NULL)
@@ -264,6 +315,8 @@ bool VCriticalSection::Lock()
 		}
 	} while (fOwner != currentTaskID);
 #endif
+	if (GetUseCount() == 1)
+		VLockProfiler::RecordAcquisition( this);
 	return true;
 #endif
 }
@@ -277,7 +330,14 @@ bool VCriticalSection::Unlock()
 #else
 	xbox_assert((fOwner == VTask::GetCurrentID()) && (GetUseCount() > 0) && (GetUseCount() < 32000L));
 
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+	// Unlock or another successfull lock can only be called from same thread (so no contention can occur on fUseCount)
+	if (--fUseCount == 0)
+	{
+		fOwner = NULL_TASK_ID;
+		XLinuxAdaptiveLock::Unlock( &fLockWord);
+	}
+#elif VCriticalSection_USE_SPINLOCK
 	_Lock();
 	if (--fSpinLockAndUseCount == 0x80000000)
 	{
@@ -321,6 +381,153 @@ bool VCriticalSection::Unlock()
 //================================================================================================================
 
 
+VReaderWriterLock::VReaderWriterLock( sLONG inReaderSlots)
+: fReaderSlotCount( (inReaderSlots > 0) ? inReaderSlots : Max<sLONG>( VSystem::GetNumberOfProcessors(), 1))
+, fWriterPending( 0)
+{
+	fReaderSlots = new ReaderSlot[fReaderSlotCount];
+	for( sLONG i = 0 ; i < fReaderSlotCount ; ++i)
+		fReaderSlots[i].fCount = 0;
+}
+
+
+VReaderWriterLock::~VReaderWriterLock()
+{
+	xbox_assert( fWriterPending == 0 && !_HasReaders());
+	delete[] fReaderSlots;
+}
+
+
+bool VReaderWriterLock::_HasReaders() const
+{
+	for( sLONG i = 0 ; i < fReaderSlotCount ; ++i)
+	{
+		if (VInterlocked::AtomicGet( &fReaderSlots[i].fCount) != 0)
+			return true;
+	}
+	return false;
+}
+
+
+void VReaderWriterLock::_ReleaseRead( sLONG *inReaderCount)
+{
+	// the last reader of a slot wakes up a pending writer which will check the other slots
+	if ( (VInterlocked::Decrement( inReaderCount) == 0) && (VInterlocked::AtomicGet( &fWriterPending) != 0) )
+		fWriterGate.Unlock();
+}
+
+
+bool VReaderWriterLock::TryToLockRead()
+{
+	sLONG *readerCount = _GetReaderCount();
+	VInterlocked::Increment( readerCount);
+	if (VInterlocked::AtomicGet( &fWriterPending) == 0)
+		return true;
+	
+	// the writer itself may read
+	if (fWriterMutex.GetOwnerTaskID() == VTask::GetCurrentID())
+		return true;
+
+	_ReleaseRead( readerCount);
+	return false;
+}
+
+
+bool VReaderWriterLock::LockRead()
+{
+	sLONG8 waitStart = 0;
+	while( !TryToLockRead())
+	{
+		// a writer is pending: wait until it releases the lock
+		if ( (waitStart == 0) && VLockProfiler::IsRunning())
+			waitStart = VLockProfiler::GetTimeStamp();
+		fReadersGate.Lock();
+	}
+
+	if (waitStart != 0)
+		VLockProfiler::RecordContention( this, waitStart);
+	VLockProfiler::RecordAcquisition( this);
+
+	return true;
+}
+
+
+bool VReaderWriterLock::UnlockRead()
+{
+	xbox_assert( _HasReaders());
+	_ReleaseRead( _GetReaderCount());
+	return true;
+}
+
+
+bool VReaderWriterLock::LockWrite()
+{
+	fWriterMutex.Lock();
+	if (fWriterMutex.GetUseCount() > 1)
+		return true;	// already the writer
+
+	sLONG8 waitStart = 0;
+
+	// stop new readers
+	fReadersGate.Reset();
+	VInterlocked::Exchange( &fWriterPending, 1);
+
+	// wait for current readers to leave
+	for(;;)
+	{
+		fWriterGate.Reset();
+		if (!_HasReaders())
+			break;
+		if ( (waitStart == 0) && VLockProfiler::IsRunning())
+			waitStart = VLockProfiler::GetTimeStamp();
+		fWriterGate.Lock();
+	}
+
+	if (waitStart != 0)
+		VLockProfiler::RecordContention( this, waitStart);
+	VLockProfiler::RecordAcquisition( this);
+
+	return true;
+}
+
+
+bool VReaderWriterLock::TryToLockWrite()
+{
+	if (!fWriterMutex.TryToLock())
+		return false;
+	
+	if (fWriterMutex.GetUseCount() > 1)
+		return true;	// already the writer
+
+	fReadersGate.Reset();
+	VInterlocked::Exchange( &fWriterPending, 1);
+	if (!_HasReaders())
+		return true;
+
+	VInterlocked::Exchange( &fWriterPending, 0);
+	fReadersGate.Unlock();
+	fWriterMutex.Unlock();
+	return false;
+}
+
+
+bool VReaderWriterLock::UnlockWrite()
+{
+	xbox_assert( fWriterPending != 0 && fWriterMutex.GetOwnerTaskID() == VTask::GetCurrentID());
+
+	if (fWriterMutex.GetUseCount() == 1)
+	{
+		VInterlocked::Exchange( &fWriterPending, 0);
+		fReadersGate.Unlock();
+	}
+	fWriterMutex.Unlock();
+	return true;
+}
+
+
+//================================================================================================================
+
+
 VConditionVariable::~VConditionVariable()
 {
 	xbox_assert( fBusy == NULL);
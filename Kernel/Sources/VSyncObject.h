@@ -168,7 +168,13 @@ private:
 			sLONG					fUnlockStamp;	// incremented for each Unlock
 };
 
+#if VERSION_LINUX
+#define VCriticalSection_USE_FUTEX 1		// XLinuxAdaptiveLock
+#define VCriticalSection_USE_SPINLOCK 0
+#else
+#define VCriticalSection_USE_FUTEX 0
 #define VCriticalSection_USE_SPINLOCK 1
+#endif
 
 class XTOOLBOX_API VCriticalSection : public VSyncObject
 {
@@ -189,7 +195,9 @@ public:
 			bool					Unlock();
 	
 			// No protection - should be called only if Lock() returns true
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+			sLONG					GetUseCount () const						{ return fUseCount; }
+#elif VCriticalSection_USE_SPINLOCK
 			sLONG					GetUseCount () const						{ return fSpinLockAndUseCount & 0x7FFFFFFF; }
 #else			
 			sLONG					GetUseCount () const						{ return fUseCount; }
@@ -198,13 +206,17 @@ public:
 			VTaskID					GetOwnerTaskID() const						{ return fOwner;}
 
 private:
-			VSyncEvent*				fEvent;
 			VTaskID					fOwner;
-#if VCriticalSection_USE_SPINLOCK
+#if VCriticalSection_USE_FUTEX
+			sLONG					fLockWord;		/* XLinuxAdaptiveLock held by fOwner */
+			sLONG					fUseCount;
+#elif VCriticalSection_USE_SPINLOCK
+			VSyncEvent*				fEvent;
 			SpinLockType			fSpinLockAndUseCount;		/* Used for internal mutex on structure */
 			void					_Lock()															{ SpinLockThread( fSpinLockAndUseCount);}
 			void					_Unlock()														{ SpinUnlock( fSpinLockAndUseCount);}
 #else
+			VSyncEvent*				fEvent;
 			sLONG					fUseCount;
 	static	sLONG					sUnlockCount;
 #endif
@@ -265,18 +277,74 @@ public:
 			bool					Wait( VCriticalSection *inMutex)								{ return _Wait( inMutex, false, 0);}
 			
 private:
+#if VCriticalSection_USE_FUTEX
+			void					_Lock()															{ XLinuxAdaptiveLock::Lock( &fSpinLock, this);}
+			void					_Unlock()														{ XLinuxAdaptiveLock::Unlock( &fSpinLock);}
+#else
 			void					_Lock()															{ SpinLockThread( fSpinLock);}
 			void					_Unlock()														{ SpinUnlock( fSpinLock);}
+#endif
 
 			bool					_Wait( VCriticalSection *inMutex, bool inWithTimeout, sLONG inTimeoutMilliseconds);
 
 			VSyncEvent*				fEvent;
 			VCriticalSection*		fBusy;			/* mutex associated with variable for safety check */
-			SpinLockType			fSpinLock;		/* Used for internal mutex on structure */
+			SpinLockType			fSpinLock;		/* Used for internal mutex on structure (XLinuxAdaptiveLock word on linux) */
 			sWORD					fWaiters;		/* Number of threads waiting */
 			sWORD					fSigsPending;	/* Number of outstanding signals */
 };
 
+class XTOOLBOX_API VReaderWriterLock : public VSyncObject
+{
+public:
+	/*
+			Shared/exclusive lock for read-mostly structures.
+			
+			Any number of readers can hold the lock at the same time, a writer holds it alone.
+			Writer-preferring: once a writer waits, new readers are blocked until it has released the lock.
+			
+			Read lock is not recursive (a task holding the read lock may deadlock with a waiting writer if it asks for it again)
+			and cannot be upgraded to a write lock.
+			Write lock is recursive and the writer may also take the read lock.
+
+			Readers only touch a counter in the fast path.
+			With inReaderSlots > 1, readers are spread over that many counters (one per cache line)
+			so that concurrent readers on different cores don't bounce the same cache line.
+			Pass 0 to get one slot per processor.
+			
+			fiber-aware.
+	*/
+									VReaderWriterLock( sLONG inReaderSlots = 1);
+									~VReaderWriterLock();
+
+			bool					LockRead();
+			bool					TryToLockRead();
+			bool					UnlockRead();
+
+			bool					LockWrite();
+			bool					TryToLockWrite();
+			bool					UnlockWrite();
+
+private:
+	typedef struct ReaderSlot
+	{
+			sLONG					fCount;
+			char					fPadding[64 - sizeof( sLONG)];
+	} ReaderSlot;
+
+			sLONG*					_GetReaderCount() const							{ return &fReaderSlots[ (fReaderSlotCount > 1) ? (VTask::GetCurrentID() % fReaderSlotCount) : 0].fCount; }
+			bool					_HasReaders() const;
+			void					_ReleaseRead( sLONG *inReaderCount);
+
+			ReaderSlot*				fReaderSlots;
+			sLONG					fReaderSlotCount;
+			sLONG					fWriterPending;		/* 1 while a writer waits for or holds the lock */
+			VCriticalSection		fWriterMutex;		/* serializes writers */
+			VSyncEvent				fReadersGate;		/* blocked readers wait on it while fWriterPending is set */
+			VSyncEvent				fWriterGate;		/* the writer waits on it for the readers to leave */
+};
+
+
 template<class T>
 class StLocker
 { 
@@ -291,6 +359,28 @@ private:
 typedef StLocker<VCriticalSection> VTaskLock;
 
 
+class StReadLocker
+{ 
+public:
+			StReadLocker( VReaderWriterLock* inLock) : fLock( inLock)	{ fLock->LockRead(); }
+			~StReadLocker()												{ fLock->UnlockRead(); }
+
+private:
+	VReaderWriterLock*	fLock;
+};
+
+
+class StWriteLocker
+{ 
+public:
+			StWriteLocker( VReaderWriterLock* inLock) : fLock( inLock)	{ fLock->LockWrite(); }
+			~StWriteLocker()											{ fLock->UnlockWrite(); }
+
+private:
+	VReaderWriterLock*	fLock;
+};
+
+
 END_TOOLBOX_NAMESPACE
 
 #endif
@@ -904,6 +904,576 @@ bool VFromUnicodeConverter_UTF8::ConvertFrom_wchar( const wchar_t* inSource, VIn
 //==========================================================================================
 
 
+/*
+	Decoding and reverse tables of a single byte charset.
+	Tables are built once by asking the platform converters for each of the 256 bytes
+	so that table conversions give exactly the same results.
+*/
+BEGIN_TOOLBOX_NAMESPACE
+
+class VSingleByteCharSetTable : public VObject
+{
+public:
+	static	VSingleByteCharSetTable*	Create( CharSet inCharSet);
+
+			const UniChar*				GetToUnicodeTable() const	{ return fToUnicode; }
+			bool						IsASCIICompatible() const	{ return fIsASCIICompatible; }
+
+			bool						FromUnicode( UniChar inChar, uBYTE& outByte) const
+			{
+				if (fIsASCIICompatible && (inChar < 0x80))
+				{
+					outByte = (uBYTE) inChar;
+					return true;
+				}
+				const ReverseEntry *entry = std::lower_bound( fFromUnicode, fFromUnicode + fFromUnicodeCount, inChar);
+				if ( (entry == fFromUnicode + fFromUnicodeCount) || (entry->fChar != inChar) )
+					return false;
+				outByte = entry->fByte;
+				return true;
+			}
+
+private:
+			struct ReverseEntry
+			{
+				UniChar	fChar;
+				uBYTE	fByte;
+
+				bool	operator<( UniChar inChar) const	{ return fChar < inChar; }
+				bool	operator<( const ReverseEntry& inOther) const	{ return fChar < inOther.fChar; }
+			};
+
+										VSingleByteCharSetTable():fFromUnicodeCount( 0), fIsASCIICompatible( false)	{;}
+
+			bool						_Build( VToUnicodeConverter *inToUnicode, VFromUnicodeConverter *inFromUnicode);
+
+			UniChar						fToUnicode[256];
+			ReverseEntry				fFromUnicode[256];	// sorted by char, ascii chars are not stored if fIsASCIICompatible
+			VIndex						fFromUnicodeCount;
+			bool						fIsASCIICompatible;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
+/*
+	static
+*/
+VSingleByteCharSetTable *VSingleByteCharSetTable::Create( CharSet inCharSet)
+{
+	VSingleByteCharSetTable *table = NULL;
+
+	VToUnicodeConverter *toUnicode = XIntlMgrImpl::NewToUnicodeConverter( inCharSet);
+	VFromUnicodeConverter *fromUnicode = XIntlMgrImpl::NewFromUnicodeConverter( inCharSet);
+	if ( (toUnicode != NULL) && (fromUnicode != NULL) && toUnicode->IsValid() && fromUnicode->IsValid())
+	{
+		table = new VSingleByteCharSetTable;
+		if (!table->_Build( toUnicode, fromUnicode))
+		{
+			delete table;
+			table = NULL;
+		}
+	}
+	ReleaseRefCountable( &toUnicode);
+	ReleaseRefCountable( &fromUnicode);
+
+	return table;
+}
+
+
+bool VSingleByteCharSetTable::_Build( VToUnicodeConverter *inToUnicode, VFromUnicodeConverter *inFromUnicode)
+{
+	// each byte must give exactly one char
+	for( sLONG i = 0 ; i < 256 ; ++i)
+	{
+		uBYTE byte = (uBYTE) i;
+		UniChar chars[4];
+		VSize bytesConsumed = 0;
+		VIndex charsProduced = 0;
+		if (!inToUnicode->Convert( &byte, 1, &bytesConsumed, chars, 4, &charsProduced) || (bytesConsumed != 1) || (charsProduced != 1))
+			return false;
+		fToUnicode[i] = chars[0];
+	}
+
+	// keep only the chars the platform converter gives back as one byte.
+	// other chars are left to the platform converter which substitutes them.
+	std::vector<ReverseEntry> entries;
+	entries.reserve( 256);
+	for( sLONG i = 0 ; i < 256 ; ++i)
+	{
+		UniChar c = fToUnicode[i];
+		if ( (c >= 0xD800) && (c <= 0xDFFF) )
+			continue;
+
+		uBYTE bytes[8];
+		VIndex charsConsumed = 0;
+		VSize bytesProduced = 0;
+		if (inFromUnicode->Convert( &c, 1, &charsConsumed, bytes, sizeof( bytes), &bytesProduced) && (charsConsumed == 1) && (bytesProduced == 1))
+		{
+			ReverseEntry entry;
+			entry.fChar = c;
+			entry.fByte = bytes[0];
+			entries.push_back( entry);
+		}
+	}
+	std::sort( entries.begin(), entries.end());
+
+	// ascii compatible if all ascii chars map to themselves both ways
+	sLONG asciiCount = 0;
+	for( std::vector<ReverseEntry>::const_iterator i = entries.begin() ; i != entries.end() && i->fChar < 0x80 ; ++i)
+	{
+		if ( (i->fByte == i->fChar) && (fToUnicode[i->fChar] == i->fChar) && ((i == entries.begin()) || ((i-1)->fChar != i->fChar)) )
+			++asciiCount;
+	}
+	fIsASCIICompatible = (asciiCount == 0x80);
+
+	fFromUnicodeCount = 0;
+	for( std::vector<ReverseEntry>::const_iterator i = entries.begin() ; i != entries.end() ; ++i)
+	{
+		if (fIsASCIICompatible && (i->fChar < 0x80))
+			continue;
+		if ( (fFromUnicodeCount > 0) && (fFromUnicode[fFromUnicodeCount-1].fChar == i->fChar) )
+			continue;
+		fFromUnicode[fFromUnicodeCount++] = *i;
+	}
+
+	return true;
+}
+
+
+//==========================================================================================
+
+
+/*
+	Single byte charset tables and released platform converters.
+	Creating a platform converter means looking up the charset name and opening a system converter (ucnv_open, TEC...),
+	so converters for other charsets than the ones VTextConverters keeps are recycled here instead of being destroyed.
+*/
+
+// charsets which are probed for a single byte table
+static sLONG _GetSingleByteCharSetSlot( CharSet inCharSet)
+{
+	if ( (inCharSet >= VTC_MAC_ROMAN) && (inCharSet <= VTC_WIN_BALTIC) )
+		return inCharSet - VTC_MAC_ROMAN;					// 0..15
+	if ( (inCharSet >= VTC_KOI8R) && (inCharSet <= VTC_ISO_8859_13) )
+		return 16 + (inCharSet - VTC_KOI8R);				// 16..27
+	if (inCharSet == VTC_ISO_8859_15)
+		return 28;
+	if (inCharSet == VTC_IBM437)
+		return 29;
+	return -1;
+}
+
+#define kSINGLE_BYTE_CHARSET_SLOTS		30
+
+// max number of released platform converters kept for one charset
+#define kPOOLED_CONVERTERS_PER_CHARSET	4
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VTextConverterPool : public VObject, public IRefCountable
+{
+public:
+													VTextConverterPool();
+	virtual											~VTextConverterPool();
+
+			VToUnicodeConverter*					RetainToUnicodeConverter( CharSet inCharSet);
+			VFromUnicodeConverter*					RetainFromUnicodeConverter( CharSet inCharSet);
+
+			// platform converters
+			VToUnicodeConverter*					TakeToUnicodeConverter( CharSet inCharSet);
+			VFromUnicodeConverter*					TakeFromUnicodeConverter( CharSet inCharSet);
+			void									RecycleToUnicodeConverter( CharSet inCharSet, VToUnicodeConverter *inConverter);
+			void									RecycleFromUnicodeConverter( CharSet inCharSet, VFromUnicodeConverter *inConverter);
+
+private:
+			const VSingleByteCharSetTable*			_GetSingleByteCharSetTable( CharSet inCharSet);
+
+	typedef	std::multimap<CharSet,VToUnicodeConverter*>		MapOfToUnicodeConverters;
+	typedef	std::multimap<CharSet,VFromUnicodeConverter*>	MapOfFromUnicodeConverters;
+
+			VSingleByteCharSetTable*				fTables[kSINGLE_BYTE_CHARSET_SLOTS];	// published once built, never modified after
+			sLONG									fProbedSlots;							// bit set once the slot charset has been probed
+			VCriticalSection						fMutex;
+			MapOfToUnicodeConverters				fToUnicodeConverters;
+			MapOfFromUnicodeConverters				fFromUnicodeConverters;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
+VTextConverterPool::VTextConverterPool()
+: fProbedSlots( 0)
+{
+	for( sLONG i = 0 ; i < kSINGLE_BYTE_CHARSET_SLOTS ; ++i)
+		fTables[i] = NULL;
+}
+
+
+VTextConverterPool::~VTextConverterPool()
+{
+	for( sLONG i = 0 ; i < kSINGLE_BYTE_CHARSET_SLOTS ; ++i)
+		delete fTables[i];
+
+	for( MapOfToUnicodeConverters::iterator i = fToUnicodeConverters.begin() ; i != fToUnicodeConverters.end() ; ++i)
+		i->second->Release();
+
+	for( MapOfFromUnicodeConverters::iterator i = fFromUnicodeConverters.begin() ; i != fFromUnicodeConverters.end() ; ++i)
+		i->second->Release();
+}
+
+
+const VSingleByteCharSetTable *VTextConverterPool::_GetSingleByteCharSetTable( CharSet inCharSet)
+{
+	sLONG slot = _GetSingleByteCharSetSlot( inCharSet);
+	if (slot < 0)
+		return NULL;
+
+	// lock-free once probed
+	if ((VInterlocked::AtomicGet( &fProbedSlots) & (1 << slot)) != 0)
+		return (const VSingleByteCharSetTable*) VInterlocked::CompareExchangePtr( (void**) &fTables[slot], NULL, NULL);
+
+	VTaskLock lock( &fMutex);
+	if ((VInterlocked::AtomicGet( &fProbedSlots) & (1 << slot)) == 0)
+	{
+		VSingleByteCharSetTable *table = VSingleByteCharSetTable::Create( inCharSet);
+		VInterlocked::CompareExchangePtr( (void**) &fTables[slot], NULL, table);
+		VInterlocked::TestAndSet( &fProbedSlots, slot);
+	}
+	return fTables[slot];
+}
+
+
+VToUnicodeConverter *VTextConverterPool::RetainToUnicodeConverter( CharSet inCharSet)
+{
+	const VSingleByteCharSetTable *table = _GetSingleByteCharSetTable( inCharSet);
+	if (table != NULL)
+		return new VToUnicodeConverter_SingleByte( table, this);
+
+	VToUnicodeConverter *converter = TakeToUnicodeConverter( inCharSet);
+	if (converter == NULL)
+		return NULL;
+
+	return new VToUnicodeConverter_Pooled( inCharSet, converter, this);
+}
+
+
+VFromUnicodeConverter *VTextConverterPool::RetainFromUnicodeConverter( CharSet inCharSet)
+{
+	const VSingleByteCharSetTable *table = _GetSingleByteCharSetTable( inCharSet);
+	if (table != NULL)
+		return new VFromUnicodeConverter_SingleByte( inCharSet, table, this);
+
+	VFromUnicodeConverter *converter = TakeFromUnicodeConverter( inCharSet);
+	if (converter == NULL)
+		return NULL;
+
+	return new VFromUnicodeConverter_Pooled( inCharSet, converter, this);
+}
+
+
+VToUnicodeConverter *VTextConverterPool::TakeToUnicodeConverter( CharSet inCharSet)
+{
+	{
+		VTaskLock lock( &fMutex);
+		MapOfToUnicodeConverters::iterator i = fToUnicodeConverters.find( inCharSet);
+		if (i != fToUnicodeConverters.end())
+		{
+			VToUnicodeConverter *converter = i->second;
+			fToUnicodeConverters.erase( i);
+			return converter;
+		}
+	}
+	return XIntlMgrImpl::NewToUnicodeConverter( inCharSet);
+}
+
+
+VFromUnicodeConverter *VTextConverterPool::TakeFromUnicodeConverter( CharSet inCharSet)
+{
+	{
+		VTaskLock lock( &fMutex);
+		MapOfFromUnicodeConverters::iterator i = fFromUnicodeConverters.find( inCharSet);
+		if (i != fFromUnicodeConverters.end())
+		{
+			VFromUnicodeConverter *converter = i->second;
+			fFromUnicodeConverters.erase( i);
+			return converter;
+		}
+	}
+	return XIntlMgrImpl::NewFromUnicodeConverter( inCharSet);
+}
+
+
+void VTextConverterPool::RecycleToUnicodeConverter( CharSet inCharSet, VToUnicodeConverter *inConverter)
+{
+#if !VERSIONMAC	// TEC converters may keep some state between calls
+	if (inConverter->GetRefCount() == 1)
+	{
+		VTaskLock lock( &fMutex);
+		if (fToUnicodeConverters.count( inCharSet) < kPOOLED_CONVERTERS_PER_CHARSET)
+		{
+			fToUnicodeConverters.insert( MapOfToUnicodeConverters::value_type( inCharSet, inConverter));
+			return;
+		}
+	}
+#endif
+	inConverter->Release();
+}
+
+
+void VTextConverterPool::RecycleFromUnicodeConverter( CharSet inCharSet, VFromUnicodeConverter *inConverter)
+{
+#if !VERSIONMAC	// TEC converters may keep some state between calls
+	if (inConverter->GetRefCount() == 1)
+	{
+		VTaskLock lock( &fMutex);
+		if (fFromUnicodeConverters.count( inCharSet) < kPOOLED_CONVERTERS_PER_CHARSET)
+		{
+			fFromUnicodeConverters.insert( MapOfFromUnicodeConverters::value_type( inCharSet, inConverter));
+			return;
+		}
+	}
+#endif
+	inConverter->Release();
+}
+
+
+//==========================================================================================
+
+
+VToUnicodeConverter_SingleByte::VToUnicodeConverter_SingleByte( const VSingleByteCharSetTable *inTable, VTextConverterPool *inPool)
+: fTable( inTable)
+, fPool( RetainRefCountable( inPool))
+{
+}
+
+
+VToUnicodeConverter_SingleByte::~VToUnicodeConverter_SingleByte()
+{
+	ReleaseRefCountable( &fPool);
+}
+
+
+bool VToUnicodeConverter_SingleByte::Convert( const void *inSource, VSize inSourceBytes, VSize* outBytesConsumed, UniChar* inDestination, VIndex inDestinationChars, VIndex *outProducedChars)
+{
+	const uBYTE *srcPtr = (const uBYTE *) inSource;
+	const uBYTE *srcEnd = srcPtr + Min( inSourceBytes, (VSize) inDestinationChars);
+	UniChar *outPtr = inDestination;
+	const UniChar *table = fTable->GetToUnicodeTable();
+
+	if (fTable->IsASCIICompatible())
+	{
+		// ascii pass-through, 8 bytes at a time
+		const uLONG8 highBits = XBOX_LONG8(0x8080808080808080);
+		while (srcEnd - srcPtr >= 8)
+		{
+			uLONG8 bytes;
+			::memcpy( &bytes, srcPtr, sizeof( bytes));
+			if ((bytes & highBits) != 0)
+			{
+				// decode up to next 8 bytes boundary
+				for( const uBYTE *end = srcPtr + 8 ; srcPtr < end ; ++srcPtr)
+					*outPtr++ = table[*srcPtr];
+				continue;
+			}
+			outPtr[0] = srcPtr[0];
+			outPtr[1] = srcPtr[1];
+			outPtr[2] = srcPtr[2];
+			outPtr[3] = srcPtr[3];
+			outPtr[4] = srcPtr[4];
+			outPtr[5] = srcPtr[5];
+			outPtr[6] = srcPtr[6];
+			outPtr[7] = srcPtr[7];
+			srcPtr += 8;
+			outPtr += 8;
+		}
+	}
+
+	while (srcPtr < srcEnd)
+		*outPtr++ = table[*srcPtr++];
+
+	*outBytesConsumed = srcPtr - (const uBYTE *) inSource;
+	*outProducedChars = (VIndex) (outPtr - inDestination);
+
+	return true;
+}
+
+
+VFromUnicodeConverter_SingleByte::VFromUnicodeConverter_SingleByte( CharSet inCharSet, const VSingleByteCharSetTable *inTable, VTextConverterPool *inPool)
+: fCharSet( inCharSet)
+, fTable( inTable)
+, fPool( RetainRefCountable( inPool))
+, fFallbackConverter( NULL)
+{
+}
+
+
+VFromUnicodeConverter_SingleByte::~VFromUnicodeConverter_SingleByte()
+{
+	if (fFallbackConverter != NULL)
+		fPool->RecycleFromUnicodeConverter( fCharSet, fFallbackConverter);
+	ReleaseRefCountable( &fPool);
+}
+
+
+bool VFromUnicodeConverter_SingleByte::Convert( const UniChar* inSource, VIndex inSourceChars, VIndex *outCharsConsumed, void* inBuffer, VSize inBufferSize, VSize *outBytesProduced)
+{
+	bool isOK = true;
+
+	const UniChar *srcPtr = inSource;
+	const UniChar *srcEnd = inSource + inSourceChars;
+	uBYTE *outPtr = (uBYTE *) inBuffer;
+	uBYTE *outEnd = outPtr + inBufferSize;
+	bool asciiCompatible = fTable->IsASCIICompatible();
+	const uLONG8 highBits = XBOX_LONG8(0xFF80FF80FF80FF80);
+
+	while ( (srcPtr < srcEnd) && (outPtr < outEnd) )
+	{
+		// ascii pass-through, 4 chars at a time
+		if (asciiCompatible)
+		{
+			while ( (srcEnd - srcPtr >= 4) && (outEnd - outPtr >= 4) )
+			{
+				uLONG8 chars;
+				::memcpy( &chars, srcPtr, sizeof( chars));
+				if ((chars & highBits) != 0)
+					break;
+				outPtr[0] = (uBYTE) srcPtr[0];
+				outPtr[1] = (uBYTE) srcPtr[1];
+				outPtr[2] = (uBYTE) srcPtr[2];
+				outPtr[3] = (uBYTE) srcPtr[3];
+				srcPtr += 4;
+				outPtr += 4;
+			}
+			if ( (srcPtr >= srcEnd) || (outPtr >= outEnd) )
+				break;
+		}
+
+		uBYTE byte;
+		if (fTable->FromUnicode( *srcPtr, byte))
+		{
+			*outPtr++ = byte;
+			++srcPtr;
+		}
+		else
+		{
+			// let the platform converter substitute the run of unmapped chars
+			const UniChar *runStart = srcPtr;
+			do
+			{
+				++srcPtr;
+			} while ( (srcPtr < srcEnd) && !fTable->FromUnicode( *srcPtr, byte));
+
+			if (fFallbackConverter == NULL)
+				fFallbackConverter = fPool->TakeFromUnicodeConverter( fCharSet);
+
+			VIndex charsConsumed = 0;
+			VSize bytesProduced = 0;
+			if (fFallbackConverter != NULL)
+				isOK = fFallbackConverter->Convert( runStart, (VIndex) (srcPtr - runStart), &charsConsumed, outPtr, outEnd - outPtr, &bytesProduced);
+			else
+				isOK = false;
+
+			outPtr += bytesProduced;
+			if (!isOK || (runStart + charsConsumed != srcPtr))
+			{
+				srcPtr = runStart + charsConsumed;
+				break;
+			}
+		}
+	}
+
+	*outCharsConsumed = (VIndex) (srcPtr - inSource);
+	*outBytesProduced = outPtr - (uBYTE *) inBuffer;
+
+	return isOK;
+}
+
+
+//==========================================================================================
+
+
+VToUnicodeConverter_Pooled::VToUnicodeConverter_Pooled( CharSet inCharSet, VToUnicodeConverter *inConverter, VTextConverterPool *inPool)
+: fCharSet( inCharSet)
+, fConverter( inConverter)
+, fPool( RetainRefCountable( inPool))
+{
+}
+
+
+VToUnicodeConverter_Pooled::~VToUnicodeConverter_Pooled()
+{
+	fPool->RecycleToUnicodeConverter( fCharSet, fConverter);
+	ReleaseRefCountable( &fPool);
+}
+
+
+bool VToUnicodeConverter_Pooled::IsValid() const
+{
+	return fConverter->IsValid();
+}
+
+
+bool VToUnicodeConverter_Pooled::ConvertString( const void* inSource, VSize inSourceBytes, VSize* outBytesConsumed, VString& outDestination)
+{
+	return fConverter->ConvertString( inSource, inSourceBytes, outBytesConsumed, outDestination);
+}
+
+
+bool VToUnicodeConverter_Pooled::Convert( const void* inSource, VSize inSourceBytes, VSize* outBytesConsumed, UniChar* inDestination, VIndex inDestinationChars, VIndex* outProducedChars)
+{
+	return fConverter->Convert( inSource, inSourceBytes, outBytesConsumed, inDestination, inDestinationChars, outProducedChars);
+}
+
+
+VSize VToUnicodeConverter_Pooled::GetCharSize() const
+{
+	return fConverter->GetCharSize();
+}
+
+
+VFromUnicodeConverter_Pooled::VFromUnicodeConverter_Pooled( CharSet inCharSet, VFromUnicodeConverter *inConverter, VTextConverterPool *inPool)
+: fCharSet( inCharSet)
+, fConverter( inConverter)
+, fPool( RetainRefCountable( inPool))
+{
+}
+
+
+VFromUnicodeConverter_Pooled::~VFromUnicodeConverter_Pooled()
+{
+	fPool->RecycleFromUnicodeConverter( fCharSet, fConverter);
+	ReleaseRefCountable( &fPool);
+}
+
+
+bool VFromUnicodeConverter_Pooled::IsValid() const
+{
+	return fConverter->IsValid();
+}
+
+
+bool VFromUnicodeConverter_Pooled::ConvertRealloc( const UniChar *inSource, VIndex inSourceChars, void*& ioBuffer, VSize& ioBytesInBuffer, VSize inTrailingBytes)
+{
+	return fConverter->ConvertRealloc( inSource, inSourceChars, ioBuffer, ioBytesInBuffer, inTrailingBytes);
+}
+
+
+bool VFromUnicodeConverter_Pooled::Convert( const UniChar *inSource, VIndex inSourceChars, VIndex *outCharsConsumed, void *inBuffer, VSize inBufferSize, VSize *outBytesProduced)
+{
+	return fConverter->Convert( inSource, inSourceChars, outCharsConsumed, inBuffer, inBufferSize, outBytesProduced);
+}
+
+
+VSize VFromUnicodeConverter_Pooled::GetCharSize() const
+{
+	return fConverter->GetCharSize();
+}
+
+
+
+
 // keep VTC_SystemCharSet definition private
 // cause it does not make sense outside win or mac specific code.
 #if VERSIONMAC
@@ -944,6 +1514,8 @@ VTextConverters::VTextConverters()
 
 	fToUTF8Converter = new VToUnicodeConverter_UTF8;
 	fFromUTF8Converter = new VFromUnicodeConverter_UTF8;
+
+	fPool = new VTextConverterPool;
 }
 
 
@@ -966,6 +1538,8 @@ VTextConverters::~VTextConverters()
 
 	ReleaseRefCountable( &fToUTF8Converter);
 	ReleaseRefCountable( &fFromUTF8Converter);
+
+	ReleaseRefCountable( &fPool);
 }
 
 
@@ -1173,7 +1747,7 @@ VToUnicodeConverter* VTextConverters::RetainToUnicodeConverter( CharSet inCharSe
 			break;
 		
 		default:
-			converter = XIntlMgrImpl::NewToUnicodeConverter(inCharSet);
+			converter = fPool->RetainToUnicodeConverter(inCharSet);
 			if (converter == NULL)
 				converter = new VToUnicodeConverter_Void;
 			break;
@@ -1240,7 +1814,7 @@ VFromUnicodeConverter* VTextConverters::RetainFromUnicodeConverter(CharSet inCha
 			break;
 		
 		default:
-			converter = XIntlMgrImpl::NewFromUnicodeConverter(inCharSet);
+			converter = fPool->RetainFromUnicodeConverter(inCharSet);
 			if (converter == NULL)
 				converter = new VFromUnicodeConverter_Void;
 			break;
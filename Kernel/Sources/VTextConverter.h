@@ -24,6 +24,8 @@ BEGIN_TOOLBOX_NAMESPACE
 
 // Needed declaration
 class VString;
+class VSingleByteCharSetTable;
+class VTextConverterPool;
 
 // Conversion d'un jeu de caracteres donne vers Unicode (UTF-16)
 class XTOOLBOX_API VToUnicodeConverter : public VObject, public IRefCountable
@@ -170,6 +172,77 @@ public:
 
 
 
+// Conversion from a single byte charset (Windows-125x, ISO-8859-x, MacRoman...) to Unicode (UTF-16) using a 256 entries table
+class XTOOLBOX_API VToUnicodeConverter_SingleByte : public VToUnicodeConverter
+{
+public:
+					VToUnicodeConverter_SingleByte( const VSingleByteCharSetTable *inTable, VTextConverterPool *inPool);
+	virtual			~VToUnicodeConverter_SingleByte();
+
+	virtual bool	Convert( const void *inSource, VSize inSourceBytes, VSize* outBytesConsumed, UniChar* inDestination, VIndex inDestinationChars, VIndex *outProducedChars);
+
+private:
+			const VSingleByteCharSetTable*	fTable;
+			VTextConverterPool*				fPool;
+};
+
+
+// Conversion from Unicode (UTF-16) to a single byte charset using the reverse table.
+// Chars which are not in the table are given to the platform converter so that they are substituted the same way.
+class XTOOLBOX_API VFromUnicodeConverter_SingleByte : public VFromUnicodeConverter
+{
+public:
+					VFromUnicodeConverter_SingleByte( CharSet inCharSet, const VSingleByteCharSetTable *inTable, VTextConverterPool *inPool);
+	virtual			~VFromUnicodeConverter_SingleByte();
+
+	virtual bool	Convert( const UniChar* inSource, VIndex inSourceChars, VIndex *outCharsConsumed, void* inBuffer, VSize inBufferSize, VSize *outBytesProduced);
+	virtual VSize	GetCharSize () const	{ return sizeof(uBYTE); }
+
+private:
+			CharSet							fCharSet;
+			const VSingleByteCharSetTable*	fTable;
+			VTextConverterPool*				fPool;
+			VFromUnicodeConverter*			fFallbackConverter;	// platform converter (taken from the pool on first unmapped char)
+};
+
+
+// Platform converter given back to the converters pool when released
+class XTOOLBOX_API VToUnicodeConverter_Pooled : public VToUnicodeConverter
+{
+public:
+					VToUnicodeConverter_Pooled( CharSet inCharSet, VToUnicodeConverter *inConverter, VTextConverterPool *inPool);
+	virtual			~VToUnicodeConverter_Pooled();
+
+	virtual bool	IsValid () const;
+	virtual bool	ConvertString( const void* inSource, VSize inSourceBytes, VSize* outBytesConsumed, VString& outDestination);
+	virtual bool	Convert( const void* inSource, VSize inSourceBytes, VSize* outBytesConsumed, UniChar* inDestination, VIndex inDestinationChars, VIndex* outProducedChars);
+	virtual VSize	GetCharSize() const;
+
+private:
+			CharSet					fCharSet;
+			VToUnicodeConverter*	fConverter;
+			VTextConverterPool*		fPool;
+};
+
+
+class XTOOLBOX_API VFromUnicodeConverter_Pooled : public VFromUnicodeConverter
+{
+public:
+					VFromUnicodeConverter_Pooled( CharSet inCharSet, VFromUnicodeConverter *inConverter, VTextConverterPool *inPool);
+	virtual			~VFromUnicodeConverter_Pooled();
+
+	virtual bool	IsValid () const;
+	virtual bool	ConvertRealloc( const UniChar *inSource, VIndex inSourceChars, void*& ioBuffer, VSize& ioBytesInBuffer, VSize inTrailingBytes);
+	virtual bool	Convert( const UniChar *inSource, VIndex inSourceChars, VIndex *outCharsConsumed, void *inBuffer, VSize inBufferSize, VSize *outBytesProduced);
+	virtual VSize	GetCharSize() const;
+
+private:
+			CharSet					fCharSet;
+			VFromUnicodeConverter*	fConverter;
+			VTextConverterPool*		fPool;
+};
+
+
 class XTOOLBOX_API VTextConverters : public VObject
 {
 public:
@@ -244,6 +317,8 @@ private:
 
 			VToUnicodeConverter_UTF8*			fToUTF8Converter;	// converter from VTC_UTF_16 to VTC_UTF_8
 			VFromUnicodeConverter_UTF8*			fFromUTF8Converter;	// converter from VTC_UTF_8 to VTC_UTF_16
+
+			VTextConverterPool*					fPool;	// single byte charset tables and released platform converters
 };
 
 END_TOOLBOX_NAMESPACE
@@ -0,0 +1,552 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VKernelPrecompiled.h"
+#include "VTraceProfiler.h"
+#include "VTask.h"
+#include "VString.h"
+#include "VValueBag.h"
+#include "VFile.h"
+#include "VFileStream.h"
+#include "VInterlocked.h"
+
+
+BEGIN_TOOLBOX_NAMESPACE
+
+// per task event buffer.
+// Only the owner task writes into it: events [0..fCount[ are stable once fCount has been published.
+class VTraceBuffer : public VObject, public IRefCountable
+{
+public:
+								VTraceBuffer( sLONG inCapacity, sLONG inGeneration)
+									: fEvents( new VTraceProfiler::TraceEvent[inCapacity])
+									, fCapacity( inCapacity)
+									, fCount( 0)
+									, fDepth( 0)
+									, fGeneration( inGeneration)
+									, fDroppedCount( 0)
+									, fTaskID( VTask::GetCurrentID())
+									{
+										if (fEvents == NULL)
+											fCapacity = 0;
+										VTask *task = VTask::GetCurrent();
+										if (task != NULL)
+											task->GetName( fTaskName);
+									}
+	virtual						~VTraceBuffer()				{ delete [] fEvents; }
+
+			void				Clear( sLONG inGeneration)	{ VInterlocked::Exchange( &fCount, 0); fDepth = 0; fDroppedCount = 0; fGeneration = inGeneration; }
+
+			VTraceProfiler::TraceEvent*	fEvents;
+			sLONG				fCapacity;
+			sLONG				fCount;
+			sLONG				fDepth;
+			sLONG				fGeneration;
+			sLONG8				fDroppedCount;
+			VTaskID				fTaskID;
+			VString				fTaskName;
+};
+
+END_TOOLBOX_NAMESPACE
+
+
+static VCriticalSection					sMutex;
+static std::vector<VTraceBuffer*>		sBuffers;			// buffers recorded since last Start()
+static VTaskDataKey						sDataKey = 0;
+static sLONG							sCapacity = 0;
+static sLONG							sGeneration = 0;
+static sLONG8							sStartTime = 0;
+static sLONG8							sFrequency = 1;
+
+
+static void _DisposeBuffer( void *inData)
+{
+	static_cast<VTraceBuffer*>( inData)->Release();
+}
+
+
+static sLONG8 _TicksToMicroseconds( sLONG8 inTicks)
+{
+	return (sLONG8) (((Real) inTicks * 1000000.0) / (Real) sFrequency);
+}
+
+
+static bool _CompareEvents( const VTraceProfiler::TraceEvent& inFirst, const VTraceProfiler::TraceEvent& inSecond)
+{
+	// parents before their children
+	if (inFirst.fStart != inSecond.fStart)
+		return inFirst.fStart < inSecond.fStart;
+	return inFirst.fDepth < inSecond.fDepth;
+}
+
+
+static void _CopyEvents( const VTraceBuffer *inBuffer, std::vector<VTraceProfiler::TraceEvent>& outEvents)
+{
+	sLONG count = VInterlocked::AtomicGet( const_cast<sLONG*>( &inBuffer->fCount));
+	outEvents.assign( inBuffer->fEvents, inBuffer->fEvents + count);
+	std::sort( outEvents.begin(), outEvents.end(), _CompareEvents);
+}
+
+
+static std::string _MakeKey( const VTraceProfiler::TraceEvent& inEvent)
+{
+	std::string key( inEvent.fCategory);
+	key += '\t';
+	key += inEvent.fName;
+	return key;
+}
+
+
+static sLONG _GetHistogramBucket( sLONG8 inMicroseconds)
+{
+	sLONG bucket = 0;
+	while( (bucket < VTraceProfiler::kHistogramBucketCount - 1) && (inMicroseconds >= (((sLONG8) 1) << bucket)) )
+		++bucket;
+	return bucket;
+}
+
+
+static void _AppendJSONString( VString& ioJSON, const char *inString)
+{
+	ioJSON.AppendUniChar( '"');
+	for( const char *p = inString ; *p != 0 ; ++p)
+	{
+		char c = *p;
+		if (c == '"' || c == '\\')
+		{
+			ioJSON.AppendUniChar( '\\');
+			ioJSON.AppendUniChar( c);
+		}
+		else if ( (unsigned char) c < 0x20)
+		{
+			ioJSON.AppendUniChar( ' ');
+		}
+		else
+		{
+			ioJSON.AppendUniChar( (UniChar) (unsigned char) c);
+		}
+	}
+	ioJSON.AppendUniChar( '"');
+}
+
+
+// durations of all events of a given category and name, see GetHistograms().
+typedef struct VTraceHistogram
+{
+	const char*		fCategory;
+	const char*		fName;
+	sLONG8			fCount;
+	sLONG8			fTotalMicroseconds;
+	sLONG8			fMaxMicroseconds;
+	sLONG8			fBuckets[VTraceProfiler::kHistogramBucketCount];
+} VTraceHistogram;
+
+
+class VCallNode
+{
+public:
+	typedef std::map<std::string, VCallNode*>	MapOfNodes;
+
+								VCallNode( const char *inCategory, const char *inName) : fCategory( inCategory), fName( inName), fCount( 0), fTotalTicks( 0), fChildrenTicks( 0)	{}
+								~VCallNode()
+								{
+									for( MapOfNodes::iterator i = fChildren.begin() ; i != fChildren.end() ; ++i)
+										delete i->second;
+								}
+
+			VCallNode*			GetChild( const VTraceProfiler::TraceEvent& inEvent)
+								{
+									std::string key( _MakeKey( inEvent));
+									MapOfNodes::iterator i = fChildren.find( key);
+									if (i != fChildren.end())
+										return i->second;
+									VCallNode *node = new VCallNode( inEvent.fCategory, inEvent.fName);
+									fChildren.insert( MapOfNodes::value_type( key, node));
+									return node;
+								}
+
+			void				AddChildrenToBag( VValueBag& ioBag) const
+								{
+									for( MapOfNodes::const_iterator i = fChildren.begin() ; i != fChildren.end() ; ++i)
+									{
+										const VCallNode *node = i->second;
+										VValueBag *bag = new VValueBag;
+										if (bag != NULL)
+										{
+											bag->SetString( "category", VString( node->fCategory));
+											bag->SetString( "name", VString( node->fName));
+											bag->SetLong8( "count", node->fCount);
+											bag->SetLong8( "total_time", _TicksToMicroseconds( node->fTotalTicks));
+											bag->SetLong8( "self_time", _TicksToMicroseconds( node->fTotalTicks - node->fChildrenTicks));
+											node->AddChildrenToBag( *bag);
+											ioBag.AddElement( "scope", bag);
+											bag->Release();
+										}
+									}
+								}
+
+			void				Dump( sLONG inLevel) const
+								{
+									for( MapOfNodes::const_iterator i = fChildren.begin() ; i != fChildren.end() ; ++i)
+									{
+										const VCallNode *node = i->second;
+										VString string;
+										for( sLONG level = 0 ; level < inLevel ; ++level)
+											string += "  ";
+										string += node->fCategory;
+										string += " ";
+										string += node->fName;
+										string += " : ";
+										string.AppendLong8( node->fCount);
+										string += " calls, total ";
+										string.AppendLong8( _TicksToMicroseconds( node->fTotalTicks));
+										string += " us, self ";
+										string.AppendLong8( _TicksToMicroseconds( node->fTotalTicks - node->fChildrenTicks));
+										string += " us\r\n";
+										DebugMsg( string);
+										node->Dump( inLevel + 1);
+									}
+								}
+
+			const char*			fCategory;
+			const char*			fName;
+			sLONG8				fCount;
+			sLONG8				fTotalTicks;
+			sLONG8				fChildrenTicks;
+			MapOfNodes			fChildren;
+};
+
+
+static void _BuildCallTree( const std::vector<VTraceBuffer*>& inBuffers, VCallNode& ioRoot)
+{
+	std::vector<VTraceProfiler::TraceEvent> events;
+	std::vector<VCallNode*> stack;
+
+	for( std::vector<VTraceBuffer*>::const_iterator i = inBuffers.begin() ; i != inBuffers.end() ; ++i)
+	{
+		_CopyEvents( *i, events);
+		stack.clear();
+		for( std::vector<VTraceProfiler::TraceEvent>::const_iterator j = events.begin() ; j != events.end() ; ++j)
+		{
+			// if the parent event was dropped, attach to the deepest known ancestor
+			while( stack.size() > (size_t) j->fDepth)
+				stack.pop_back();
+			
+			sLONG8 duration = j->fEnd - j->fStart;
+			VCallNode *parent = stack.empty() ? &ioRoot : stack.back();
+			VCallNode *node = parent->GetChild( *j);
+			++node->fCount;
+			node->fTotalTicks += duration;
+			parent->fChildrenTicks += duration;
+			stack.push_back( node);
+		}
+	}
+}
+
+
+bool VTraceProfiler::sRunning = false;
+
+
+void VTraceProfiler::Start( sLONG inEventsPerTask)
+{
+	xbox_assert( inEventsPerTask > 0);
+
+	sMutex.Lock();
+
+	// task buffers are cleared by their owner task on their next scope
+	for( std::vector<VTraceBuffer*>::iterator i = sBuffers.begin() ; i != sBuffers.end() ; ++i)
+		(*i)->Release();
+	sBuffers.clear();
+
+	if (sDataKey == 0)
+		sDataKey = VTask::CreateDataKey( _DisposeBuffer);
+
+	sCapacity = inEventsPerTask;
+	sFrequency = VSystem::GetProfilingFrequency();
+	VSystem::GetProfilingCounter( sStartTime);
+	VInterlocked::Increment( &sGeneration);
+	sRunning = true;
+
+	sMutex.Unlock();
+}
+
+
+void VTraceProfiler::Stop()
+{
+	// recorded events remain available until next Start()
+	sRunning = false;
+}
+
+
+VTraceBuffer* VTraceProfiler::_EnterScope()
+{
+	if (VTask::GetCurrent() == NULL)
+		return NULL;
+
+	VTraceBuffer *buffer = static_cast<VTraceBuffer*>( VTask::GetCurrentData( sDataKey));
+	sLONG generation = VInterlocked::AtomicGet( &sGeneration);
+	if ( (buffer == NULL) || (buffer->fGeneration != generation) )
+	{
+		// first scope of this task since last Start()
+		sMutex.Lock();
+		if ( (buffer != NULL) && (buffer->fCapacity == sCapacity) )
+		{
+			buffer->Clear( sGeneration);
+		}
+		else
+		{
+			VTraceBuffer *newBuffer = new VTraceBuffer( sCapacity, sGeneration);
+			VTask::SetCurrentData( sDataKey, newBuffer);
+			ReleaseRefCountable( &buffer);
+			buffer = newBuffer;
+		}
+		if (buffer != NULL)
+		{
+			buffer->Retain();
+			sBuffers.push_back( buffer);
+		}
+		sMutex.Unlock();
+	}
+	
+	if (buffer != NULL)
+		++buffer->fDepth;
+
+	return buffer;
+}
+
+
+void VTraceProfiler::_LeaveScope( VTraceBuffer *inBuffer, const char *inCategory, const char *inName, sLONG8 inStart)
+{
+	sLONG8 end;
+	VSystem::GetProfilingCounter( end);
+
+	// the depth may have been reset by a Start() while the scope was opened
+	if (inBuffer->fDepth > 0)
+		--inBuffer->fDepth;
+
+	sLONG count = inBuffer->fCount;
+	if (count < inBuffer->fCapacity)
+	{
+		TraceEvent *event = &inBuffer->fEvents[count];
+		event->fCategory = inCategory;
+		event->fName = inName;
+		event->fStart = inStart;
+		event->fEnd = end;
+		event->fDepth = inBuffer->fDepth;
+		VInterlocked::Exchange( &inBuffer->fCount, count + 1);
+	}
+	else
+	{
+		++inBuffer->fDroppedCount;
+	}
+}
+
+
+void VTraceProfiler::_RetainBuffers( std::vector<VTraceBuffer*>& outBuffers)
+{
+	sMutex.Lock();
+	outBuffers = sBuffers;
+	for( std::vector<VTraceBuffer*>::iterator i = outBuffers.begin() ; i != outBuffers.end() ; ++i)
+		(*i)->Retain();
+	sMutex.Unlock();
+}
+
+
+static void _ReleaseBuffers( std::vector<VTraceBuffer*>& ioBuffers)
+{
+	for( std::vector<VTraceBuffer*>::iterator i = ioBuffers.begin() ; i != ioBuffers.end() ; ++i)
+		(*i)->Release();
+	ioBuffers.clear();
+}
+
+
+void VTraceProfiler::GetCallTree( VValueBag& outBag)
+{
+	std::vector<VTraceBuffer*> buffers;
+	_RetainBuffers( buffers);
+
+	VCallNode root( "", "");
+	_BuildCallTree( buffers, root);
+	root.AddChildrenToBag( outBag);
+
+	_ReleaseBuffers( buffers);
+}
+
+
+void VTraceProfiler::GetHistograms( VValueBag& outBag)
+{
+	typedef std::map<std::string, VTraceHistogram>	MapOfHistograms;
+
+	std::vector<VTraceBuffer*> buffers;
+	_RetainBuffers( buffers);
+
+	MapOfHistograms histograms;
+	std::vector<TraceEvent> events;
+	for( std::vector<VTraceBuffer*>::const_iterator i = buffers.begin() ; i != buffers.end() ; ++i)
+	{
+		_CopyEvents( *i, events);
+		for( std::vector<TraceEvent>::const_iterator j = events.begin() ; j != events.end() ; ++j)
+		{
+			std::pair<MapOfHistograms::iterator, bool> inserted = histograms.insert( MapOfHistograms::value_type( _MakeKey( *j), VTraceHistogram()));
+			VTraceHistogram& histogram = inserted.first->second;
+			if (inserted.second)
+			{
+				::memset( &histogram, 0, sizeof( histogram));
+				histogram.fCategory = j->fCategory;
+				histogram.fName = j->fName;
+			}
+			sLONG8 duration = _TicksToMicroseconds( j->fEnd - j->fStart);
+			++histogram.fCount;
+			histogram.fTotalMicroseconds += duration;
+			if (duration > histogram.fMaxMicroseconds)
+				histogram.fMaxMicroseconds = duration;
+			++histogram.fBuckets[_GetHistogramBucket( duration)];
+		}
+	}
+
+	_ReleaseBuffers( buffers);
+
+	for( MapOfHistograms::const_iterator i = histograms.begin() ; i != histograms.end() ; ++i)
+	{
+		const VTraceHistogram& histogram = i->second;
+		VValueBag *scopeBag = new VValueBag;
+		if (scopeBag != NULL)
+		{
+			scopeBag->SetString( "category", VString( histogram.fCategory));
+			scopeBag->SetString( "name", VString( histogram.fName));
+			scopeBag->SetLong8( "count", histogram.fCount);
+			scopeBag->SetLong8( "total_time", histogram.fTotalMicroseconds);
+			scopeBag->SetLong8( "max_time", histogram.fMaxMicroseconds);
+			for( sLONG bucket = 0 ; bucket < kHistogramBucketCount ; ++bucket)
+			{
+				if (histogram.fBuckets[bucket] == 0)
+					continue;
+				VValueBag *bucketBag = new VValueBag;
+				if (bucketBag != NULL)
+				{
+					bucketBag->SetLong8( "max_time", (bucket < kHistogramBucketCount - 1) ? (((sLONG8) 1) << bucket) : -1);
+					bucketBag->SetLong8( "count", histogram.fBuckets[bucket]);
+					scopeBag->AddElement( "bucket", bucketBag);
+					bucketBag->Release();
+				}
+			}
+			outBag.AddElement( "scope", scopeBag);
+			scopeBag->Release();
+		}
+	}
+}
+
+
+VError VTraceProfiler::GetChromeTrace( VString& outJSON)
+{
+	std::vector<VTraceBuffer*> buffers;
+	_RetainBuffers( buffers);
+
+	outJSON = "{\"traceEvents\":[";
+	bool first = true;
+	std::vector<TraceEvent> events;
+	for( std::vector<VTraceBuffer*>::const_iterator i = buffers.begin() ; i != buffers.end() ; ++i)
+	{
+		const VTraceBuffer *buffer = *i;
+
+		// thread name metadata event
+		if (!first)
+			outJSON += ",";
+		first = false;
+		outJSON += "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+		outJSON.AppendLong( buffer->fTaskID);
+		outJSON += ",\"args\":{\"name\":";
+		VString name( buffer->fTaskName);
+		if (name.IsEmpty())
+		{
+			name = "task ";
+			name.AppendLong( buffer->fTaskID);
+		}
+		VString escapedName;
+		name.GetJSONString( escapedName, JSON_WithQuotesIfNecessary);
+		outJSON += escapedName;
+		outJSON += "}}";
+
+		_CopyEvents( buffer, events);
+		for( std::vector<TraceEvent>::const_iterator j = events.begin() ; j != events.end() ; ++j)
+		{
+			outJSON += ",\n{\"cat\":";
+			_AppendJSONString( outJSON, j->fCategory);
+			outJSON += ",\"name\":";
+			_AppendJSONString( outJSON, j->fName);
+			outJSON += ",\"ph\":\"X\",\"pid\":1,\"tid\":";
+			outJSON.AppendLong( buffer->fTaskID);
+			outJSON += ",\"ts\":";
+			outJSON.AppendReal( ((Real) (j->fStart - sStartTime) * 1000000.0) / (Real) sFrequency);
+			outJSON += ",\"dur\":";
+			outJSON.AppendReal( ((Real) (j->fEnd - j->fStart) * 1000000.0) / (Real) sFrequency);
+			outJSON += "}";
+		}
+	}
+	outJSON += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+	_ReleaseBuffers( buffers);
+
+	return VE_OK;
+}
+
+
+VError VTraceProfiler::WriteChromeTrace( VFile& inFile)
+{
+	VString json;
+	VError err = GetChromeTrace( json);
+	if (err == VE_OK)
+	{
+		VFileStream stream( &inFile, FO_CreateIfNotFound | FO_Overwrite);
+		err = stream.OpenWriting();
+		if (err == VE_OK)
+		{
+			stream.SetCharSet( VTC_UTF_8);
+			err = stream.PutText( json);
+			VError closeErr = stream.CloseWriting();
+			if (err == VE_OK)
+				err = closeErr;
+		}
+	}
+	return err;
+}
+
+
+sLONG8 VTraceProfiler::GetDroppedCount()
+{
+	std::vector<VTraceBuffer*> buffers;
+	_RetainBuffers( buffers);
+
+	sLONG8 count = 0;
+	for( std::vector<VTraceBuffer*>::const_iterator i = buffers.begin() ; i != buffers.end() ; ++i)
+		count += (*i)->fDroppedCount;
+
+	_ReleaseBuffers( buffers);
+	
+	return count;
+}
+
+
+void VTraceProfiler::DumpStats()
+{
+	std::vector<VTraceBuffer*> buffers;
+	_RetainBuffers( buffers);
+
+	VCallNode root( "", "");
+	_BuildCallTree( buffers, root);
+	root.Dump( 0);
+
+	_ReleaseBuffers( buffers);
+}
@@ -0,0 +1,140 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VTraceProfiler__
+#define __VTraceProfiler__
+
+#include "Kernel/Sources/VSyncObject.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+class VValueBag;
+class VTraceBuffer;
+
+/*
+	Opt-in hierarchical scoped-timer profiler.
+
+	Scopes are declared with VTRACE_SCOPE( category, name) or VTRACE_FUNCTION( category).
+	The category and name must be string literals (or any string that outlives the profiler data)
+	because only their address is recorded.
+
+	Each task records its scopes in its own preallocated buffer, so that recording never takes a lock:
+	when not running a scope costs a test on a static boolean.
+	Events are timed with the same profiling counter as VProfilingCounter.
+	A task buffer that is full drops its next events (see GetDroppedCount()).
+
+	Recorded events can be aggregated into a call tree (merged across tasks) and into per-scope latency histograms,
+	or exported in the Chrome trace event format (chrome://tracing).
+	Aggregation and export should be done once the profiler is stopped, or at least not while Start() is being called.
+*/
+class XTOOLBOX_API VTraceProfiler
+{
+public:
+	enum {
+		kHistogramBucketCount	= 24		// bucket i counts durations shorter than 2^i microseconds, the last one all longer durations
+	};
+
+	typedef struct TraceEvent
+	{
+		const char*		fCategory;
+		const char*		fName;
+		sLONG8			fStart;			// profiling counter
+		sLONG8			fEnd;
+		sLONG			fDepth;			// 0 for an outermost scope
+	} TraceEvent;
+
+	// Start() clears previously recorded events.
+	static	void				Start( sLONG inEventsPerTask = 65536);
+	static	void				Stop();
+	static	bool				IsRunning()										{ return sRunning; }
+
+	/*
+		call tree merged across tasks, times in microseconds:
+		<call_tree>
+			<scope category="" name="" count="" total_time="" self_time="">
+				<scope .../>
+			</scope>
+		</call_tree>
+	*/
+	static	void				GetCallTree( VValueBag& outBag);
+
+	/*
+		one histogram per scope, times in microseconds:
+		<scope category="" name="" count="" total_time="" max_time="">
+			<bucket max_time="" count=""/>		max_time is -1 for the last bucket. Only non empty buckets are reported.
+		</scope>
+	*/
+	static	void				GetHistograms( VValueBag& outBag);
+
+	// Chrome trace event format ("X" complete events, one thread per task)
+	static	VError				GetChromeTrace( VString& outJSON);
+	static	VError				WriteChromeTrace( VFile& inFile);
+
+	// number of events that could not be recorded because a task buffer was full
+	static	sLONG8				GetDroppedCount();
+
+	// dumps the call tree using DebugMsg
+	static	void				DumpStats();
+
+private:
+friend class VTraceScope;
+								VTraceProfiler();
+
+	static	VTraceBuffer*		_EnterScope();
+	static	void				_LeaveScope( VTraceBuffer *inBuffer, const char *inCategory, const char *inName, sLONG8 inStart);
+	static	void				_RetainBuffers( std::vector<VTraceBuffer*>& outBuffers);
+
+	static	bool				sRunning;
+};
+
+
+class XTOOLBOX_API VTraceScope
+{
+public:
+								VTraceScope( const char *inCategory, const char *inName):fBuffer( NULL)
+								{
+									if (VTraceProfiler::IsRunning())
+									{
+										fBuffer = VTraceProfiler::_EnterScope();
+										fCategory = inCategory;
+										fName = inName;
+										VSystem::GetProfilingCounter( fStart);
+									}
+								}
+								~VTraceScope()
+								{
+									if (fBuffer != NULL)
+										VTraceProfiler::_LeaveScope( fBuffer, fCategory, fName, fStart);
+								}
+
+private:
+								VTraceScope( const VTraceScope&);	// no
+			VTraceScope&		operator=( const VTraceScope&);	// no
+
+			VTraceBuffer*		fBuffer;
+			const char*			fCategory;
+			const char*			fName;
+			sLONG8				fStart;
+};
+
+
+#define VTRACE_CONCAT_(a,b)					a##b
+#define VTRACE_CONCAT(a,b)					VTRACE_CONCAT_(a,b)
+#define VTRACE_SCOPE(category,name)			XBOX::VTraceScope VTRACE_CONCAT( __traceScope, __LINE__)( category, name)
+#define VTRACE_FUNCTION(category)			VTRACE_SCOPE( category, __FUNCTION__)
+
+END_TOOLBOX_NAMESPACE
+
+#endif
@@ -16,3 +16,51 @@
 #include "VKernelPrecompiled.h"
 #include "XLinuxSyncObject.h"
 
+#include "VLockProfiler.h"
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+
+// number of spin rounds before parking: round n spins 2^n times
+const sLONG kAdaptiveLockSpinRounds = 8;
+
+
+static inline void _CpuRelax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__( "pause");
+#endif
+}
+
+
+void XLinuxAdaptiveLock::_LockContended( sLONG *ioLockWord, const void *inLock)
+{
+	sLONG8 waitStart = VLockProfiler::IsRunning() ? VLockProfiler::GetTimeStamp() : 0;
+
+	// spin phase: the owner generally holds the lock for a few hundred cycles only
+	bool acquired = false;
+	for( sLONG round = 0 ; round < kAdaptiveLockSpinRounds && !acquired ; ++round)
+	{
+		for( sLONG i = 1 << round ; i > 0 ; --i)
+			_CpuRelax();
+		if (*((volatile sLONG*) ioLockWord) == 0)
+			acquired = (VInterlocked::CompareExchange( ioLockWord, 0, 1) == 0);
+	}
+
+	// park phase: mark the lock as contended so that Unlock() wakes us up
+	if (!acquired)
+	{
+		while( VInterlocked::Exchange( ioLockWord, 2) != 0)
+			::syscall( SYS_futex, ioLockWord, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0);
+	}
+
+	if (waitStart != 0)
+		VLockProfiler::RecordContention( inLock, waitStart);
+}
+
+
+void XLinuxAdaptiveLock::_Wake( sLONG *ioLockWord)
+{
+	::syscall( SYS_futex, ioLockWord, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
@@ -53,6 +53,29 @@ static int pthread_cond_timedwait_relative_np(pthread_cond_t* cond, pthread_mute
 BEGIN_TOOLBOX_NAMESPACE
 
 
+/*
+	Adaptive non-recursive lock stored in a single sLONG.
+	0: unlocked, 1: locked, 2: locked and some task may be parked on it.
+
+	A contended Lock() first spins with a bounded exponential backoff, hoping the owner
+	releases the lock soon, then parks the thread on a futex until Unlock() wakes it up.
+	This is the implementation behind VCriticalSection, VSmallCriticalSection and VConditionVariable.
+
+	inLock is only used to identify the lock for the VLockProfiler.
+*/
+class XTOOLBOX_API XLinuxAdaptiveLock
+{
+public:
+	static	bool	TryToLock( sLONG *ioLockWord)						{ return VInterlocked::CompareExchange( ioLockWord, 0, 1) == 0; }
+	static	void	Lock( sLONG *ioLockWord, const void *inLock)		{ if (VInterlocked::CompareExchange( ioLockWord, 0, 1) != 0) _LockContended( ioLockWord, inLock); }
+	static	void	Unlock( sLONG *ioLockWord)							{ if (VInterlocked::Exchange( ioLockWord, 0) == 2) _Wake( ioLockWord); }
+
+private:
+	static	void	_LockContended( sLONG *ioLockWord, const void *inLock);
+	static	void	_Wake( sLONG *ioLockWord);
+};
+
+
 class XTOOLBOX_API XLinuxSemaphore
 {
 public:
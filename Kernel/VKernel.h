@@ -97,6 +97,8 @@
 #include "Kernel/Sources/VProcess.h"
 #include "Kernel/Sources/VSmallCriticalSection.h"
 #include "Kernel/Sources/VSyncObject.h"
+#include "Kernel/Sources/VLockProfiler.h"
+#include "Kernel/Sources/VTraceProfiler.h"
 #include "Kernel/Sources/VTask.h"
 #include "Kernel/Sources/VInterlocked.h"
 
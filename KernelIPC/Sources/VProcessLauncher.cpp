@@ -92,11 +92,21 @@ sLONG VProcessLauncher::WriteToChild(const void *inBuffer, uLONG inBufferSizeInB
 	return fProcessLauncherImpl->WriteToChild(inBuffer, inBufferSizeInBytes, inClosePipeAfterWritting);
 }
 
+sLONG VProcessLauncher::TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes)
+{
+	return fProcessLauncherImpl->TryWriteToChild(inBuffer, inBufferSizeInBytes);
+}
+
 sLONG VProcessLauncher::WaitForData ()
 {
 	return fProcessLauncherImpl->WaitForData();
 }
 
+sLONG VProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags)
+{
+	return fProcessLauncherImpl->WaitForData(inTimeoutMilliseconds, inFlags);
+}
+
 sLONG VProcessLauncher::ReadFromChild(char *outBuffer, long inBufferSize)
 {
 	return fProcessLauncherImpl->ReadFromChild(outBuffer, inBufferSize);
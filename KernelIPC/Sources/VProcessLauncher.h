@@ -114,6 +114,10 @@ public:
 	 
 					- eVPLTerminated		External process is terminated.
 	 
+					- eVPLStdInFlag			Data can be written to stdin (WaitForData() with timeout only).
+	 
+					- eVPLTimedOut			Nothing happened before timeout (WaitForData() with timeout only).
+	 
 	 */
 	
 	enum {
@@ -122,7 +126,9 @@ public:
 		eVPLStdOutFlag		= 1, 
 		eVPLStdErrFlag		= 2,
 		eVPLBothFlags		= eVPLStdOutFlag | eVPLStdErrFlag,
-		eVPLTerminated		= 4
+		eVPLTerminated		= 4,
+		eVPLStdInFlag		= 8,
+		eVPLTimedOut		= 16
 		
 	};
 
@@ -196,12 +202,22 @@ static	sLONG		ExecuteCommandLine(const VString& inCommandLine,
 		/** @brief	Write to the child's STDIN. Returns of the number of bytes written or -1 in case of error (if you write 0 bytes, it returns 0) */
 		sLONG		WriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes, bool inClosePipeAfterWritting = false);
 	
+		/** @brief	Write to the child's STDIN without blocking. Returns the number of bytes written (0 if pipe is full) or -1 in case of error.
+					On Windows, the pipe is switched to non-blocking mode for the write and at most 4KB are written at once. */
+		sLONG		TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes);
+	
 		/** @brief	Closing STDIN pipe after writting into it is a good habit */
 		void		CloseStandardInput();
 	
 		/** @brief	Block and wait for data or external process termination. */	
 		sLONG		WaitForData ();
 		
+		/** @brief	Wait until one of the pipes in inFlags (eVPLStdOutFlag, eVPLStdErrFlag, eVPLStdInFlag) is ready, for at most
+					inTimeoutMilliseconds (negative to wait infinitely). Returns ready flags, eVPLTimedOut, eVPLTerminated, or eVPLError. 
+					A pipe which has reached its end (read returned -1) is no longer waited for. Doesn't rely on SIGCHLD, so it can
+					be called from any thread. */
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags = eVPLBothFlags);
+		
 		/** @brief	Read from the child's STDOUT. Returns the number of bytes read or -1. Non-blocking call, return 0 if no data.*/
 		sLONG		ReadFromChild(char *outBuffer, long inBufferSize);
 		
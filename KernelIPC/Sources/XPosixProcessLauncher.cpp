@@ -19,6 +19,7 @@
 
 #include <sys/wait.h>
 #include <sys/select.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <set>
 #include <signal.h>
@@ -106,6 +107,7 @@ XPosixProcessLauncher::XPosixProcessLauncher()
 	fPipeChildToParent[pWriteSide]		= kInvalidDescriptor ;
 	fPipeChildErrorToParent[pReadSide]	= kInvalidDescriptor ;
 	fPipeChildErrorToParent[pWriteSide] = kInvalidDescriptor ;
+	fStdOutEnded = fStdErrEnded = false;
 
 	fRedirectStandardInput = true;
 	fRedirectStandardOutput = true;
@@ -252,6 +254,39 @@ sLONG XPosixProcessLauncher::WriteToChild(const void *inBuffer, uLONG inBufferSi
 	return -1;
 }
 
+sLONG XPosixProcessLauncher::TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes)
+{
+	if (!testAssert(inBuffer != NULL) || !fIsRunning || fPipeParentToChild[pWriteSide] == kInvalidDescriptor)
+		
+		return -1;
+	
+	if (!inBufferSizeInBytes)
+		
+		return 0;
+	
+	// Pipe is blocking for WriteToChild(), set it non-blocking for this write only.
+	
+	int	fd				= fPipeParentToChild[pWriteSide];
+	int	originalFlags	= fcntl(fd, F_GETFL, 0);
+	
+	if (originalFlags == -1 || fcntl(fd, F_SETFL, originalFlags | O_NONBLOCK) == -1)
+		
+		return -1;
+	
+	ssize_t	nb_written	= write(fd, inBuffer, inBufferSizeInBytes);
+	int		writeError	= errno;
+	
+	fcntl(fd, F_SETFL, originalFlags);
+	
+	if (nb_written == -1)
+		
+		return writeError == EAGAIN || writeError == EWOULDBLOCK ? 0 : -1;
+	
+	else
+		
+		return (sLONG) nb_written;
+}
+
 sLONG XPosixProcessLauncher::WaitForData ()
 {
 	sigset_t	sigmask;
@@ -307,15 +342,97 @@ sLONG XPosixProcessLauncher::WaitForData ()
 }
 
 
+sLONG XPosixProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags)
+{
+	struct pollfd	fds[3];
+	sLONG			flags[3];
+	nfds_t			count = 0;
+	
+	if ((inFlags & VProcessLauncher::eVPLStdOutFlag) && !fStdOutEnded && fPipeChildToParent[pReadSide] != kInvalidDescriptor) {
+		
+		fds[count].fd = fPipeChildToParent[pReadSide];
+		fds[count].events = POLLIN;
+		flags[count++] = VProcessLauncher::eVPLStdOutFlag;
+		
+	}
+	if ((inFlags & VProcessLauncher::eVPLStdErrFlag) && !fStdErrEnded && fPipeChildErrorToParent[pReadSide] != kInvalidDescriptor) {
+		
+		fds[count].fd = fPipeChildErrorToParent[pReadSide];
+		fds[count].events = POLLIN;
+		flags[count++] = VProcessLauncher::eVPLStdErrFlag;
+		
+	}
+	if ((inFlags & VProcessLauncher::eVPLStdInFlag) && fPipeParentToChild[pWriteSide] != kInvalidDescriptor) {
+		
+		fds[count].fd = fPipeParentToChild[pWriteSide];
+		fds[count].events = POLLOUT;
+		flags[count++] = VProcessLauncher::eVPLStdInFlag;
+		
+	}
+	
+	if (!count) {
+		
+		// All pipes have ended, only termination is to be expected: caller will check with IsRunning().
+		
+		if (inTimeoutMilliseconds > 0)
+			
+			VTask::Sleep(inTimeoutMilliseconds);
+
+		return !fIsRunning ? VProcessLauncher::eVPLTerminated : VProcessLauncher::eVPLTimedOut;
+		
+	}
+	
+	int	r = poll(fds, count, inTimeoutMilliseconds < 0 ? -1 : inTimeoutMilliseconds);
+	
+	if (r == -1) 
+		
+		return errno == EINTR ? VProcessLauncher::eVPLTimedOut : VProcessLauncher::eVPLError;
+	
+	else if (!r)
+		
+		return VProcessLauncher::eVPLTimedOut;
+	
+	sLONG	code = 0;
+
+	for (nfds_t i = 0; i < count; i++) {
+		
+		// A hang-up is reported as ready, the read will then return end of pipe.
+		
+		if (fds[i].revents & POLLNVAL)
+			
+			return VProcessLauncher::eVPLError;
+
+		else if (fds[i].revents)
+			
+			code |= flags[i];
+		
+	}
+	
+	return !code ? VProcessLauncher::eVPLError : code;
+}
+
+
 sLONG XPosixProcessLauncher::ReadFromChild(char *outBuffer, long inBufferSize)
 {
-	return _ReadFromPipe(fPipeChildToParent[pReadSide], outBuffer, inBufferSize);
+	sLONG	nb_read = _ReadFromPipe(fPipeChildToParent[pReadSide], outBuffer, inBufferSize);
+	
+	if (nb_read < 0)
+		
+		fStdOutEnded = true;
+	
+	return nb_read;
 }
 
 
 sLONG XPosixProcessLauncher::ReadErrorFromChild(char *outBuffer, long inBufferSize)
 {
-	return _ReadFromPipe(fPipeChildErrorToParent[pReadSide], outBuffer, inBufferSize);
+	sLONG	nb_read = _ReadFromPipe(fPipeChildErrorToParent[pReadSide], outBuffer, inBufferSize);
+	
+	if (nb_read < 0)
+		
+		fStdErrEnded = true;
+	
+	return nb_read;
 }
 
 sLONG XPosixProcessLauncher::Start()
@@ -383,6 +500,7 @@ sLONG XPosixProcessLauncher::Start(const EnvVarNamesAndValuesMap &inVarToUse)
 
 	// Create child process.
 	
+	fStdOutEnded = fStdErrEnded = false;
 	fIsRunning = true;	
 	fProcessID = fork();
 			
@@ -48,8 +48,10 @@ public:
 		void		CloseStandardInput();
 		
 		sLONG		WriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes, bool inClosePipeAfterWritting = false);
+		sLONG		TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes);
 	
 		sLONG		WaitForData ();
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags);
 	
 		// Reads are non-blocking.
 		
@@ -85,6 +87,11 @@ private:
 		int			fPipeChildToParent[2];
 		int			fPipeChildErrorToParent[2];
 		
+		// Set when a read returned end of pipe (or failed), so WaitForData() doesn't wait for it anymore.
+		
+		bool		fStdOutEnded;
+		bool		fStdErrEnded;
+		
 		enum
 		{
 					pReadSide = 0,
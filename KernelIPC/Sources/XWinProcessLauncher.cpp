@@ -518,6 +518,77 @@ sLONG XWinProcessLauncher::Start(const EnvVarNamesAndValuesMap &inVarToUse)
 	return err;
 }
 
+// Non-blocking writes of anonymous pipes don't write partially a request bigger than the free space of the pipe, 
+// so write at most the default pipe buffer size.
+static const uLONG kMAX_TRY_WRITE_SIZE = 4096;
+sLONG XWinProcessLauncher::TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes)
+{
+	if (!testAssert(inBuffer != NULL) || fChildStdInWriteDup == INVALID_HANDLE_VALUE)
+		return -1;
+
+	// The pipe is switched to non-blocking mode for this write only, WriteToChild() must keep blocking.
+	DWORD	mode = PIPE_NOWAIT;
+	DWORD	written = 0;
+	BOOL	isOk;
+
+	if (!::SetNamedPipeHandleState(fChildStdInWriteDup, &mode, NULL, NULL))
+		return -1;
+
+	isOk = ::WriteFile(fChildStdInWriteDup, inBuffer, inBufferSizeInBytes > kMAX_TRY_WRITE_SIZE ? kMAX_TRY_WRITE_SIZE : inBufferSizeInBytes, &written, NULL);
+
+	mode = PIPE_WAIT;
+	::SetNamedPipeHandleState(fChildStdInWriteDup, &mode, NULL, NULL);
+
+	return isOk ? (sLONG) written : -1;	// 0 if the pipe is full
+}
+
+sLONG XWinProcessLauncher::WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags)
+{
+	// Anonymous pipes can't be waited for, peek them at short interval instead. Nor can they be polled for writing:
+	// stdin is considered ready after one interval (TryWriteToChild() returns 0 if the pipe is still full).
+
+	const sLONG	kPeekInterval	= 5;
+	sLONG		elapsed			= 0;
+
+	for ( ; ; ) {
+
+		sLONG	code		= 0;
+		DWORD	available;
+
+		if ((inFlags & VProcessLauncher::eVPLStdInFlag) && elapsed > 0)
+
+			code |= VProcessLauncher::eVPLStdInFlag;
+
+		// A failed peek (broken pipe) is reported as ready, the read will then return end of pipe.
+
+		if ((inFlags & VProcessLauncher::eVPLStdOutFlag) && fChildStdOutReadDup != INVALID_HANDLE_VALUE
+		&& (!::PeekNamedPipe(fChildStdOutReadDup, NULL, 0, NULL, &available, NULL) || available))
+
+			code |= VProcessLauncher::eVPLStdOutFlag;
+
+		if ((inFlags & VProcessLauncher::eVPLStdErrFlag) && fChildStdErrReadDup != INVALID_HANDLE_VALUE
+		&& (!::PeekNamedPipe(fChildStdErrReadDup, NULL, 0, NULL, &available, NULL) || available))
+
+			code |= VProcessLauncher::eVPLStdErrFlag;
+
+		if (code)
+
+			return code;
+
+		else if (!fIsRunning)
+
+			return VProcessLauncher::eVPLTerminated;
+
+		else if (inTimeoutMilliseconds >= 0 && elapsed >= inTimeoutMilliseconds)
+
+			return VProcessLauncher::eVPLTimedOut;
+
+		VTask::Sleep(kPeekInterval);
+		elapsed += kPeekInterval;
+
+	}
+}
+
 bool XWinProcessLauncher::IsRunning()
 {
 	if(!fWaitClosingChildProcess)
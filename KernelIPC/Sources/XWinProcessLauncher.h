@@ -48,8 +48,10 @@ inline	void		SetRedirectStandardOutput(bool isStandardOutputRedirected)		{ fRedi
 		void		CloseStandardInput();
 		
 		sLONG		WriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes, bool inClosePipeAfterWritting = false);
+		sLONG		TryWriteToChild(const void *inBuffer, uLONG inBufferSizeInBytes);
 
 		sLONG		WaitForData ()	{ return 0;	/* TODO */ }
+		sLONG		WaitForData (sLONG inTimeoutMilliseconds, sLONG inFlags);
 	
 		sLONG		ReadFromChild(char *outBuffer, long inBufferSize);
 		sLONG		ReadErrorFromChild(char *outBuffer, long inBufferSize);
@@ -140,6 +140,8 @@ const XBOX::VPtrStream& VHTTPMessage::GetBody() const
 
 XBOX::VError VHTTPMessage::ReadFromStream (XBOX::VStream& inStream, const XBOX::VString& inBoundary)
 {
+	VTRACE_SCOPE ("http", "VHTTPMessage::ReadFromStream");
+
 #define	MAX_BUFFER_LENGTH	32768
 
 	const char			HTTP_CR = '\r';
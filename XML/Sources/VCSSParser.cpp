@@ -4882,25 +4882,35 @@ void VCSSMatch::Match(opaque_ElementPtr inElement, CSSMedia::eMediaType inMediaT
 	VCSSMatchAttributeVector attributes;
 	const CSSRuleSet::Selector *curSelector;
 
-	//iterate on medias
 	xbox_assert(fMediaRules);
-	CSSRuleSet::MediaRules::reverse_iterator itMedia = fMediaRules->rbegin();
-	for (;itMedia != fMediaRules->rend(); itMedia++)
+	_BuildRulesIndex();
+	fParentCache.clear();
+
+	//check medias with media type filter
+	std::vector<bool> mediaEnabled( fMediaRules->size(), true);
+	if (inMediaType != CSSMedia::ALL)
 	{
-		//check with media type filter
-		if (inMediaType != CSSMedia::ALL)
+		for (VIndex indexMedia = 0; indexMedia < (VIndex)fMediaRules->size(); indexMedia++)
 		{
-			const CSSMedia::Set& medias = (*itMedia).first;
-			if (!((medias.find( inMediaType) != medias.end())
-				  ||
-				  (medias.find( CSSMedia::ALL) != medias.end())))
-				continue;
+			const CSSMedia::Set& medias = (*fMediaRules)[indexMedia].first;
+			mediaEnabled[indexMedia] = (medias.find( inMediaType) != medias.end())
+									   ||
+									   (medias.find( CSSMedia::ALL) != medias.end());
 		}
+	}
 
-		//iterate on rules
-		CSSRuleSet::Rules::reverse_iterator itRule = (*itMedia).second.rbegin();
-		for (;itRule != (*itMedia).second.rend();itRule++)
+	//iterate on rules which rightmost simple selector might match the element (in the same order as medias & rules reverse iteration)
+	RuleRanks ranks;
+	_GetCandidateRules( inElement, ranks);
+	{
+		RuleRanks::const_iterator itRank = ranks.begin();
+		for (;itRank != ranks.end(); itRank++)
 		{
+			const RulePosition& position = fRulePositions[*itRank];
+			if (!mediaEnabled[position.first])
+				continue;
+			const CSSRuleSet::Rule *itRule = &((*fMediaRules)[position.first].second[position.second]);
+
 			curSelector = &selectorEmpty;
 
 			//iterate on selectors (one at least must match)
@@ -4940,7 +4950,7 @@ void VCSSMatch::Match(opaque_ElementPtr inElement, CSSMedia::eMediaType inMediaT
 									opaque_ElementPtr elemParent = elemCur;
 									do
 									{
-										elemParent = fHandlerGetParentElement( elemParent);
+										elemParent = _GetParentElement( elemParent);
 										if (elemParent && _MatchSimpleSelector( elemParent, *itSimpleSelector))
 											break;
 									} while (elemParent);
@@ -4952,7 +4962,7 @@ void VCSSMatch::Match(opaque_ElementPtr inElement, CSSMedia::eMediaType inMediaT
 							case CSSRuleSet::CHILD:
 								{
 									//check if parent element match simple selector
-									opaque_ElementPtr elemParent = fHandlerGetParentElement( elemCur);
+									opaque_ElementPtr elemParent = _GetParentElement( elemCur);
 									if (!(elemParent && _MatchSimpleSelector( elemParent, *itSimpleSelector)))
 										bMatch = false;
 									elemCur = elemParent;
@@ -5061,7 +5071,7 @@ bool VCSSMatch::_MatchSimpleSelector(opaque_ElementPtr inElement, const CSSRuleS
 		if (*itPseudo == (int)CSSRuleSet::Pseudo::PC_FIRST_CHILD)
 		{
 			//check first child rule
-			if (fHandlerGetParentElement( inElement) == NULL
+			if (_GetParentElement( inElement) == NULL
 				||
 				fHandlerGetPrevElement( inElement) != NULL)
 				return false;
@@ -5129,6 +5139,212 @@ bool VCSSMatch::_MatchSimpleSelector(opaque_ElementPtr inElement, const CSSRuleS
 	return true;
 }
 
+/** build rules index key from element id or name
+@remarks
+	ids and names are compared with VString::EqualToString (collation) so the key keeps only lowercased ASCII letters:
+	strings which compare equal have the same key and rules with the same key are checked anyway;
+	return false if the string contains non-ASCII characters (then it cannot be keyed)
+*/
+static bool _GetRulesIndexKey( const VString& inValue, VString& outKey)
+{
+	outKey.Clear();
+	const UniChar *c = inValue.GetCPointer();
+	const UniChar *end = c + inValue.GetLength();
+	for (;c != end; c++)
+	{
+		if (*c >= 128)
+			return false;
+		if (*c >= 'A' && *c <= 'Z')
+			outKey.AppendUniChar( *c - 'A' + 'a');
+		else if (*c >= 'a' && *c <= 'z')
+			outKey.AppendUniChar( *c);
+	}
+	return true;
+}
+
+static void _AddRuleRank( std::vector<sLONG>& ioRanks, sLONG inRank)
+{
+	//a rule with many selectors might be added many times
+	if (ioRanks.empty() || ioRanks.back() != inRank)
+		ioRanks.push_back( inRank);
+}
+
+/** build rules index if needed */
+void VCSSMatch::_BuildRulesIndex()
+{
+	VSize countRules = 0;
+	CSSRuleSet::MediaRules::const_iterator itMedia = fMediaRules->begin();
+	for (;itMedia != fMediaRules->end(); itMedia++)
+		countRules += (*itMedia).second.size();
+
+	if (fRulesIndexValid && fIndexedMediasCount == fMediaRules->size() && fIndexedRulesCount == countRules)
+		return;
+
+	fRulePositions.clear();
+	fRulesByID.clear();
+	fRulesByClass.clear();
+	fRulesByName.clear();
+	fRulesWithID.clear();
+	fRulesWithName.clear();
+	fUniversalRules.clear();
+
+	//ranks follow Match() cascading order: last media & last rule first
+	fRulePositions.reserve( countRules);
+	for (VIndex indexMedia = (VIndex)fMediaRules->size()-1; indexMedia >= 0; indexMedia--)
+	{
+		const CSSRuleSet::Rules& rules = (*fMediaRules)[indexMedia].second;
+		for (VIndex indexRule = (VIndex)rules.size()-1; indexRule >= 0; indexRule--)
+		{
+			fRulePositions.push_back( RulePosition( indexMedia, indexRule));
+			_IndexRule( rules[indexRule].first, (sLONG)fRulePositions.size()-1);
+		}
+	}
+
+	fIndexedMediasCount = fMediaRules->size();
+	fIndexedRulesCount = countRules;
+	fRulesIndexValid = true;
+}
+
+/** add rule to the buckets of its selectors rightmost simple selector */
+void VCSSMatch::_IndexRule( const CSSRuleSet::Selectors& inSelectors, sLONG inRank)
+{
+	if (inSelectors.empty())
+	{
+		//rule without selector match any element
+		_AddRuleRank( fUniversalRules, inRank);
+		return;
+	}
+
+	CSSRuleSet::Selectors::const_iterator itSelector = inSelectors.begin();
+	for (;itSelector != inSelectors.end(); itSelector++)
+	{
+		if ((*itSelector).empty())
+		{
+			_AddRuleRank( fUniversalRules, inRank);
+			continue;
+		}
+
+		//the element must match the rightmost simple selector: use its most selective condition as key
+		const CSSRuleSet::SimpleSelector& simpleSelector = (*itSelector).back();
+		VString key;
+		bool bIndexed = false;
+
+		CSSRuleSet::CondVector::const_iterator itCond = simpleSelector.fConditions.begin();
+		for (;(!bIndexed) && itCond != simpleSelector.fConditions.end(); itCond++)
+		{
+			const CSSRuleSet::Condition& cond = *itCond;
+			if (!cond.fIsClass && !cond.fInclude && !cond.fBeginsWith && cond.fValues.size() == 1
+				&& cond.fName.EqualToStringRaw( CVSTR("id")) && _GetRulesIndexKey( cond.fValues[0], key))
+			{
+				_AddRuleRank( fRulesByID[key], inRank);
+				_AddRuleRank( fRulesWithID, inRank);
+				bIndexed = true;
+			}
+		}
+
+		itCond = simpleSelector.fConditions.begin();
+		for (;(!bIndexed) && itCond != simpleSelector.fConditions.end(); itCond++)
+		{
+			const CSSRuleSet::Condition& cond = *itCond;
+			if (cond.fIsClass && !cond.fValues.empty() && !cond.fValues[0].IsEmpty())
+			{
+				//class values are compared bitwise (see MatchInclude)
+				_AddRuleRank( fRulesByClass[cond.fValues[0]], inRank);
+				bIndexed = true;
+			}
+		}
+
+		if (!bIndexed && !simpleSelector.fNameElem.IsEmpty() && _GetRulesIndexKey( simpleSelector.fNameElem, key))
+		{
+			_AddRuleRank( fRulesByName[key], inRank);
+			_AddRuleRank( fRulesWithName, inRank);
+			bIndexed = true;
+		}
+
+		if (!bIndexed)
+			_AddRuleRank( fUniversalRules, inRank);
+	}
+}
+
+/** return sorted ranks of the rules which might match the specified element */
+void VCSSMatch::_GetCandidateRules( opaque_ElementPtr inElement, RuleRanks& outRanks)
+{
+	outRanks.clear();
+	outRanks.insert( outRanks.end(), fUniversalRules.begin(), fUniversalRules.end());
+
+	VString key;
+	if (!fRulesByID.empty())
+	{
+		VString value;
+		if (fHandlerGetAttributeValue( inElement, CVSTR("id"), value))
+		{
+			if (_GetRulesIndexKey( value, key))
+			{
+				MapOfRuleRanks::const_iterator itRanks = fRulesByID.find( key);
+				if (itRanks != fRulesByID.end())
+					outRanks.insert( outRanks.end(), itRanks->second.begin(), itRanks->second.end());
+			}
+			else
+				outRanks.insert( outRanks.end(), fRulesWithID.begin(), fRulesWithID.end());
+		}
+	}
+
+	if (!fRulesByClass.empty())
+	{
+		//split class attribute like MatchInclude
+		const VString& value = fHandlerGetElementClass( inElement);
+		const UniChar *c = value.GetCPointer();
+		const UniChar *end = c + value.GetLength();
+		while (c != end)
+		{
+			while (c != end && (VCSSUtil::isSpace(*c) || *c == ','))
+				c++;
+			const UniChar *start = c;
+			while (c != end && !(VCSSUtil::isSpace(*c) || *c == ','))
+				c++;
+			if (c != start)
+			{
+				key.Clear();
+				key.AppendUniChars( start, (VIndex)(c-start));
+				MapOfRuleRanks::const_iterator itRanks = fRulesByClass.find( key);
+				if (itRanks != fRulesByClass.end())
+					outRanks.insert( outRanks.end(), itRanks->second.begin(), itRanks->second.end());
+			}
+		}
+	}
+
+	if (!fRulesByName.empty())
+	{
+		if (_GetRulesIndexKey( fHandlerGetElementName( inElement), key))
+		{
+			MapOfRuleRanks::const_iterator itRanks = fRulesByName.find( key);
+			if (itRanks != fRulesByName.end())
+				outRanks.insert( outRanks.end(), itRanks->second.begin(), itRanks->second.end());
+		}
+		else
+			outRanks.insert( outRanks.end(), fRulesWithName.begin(), fRulesWithName.end());
+	}
+
+	std::sort( outRanks.begin(), outRanks.end());
+	outRanks.erase( std::unique( outRanks.begin(), outRanks.end()), outRanks.end());
+}
+
+/** return parent element (cached while matching one element) */
+VCSSMatch::opaque_ElementPtr VCSSMatch::_GetParentElement( opaque_ElementPtr inElement)
+{
+	//descendant selectors of every rule walk up the same ancestors
+	std::vector< std::pair<opaque_ElementPtr, opaque_ElementPtr> >::const_iterator it = fParentCache.begin();
+	for (;it != fParentCache.end(); it++)
+	{
+		if (it->first == inElement)
+			return it->second;
+	}
+	opaque_ElementPtr elemParent = fHandlerGetParentElement( inElement);
+	if (fParentCache.size() < 64)
+		fParentCache.push_back( std::pair<opaque_ElementPtr, opaque_ElementPtr>( inElement, elemParent));
+	return elemParent;
+}
+
 /** return true if inValue contains single value inSingleValue */
 bool VCSSMatch::MatchInclude( const VString& inValue, const VString& inSingleValue)
 {
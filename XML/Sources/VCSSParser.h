@@ -1777,14 +1777,23 @@ public:
 
 		fHandlerGetAttributeValue = NULL;
 		fHandlerSetAttribute = NULL;
+
+		fRulesIndexValid = false;
+		fIndexedMediasCount = 0;
+		fIndexedRulesCount = 0;
 	}
 
 	virtual ~VCSSMatch() {}
 
-	/** set CSS matching rules */
+	/** set CSS matching rules 
+	@remarks
+		rules are indexed on first Match() call: index is rebuilt if the number of medias or rules changes,
+		otherwise if rules are modified, call again SetCSSRules to reset the index
+	*/
 	void SetCSSRules( CSSRuleSet::MediaRules *inMediaRules)
 	{
 		fMediaRules = inMediaRules;
+		fRulesIndexValid = false;
 	}
 
 	/** set GetParentElement handler */
@@ -1841,6 +1850,10 @@ public:
 		all handlers must be initialized
 
 		for now only :first-child and :lang pseudo-classes are supported; other pseudo-classes rules are ignored
+
+		only the rules which rightmost simple selector can match the element id, class or name are checked
+		(like browsers do): so Match() uses the instance rules index & parent cache and
+		must not be called concurrently on the same instance
 	*/
 	void Match(opaque_ElementPtr inElement, CSSMedia::eMediaType inMediaType = CSSMedia::ALL); 
 
@@ -1851,9 +1864,40 @@ public:
 	static bool MatchInclude( const VString& inValue, const VString& inSingleValue);
 
 protected: 
+	/** rules index key comparison (bitwise) */
+	class RawStringLess
+	{
+	public:
+		bool operator()( const VString& inString1, const VString& inString2) const
+		{
+			if (inString1.GetLength() != inString2.GetLength())
+				return inString1.GetLength() < inString2.GetLength();
+			return memcmp( inString1.GetCPointer(), inString2.GetCPointer(), inString1.GetLength() * sizeof(UniChar)) < 0;
+		}
+	};
+
+	/** rules are referenced by their rank in matching order (last media & last rule first) */
+	typedef std::vector<sLONG> RuleRanks;
+	typedef std::map<VString, RuleRanks, RawStringLess> MapOfRuleRanks;
+
+	/** (media index, rule index) per rank */
+	typedef std::pair<VIndex, VIndex> RulePosition;
+
 	/** return true if the specified element match the specified simple selector conditions */
 	bool _MatchSimpleSelector(opaque_ElementPtr inElement, const CSSRuleSet::SimpleSelector& inSimpleSelector);
 
+	/** build rules index if needed */
+	void _BuildRulesIndex();
+
+	/** add rule to the buckets of its selectors rightmost simple selector */
+	void _IndexRule( const CSSRuleSet::Selectors& inSelectors, sLONG inRank);
+
+	/** return sorted ranks of the rules which might match the specified element */
+	void _GetCandidateRules( opaque_ElementPtr inElement, RuleRanks& outRanks);
+
+	/** return parent element (cached while matching one element) */
+	opaque_ElementPtr _GetParentElement( opaque_ElementPtr inElement);
+
 	/** ref on external rulesets (classified by media type) */
 	CSSRuleSet::MediaRules *fMediaRules;
 
@@ -1866,6 +1910,21 @@ protected:
 
 	tfn_GetAttributeValue	fHandlerGetAttributeValue;
 	tfn_SetAttribute		fHandlerSetAttribute;
+
+	/** rules index */
+	bool					fRulesIndexValid;
+	VSize					fIndexedMediasCount;
+	VSize					fIndexedRulesCount;
+	std::vector<RulePosition> fRulePositions;
+	MapOfRuleRanks			fRulesByID;
+	MapOfRuleRanks			fRulesByClass;
+	MapOfRuleRanks			fRulesByName;
+	RuleRanks				fRulesWithID;		//all ranks in fRulesByID (for elements which id cannot be keyed)
+	RuleRanks				fRulesWithName;		//all ranks in fRulesByName (for elements which name cannot be keyed)
+	RuleRanks				fUniversalRules;
+
+	/** parent elements cache (valid while matching one element) */
+	std::vector< std::pair<opaque_ElementPtr, opaque_ElementPtr> > fParentCache;
 };
 
 #define CSSClampVal(val, minval, maxval) if (val > (maxval)) val = (maxval); if ( val < (minval)) val = (minval);
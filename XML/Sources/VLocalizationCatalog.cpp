@@ -0,0 +1,832 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#include "VXMLPrecompiled.h"
+#include "VLocalizationCatalog.h"
+
+#if !VERSIONWIN
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+BEGIN_TOOLBOX_NAMESPACE
+
+/*
+	Catalog image layout, in native byte order, every block aligned on 8 bytes:
+
+	- header
+	- string table (UniChar, not null terminated)
+	- for each index: one seed per bucket (sLONG), then the entries stored at their slot
+	- group items, sorted by ID inside each group
+	- group bags entries, then their VValueBag::WriteToStream() data
+
+	A key is hashed once with 64 bits FNV-1a. The low half selects a bucket, the bucket seed gives the slot:
+	0 is an empty bucket, a negative seed is the slot itself (-slot-1), a positive seed rehashes the high half.
+	The index is minimal (as many slots as entries), so an unknown key also lands on a slot and the entry key must be compared.
+*/
+
+const uLONG		kCatalogSignature	= 'XLFC';
+const uLONG		kCatalogVersion		= 1;
+const uLONG		kCatalogByteOrder	= 0x01020304;
+const sLONG		kMaxSeed			= 0x100000;
+
+enum
+{
+	kSection_STRSharpCodes = 0,
+	kSection_Objects,
+	kSection_DotStrings,
+	kSection_Groups,
+	kSection_Count
+};
+
+typedef struct SCatalogString
+{
+	uLONG			fOffset;		// in UniChar
+	uLONG			fLength;
+} SCatalogString;
+
+typedef struct SCatalogSection
+{
+	uLONG			fCount;
+	uLONG			fBucketCount;
+	uLONG			fSeedsOffset;
+	uLONG			fEntriesOffset;
+} SCatalogSection;
+
+typedef struct SCatalogHeader
+{
+	uLONG			fSignature;
+	uLONG			fVersion;
+	uLONG			fByteOrder;
+	uLONG			fReserved;
+	uLONG8			fStamp;
+	uLONG8			fImageSize;
+	uLONG			fStringsOffset;
+	uLONG			fStringsLength;
+	SCatalogSection	fSections[kSection_Count];
+	uLONG			fGroupItemsOffset;
+	uLONG			fGroupItemsCount;
+	uLONG			fBagsOffset;
+	uLONG			fBagsCount;
+	uLONG			fBagDataOffset;
+	uLONG			fBagDataSize;
+} SCatalogHeader;
+
+typedef struct SCatalogSTRSharpEntry
+{
+	sLONG			fID;
+	uLONG			fStringID;
+	SCatalogString	fString;
+} SCatalogSTRSharpEntry;
+
+typedef struct SCatalogKeyEntry
+{
+	SCatalogString	fKey;
+	SCatalogString	fString;
+} SCatalogKeyEntry;
+
+typedef struct SCatalogGroupEntry
+{
+	SCatalogString	fName;
+	uLONG			fFirstItem;
+	uLONG			fItemCount;
+} SCatalogGroupEntry;
+
+typedef struct SCatalogGroupItem
+{
+	uLONG			fID;
+	SCatalogString	fString;
+} SCatalogGroupItem;
+
+typedef struct SCatalogBag
+{
+	SCatalogString	fResname;
+	SCatalogString	fRestype;
+	uLONG			fDataOffset;	// in bag data
+	uLONG			fDataSize;
+} SCatalogBag;
+
+
+static uLONG8 _HashUniChars( const UniChar *inChars, VIndex inLength)
+{
+	uLONG8 hash = XBOX_LONG8(0xcbf29ce484222325);
+	for( VIndex i = 0 ; i < inLength ; ++i)
+	{
+		hash ^= inChars[i];
+		hash *= XBOX_LONG8(0x100000001b3);
+	}
+	return hash;
+}
+
+
+static uLONG8 _HashString( const VString& inString)
+{
+	return _HashUniChars( inString.GetCPointer(), inString.GetLength());
+}
+
+
+static uLONG8 _HashSTRSharpCode( sLONG inID, uLONG inStringID)
+{
+	UniChar key[4] = { (UniChar) (((uLONG) inID) >> 16), (UniChar) inID, (UniChar) (inStringID >> 16), (UniChar) inStringID };
+	return _HashUniChars( key, 4);
+}
+
+
+static uLONG _Mix( uLONG inValue)
+{
+	inValue ^= inValue >> 16;
+	inValue *= 0x85EBCA6B;
+	inValue ^= inValue >> 13;
+	inValue *= 0xC2B2AE35;
+	inValue ^= inValue >> 16;
+	return inValue;
+}
+
+
+static uLONG _GetBucket( uLONG8 inHash, uLONG inBucketCount)
+{
+	return _Mix( (uLONG) inHash) % inBucketCount;
+}
+
+
+static uLONG _GetSlot( uLONG8 inHash, sLONG inSeed, uLONG inCount)
+{
+	return _Mix( ((uLONG) (inHash >> 32)) ^ _Mix( (uLONG) inSeed)) % inCount;
+}
+
+
+static bool _BuildPerfectHash( const std::vector<uLONG8>& inHashes, std::vector<sLONG>& outSeeds, std::vector<uLONG>& outSlots)
+{
+	uLONG count = (uLONG) inHashes.size();
+	uLONG bucketCount = count / 4 + 1;
+
+	std::vector<std::vector<uLONG> > buckets( bucketCount);
+	for( uLONG i = 0 ; i < count ; ++i)
+		buckets[_GetBucket( inHashes[i], bucketCount)].push_back( i);
+
+	// place the largest buckets first, while most slots are free
+	std::vector<std::pair<size_t,uLONG> > order;
+	order.reserve( bucketCount);
+	for( uLONG i = 0 ; i < bucketCount ; ++i)
+	{
+		if (!buckets[i].empty())
+			order.push_back( std::pair<size_t,uLONG>( buckets[i].size(), i));
+	}
+	std::sort( order.begin(), order.end(), std::greater<std::pair<size_t,uLONG> >());
+
+	outSeeds.assign( bucketCount, 0);
+	outSlots.assign( count, 0);
+	std::vector<bool> used( count, false);
+	std::vector<uLONG> slots;
+	uLONG nextFreeSlot = 0;
+
+	for( std::vector<std::pair<size_t,uLONG> >::const_iterator i = order.begin() ; i != order.end() ; ++i)
+	{
+		const std::vector<uLONG>& bucket = buckets[i->second];
+		if (bucket.size() == 1)
+		{
+			while( used[nextFreeSlot])
+				++nextFreeSlot;
+			used[nextFreeSlot] = true;
+			outSlots[bucket[0]] = nextFreeSlot;
+			outSeeds[i->second] = -((sLONG) nextFreeSlot) - 1;
+			continue;
+		}
+
+		bool placed = false;
+		for( sLONG seed = 1 ; (seed <= kMaxSeed) && !placed ; ++seed)
+		{
+			slots.clear();
+			placed = true;
+			for( std::vector<uLONG>::const_iterator j = bucket.begin() ; (j != bucket.end()) && placed ; ++j)
+			{
+				uLONG slot = _GetSlot( inHashes[*j], seed, count);
+				if (used[slot] || (std::find( slots.begin(), slots.end(), slot) != slots.end()))
+					placed = false;
+				else
+					slots.push_back( slot);
+			}
+			if (placed)
+			{
+				for( size_t j = 0 ; j < bucket.size() ; ++j)
+				{
+					used[slots[j]] = true;
+					outSlots[bucket[j]] = slots[j];
+				}
+				outSeeds[i->second] = seed;
+			}
+		}
+		if (!placed)
+			return false;	// two keys with the same 64 bits hash
+	}
+	return true;
+}
+
+
+static uLONG _AppendBlock( std::vector<char>& ioImage, const void *inData, VSize inSize)
+{
+	ioImage.resize( (ioImage.size() + 7) & ~((size_t) 7), 0);
+	uLONG offset = (uLONG) ioImage.size();
+	if (inSize > 0)
+		ioImage.insert( ioImage.end(), (const char*) inData, ((const char*) inData) + inSize);
+	return offset;
+}
+
+
+template<class Entry>
+static bool _AppendIndex( std::vector<char>& ioImage, const std::vector<Entry>& inEntries, const std::vector<uLONG8>& inHashes, SCatalogSection& outSection)
+{
+	std::vector<sLONG> seeds;
+	std::vector<uLONG> slots;
+	if (!_BuildPerfectHash( inHashes, seeds, slots))
+		return false;
+
+	std::vector<Entry> entries( inEntries.size());
+	for( size_t i = 0 ; i < inEntries.size() ; ++i)
+		entries[slots[i]] = inEntries[i];
+
+	outSection.fCount = (uLONG) entries.size();
+	outSection.fBucketCount = (uLONG) seeds.size();
+	outSection.fSeedsOffset = _AppendBlock( ioImage, &seeds[0], seeds.size() * sizeof( sLONG));
+	outSection.fEntriesOffset = _AppendBlock( ioImage, entries.empty() ? NULL : &entries[0], entries.size() * sizeof( Entry));
+	return true;
+}
+
+
+/**
+* @brief String table of a catalog being built.
+* Localized strings are shared by the manager (see StringsSet) and stored once.
+*/
+class VCatalogStringTable
+{
+public:
+	SCatalogString AddString( const VString& inString)
+	{
+		SCatalogString ref;
+		ref.fOffset = (uLONG) fChars.size();
+		ref.fLength = (uLONG) inString.GetLength();
+		fChars.insert( fChars.end(), inString.GetCPointer(), inString.GetCPointer() + inString.GetLength());
+		return ref;
+	}
+
+	SCatalogString AddSharedString( const VString *inString)
+	{
+		std::map<const VString*,SCatalogString>::const_iterator i = fSharedStrings.find( inString);
+		if (i != fSharedStrings.end())
+			return i->second;
+		SCatalogString ref = AddString( *inString);
+		fSharedStrings.insert( std::map<const VString*,SCatalogString>::value_type( inString, ref));
+		return ref;
+	}
+
+	std::vector<UniChar>						fChars;
+	std::map<const VString*,SCatalogString>		fSharedStrings;
+};
+
+
+/**
+* @brief Bounds checking of a catalog image, so that a damaged file is rejected instead of being read out of its mapping.
+*/
+class VCatalogValidator
+{
+public:
+	VCatalogValidator( const char *inImage, VSize inImageSize) : fImage( inImage), fImageSize( inImageSize), fStringsLength( 0)	{;}
+
+	bool IsBlockValid( uLONG inOffset, uLONG inCount, VSize inItemSize) const
+	{
+		return ((inOffset & 7) == 0) && (inOffset <= fImageSize) && (((VSize) inCount) <= (fImageSize - inOffset) / inItemSize);
+	}
+
+	bool IsStringValid( const SCatalogString& inString) const
+	{
+		return (inString.fOffset <= fStringsLength) && (inString.fLength <= fStringsLength - inString.fOffset);
+	}
+
+	bool IsSectionValid( const SCatalogSection& inSection, VSize inEntrySize) const
+	{
+		if ( (inSection.fBucketCount == 0) || !IsBlockValid( inSection.fSeedsOffset, inSection.fBucketCount, sizeof( sLONG)) || !IsBlockValid( inSection.fEntriesOffset, inSection.fCount, inEntrySize) )
+			return false;
+		const sLONG *seeds = (const sLONG*) (fImage + inSection.fSeedsOffset);
+		for( uLONG i = 0 ; i < inSection.fBucketCount ; ++i)
+		{
+			if ( (seeds[i] < 0) && ((uLONG) (-(seeds[i] + 1)) >= inSection.fCount) )
+				return false;
+		}
+		return true;
+	}
+
+	const char*		fImage;
+	VSize			fImageSize;
+	uLONG			fStringsLength;
+};
+
+
+static const SCatalogHeader* _GetHeader( const char *inImage)
+{
+	return (const SCatalogHeader*) inImage;
+}
+
+
+static const UniChar* _GetChars( const char *inImage, const SCatalogString& inString)
+{
+	return ((const UniChar*) (inImage + _GetHeader( inImage)->fStringsOffset)) + inString.fOffset;
+}
+
+
+static bool _EqualToString( const char *inImage, const SCatalogString& inString, const VString& inOther)
+{
+	return (inString.fLength == (uLONG) inOther.GetLength()) && ((inString.fLength == 0) || (::memcmp( _GetChars( inImage, inString), inOther.GetCPointer(), inString.fLength * sizeof( UniChar)) == 0));
+}
+
+
+static void _AddKeyEntry( VCatalogStringTable& ioStrings, const VString& inKey, const VString *inString, std::vector<SCatalogKeyEntry>& ioEntries, std::vector<uLONG8>& ioHashes)
+{
+	SCatalogKeyEntry entry;
+	entry.fKey = ioStrings.AddString( inKey);
+	entry.fString = ioStrings.AddSharedString( inString);
+	ioEntries.push_back( entry);
+	ioHashes.push_back( _HashString( inKey));
+}
+
+
+#pragma mark Public
+
+VLocalizationCatalog::VLocalizationCatalog()
+: fImage( NULL)
+, fImageSize( 0)
+, fAllocatedImage( NULL)
+, fMappedImage( NULL)
+{
+}
+
+
+VLocalizationCatalog::~VLocalizationCatalog()
+{
+	if (fMappedImage != NULL)
+	{
+		#if VERSIONWIN
+		::UnmapViewOfFile( fMappedImage);
+		#else
+		::munmap( fMappedImage, fImageSize);
+		#endif
+	}
+	if (fAllocatedImage != NULL)
+		::free( fAllocatedImage);
+}
+
+
+VLocalizationCatalog* VLocalizationCatalog::Compile( uLONG8 inStamp, const STRSharpCodeAndStringMap& inSTRSharpCodes, const OOSyntaxStringAndStringMap& inObjects, const DotStringsAndStringsMap& inDotStrings,
+													const GroupToIDAndStringsMap& inGroups, const GroupBagsByResnameMap& inBagsByResname, const GroupBagsByRestypeMap& inBagsByRestype)
+{
+	VCatalogStringTable strings;
+
+	std::vector<SCatalogSTRSharpEntry> strSharpEntries;
+	std::vector<uLONG8> strSharpHashes;
+	strSharpEntries.reserve( inSTRSharpCodes.size());
+	strSharpHashes.reserve( inSTRSharpCodes.size());
+	for( STRSharpCodeAndStringMap::const_iterator i = inSTRSharpCodes.begin() ; i != inSTRSharpCodes.end() ; ++i)
+	{
+		SCatalogSTRSharpEntry entry;
+		entry.fID = i->first.fID;
+		entry.fStringID = i->first.fStringID;
+		entry.fString = strings.AddSharedString( i->second);
+		strSharpEntries.push_back( entry);
+		strSharpHashes.push_back( _HashSTRSharpCode( entry.fID, entry.fStringID));
+	}
+
+	std::vector<SCatalogKeyEntry> objectEntries;
+	std::vector<uLONG8> objectHashes;
+	for( OOSyntaxStringAndStringMap::const_iterator i = inObjects.begin() ; i != inObjects.end() ; ++i)
+		_AddKeyEntry( strings, i->first, i->second, objectEntries, objectHashes);
+
+	std::vector<SCatalogKeyEntry> dotStringsEntries;
+	std::vector<uLONG8> dotStringsHashes;
+	for( DotStringsAndStringsMap::const_iterator i = inDotStrings.begin() ; i != inDotStrings.end() ; ++i)
+		_AddKeyEntry( strings, i->first, i->second, dotStringsEntries, dotStringsHashes);
+
+	std::vector<SCatalogGroupEntry> groupEntries;
+	std::vector<uLONG8> groupHashes;
+	std::vector<SCatalogGroupItem> groupItems;
+	for( GroupToIDAndStringsMap::const_iterator i = inGroups.begin() ; i != inGroups.end() ; ++i)
+	{
+		SCatalogGroupEntry entry;
+		entry.fName = strings.AddString( i->first);
+		entry.fFirstItem = (uLONG) groupItems.size();
+		entry.fItemCount = (uLONG) i->second.size();
+		for( std::map<uLONG,VString*>::const_iterator j = i->second.begin() ; j != i->second.end() ; ++j)
+		{
+			SCatalogGroupItem item;
+			item.fID = j->first;
+			item.fString = strings.AddSharedString( j->second);
+			groupItems.push_back( item);
+		}
+		groupEntries.push_back( entry);
+		groupHashes.push_back( _HashString( i->first));
+	}
+
+	// bags are found by name and by type, both maps share the same bags
+	std::map<const VValueBag*,const VString*> resnames;
+	for( GroupBagsByResnameMap::const_iterator i = inBagsByResname.begin() ; i != inBagsByResname.end() ; ++i)
+		resnames[i->second.Get()] = &i->first;
+
+	std::vector<SCatalogBag> bags;
+	VPtrStream bagData;
+	VError err = bagData.OpenWriting();
+	for( GroupBagsByRestypeMap::const_iterator i = inBagsByRestype.begin() ; (i != inBagsByRestype.end()) && (err == VE_OK) ; ++i)
+	{
+		std::map<const VValueBag*,const VString*>::const_iterator resname = resnames.find( i->second.Get());
+
+		SCatalogBag bag;
+		bag.fResname = strings.AddString( (resname != resnames.end()) ? *resname->second : VString());
+		bag.fRestype = strings.AddString( i->first);
+		bag.fDataOffset = (uLONG) bagData.GetPos();
+		err = i->second->WriteToStream( &bagData);
+		bag.fDataSize = (uLONG) (bagData.GetPos() - bag.fDataOffset);
+		bags.push_back( bag);
+	}
+	bagData.CloseWriting();
+	if (err != VE_OK)
+		return NULL;
+
+	std::vector<char> image;
+	image.resize( sizeof( SCatalogHeader), 0);
+
+	SCatalogHeader header;
+	::memset( &header, 0, sizeof( header));
+	header.fSignature = kCatalogSignature;
+	header.fVersion = kCatalogVersion;
+	header.fByteOrder = kCatalogByteOrder;
+	header.fStamp = inStamp;
+	header.fStringsLength = (uLONG) strings.fChars.size();
+	header.fStringsOffset = _AppendBlock( image, strings.fChars.empty() ? NULL : &strings.fChars[0], strings.fChars.size() * sizeof( UniChar));
+
+	if ( !_AppendIndex( image, strSharpEntries, strSharpHashes, header.fSections[kSection_STRSharpCodes])
+		|| !_AppendIndex( image, objectEntries, objectHashes, header.fSections[kSection_Objects])
+		|| !_AppendIndex( image, dotStringsEntries, dotStringsHashes, header.fSections[kSection_DotStrings])
+		|| !_AppendIndex( image, groupEntries, groupHashes, header.fSections[kSection_Groups]) )
+		return NULL;
+
+	header.fGroupItemsCount = (uLONG) groupItems.size();
+	header.fGroupItemsOffset = _AppendBlock( image, groupItems.empty() ? NULL : &groupItems[0], groupItems.size() * sizeof( SCatalogGroupItem));
+	header.fBagsCount = (uLONG) bags.size();
+	header.fBagsOffset = _AppendBlock( image, bags.empty() ? NULL : &bags[0], bags.size() * sizeof( SCatalogBag));
+	header.fBagDataSize = (uLONG) bagData.GetDataSize();
+	header.fBagDataOffset = _AppendBlock( image, bagData.GetDataPtr(), bagData.GetDataSize());
+	_AppendBlock( image, NULL, 0);
+
+	// offsets are 32 bits
+	if (image.size() >= 0x7FFFFFFF)
+		return NULL;
+
+	header.fImageSize = image.size();
+	::memcpy( &image[0], &header, sizeof( header));
+
+	void *data = ::malloc( image.size());
+	if (data == NULL)
+		return NULL;
+	::memcpy( data, &image[0], image.size());
+
+	VLocalizationCatalog *catalog = new VLocalizationCatalog;
+	catalog->fAllocatedImage = data;
+	catalog->fImage = (const char*) data;
+	catalog->fImageSize = image.size();
+	catalog->fGroupBagsByResname = inBagsByResname;
+	catalog->fGroupBagsByRestype = inBagsByRestype;
+
+	xbox_assert( catalog->_IsValid( inStamp));
+
+	return catalog;
+}
+
+
+VLocalizationCatalog* VLocalizationCatalog::Open( const VFile& inFile, uLONG8 inStamp)
+{
+	void *image = NULL;
+	VSize imageSize = 0;
+
+	#if VERSIONWIN
+	HANDLE fileHandle = ::CreateFileW( (LPCWSTR) inFile.GetPath().GetPath().GetCPointer(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER fileSize;
+		if (::GetFileSizeEx( fileHandle, &fileSize) && (fileSize.QuadPart >= sizeof( SCatalogHeader)) && (fileSize.QuadPart < 0x7FFFFFFF))
+		{
+			HANDLE mapping = ::CreateFileMappingW( fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (mapping != NULL)
+			{
+				image = ::MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0);
+				if (image != NULL)
+					imageSize = (VSize) fileSize.QuadPart;
+				::CloseHandle( mapping);
+			}
+		}
+		::CloseHandle( fileHandle);
+	}
+	#else
+	VString path;
+	inFile.GetPath().GetPosixPath( path);
+	VStringConvertBuffer buffer( path, VTC_UTF_8);
+	int fd = ::open( buffer.GetCPointer(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat fileStatus;
+		if ( (::fstat( fd, &fileStatus) == 0) && (fileStatus.st_size >= (off_t) sizeof( SCatalogHeader)) && (fileStatus.st_size < 0x7FFFFFFF) )
+		{
+			void *p = ::mmap( NULL, (size_t) fileStatus.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (p != MAP_FAILED)
+			{
+				image = p;
+				imageSize = (VSize) fileStatus.st_size;
+			}
+		}
+		::close( fd);
+	}
+	#endif
+
+	if (image == NULL)
+		return NULL;
+
+	VLocalizationCatalog *catalog = new VLocalizationCatalog;
+	catalog->fMappedImage = image;
+	catalog->fImage = (const char*) image;
+	catalog->fImageSize = imageSize;
+
+	if (!catalog->_IsValid( inStamp) || (catalog->_LoadGroupBags() != VE_OK))
+		ReleaseRefCountable( &catalog);
+
+	return catalog;
+}
+
+
+VError VLocalizationCatalog::WriteToFile( const VFile& inFile) const
+{
+	// write a temporary file then rename it, another process may be mapping a catalog with the same name
+	VString name, tempName;
+	inFile.GetName( name);
+	VUUID uuid( true);
+	uuid.GetString( tempName);
+	tempName = name + CVSTR( ".") + tempName + CVSTR( ".tmp");
+
+	VFilePath tempPath( inFile.GetPath());
+	tempPath.SetFileName( tempName);
+	VFile tempFile( tempPath);
+
+	VFileStream stream( &tempFile);
+	VError err = stream.OpenWriting();
+	if (err == VE_OK)
+	{
+		err = stream.PutData( fImage, fImageSize);
+		VError closeErr = stream.CloseWriting();
+		if (err == VE_OK)
+			err = closeErr;
+	}
+
+	if (err == VE_OK)
+	{
+		if (inFile.Exists())
+			inFile.Delete();
+		err = tempFile.Rename( name);
+	}
+
+	if ( (err != VE_OK) && tempFile.Exists() )
+		tempFile.Delete();
+
+	return err;
+}
+
+
+uLONG8 VLocalizationCatalog::GetStamp() const
+{
+	return _GetHeader( fImage)->fStamp;
+}
+
+
+bool VLocalizationCatalog::LocalizeSTRSharpCode( const STRSharpCodes& inSTRSharpCode, VString& outLocalizedString) const
+{
+	uLONG slot;
+	if (!_FindSlot( kSection_STRSharpCodes, _HashSTRSharpCode( inSTRSharpCode.fID, inSTRSharpCode.fStringID), slot))
+		return false;
+
+	const SCatalogSTRSharpEntry& entry = ((const SCatalogSTRSharpEntry*) (fImage + _GetHeader( fImage)->fSections[kSection_STRSharpCodes].fEntriesOffset))[slot];
+	if ( (entry.fID != inSTRSharpCode.fID) || (entry.fStringID != inSTRSharpCode.fStringID) )
+		return false;
+
+	_GetString( &entry.fString, outLocalizedString);
+	return true;
+}
+
+
+bool VLocalizationCatalog::LocalizeObjectURL( const VString& inObjectURL, VString& outLocalizedString) const
+{
+	uLONG slot;
+	if (!_FindSlot( kSection_Objects, _HashString( inObjectURL), slot))
+		return false;
+
+	const SCatalogKeyEntry& entry = ((const SCatalogKeyEntry*) (fImage + _GetHeader( fImage)->fSections[kSection_Objects].fEntriesOffset))[slot];
+	if (!_EqualToString( fImage, entry.fKey, inObjectURL))
+		return false;
+
+	_GetString( &entry.fString, outLocalizedString);
+	return true;
+}
+
+
+bool VLocalizationCatalog::LocalizeDotStringsKey( const VString& inDotStringsKey, VString& outLocalizedString) const
+{
+	uLONG slot;
+	if (!_FindSlot( kSection_DotStrings, _HashString( inDotStringsKey), slot))
+		return false;
+
+	const SCatalogKeyEntry& entry = ((const SCatalogKeyEntry*) (fImage + _GetHeader( fImage)->fSections[kSection_DotStrings].fEntriesOffset))[slot];
+	if (!_EqualToString( fImage, entry.fKey, inDotStringsKey))
+		return false;
+
+	_GetString( &entry.fString, outLocalizedString);
+	return true;
+}
+
+
+bool VLocalizationCatalog::GetOrderedStringsOfGroup( const VString& inGroup, std::vector<VString>& outLocalizedStrings) const
+{
+	uLONG slot;
+	if (!_FindSlot( kSection_Groups, _HashString( inGroup), slot))
+		return false;
+
+	const SCatalogHeader *header = _GetHeader( fImage);
+	const SCatalogGroupEntry& entry = ((const SCatalogGroupEntry*) (fImage + header->fSections[kSection_Groups].fEntriesOffset))[slot];
+	if (!_EqualToString( fImage, entry.fName, inGroup) || (entry.fItemCount == 0))
+		return false;
+
+	const SCatalogGroupItem *items = ((const SCatalogGroupItem*) (fImage + header->fGroupItemsOffset)) + entry.fFirstItem;
+	outLocalizedStrings.resize( entry.fItemCount);
+	for( uLONG i = 0 ; i < entry.fItemCount ; ++i)
+		_GetString( &items[i].fString, outLocalizedStrings[i]);
+
+	return true;
+}
+
+
+const VValueBag* VLocalizationCatalog::RetainGroupBag( const VString& inGroupResname) const
+{
+	GroupBagsByResnameMap::const_iterator i = fGroupBagsByResname.find( inGroupResname);
+	return (i == fGroupBagsByResname.end()) ? NULL : i->second.Retain();
+}
+
+
+void VLocalizationCatalog::RetainGroupBagsByRestype( const VString& inResType, std::vector<VRefPtr<const VValueBag> >& outBags) const
+{
+	std::pair<GroupBagsByRestypeMap::const_iterator,GroupBagsByRestypeMap::const_iterator> range = fGroupBagsByRestype.equal_range( inResType);
+	for( GroupBagsByRestypeMap::const_iterator i = range.first ; i != range.second ; ++i)
+		outBags.push_back( i->second);
+}
+
+
+#pragma mark Private
+
+bool VLocalizationCatalog::_IsValid( uLONG8 inStamp) const
+{
+	if (fImageSize < sizeof( SCatalogHeader))
+		return false;
+
+	const SCatalogHeader *header = _GetHeader( fImage);
+	if ( (header->fSignature != kCatalogSignature) || (header->fVersion != kCatalogVersion) || (header->fByteOrder != kCatalogByteOrder)
+		|| (header->fStamp != inStamp) || (header->fImageSize != fImageSize) )
+		return false;
+
+	VCatalogValidator validator( fImage, fImageSize);
+	if (!validator.IsBlockValid( header->fStringsOffset, header->fStringsLength, sizeof( UniChar)))
+		return false;
+	validator.fStringsLength = header->fStringsLength;
+
+	if ( !validator.IsSectionValid( header->fSections[kSection_STRSharpCodes], sizeof( SCatalogSTRSharpEntry))
+		|| !validator.IsSectionValid( header->fSections[kSection_Objects], sizeof( SCatalogKeyEntry))
+		|| !validator.IsSectionValid( header->fSections[kSection_DotStrings], sizeof( SCatalogKeyEntry))
+		|| !validator.IsSectionValid( header->fSections[kSection_Groups], sizeof( SCatalogGroupEntry))
+		|| !validator.IsBlockValid( header->fGroupItemsOffset, header->fGroupItemsCount, sizeof( SCatalogGroupItem))
+		|| !validator.IsBlockValid( header->fBagsOffset, header->fBagsCount, sizeof( SCatalogBag))
+		|| !validator.IsBlockValid( header->fBagDataOffset, header->fBagDataSize, 1) )
+		return false;
+
+	const SCatalogSTRSharpEntry *strSharpEntries = (const SCatalogSTRSharpEntry*) (fImage + header->fSections[kSection_STRSharpCodes].fEntriesOffset);
+	for( uLONG i = 0 ; i < header->fSections[kSection_STRSharpCodes].fCount ; ++i)
+	{
+		if (!validator.IsStringValid( strSharpEntries[i].fString))
+			return false;
+	}
+
+	for( sLONG section = kSection_Objects ; section <= kSection_DotStrings ; ++section)
+	{
+		const SCatalogKeyEntry *keyEntries = (const SCatalogKeyEntry*) (fImage + header->fSections[section].fEntriesOffset);
+		for( uLONG i = 0 ; i < header->fSections[section].fCount ; ++i)
+		{
+			if (!validator.IsStringValid( keyEntries[i].fKey) || !validator.IsStringValid( keyEntries[i].fString))
+				return false;
+		}
+	}
+
+	const SCatalogGroupEntry *groupEntries = (const SCatalogGroupEntry*) (fImage + header->fSections[kSection_Groups].fEntriesOffset);
+	for( uLONG i = 0 ; i < header->fSections[kSection_Groups].fCount ; ++i)
+	{
+		if ( !validator.IsStringValid( groupEntries[i].fName) || (groupEntries[i].fFirstItem > header->fGroupItemsCount)
+			|| (groupEntries[i].fItemCount > header->fGroupItemsCount - groupEntries[i].fFirstItem) )
+			return false;
+	}
+
+	const SCatalogGroupItem *groupItems = (const SCatalogGroupItem*) (fImage + header->fGroupItemsOffset);
+	for( uLONG i = 0 ; i < header->fGroupItemsCount ; ++i)
+	{
+		if (!validator.IsStringValid( groupItems[i].fString))
+			return false;
+	}
+
+	const SCatalogBag *bags = (const SCatalogBag*) (fImage + header->fBagsOffset);
+	for( uLONG i = 0 ; i < header->fBagsCount ; ++i)
+	{
+		if ( !validator.IsStringValid( bags[i].fResname) || !validator.IsStringValid( bags[i].fRestype)
+			|| (bags[i].fDataOffset > header->fBagDataSize) || (bags[i].fDataSize > header->fBagDataSize - bags[i].fDataOffset) )
+			return false;
+	}
+
+	return true;
+}
+
+
+VError VLocalizationCatalog::_LoadGroupBags()
+{
+	const SCatalogHeader *header = _GetHeader( fImage);
+	const SCatalogBag *bags = (const SCatalogBag*) (fImage + header->fBagsOffset);
+
+	VError err = VE_OK;
+	for( uLONG i = 0 ; (i < header->fBagsCount) && (err == VE_OK) ; ++i)
+	{
+		VString resname, restype;
+		_GetString( &bags[i].fResname, resname);
+		_GetString( &bags[i].fRestype, restype);
+
+		VValueBag *bag = new VValueBag;
+		if (bag == NULL)
+		{
+			err = VE_MEMORY_FULL;
+			break;
+		}
+
+		VConstPtrStream stream( fImage + header->fBagDataOffset + bags[i].fDataOffset, bags[i].fDataSize);
+		err = stream.OpenReading();
+		if (err == VE_OK)
+		{
+			err = bag->ReadFromStream( &stream);
+			stream.CloseReading();
+		}
+
+		if (err == VE_OK)
+		{
+			VRefPtr<const VValueBag> bagRef( bag);
+			if (!resname.IsEmpty())
+				fGroupBagsByResname.insert( GroupBagsByResnameMap::value_type( resname, bagRef));
+			fGroupBagsByRestype.insert( GroupBagsByRestypeMap::value_type( restype, bagRef));
+		}
+		bag->Release();
+	}
+
+	return err;
+}
+
+
+bool VLocalizationCatalog::_FindSlot( sLONG inSection, uLONG8 inHash, uLONG& outSlot) const
+{
+	const SCatalogSection& section = _GetHeader( fImage)->fSections[inSection];
+	if (section.fCount == 0)
+		return false;
+
+	sLONG seed = ((const sLONG*) (fImage + section.fSeedsOffset))[_GetBucket( inHash, section.fBucketCount)];
+	if (seed == 0)
+		return false;
+
+	outSlot = (seed < 0) ? (uLONG) (-(seed + 1)) : _GetSlot( inHash, seed, section.fCount);
+	return true;
+}
+
+
+void VLocalizationCatalog::_GetString( const void *inStringRef, VString& outString) const
+{
+	const SCatalogString *ref = (const SCatalogString*) inStringRef;
+	outString.Clear();
+	outString.AppendUniChars( _GetChars( fImage, *ref), (VIndex) ref->fLength);
+}
+
+
+END_TOOLBOX_NAMESPACE
@@ -0,0 +1,80 @@
+/*
+* This file is part of Wakanda software, licensed by 4D under
+*  (i) the GNU General Public License version 3 (GNU GPL v3), or
+*  (ii) the Affero General Public License version 3 (AGPL v3) or
+*  (iii) a commercial license.
+* This file remains the exclusive property of 4D and/or its licensors
+* and is protected by national and international legislations.
+* In any event, Licensee's compliance with the terms and conditions
+* of the applicable license constitutes a prerequisite to any use of this file.
+* Except as otherwise expressly stated in the applicable license,
+* such license does not include any other license or rights on this file,
+* 4D's and/or its licensors' trademarks and/or other proprietary rights.
+* Consequently, no title, copyright or other proprietary rights
+* other than those specified in the applicable license is granted.
+*/
+#ifndef __VLOCALIZATIONCATALOG__
+#define __VLOCALIZATIONCATALOG__
+
+#include "VLocalizationManager.h"
+
+BEGIN_TOOLBOX_NAMESPACE
+
+/**
+* @brief Compiled, read-only image of the localization tables of a VLocalizationManager.
+* The image holds a string table and one minimal perfect hash index per kind of key (STR# codes, object URLs, .strings keys and groups).
+* It is either built in memory from the manager tables or memory-mapped from a catalog file previously written with WriteToFile().
+* A catalog never changes once built, so lookups need no lock.
+* The stamp identifies the localization sources the catalog was built from; Open() rejects a file whose stamp or layout doesn't match.
+*/
+class XTOOLBOX_API VLocalizationCatalog : public VObject, public IRefCountable
+{
+public:
+	/**
+	* @brief Build a catalog from the manager tables.
+	* @return NULL if the tables cannot be indexed (the caller keeps using its tables)
+	*/
+	static	VLocalizationCatalog*	Compile( uLONG8 inStamp, const STRSharpCodeAndStringMap& inSTRSharpCodes, const OOSyntaxStringAndStringMap& inObjects, const DotStringsAndStringsMap& inDotStrings,
+											const GroupToIDAndStringsMap& inGroups, const GroupBagsByResnameMap& inBagsByResname, const GroupBagsByRestypeMap& inBagsByRestype);
+
+	/**
+	* @brief Map a catalog file.
+	* @return NULL if the file doesn't exist, is not a catalog, was built by another format version or from other sources than inStamp.
+	*/
+	static	VLocalizationCatalog*	Open( const VFile& inFile, uLONG8 inStamp);
+
+			VError					WriteToFile( const VFile& inFile) const;
+
+			uLONG8					GetStamp() const;
+
+			bool					LocalizeSTRSharpCode( const STRSharpCodes& inSTRSharpCode, VString& outLocalizedString) const;
+			bool					LocalizeObjectURL( const VString& inObjectURL, VString& outLocalizedString) const;
+			bool					LocalizeDotStringsKey( const VString& inDotStringsKey, VString& outLocalizedString) const;
+			bool					GetOrderedStringsOfGroup( const VString& inGroup, std::vector<VString>& outLocalizedStrings) const;
+
+			const VValueBag*		RetainGroupBag( const VString& inGroupResname) const;
+			void					RetainGroupBagsByRestype( const VString& inResType, std::vector<VRefPtr<const VValueBag> >& outBags) const;
+
+private:
+											VLocalizationCatalog();
+	virtual									~VLocalizationCatalog();
+											VLocalizationCatalog( const VLocalizationCatalog&);	// no
+			VLocalizationCatalog&			operator=( const VLocalizationCatalog&);	// no
+
+			bool							_IsValid( uLONG8 inStamp) const;
+			VError							_LoadGroupBags();
+			bool							_FindSlot( sLONG inSection, uLONG8 inHash, uLONG& outSlot) const;
+			void							_GetString( const void *inStringRef, VString& outString) const;
+
+			const char*						fImage;
+			VSize							fImageSize;
+			void*							fAllocatedImage;	/**< image built by Compile() */
+			void*							fMappedImage;		/**< image mapped by Open() */
+
+			GroupBagsByResnameMap			fGroupBagsByResname;
+			GroupBagsByRestypeMap			fGroupBagsByRestype;
+};
+
+END_TOOLBOX_NAMESPACE
+
+#endif
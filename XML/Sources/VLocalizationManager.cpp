@@ -15,6 +15,7 @@
 */
 #include "VXMLPrecompiled.h"
 #include "VLocalizationManager.h"
+#include "VLocalizationCatalog.h"
 #include "VLocalizationXMLHandler.h"
 #include "XMLSaxParser.h"
 
@@ -22,19 +23,54 @@ BEGIN_TOOLBOX_NAMESPACE
 
 static const VString kXliffExtension(L"xlf");
 static const VString kStringsExtension(L"strings");
+static const VString kCatalogExtension(L"xlfc");
+static const sLONG kCatalogFileMaxAgeInDays = 30;
+
+
+static void _HashBytes( uLONG8& ioHash, const void *inData, VSize inSize)
+{
+	for( const uBYTE *p = (const uBYTE*) inData, *end = p + inSize ; p != end ; ++p)
+	{
+		ioHash ^= *p;
+		ioHash *= XBOX_LONG8(0x100000001b3);
+	}
+}
 
 #pragma mark Public
 
-VLocalizationManager::VLocalizationManager(DialectCode inDialectCode): fCurrentDialectCode(inDialectCode)
+VLocalizationManager::VLocalizationManager(DialectCode inDialectCode)
+: fReadWriteCriticalSection(0)
+, fCurrentDialectCode(inDialectCode)
+, fParsedSourcesCount(0)
+, fIsParsingSources(false)
+, fHasInsertedStrings(false)
+, fCatalogIsStale(1)
+, fTableLookupsBeforeCompile(0)
+, fCatalog(NULL)
+, fCatalogFolder(NULL)
+, fCatalogFolderIsPurged(false)
 {
 	fSAXParser = new VXMLParser();
 	fSAXParser->Init();
 	fSAXHandler = new VLocalizationXMLHandler(this);
 	fLocalizedStringsSet = new StringsSet();
+
+	StErrorContextInstaller errorContext( false);
+	VFolder *cacheFolder = VFolder::RetainSystemFolder( eFK_UserCache, false);
+	if (cacheFolder != NULL)
+	{
+		VFilePath catalogFolderPath( cacheFolder->GetPath());
+		catalogFolderPath.ToSubFolder( CVSTR( "Localization Catalogs"));
+		fCatalogFolder = new VFolder( catalogFolderPath);
+		ReleaseRefCountable( &cacheFolder);
+	}
 }
 
 VLocalizationManager::~VLocalizationManager()
 {
+	ReleaseRefCountable( &fCatalog);
+	ReleaseRefCountable( &fCatalogFolder);
+
 	delete fSAXHandler;
 	if (fSAXParser != NULL)
 	{
@@ -46,27 +82,32 @@ VLocalizationManager::~VLocalizationManager()
 
 bool VLocalizationManager::ClearLocalizations()
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
 
-	delete fLocalizedStringsSet;
-	fStringsRelativeToSTRSharpCodes.clear();
-	fStringsRelativeToObjects.clear();
-	fStringsAndIDsRelativeToGroups.clear();
-	fStringsRelativeToDotStrings.clear();
-	
-	fLocalizedStringsSet = new StringsSet();
+	_ClearTables();
 
-	fGroupBagsByResname.clear();
-	fGroupBagsByRestype.clear();
+	fSources.clear();
+	fParsedSourcesCount = 0;
+	fHasInsertedStrings = false;
+	_PublishCatalog( NULL);
+	VInterlocked::Exchange( &fTableLookupsBeforeCompile, 0);
+	VInterlocked::Exchange( &fCatalogIsStale, 1);
 	
 	return true;
 }
 
+void VLocalizationManager::SetCatalogFolder( VFolder *inFolder)
+{
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+
+	CopyRefCountable( &fCatalogFolder, inFolder);
+}
+
 bool VLocalizationManager::DoesNeedAnUpdate()
 {
 	bool needAnUpdate = false;
 	
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
 	
 	//Check the last modification date of every file
 	FilePathAndTimeMap newFilesProcessedAndLastModificationTime;
@@ -169,44 +210,45 @@ VError VLocalizationManager::_LoadFile(VFile* inFileToAdd, bool actuallyLoadingO
 	if (!inFileToAdd->Exists())
 		return VE_FILE_NOT_FOUND;
 
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+
 	//Extensions comparison
 	if (inFileToAdd->MatchExtension(kXliffExtension))
 	{
-		//The file seems to be a XLIFF file, let's analyse it
-		if (AnalyzeXLIFFFile(inFileToAdd, inForceLoading) == VE_OK)
-		{			
-			//We need to know the successfully loaded files
-			if (!actuallyLoadingOfAFolder)
+		//The file seems to be a XLIFF file, it will be analysed on first lookup
+		_AddSource(inFileToAdd, false, inForceLoading);
+
+		//We need to know the successfully loaded files
+		if (!actuallyLoadingOfAFolder)
+		{
+			bool alreadyExists = false;
+			for( std::vector<VFilePath>::iterator i = fFilesAndFoldersProcessed.begin() ; (i != fFilesAndFoldersProcessed.end()) && !alreadyExists ; ++i)
 			{
-				bool alreadyExists = false;
-				for( std::vector<VFilePath>::iterator i = fFilesAndFoldersProcessed.begin() ; (i != fFilesAndFoldersProcessed.end()) && !alreadyExists ; ++i)
-				{
-					if (i->IsFile())
-					{
-						VFile f( *i);
-						alreadyExists = inFileToAdd->IsSameFile( &f);
-					}
-				}
-				//If the file isn't in the list, let's add it
-				if (!alreadyExists)
+				if (i->IsFile())
 				{
-					fFilesAndFoldersProcessed.push_back(inFileToAdd->GetPath());
+					VFile f( *i);
+					alreadyExists = inFileToAdd->IsSameFile( &f);
 				}
 			}
-			//We also need the modification time of every file
-			VTime lastModificationTime;
-			inFileToAdd->GetTimeAttributes(&lastModificationTime);
-			std::pair< FilePathAndTimeMap::iterator, bool > resultOfInsert = fFilesProcessedAndLastModificationTime.insert(FilePathAndTimeMap::value_type(inFileToAdd->GetPath(), lastModificationTime));
-			if (!resultOfInsert.second)
+			//If the file isn't in the list, let's add it
+			if (!alreadyExists)
 			{
-				resultOfInsert.first->second = lastModificationTime;
+				fFilesAndFoldersProcessed.push_back(inFileToAdd->GetPath());
 			}
 		}
+		//We also need the modification time of every file
+		VTime lastModificationTime;
+		inFileToAdd->GetTimeAttributes(&lastModificationTime);
+		std::pair< FilePathAndTimeMap::iterator, bool > resultOfInsert = fFilesProcessedAndLastModificationTime.insert(FilePathAndTimeMap::value_type(inFileToAdd->GetPath(), lastModificationTime));
+		if (!resultOfInsert.second)
+		{
+			resultOfInsert.first->second = lastModificationTime;
+		}
 		return VE_OK;
 	}
 	else if (inFileToAdd->MatchExtension(kStringsExtension))
 	{
-		AnalyzeDotStringsFile(inFileToAdd);	
+		_AddSource(inFileToAdd, true, false);
 	}
 	return VE_FILE_BAD_KIND;
 }
@@ -286,9 +328,15 @@ bool VLocalizationManager::LoadDefaultLocalizationFoldersForComponentOrPlugin( V
 //Localization
 bool VLocalizationManager::LocalizeStringWithKey(const VString& inKeyToLookUp, VString& outLocalizedString)
 {
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+		return catalog->LocalizeObjectURL(inKeyToLookUp, outLocalizedString);
+
 	bool result = false;
-	
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+
 	OOSyntaxStringAndStringMap::iterator urlToStringHashMapIterator = fStringsRelativeToObjects.find(inKeyToLookUp);
 	if(urlToStringHashMapIterator != fStringsRelativeToObjects.end()){
 		outLocalizedString = *(urlToStringHashMapIterator->second);
@@ -300,9 +348,15 @@ bool VLocalizationManager::LocalizeStringWithKey(const VString& inKeyToLookUp, V
 
 bool VLocalizationManager::LocalizeStringWithSTRSharpCodes(const STRSharpCodes& inSTRSharpCodesToLookUp, VString& outLocalizedString)
 {
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+		return catalog->LocalizeSTRSharpCode(inSTRSharpCodesToLookUp, outLocalizedString);
+
 	bool result = false;
-	
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+
 	STRSharpCodeAndStringMap::iterator stringsMapsRelativeToSTRSharpCodesIterator = fStringsRelativeToSTRSharpCodes.find(inSTRSharpCodesToLookUp);
 	if(stringsMapsRelativeToSTRSharpCodesIterator != fStringsRelativeToSTRSharpCodes.end()){
 		outLocalizedString = *(stringsMapsRelativeToSTRSharpCodesIterator->second);
@@ -315,9 +369,20 @@ bool VLocalizationManager::LocalizeStringWithSTRSharpCodes(const STRSharpCodes&
 
 bool VLocalizationManager::LocalizeGroupOfStringsWithAStrSharpID( sLONG inID, std::vector<VString>& outLocalizedStrings)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
-
 	outLocalizedStrings.clear();
+
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+	{
+		VString localizedString;
+		for( uLONG index = 1 ; catalog->LocalizeSTRSharpCode( STRSharpCodes( inID, index), localizedString) ; ++index)
+			outLocalizedStrings.push_back( localizedString);
+		return !outLocalizedStrings.empty();
+	}
+
 	try
 	{
 		uLONG index = 1;
@@ -344,9 +409,15 @@ bool VLocalizationManager::GetOrderedStringsOfGroup(const VString& groupName, st
 {
 	outLocalizedStringsVector.clear();
 
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+		return catalog->GetOrderedStringsOfGroup(groupName, outLocalizedStringsVector);
+
 	bool result = false;
-	
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+
 	GroupToIDAndStringsMap::iterator groupsMapIterator = fStringsAndIDsRelativeToGroups.find(groupName);
 	if(groupsMapIterator != fStringsAndIDsRelativeToGroups.end()){
 		if(groupsMapIterator->second.size() > 0){
@@ -368,9 +439,15 @@ bool VLocalizationManager::GetOrderedStringsOfGroup(const VString& groupName, st
 
 bool VLocalizationManager::LocalizeStringWithDotStringsKey(const VString& inKeyToLookUp, VString& outLocalizedString)
 {
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+		return catalog->LocalizeDotStringsKey(inKeyToLookUp, outLocalizedString);
+
 	bool result = false;
-	
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+
 	DotStringsAndStringsMap::iterator dotStringsKeyToStringHashMapIterator = fStringsRelativeToDotStrings.find(inKeyToLookUp);
 	if(dotStringsKeyToStringHashMapIterator != fStringsRelativeToDotStrings.end()){
 		outLocalizedString = *(dotStringsKeyToStringHashMapIterator->second);
@@ -402,7 +479,8 @@ DialectCode VLocalizationManager::GetLocalizationLanguage()
 
 bool VLocalizationManager::InsertSTRSharpCodeAndString(const STRSharpCodes inSTRSharpCodeToAdd, VString& inLocalizedStringToAdd, bool inShouldOverwriteExistentValue)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	_WillInsertString();
 	
 	//We verify if we can overwrite an existent value
 	STRSharpCodeAndStringMap::iterator sTRSharpMapIterator = fStringsRelativeToSTRSharpCodes.find(inSTRSharpCodeToAdd);
@@ -430,7 +508,8 @@ bool VLocalizationManager::InsertSTRSharpCodeAndString(const STRSharpCodes inSTR
 
 bool VLocalizationManager::InsertObjectURLAndString(const VString& inObjectURL, const VString& inLocalizedStringToAdd, bool inShouldOverwriteExistentValue)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	_WillInsertString();
 	//We verify if we can overwrite an existent value
 	OOSyntaxStringAndStringMap::iterator objectsMapIterator = fStringsRelativeToObjects.find(inObjectURL);
 	
@@ -453,7 +532,8 @@ bool VLocalizationManager::InsertObjectURLAndString(const VString& inObjectURL,
 
 bool VLocalizationManager::InsertIDAndStringInAGroup(uLONG inID, const VString& inLocalizedString, const VString& inGroup, bool inShouldOverwriteExistentValue)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	_WillInsertString();
 	
 	//Find if the group is already inserted, if not insert it
 	GroupToIDAndStringsMap::iterator groupsMapIterator = fStringsAndIDsRelativeToGroups.find(inGroup);
@@ -478,7 +558,8 @@ bool VLocalizationManager::InsertIDAndStringInAGroup(uLONG inID, const VString&
 
 bool VLocalizationManager::InsertDotStringsKeyAndString(const VString& inDotStringsKey, const VString& inLocalizedStringToAdd, bool inShouldOverwriteExistentValue)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	_WillInsertString();
 	//We verify if we can overwrite an existent value
 	DotStringsAndStringsMap::iterator dotStringsMapIterator = fStringsRelativeToDotStrings.find(inDotStringsKey);
 	
@@ -502,7 +583,8 @@ bool VLocalizationManager::InsertDotStringsKeyAndString(const VString& inDotStri
 
 void VLocalizationManager::InsertGroupBag( const VString& inGroupResname, const VString& inGroupRestype, const VValueBag *inBag)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	_WillInsertString();
 
 	#if 0
 	VString dump;
@@ -522,7 +604,12 @@ void VLocalizationManager::InsertGroupBag( const VString& inGroupResname, const
 
 const VValueBag *VLocalizationManager::RetainGroupBag( const VString& inGroupResname)
 {
-	VTaskLock fReadWriteLocker(&fReadWriteCriticalSection);
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+		return catalog->RetainGroupBag( inGroupResname);
 	
 	MapOfBagByName::iterator i = fGroupBagsByResname.find( inGroupResname);
 	return (i == fGroupBagsByResname.end()) ? NULL : i->second.Retain();
@@ -531,6 +618,15 @@ const VValueBag *VLocalizationManager::RetainGroupBag( const VString& inGroupRes
 
 void VLocalizationManager::RetainGroupBagsByRestype( const VString& inResType, std::vector<VRefPtr<const VValueBag> >& outBags)
 {
+	_UpdateCatalogIfStale();
+
+	StReadLocker fReadWriteLocker(&fReadWriteCriticalSection);
+	VLocalizationCatalog *catalog = fCatalog;
+	if (catalog != NULL)
+	{
+		catalog->RetainGroupBagsByRestype( inResType, outBags);
+		return;
+	}
 	std::pair<MapOfBagByRestype::iterator,MapOfBagByRestype::iterator> range = fGroupBagsByRestype.equal_range( inResType);
 	for( MapOfBagByRestype::iterator i = range.first ; i != range.second ; ++i)
 		outBags.push_back( i->second);
@@ -608,6 +704,192 @@ VError VLocalizationManager::AnalyzeDotStringsFile(VFile* inFileToAnalyze)
 }
 
 
+#pragma mark Private
+
+void VLocalizationManager::_AddSource(VFile* inFile, bool inIsDotStrings, bool inForceLoading)
+{
+	SLocalizationSource source;
+	source.fPath = inFile->GetPath();
+	source.fIsDotStrings = inIsDotStrings;
+	source.fForceLoading = inForceLoading;
+	source.fSize = 0;
+
+	VTime lastModificationTime;
+	inFile->GetTimeAttributes(&lastModificationTime);
+	inFile->GetSize(&source.fSize);
+	source.fModificationStamp = lastModificationTime.GetStamp();
+
+	fSources.push_back(source);
+	VInterlocked::Exchange(&fTableLookupsBeforeCompile, 0);	// the tables don't hold this source yet
+	VInterlocked::Exchange(&fCatalogIsStale, 1);
+}
+
+void VLocalizationManager::_ParsePendingSources()
+{
+	// fReadWriteCriticalSection must be write locked, the files are parsed in loading order like they used to be in LoadFile()
+	fIsParsingSources = true;
+	while (fParsedSourcesCount < fSources.size())
+	{
+		const SLocalizationSource& source = fSources[fParsedSourcesCount++];
+		VFile file(source.fPath);
+		if (source.fIsDotStrings)
+			AnalyzeDotStringsFile(&file);
+		else
+			AnalyzeXLIFFFile(&file, source.fForceLoading);
+	}
+	fIsParsingSources = false;
+}
+
+void VLocalizationManager::_WillInsertString()
+{
+	// fReadWriteCriticalSection must be write locked
+	if (!fIsParsingSources)
+	{
+		// an insert must override the strings of the files loaded before it
+		_ParsePendingSources();
+		fHasInsertedStrings = true;
+
+		// the tables are now complete: they serve the lookups until they have served as many as they hold strings,
+		// so that interleaved inserts and lookups don't compile the whole catalog each time
+		_PublishCatalog(NULL);
+		sLONG count = (sLONG) fLocalizedStringsSet->fHashset->size();
+		VInterlocked::Exchange(&fTableLookupsBeforeCompile, (count > 0) ? count : 1);
+	}
+	VInterlocked::Exchange(&fCatalogIsStale, 1);
+}
+
+uLONG8 VLocalizationManager::_GetSourcesStamp() const
+{
+	uLONG8 stamp = XBOX_LONG8(0xcbf29ce484222325);
+	_HashBytes(stamp, &fCurrentDialectCode, sizeof(fCurrentDialectCode));
+	for (std::vector<SLocalizationSource>::const_iterator i = fSources.begin() ; i != fSources.end() ; ++i)
+	{
+		const VString& path = i->fPath.GetPath();
+		uBYTE flags = (i->fIsDotStrings ? 1 : 0) | (i->fForceLoading ? 2 : 0);
+		_HashBytes(stamp, path.GetCPointer(), path.GetLength() * sizeof(UniChar));
+		_HashBytes(stamp, &i->fModificationStamp, sizeof(i->fModificationStamp));
+		_HashBytes(stamp, &i->fSize, sizeof(i->fSize));
+		_HashBytes(stamp, &flags, sizeof(flags));
+	}
+	return stamp;
+}
+
+void VLocalizationManager::_UpdateCatalogIfStale()
+{
+	// fReadWriteCriticalSection must not be read locked: it is called by the lookups before they take the read lock,
+	// and no lookup is called while the read lock is held (the catalog and the tables don't call back the manager)
+	if (VInterlocked::AtomicGet(&fCatalogIsStale) == 0)
+		return;
+
+	if (VInterlocked::Decrement(&fTableLookupsBeforeCompile) >= 0)
+		return;
+
+	_UpdateCatalog();
+}
+
+void VLocalizationManager::_UpdateCatalog()
+{
+	StWriteLocker fReadWriteLocker(&fReadWriteCriticalSection);
+
+	if (VInterlocked::AtomicGet(&fCatalogIsStale) == 0)
+		return;	// another task did it
+
+	StErrorContextInstaller errorContext(false);
+
+	uLONG8 stamp = _GetSourcesStamp();
+
+	// the catalog can be reused by the next run only if it derives from the sources alone
+	VFile *catalogFile = NULL;
+	if (!fHasInsertedStrings && !fSources.empty() && (fCatalogFolder != NULL))
+	{
+		char name[32];
+		sprintf(name, "%08X%08X", (uLONG) (stamp >> 32), (uLONG) stamp);
+		VFilePath catalogPath(fCatalogFolder->GetPath());
+		catalogPath.SetFileName(VString(name) + CVSTR(".") + kCatalogExtension);
+		catalogFile = new VFile(catalogPath);
+	}
+
+	VLocalizationCatalog *catalog = (catalogFile != NULL) ? VLocalizationCatalog::Open(*catalogFile, stamp) : NULL;
+	if (catalog != NULL)
+	{
+		// a catalog file in use must not look unused to _PurgeCatalogFolder()
+		VTime now;
+		VTime::Now(now);
+		catalogFile->SetTimeAttributes(&now);
+	}
+	else
+	{
+		_ParsePendingSources();
+		catalog = VLocalizationCatalog::Compile(stamp, fStringsRelativeToSTRSharpCodes, fStringsRelativeToObjects, fStringsRelativeToDotStrings, fStringsAndIDsRelativeToGroups, fGroupBagsByResname, fGroupBagsByRestype);
+		if ( (catalog != NULL) && (catalogFile != NULL) )
+		{
+			if (!fCatalogFolder->Exists())
+				fCatalogFolder->CreateRecursive();
+			catalog->WriteToFile(*catalogFile);
+		}
+	}
+
+	// the tables would only duplicate the catalog, they are parsed again if something is inserted later
+	if ( (catalog != NULL) && !fHasInsertedStrings )
+	{
+		_ClearTables();
+		fParsedSourcesCount = 0;
+	}
+
+	// if the compilation failed, lookups keep using the tables
+	_PublishCatalog(catalog);
+
+	// the file of the previous sources is left to _PurgeCatalogFolder(): the folder is shared, another manager may still use it
+	if ( (catalog != NULL) && (catalogFile != NULL) && !fCatalogFolderIsPurged )
+	{
+		_PurgeCatalogFolder(*catalogFile);
+		fCatalogFolderIsPurged = true;
+	}
+	ReleaseRefCountable(&catalog);
+	ReleaseRefCountable(&catalogFile);
+
+	VInterlocked::Exchange(&fCatalogIsStale, 0);
+}
+
+void VLocalizationManager::_PublishCatalog(VLocalizationCatalog *inCatalog)
+{
+	// fReadWriteCriticalSection must be write locked, so no lookup is still reading the previous catalog
+	VLocalizationCatalog *previous = fCatalog;
+	fCatalog = RetainRefCountable(inCatalog);
+	ReleaseRefCountable(&previous);
+}
+
+void VLocalizationManager::_PurgeCatalogFolder(const VFile& inCurrentFile)
+{
+	// files of other sources, or of older versions of them, are left behind by other runs: those that have not been used for a while are deleted
+	VTime limit;
+	VTime::Now(limit);
+	limit.AddDays(-kCatalogFileMaxAgeInDays);
+
+	for (VFileIterator i(fCatalogFolder, FI_ITERATE_DELETE | FI_NORMAL_FILES) ; i.IsValid() ; ++i)
+	{
+		VTime lastModification;
+		if (i->MatchExtension(kCatalogExtension) && (i->GetPath() != inCurrentFile.GetPath())
+			&& (i->GetTimeAttributes(&lastModification) == VE_OK) && (lastModification < limit))
+			i->Delete();
+	}
+}
+
+void VLocalizationManager::_ClearTables()
+{
+	delete fLocalizedStringsSet;
+	fStringsRelativeToSTRSharpCodes.clear();
+	fStringsRelativeToObjects.clear();
+	fStringsAndIDsRelativeToGroups.clear();
+	fStringsRelativeToDotStrings.clear();
+	
+	fLocalizedStringsSet = new StringsSet();
+
+	fGroupBagsByResname.clear();
+	fGroupBagsByRestype.clear();
+}
+
+
 END_TOOLBOX_NAMESPACE
 
 
@@ -69,11 +69,14 @@ typedef STL_EXT_NAMESPACE::hash_map<XBOX::VString, XBOX::VString*, STL_EXT_NAMES
 typedef STL_EXT_NAMESPACE::hash_map<XBOX::VString, std::map< uLONG, XBOX::VString*>, STL_EXT_NAMESPACE::STL_HASH_FUNCTOR_NAME<XBOX::VString> >	GroupToIDAndStringsMap;
 typedef STL_EXT_NAMESPACE::hash_map<XBOX::VString, XBOX::VString*, STL_EXT_NAMESPACE::STL_HASH_FUNCTOR_NAME<XBOX::VString> >				DotStringsAndStringsMap;
 typedef DeletableHashSet< XBOX::VString *, VString_Hash_Function>																			StringsSet;
+typedef std::map< XBOX::VString, XBOX::VRefPtr<const XBOX::VValueBag> >																	GroupBagsByResnameMap;
+typedef std::multimap< XBOX::VString, XBOX::VRefPtr<const XBOX::VValueBag> >																GroupBagsByRestypeMap;
 
 BEGIN_TOOLBOX_NAMESPACE
 
 class VXMLParser;
 class VLocalizationXMLHandler;
+class VLocalizationCatalog;
 
 #define OO_SYNTAX_INTERNAL_DIVIDER L"#}[{@"
 
@@ -82,6 +85,10 @@ class VLocalizationXMLHandler;
 * It manages the localization from the default language : 
 * - Analysis of the localization files
 * - Lookups 
+* Loaded files are only recorded, they are parsed on first lookup and compiled into a VLocalizationCatalog.
+* The catalog is cached on disk, keyed by the files paths, modification times and sizes, so that the next run maps it instead of parsing again.
+* Lookups share a reader lock with each other. After an insert, they are served by the tables for a while before the catalog is compiled again.
+* Catalog files not used for a while are deleted from the cache folder.
 */
 class XTOOLBOX_API VLocalizationManager : public VObject, public IRefCountable, public ILocalizer
 {
@@ -249,6 +256,12 @@ public:
 	*/
 			void				InsertGroupBag( const VString& inGroupResname, const VString& inGroupRestype, const VValueBag *inBag);
 
+	/**
+	* @brief Set the folder where compiled catalogs are cached (default is a subfolder of the user cache folder).
+	* Pass NULL to never read or write catalog files, the catalog is then compiled in memory on each run.
+	*/
+			void				SetCatalogFolder( VFolder *inFolder);
+
 protected:
 
 	/**
@@ -291,12 +304,31 @@ protected:
 	bool			ClearLocalizations();
 		
 private:
+	typedef struct SLocalizationSource
+	{
+		VFilePath	fPath;
+		uLONG8		fModificationStamp;
+		sLONG8		fSize;
+		bool		fIsDotStrings;
+		bool		fForceLoading;
+	} SLocalizationSource;
+
+			void							_AddSource( VFile *inFile, bool inIsDotStrings, bool inForceLoading);
+			void							_ParsePendingSources();
+			void							_WillInsertString();
+			uLONG8							_GetSourcesStamp() const;
+			void							_UpdateCatalogIfStale();
+			void							_UpdateCatalog();
+			void							_PublishCatalog( VLocalizationCatalog *inCatalog);
+			void							_PurgeCatalogFolder( const VFile& inCurrentFile);
+			void							_ClearTables();
+
 	virtual									~VLocalizationManager();
 
 											VLocalizationManager( const VLocalizationManager&);	// no
 	VLocalizationManager&					operator=( const VLocalizationManager&);	// no
 	
-	VCriticalSection						fReadWriteCriticalSection;			/**< Critical section, thread-safe behaviour of the class (i/o protection) */
+	VReaderWriterLock						fReadWriteCriticalSection;			/**< Reader/writer lock, thread-safe behaviour of the class (lookups share it, loading is exclusive). One reader slot per processor so that concurrent lookups don't share a counter */
 
 	StringsSet*								fLocalizedStringsSet;			/**< Effective container of the localized strings */
 	DialectCode								fCurrentDialectCode; 			/**< Unique language used when parsing localization files */
@@ -310,11 +342,21 @@ private:
 	std::vector<VFilePath>					fFilesAndFoldersProcessed; 		/**< All the files and folders paths processed to extract localization */
 	FilePathAndTimeMap						fFilesProcessedAndLastModificationTime; /**< All the files processed linked to the last modification date recorded */
 	
-	typedef std::map<VString,VRefPtr<const VValueBag> >	MapOfBagByName;
+	typedef GroupBagsByResnameMap	MapOfBagByName;
 	MapOfBagByName							fGroupBagsByResname;
 
-	typedef std::multimap<VString,VRefPtr<const VValueBag> >	MapOfBagByRestype;
+	typedef GroupBagsByRestypeMap	MapOfBagByRestype;
 	MapOfBagByRestype						fGroupBagsByRestype;
+
+	std::vector<SLocalizationSource>		fSources;						/**< All the loaded files, in loading order */
+	size_t									fParsedSourcesCount;			/**< The tables hold the fParsedSourcesCount first sources */
+	bool									fIsParsingSources;
+	bool									fHasInsertedStrings;			/**< Strings were inserted outside of a source, the tables can't be rebuilt from the sources */
+	sLONG									fCatalogIsStale;				/**< Something was loaded or inserted since fCatalog was compiled (atomic) */
+	sLONG									fTableLookupsBeforeCompile;		/**< After an insert, lookups served by the tables before the catalog is compiled again (atomic) */
+	VLocalizationCatalog*					fCatalog;						/**< Replaced under the write lock, NULL if the lookups must use the tables */
+	VFolder*								fCatalogFolder;
+	bool									fCatalogFolderIsPurged;
 };
 
 END_TOOLBOX_NAMESPACE
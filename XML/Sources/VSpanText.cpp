@@ -1125,6 +1125,9 @@ void ColorToValue(const RGBAColor inColor, VString& outValue)
 
 VSpanTextParser *VSpanTextParser::sInstance = NULL;
 
+//max number of parsed span text models kept for editing methods (the last edited span texts)
+#define kSPAN_TEXT_EDITABLE_DOCUMENTS_MAX	4
+
 #if VERSIONWIN
 float VSpanTextParser::GetSPANFontSizeDPI() const
 {
@@ -1347,7 +1350,7 @@ bool VSpanTextParser::GetStyledText( const VString& inSpanText, VString& outSpan
 		return true;
 	}
 
-	VDocText *doc = VSpanTextParser::Get()->ParseDocument( inSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, inSilentlyTrapParsingErrors); //no need to eval span refs here (and as input range is uniform we need uniform span ref range that is 1 char size)
+	VDocText *doc = _RetainEditableDocumentCopy( inSpanText, inSilentlyTrapParsingErrors); //we modify the document so we need a copy of the cached model
 	if (!doc)
 		return false;
 
@@ -1413,7 +1416,7 @@ bool VSpanTextParser::GetStyledText( const VString& inSpanText, VString& outSpan
 */
 bool VSpanTextParser::ReplaceStyledText( VString& ioSpanText, const VString& inSpanTextOrPlainText, sLONG inStart, sLONG inEnd, bool inTextPlainText, bool inInheritUniformStyle, bool inSilentlyTrapParsingErrors)
 {
-	VDocText *doc = VSpanTextParser::Get()->ParseDocument( ioSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, inSilentlyTrapParsingErrors); //no need to eval span refs here (and as input range is uniform we need uniform span ref range that is 1 char size)
+	VDocText *doc = _TakeEditableDocument( ioSpanText, inSilentlyTrapParsingErrors);
 	if (!doc)
 		return false;
 
@@ -1476,7 +1479,13 @@ bool VSpanTextParser::ReplaceStyledText( VString& ioSpanText, const VString& inS
 	SerializeDocument( doc, ioSpanText);
 
 	ReleaseRefCountable(&para);
-	ReleaseRefCountable(&doc);
+
+	//keep edited model for next edit - only if no style has been applied: 
+	//serializing would normalize the edited style tree, so parsing the serialized text might not give back the same styles
+	if (inTextPlainText)
+		_StoreEditableDocument( ioSpanText, doc);
+	else
+		ReleaseRefCountable(&doc);
 
 	return true;
 }
@@ -1484,7 +1493,7 @@ bool VSpanTextParser::ReplaceStyledText( VString& ioSpanText, const VString& inS
 /** replace 4D expressions references with evaluated plain text & discard 4D expressions references on the passed range */
 bool VSpanTextParser::FreezeExpressions( VDBLanguageContext *inLC, VString& ioSpanText, sLONG inStart, sLONG inEnd, bool inSilentlyTrapParsingErrors)
 {
-	VDocText *doc = VSpanTextParser::Get()->ParseDocument( ioSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, inSilentlyTrapParsingErrors); 
+	VDocText *doc = _TakeEditableDocument( ioSpanText, inSilentlyTrapParsingErrors);
 	if (!doc)
 		return false;
 
@@ -1503,7 +1512,11 @@ bool VSpanTextParser::FreezeExpressions( VDBLanguageContext *inLC, VString& ioSp
 	if (modified)
 		SerializeDocument( doc, ioSpanText);
 
-	ReleaseRefCountable(&doc);
+	//keep model for next edit only if styles have not been modified & if it has been parsed without error
+	if (!modified && inSilentlyTrapParsingErrors)
+		_StoreEditableDocument( ioSpanText, doc);
+	else
+		ReleaseRefCountable(&doc);
 
 	return modified;
 }
@@ -1518,7 +1531,7 @@ sLONG VSpanTextParser::GetReferenceAtRange(
 				VString *outFirstRefSource, VString *outFirstRefValue
 				)
 {
-	VDocText *doc = VSpanTextParser::Get()->ParseDocument( inSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, true); 
+	VDocText *doc = _RetainEditableDocumentCopy( inSpanText, true); //span ref computed value might be modified so we need a copy of the cached model
 	if (!doc)
 		return -1;
 
@@ -1558,7 +1571,7 @@ sLONG VSpanTextParser::GetReferenceAtRange(
 */
 bool VSpanTextParser::ReplaceAndOwnSpanRef( VString& ioSpanText, VDocSpanTextRef* inSpanRef, sLONG inStart, sLONG inEnd, bool inSilentlyTrapParsingErrors)
 {
-	VDocText *doc = VSpanTextParser::Get()->ParseDocument( ioSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, inSilentlyTrapParsingErrors); //no need to eval span refs here (and as input range is uniform we need uniform span ref range that is 1 char size)
+	VDocText *doc = _TakeEditableDocument( ioSpanText, inSilentlyTrapParsingErrors);
 	if (!doc)
 		return false;
 
@@ -1576,6 +1589,7 @@ bool VSpanTextParser::ReplaceAndOwnSpanRef( VString& ioSpanText, VDocSpanTextRef
 	//serialize
 	SerializeDocument( doc, ioSpanText);
 
+	//edited model is not kept: styles have been modified, and the cache would keep the caller span reference alive
 	ReleaseRefCountable(&doc);
 
 	return true;
@@ -1627,6 +1641,128 @@ VDocText *VSpanTextParser::ParseDocument(	const VString& inDocText, const uLONG
 }
 
 
+/** take the parsed model of the passed span text 
+@remarks
+	if the span text has been parsed or produced by a previous edit, the cached model is detached from the cache & returned without parsing again:
+	caller owns the returned document & might modify it (then it should call _StoreEditableDocument with the serialized document)
+
+	models are parsed with the settings used by the span text editing methods:
+	kDOC_VERSION_SPAN4D_1, 72 dpi & span refs not evaluated (as input range is uniform we need uniform span ref range that is 1 char size)
+*/
+VDocText *VSpanTextParser::_TakeEditableDocument( const VString& inSpanText, bool inSilentlyTrapParsingErrors)
+{
+	uLONG hash = inSpanText.GetHashValue();
+	{
+		VTaskLock protect(&fMutexEditableDocuments);
+
+		ListOfEditableDocument::iterator it = fEditableDocuments.begin();
+		for (;it != fEditableDocuments.end(); it++)
+		{
+			if (it->fHash == hash && it->fSpanText.GetLength() == inSpanText.GetLength() && it->fSpanText.EqualToStringRaw( inSpanText))
+			{
+				VDocText *doc = it->fDoc;
+				fEditableDocuments.erase( it);
+				return doc;
+			}
+		}
+	}
+	return ParseDocument( inSpanText, kDOC_VERSION_SPAN4D_1, 72, false, true, inSilentlyTrapParsingErrors);
+}
+
+
+/** return a copy of the cached parsed model of the passed span text (parse it & cache it if not cached yet) */
+VDocText *VSpanTextParser::_RetainEditableDocumentCopy( const VString& inSpanText, bool inSilentlyTrapParsingErrors)
+{
+	VDocText *doc = _TakeEditableDocument( inSpanText, inSilentlyTrapParsingErrors);
+	if (!doc)
+		return NULL;
+
+	//VDocNode copy constructor does not copy node properties so append them to the copy
+	VDocText *docCopy = dynamic_cast<VDocText *>(doc->Clone());
+	xbox_assert(docCopy && docCopy->GetChildCount() == doc->GetChildCount());
+	docCopy->AppendPropsFrom( doc);
+	for (VIndex i = 0; i < doc->GetChildCount(); i++)
+	{
+		VDocNode *child = docCopy->RetainChild( i);
+		child->AppendPropsFrom( doc->GetChild( i), false, true);
+		ReleaseRefCountable(&child);
+	}
+
+	if (inSilentlyTrapParsingErrors)
+		//model is kept only if it has been parsed without error
+		_StoreEditableDocument( inSpanText, doc);
+	else
+		ReleaseRefCountable(&doc);
+
+	return docCopy;
+}
+
+
+/** store model of the passed span text in the cache 
+@remarks
+	model is owned by the cache after the call
+*/
+void VSpanTextParser::_StoreEditableDocument( const VString& inSpanText, VDocText *inDoc)
+{
+	xbox_assert(inDoc);
+
+	if (!_IsParsedTextStable( inDoc))
+	{
+		//parsing the serialized document would not give back the same model
+		ReleaseRefCountable(&inDoc);
+		return;
+	}
+
+	EditableDocument entry;
+	entry.fSpanText = inSpanText;
+	entry.fHash = inSpanText.GetHashValue();
+	entry.fDoc = inDoc;
+
+	VTaskLock protect(&fMutexEditableDocuments);
+
+	fEditableDocuments.push_front( entry);
+	while (fEditableDocuments.size() > kSPAN_TEXT_EDITABLE_DOCUMENTS_MAX)
+	{
+		ReleaseRefCountable(&(fEditableDocuments.back().fDoc));
+		fEditableDocuments.pop_back();
+	}
+}
+
+
+/** return true if parsing again the serialized document would give back the same plain text & styles 
+	(serializing normalizes end of lines & invalid XML chars, and drops empty style ranges) */
+bool VSpanTextParser::_IsParsedTextStable( const VDocText *inDoc)
+{
+	const VString& text = inDoc->GetText();
+	const UniChar *c = text.GetCPointer();
+	const UniChar *end = c+text.GetLength();
+	for (;c < end; c++)
+	{
+		if (*c == 0x0A || *c == 0x0B || !IsXMLChar(*c))
+			return false;
+	}
+	return !_HasEmptyStyleRange( inDoc->GetStyles());
+}
+
+
+/** return true if one of the child styles has an empty range */
+bool VSpanTextParser::_HasEmptyStyleRange( const VTreeTextStyle *inStyles)
+{
+	if (!inStyles)
+		return false;
+
+	for (sLONG i = 1; i <= inStyles->GetChildCount(); i++)
+	{
+		const VTreeTextStyle *child = inStyles->GetNthChild( i);
+		sLONG start, end;
+		child->GetData()->GetRange( start, end);
+		if (start >= end || _HasEmptyStyleRange( child))
+			return true;
+	}
+	return false;
+}
+
+
 /** serialize document (formatting depending on version) 
 @remarks
 	//kDOC_VERSION_SPAN_1 format compatible with v13:
@@ -3601,6 +3737,14 @@ void VSpanTextParser::_SerializeVTextStyleToCSS( const VDocNode *inDocNode, cons
 }
 
 
+VSpanTextParser::~VSpanTextParser()
+{
+	ListOfEditableDocument::iterator it = fEditableDocuments.begin();
+	for (;it != fEditableDocuments.end(); it++)
+		ReleaseRefCountable(&(it->fDoc));
+}
+
+
 VSpanTextParser* VSpanTextParser::Get()
 {
 	if (sInstance == NULL)
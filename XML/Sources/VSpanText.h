@@ -56,6 +56,7 @@ class XTOOLBOX_API VSpanTextParser : public VObject , public ISpanTextParser
 {
 public:
 	VSpanTextParser():VObject() { fDelegateRef = NULL; }
+virtual ~VSpanTextParser();
 
 #if VERSIONWIN
 virtual float GetSPANFontSizeDPI() const;
@@ -289,8 +290,41 @@ void _CloseTagParagraph(VString& ioText, bool inAfterPlainText = true);
 
 void _SerializeParagraphTextAndStyles(	const VDocNode *inDocNode, const VTreeTextStyle *inStyles, const VString& inPlainText, VString &ioText, 
 										const VTextStyle *inStyleInherit = NULL, bool inSkipCharStyles = false);
+
+//editing model cache
+
+/** take the parsed model of the passed span text 
+@remarks
+	if the span text has been parsed or produced by a previous edit, the cached model is detached from the cache & returned without parsing again:
+	caller owns the returned document & might modify it (then it should call _StoreEditableDocument with the serialized document)
+*/
+VDocText *_TakeEditableDocument( const VString& inSpanText, bool inSilentlyTrapParsingErrors);
+
+/** return a copy of the cached parsed model of the passed span text (parse it & cache it if not cached yet) */
+VDocText *_RetainEditableDocumentCopy( const VString& inSpanText, bool inSilentlyTrapParsingErrors);
+
+/** store model of the passed span text in the cache 
+@remarks
+	model is owned by the cache after the call
+*/
+void _StoreEditableDocument( const VString& inSpanText, VDocText *inDoc);
+
+/** return true if parsing again the serialized document would give back the same plain text & styles 
+	(serializing normalizes end of lines & invalid XML chars, and drops empty style ranges) 
+@remarks
+	edited style trees are not normalized like parsed ones so models are only kept after edits which do not apply styles */
+bool _IsParsedTextStable( const VDocText *inDoc);
+static bool _HasEmptyStyleRange( const VTreeTextStyle *inStyles);
  
 private:
+		typedef struct EditableDocument
+		{
+			VString			fSpanText;
+			uLONG			fHash;
+			VDocText*		fDoc;
+		} EditableDocument;
+
+		typedef std::list<EditableDocument>	ListOfEditableDocument;
 static	VSpanTextParser*	sInstance;
 
 		VCriticalSection	fMutexParser;
@@ -299,6 +333,10 @@ static	VSpanTextParser*	sInstance;
 		IDocSpanTextRef*	fDelegateRef;
 
 		bool				fIsOnlyPlainText;
+
+		/** last parsed or edited span text models (most recent first) */
+		VCriticalSection		fMutexEditableDocuments;
+		ListOfEditableDocument	fEditableDocuments;
 };
 
 
@@ -21,6 +21,13 @@
 
 #include <xercesc/dom/DOMEntity.hpp>
 #include <xercesc/dom/DOMNotation.hpp>
+#include <xercesc/sax2/SAX2XMLReader.hpp>
+#include <xercesc/sax2/XMLReaderFactory.hpp>
+#include <xercesc/sax2/DefaultHandler.hpp>
+#include <xercesc/sax2/Attributes.hpp>
+#include <xercesc/sax/InputSource.hpp>
+#include <xercesc/sax/SAXParseException.hpp>
+#include <xercesc/util/BinInputStream.hpp>
 #ifdef XERCES_3_0_1
 #include <xercesc/dom/DOMLSParser.hpp>
 #endif
@@ -1232,6 +1239,1119 @@ static void ParseObject(JsonObject& ioJsonObj, PaserVString& parser, bool inToXH
 		}
 	}
 }
+//////////////////////////////////////////////////////////////////////////
+// Streaming conversion
+//
+// The converters below never hold the whole document: XML is read with a
+// SAX2 reader, JSON with a small pull tokenizer, and the output is written
+// to the destination stream by chunks. They produce and accept the JSON
+// layout of the DOM based routines above.
+//////////////////////////////////////////////////////////////////////////
+
+#ifdef XERCES_3_0_1
+typedef XMLSize_t		XercesSize;
+typedef XMLFilePos		XercesFilePos;
+#else
+typedef unsigned int	XercesSize;
+typedef unsigned int	XercesFilePos;
+#endif
+
+static const VIndex kStreamChunkSize = 32768;	// in UniChars
+
+
+static void AppendJSONEscaped( VString& ioString, const UniChar *inChars, VIndex inLength)
+{
+	// same escapes as FormatToJSONString, other control characters are written as \uXXXX
+	const UniChar *begin = inChars;
+	const UniChar *end = inChars + inLength;
+	for( const UniChar *p = inChars ; p != end ; ++p)
+	{
+		const char *escape = NULL;
+		char buffer[8];
+		switch( *p)
+		{
+			case '\\':	escape = "\\\\"; break;
+			case '/':	escape = "\\/"; break;
+			case '"':	escape = "\\\""; break;
+			case 0x0A:	escape = "\\n"; break;
+			case 0x0D:	escape = "\\r"; break;
+			case 0x09:	escape = "\\t"; break;
+			default:
+				if (*p < 0x20)
+				{
+					sprintf( buffer, "\\u%04x", (int) *p);
+					escape = buffer;
+				}
+				break;
+		}
+		if (escape != NULL)
+		{
+			if (p > begin)
+				ioString.AppendUniChars( begin, (VIndex) (p - begin));
+			ioString.AppendCString( escape);
+			begin = p + 1;
+		}
+	}
+	if (end > begin)
+		ioString.AppendUniChars( begin, (VIndex) (end - begin));
+}
+
+
+static void AppendJSONEscaped( VString& ioString, const XMLCh *inChars)
+{
+	xbox_assert(sizeof(XMLCh) == sizeof(UniChar)); //just ensure Xerces uses UTF_16
+	if (inChars != NULL)
+		AppendJSONEscaped( ioString, (const UniChar *) inChars, (VIndex) xercesc::XMLString::stringLen( inChars));
+}
+
+
+static void AppendXMLEscaped( VString& ioString, const UniChar *inChars, VIndex inLength, bool inForAttribute)
+{
+	const UniChar *begin = inChars;
+	const UniChar *end = inChars + inLength;
+	for( const UniChar *p = inChars ; p != end ; ++p)
+	{
+		const char *escape = NULL;
+		switch( *p)
+		{
+			case '&':	escape = "&amp;"; break;
+			case '<':	escape = "&lt;"; break;
+			case '>':	escape = "&gt;"; break;
+			case '"':	escape = inForAttribute ? "&quot;" : NULL; break;
+		}
+		if (escape != NULL)
+		{
+			if (p > begin)
+				ioString.AppendUniChars( begin, (VIndex) (p - begin));
+			ioString.AppendCString( escape);
+			begin = p + 1;
+		}
+	}
+	if (end > begin)
+		ioString.AppendUniChars( begin, (VIndex) (end - begin));
+}
+
+
+// Buffers text and writes it to the stream by chunks, using the stream charset.
+class VTextStreamWriter
+{
+public:
+	VTextStreamWriter( VStream *inStream) : fStream( inStream), fError( VE_OK), fLastChar( 0)	{}
+	~VTextStreamWriter()	{ Flush(); }
+
+	void		Append( const char *inCString)									{ fBuffer.AppendCString( inCString); _Appended(); }
+	void		Append( const VString& inString)								{ fBuffer.AppendString( inString); _Appended(); }
+	void		Append( UniChar inChar)											{ fBuffer.AppendUniChar( inChar); _Appended(); }
+	void		AppendJSON( const XMLCh *inChars)								{ AppendJSONEscaped( fBuffer, inChars); _Appended(); }
+	void		AppendJSON( const XMLCh *inChars, XercesSize inLength)			{ AppendJSONEscaped( fBuffer, (const UniChar *) inChars, (VIndex) inLength); _Appended(); }
+	void		AppendXML( const VString& inString, bool inForAttribute)		{ AppendXMLEscaped( fBuffer, inString.GetCPointer(), inString.GetLength(), inForAttribute); _Appended(); }
+
+	UniChar		GetLastChar() const		{ return fLastChar; }
+
+	VError		Flush()
+	{
+		if (!fBuffer.IsEmpty())
+		{
+			if (fError == VE_OK)
+				fError = fStream->PutText( fBuffer);
+			fBuffer.Clear();
+		}
+		return fError;
+	}
+
+private:
+	void		_Appended()
+	{
+		if (!fBuffer.IsEmpty())
+			fLastChar = fBuffer[fBuffer.GetLength() - 1];
+		if (fBuffer.GetLength() >= kStreamChunkSize)
+			Flush();
+	}
+
+	VStream*	fStream;
+	VString		fBuffer;
+	VError		fError;
+	UniChar		fLastChar;
+};
+
+
+// Feeds xerces with the bytes of a VStream opened for reading.
+class VStreamBinInputStream : public xercesc::BinInputStream
+{
+public:
+	VStreamBinInputStream( VStream *inStream) : fStream( inStream), fPosition( 0)	{}
+
+	virtual	XercesFilePos	curPos() const		{ return fPosition; }
+
+	virtual	XercesSize		readBytes( XMLByte* const outBuffer, const XercesSize inMaxToRead)
+	{
+		StErrorContextInstaller filter( VE_STREAM_EOF, VE_OK);
+		VSize read = 0;
+		fStream->GetData( outBuffer, (VSize) inMaxToRead, &read);
+		fPosition += (XercesFilePos) read;
+		return (XercesSize) read;
+	}
+
+#ifdef XERCES_3_0_1
+	virtual	const XMLCh*	getContentType() const	{ return NULL; }
+#endif
+
+private:
+	VStream*		fStream;
+	XercesFilePos	fPosition;
+};
+
+
+class VStreamInputSource : public xercesc::InputSource
+{
+public:
+	VStreamInputSource( VStream *inStream) : fStream( inStream)	{}
+
+	virtual	xercesc::BinInputStream*	makeStream() const	{ return new VStreamBinInputStream( fStream); }
+
+private:
+	VStream*	fStream;
+};
+
+
+// Writes the JSON description of the document as SAX events come.
+class VXMLToJsonHandler : public xercesc::DefaultHandler
+{
+public:
+	VXMLToJsonHandler( VTextStreamWriter& inWriter) : fWriter( inWriter), fInDTD( false), fInText( false), fHasError( false), fLineNumber( 0)	{}
+
+	// ContentHandler
+	virtual	void	startDocument();
+	virtual	void	endDocument();
+	virtual	void	startElement( const XMLCh* const inURI, const XMLCh* const inLocalName, const XMLCh* const inQName, const xercesc::Attributes& inAttributes);
+	virtual	void	endElement( const XMLCh* const inURI, const XMLCh* const inLocalName, const XMLCh* const inQName);
+	virtual	void	characters( const XMLCh* const inChars, const XercesSize inLength);
+	virtual	void	ignorableWhitespace( const XMLCh* const inChars, const XercesSize inLength)	{ characters( inChars, inLength); }
+	virtual	void	processingInstruction( const XMLCh* const inTarget, const XMLCh* const inData);
+
+	// LexicalHandler
+	virtual	void	comment( const XMLCh* const inChars, const XercesSize inLength);
+	virtual	void	startCDATA();
+	virtual	void	endCDATA();
+	virtual	void	startDTD( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId);
+	virtual	void	endDTD();
+
+	// DTDHandler & DeclHandler
+	virtual	void	notationDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId);
+	virtual	void	unparsedEntityDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId, const XMLCh* const inNotationName);
+	virtual	void	internalEntityDecl( const XMLCh* const inName, const XMLCh* const inValue);
+	virtual	void	externalEntityDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId);
+
+	// ErrorHandler
+	virtual	void	error( const xercesc::SAXParseException& inException)			{ _SetError( inException); }
+	virtual	void	fatalError( const xercesc::SAXParseException& inException)		{ _SetError( inException); }
+
+			bool	HasError() const	{ return fHasError; }
+			void	GetErrorMessage( VString& outErrorMessage, sLONG& outLineNumber) const	{ outErrorMessage = fErrorMessage; outLineNumber = fLineNumber; }
+
+private:
+			void	_StartChild();
+			void	_OpenText( const char *inNodeType);
+			void	_CloseText();
+			void	_AddEntity( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId, const XMLCh* const inNotationName);
+			void	_SetError( const xercesc::SAXParseException& inException);
+
+	VTextStreamWriter&	fWriter;
+	std::vector<char>	fHasChildren;	// one per open node, the document included
+	bool				fInDTD;
+	bool				fInText;		// a text or cdata node is open
+	VString				fEntities;		// DTD declarations, written when the DTD ends
+	VString				fNotations;
+	bool				fHasError;
+	VString				fErrorMessage;
+	sLONG				fLineNumber;
+};
+
+
+void VXMLToJsonHandler::startDocument()
+{
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_ROOT);
+	fWriter.Append( "\":[");
+	fHasChildren.push_back( false);
+}
+
+
+void VXMLToJsonHandler::endDocument()
+{
+	_CloseText();
+	if (!fHasChildren.empty())
+	{
+		if (fHasChildren.back())
+			fWriter.Append( "]");
+		fHasChildren.pop_back();
+	}
+	fWriter.Append( "}");
+}
+
+
+void VXMLToJsonHandler::startElement( const XMLCh* const inURI, const XMLCh* const inLocalName, const XMLCh* const inQName, const xercesc::Attributes& inAttributes)
+{
+	_StartChild();
+
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_TYPE);
+	fWriter.Append( "\":");
+	fWriter.Append( DOM_ELEMENT);
+	fWriter.Append( ",\"");
+	fWriter.Append( DOM_NAME);
+	fWriter.Append( "\":\"");
+	fWriter.AppendJSON( inQName);
+	fWriter.Append( "\"");
+
+	// same order as the DOM converter
+	XercesSize count = inAttributes.getLength();
+	for( XercesSize index = 0 ; index < count ; ++index)
+	{
+		XercesSize attribute = count - 1 - index;
+		if (index == 0)
+		{
+			fWriter.Append( ",\"");
+			fWriter.Append( DOM_ATTRIBUT);
+			fWriter.Append( "\":{\"");
+		}
+		else
+		{
+			fWriter.Append( ",\"");
+		}
+		fWriter.AppendJSON( inAttributes.getQName( attribute));
+		fWriter.Append( "\":\"");
+		fWriter.AppendJSON( inAttributes.getValue( attribute));
+		fWriter.Append( "\"");
+	}
+	if (count > 0)
+		fWriter.Append( "}");
+
+	fHasChildren.push_back( false);
+}
+
+
+void VXMLToJsonHandler::endElement( const XMLCh* const inURI, const XMLCh* const inLocalName, const XMLCh* const inQName)
+{
+	_CloseText();
+	if (fHasChildren.back())
+		fWriter.Append( "]");
+	fHasChildren.pop_back();
+	fWriter.Append( "}");
+}
+
+
+void VXMLToJsonHandler::characters( const XMLCh* const inChars, const XercesSize inLength)
+{
+	if (fInDTD)
+		return;
+
+	// adjacent chunks belong to the same text node
+	if (!fInText)
+		_OpenText( DOM_TEXT);
+	fWriter.AppendJSON( inChars, inLength);
+}
+
+
+void VXMLToJsonHandler::processingInstruction( const XMLCh* const inTarget, const XMLCh* const inData)
+{
+	if (fInDTD || inTarget == NULL || inData == NULL)
+		return;
+
+	_StartChild();
+
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_TYPE);
+	fWriter.Append( "\":");
+	fWriter.Append( DOM_PROCESSING_INSTRUCTION_NODE);
+	fWriter.Append( ",\"");
+	fWriter.Append( DOM_TARGET);
+	fWriter.Append( "\":\"");
+	fWriter.AppendJSON( inTarget);
+	fWriter.Append( "\",\"");
+	fWriter.Append( DOM_DATA);
+	fWriter.Append( "\":\"");
+	fWriter.AppendJSON( inData);
+	fWriter.Append( "\"}");
+}
+
+
+void VXMLToJsonHandler::comment( const XMLCh* const inChars, const XercesSize inLength)
+{
+	if (fInDTD)
+		return;
+
+	_StartChild();
+
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_TYPE);
+	fWriter.Append( "\":");
+	fWriter.Append( DOM_COMMENT);
+	fWriter.Append( ",\"");
+	fWriter.Append( DOM_NODE_VALUE);
+	fWriter.Append( "\":\"");
+	fWriter.AppendJSON( inChars, inLength);
+	fWriter.Append( "\"}");
+}
+
+
+void VXMLToJsonHandler::startCDATA()
+{
+	_OpenText( DOM_CDATA);
+}
+
+
+void VXMLToJsonHandler::endCDATA()
+{
+	_CloseText();
+}
+
+
+void VXMLToJsonHandler::startDTD( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId)
+{
+	_CloseText();
+
+	// like the DOM converter, the doctype is not wrapped in a childNodes member
+	if (!fHasChildren.empty())
+	{
+		if (fHasChildren.back())
+			fWriter.Append( ",");
+		fHasChildren.back() = true;
+	}
+
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_TYPE);
+	fWriter.Append( "\":");
+	fWriter.Append( DOM_DOCUMENT_TYPE);
+	fWriter.Append( ",\"");
+	fWriter.Append( DOM_DOCUMENT_TYPE_NAME);
+	fWriter.Append( "\":\"");
+	fWriter.AppendJSON( inName);
+	fWriter.Append( "\"");
+
+	if (inPublicId != NULL && *inPublicId != 0)
+	{
+		fWriter.Append( ",\"");
+		fWriter.Append( DOM_PUBLIC_ID);
+		fWriter.Append( "\":\"");
+		fWriter.AppendJSON( inPublicId);
+		fWriter.Append( "\"");
+	}
+
+	if (inSystemId != NULL && *inSystemId != 0)
+	{
+		fWriter.Append( ",\"");
+		fWriter.Append( DOM_SYSTEM_ID);
+		fWriter.Append( "\":\"");
+		fWriter.AppendJSON( inSystemId);
+		fWriter.Append( "\"");
+	}
+
+	fEntities.Clear();
+	fNotations.Clear();
+	fInDTD = true;
+}
+
+
+void VXMLToJsonHandler::endDTD()
+{
+	if (!fEntities.IsEmpty())
+	{
+		fWriter.Append( ",\"");
+		fWriter.Append( DOM_ENTITIES);
+		fWriter.Append( "\":[");
+		fWriter.Append( fEntities);
+		fWriter.Append( "]");
+	}
+
+	if (!fNotations.IsEmpty())
+	{
+		fWriter.Append( ",\"");
+		fWriter.Append( DOM_NOTATIONS);
+		fWriter.Append( "\":[");
+		fWriter.Append( fNotations);
+		fWriter.Append( "]");
+	}
+
+	fWriter.Append( "}");
+
+	fEntities.Clear();
+	fNotations.Clear();
+	fInDTD = false;
+}
+
+
+void VXMLToJsonHandler::notationDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId)
+{
+	if (!fNotations.IsEmpty())
+		fNotations += ",";
+
+	fNotations += "{\"";
+	fNotations += DOM_TYPE;
+	fNotations += "\":";
+	fNotations += DOM_NOTATION;
+	fNotations += ",\"";
+	fNotations += DOM_PUBLIC_ID;
+	fNotations += "\":\"";
+	AppendJSONEscaped( fNotations, inPublicId);
+	fNotations += "\",\"";
+	fNotations += DOM_SYSTEM_ID;
+	fNotations += "\":\"";
+	AppendJSONEscaped( fNotations, inSystemId);
+	fNotations += "\"}";
+}
+
+
+void VXMLToJsonHandler::unparsedEntityDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId, const XMLCh* const inNotationName)
+{
+	_AddEntity( inName, inPublicId, inSystemId, inNotationName);
+}
+
+
+void VXMLToJsonHandler::internalEntityDecl( const XMLCh* const inName, const XMLCh* const inValue)
+{
+	_AddEntity( inName, NULL, NULL, NULL);
+}
+
+
+void VXMLToJsonHandler::externalEntityDecl( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId)
+{
+	_AddEntity( inName, inPublicId, inSystemId, NULL);
+}
+
+
+void VXMLToJsonHandler::_AddEntity( const XMLCh* const inName, const XMLCh* const inPublicId, const XMLCh* const inSystemId, const XMLCh* const inNotationName)
+{
+	// parameter entities are not part of the DOM entities list
+	if (inName == NULL || *inName == '%')
+		return;
+
+	if (!fEntities.IsEmpty())
+		fEntities += ",";
+
+	fEntities += "{\"";
+	fEntities += DOM_TYPE;
+	fEntities += "\":";
+	fEntities += DOM_ENTITY;
+	fEntities += ",\"";
+	fEntities += DOM_NAME;
+	fEntities += "\":\"";
+	AppendJSONEscaped( fEntities, inName);
+	fEntities += "\",\"";
+	fEntities += DOM_PUBLIC_ID;
+	fEntities += "\":\"";
+	AppendJSONEscaped( fEntities, inPublicId);
+	fEntities += "\",\"";
+	fEntities += DOM_SYSTEM_ID;
+	fEntities += "\":\"";
+	AppendJSONEscaped( fEntities, inSystemId);
+	fEntities += "\",\"";
+	fEntities += DOM_NOTATION_NAME;
+	fEntities += "\":\"";
+	AppendJSONEscaped( fEntities, inNotationName);
+	fEntities += "\"}";
+}
+
+
+void VXMLToJsonHandler::_StartChild()
+{
+	_CloseText();
+
+	if (fHasChildren.empty())
+		return;
+
+	if (!fHasChildren.back())
+	{
+		// the document object has no member before its children
+		fWriter.Append( (fHasChildren.size() == 1) ? "\"" : ",\"");
+		fWriter.Append( DOM_CHILDREN);
+		fWriter.Append( "\":[");
+		fHasChildren.back() = true;
+	}
+	else
+	{
+		fWriter.Append( ",");
+	}
+}
+
+
+void VXMLToJsonHandler::_OpenText( const char *inNodeType)
+{
+	_StartChild();
+
+	fWriter.Append( "{\"");
+	fWriter.Append( DOM_TYPE);
+	fWriter.Append( "\":");
+	fWriter.Append( inNodeType);
+	fWriter.Append( ",\"");
+	fWriter.Append( DOM_NODE_VALUE);
+	fWriter.Append( "\":\"");
+	fInText = true;
+}
+
+
+void VXMLToJsonHandler::_CloseText()
+{
+	if (fInText)
+	{
+		fWriter.Append( "\"}");
+		fInText = false;
+	}
+}
+
+
+void VXMLToJsonHandler::_SetError( const xercesc::SAXParseException& inException)
+{
+	// keep the first one, like DOMXPathLightErrorHandler
+	if (fHasError)
+		return;
+
+	fHasError = true;
+	fLineNumber = (sLONG) inException.getLineNumber();
+
+	VString lineNumber, columnNumber;
+	lineNumber.FromLong( fLineNumber);
+	columnNumber.FromLong( (sLONG) inException.getColumnNumber());
+
+	fErrorMessage.FromUniCString( inException.getMessage());
+	fErrorMessage += " [line: ";
+	fErrorMessage += lineNumber;
+	fErrorMessage += ", column: ";
+	fErrorMessage += columnNumber;
+	fErrorMessage += "]";
+}
+
+
+// Pull tokenizer reading JSON text from a VStream by chunks.
+// After a jsonString token, the string contents must be consumed with ReadStringChunk, ReadString or SkipString.
+class VJSONStreamTokenizer
+{
+public:
+	typedef enum {
+		jsonNone = 0,
+		jsonBeginObject,
+		jsonEndObject,
+		jsonBeginArray,
+		jsonEndArray,
+		jsonSeparator,
+		jsonAssigne,
+		jsonString,
+		jsonLiteral		// number, true, false or null
+	} JsonToken;
+
+	VJSONStreamTokenizer( VStream *inStream) : fStream( inStream), fPos( 0), fStringDone( true), fMalformed( false)	{}
+
+			JsonToken	GetNextToken( VString *outLiteral = NULL);
+			bool		ReadStringChunk( VString& outChunk);
+			void		ReadString( VString& outString);
+			void		SkipString();
+			void		SkipValue( JsonToken inToken);
+			bool		IsMalformed() const		{ return fMalformed; }
+
+private:
+			bool		_Fill();
+			bool		_GetNextChar( UniChar& outChar);
+
+	VStream*	fStream;
+	VString		fChunk;
+	VIndex		fPos;
+	bool		fStringDone;
+	bool		fMalformed;
+};
+
+
+bool VJSONStreamTokenizer::_Fill()
+{
+	if (fPos < fChunk.GetLength())
+		return true;
+
+	StErrorContextInstaller filter( VE_STREAM_EOF, VE_OK);
+	fChunk.Clear();
+	fPos = 0;
+	fStream->GetText( fChunk, kStreamChunkSize);
+	return !fChunk.IsEmpty();
+}
+
+
+bool VJSONStreamTokenizer::_GetNextChar( UniChar& outChar)
+{
+	if (!_Fill())
+		return false;
+	outChar = fChunk[fPos++];
+	return true;
+}
+
+
+VJSONStreamTokenizer::JsonToken VJSONStreamTokenizer::GetNextToken( VString *outLiteral)
+{
+	if (!fStringDone)
+		SkipString();
+
+	UniChar c = 0;
+	do
+	{
+		if (!_GetNextChar( c))
+			return jsonNone;
+	} while( c == ' ' || c == 0x09 || c == 0x0A || c == 0x0D);
+
+	switch( c)
+	{
+		case '{':	return jsonBeginObject;
+		case '}':	return jsonEndObject;
+		case '[':	return jsonBeginArray;
+		case ']':	return jsonEndArray;
+		case ',':	return jsonSeparator;
+		case ':':	return jsonAssigne;
+		case '"':	fStringDone = false; return jsonString;
+	}
+
+	if (outLiteral != NULL)
+		outLiteral->Clear();
+
+	// a literal ends with any structural character or space
+	for( ;;)
+	{
+		if (outLiteral != NULL)
+			outLiteral->AppendUniChar( c);
+
+		if (!_Fill())
+			break;
+		c = fChunk[fPos];
+		if (c == ',' || c == '}' || c == ']' || c == ':' || c == ' ' || c == 0x09 || c == 0x0A || c == 0x0D)
+			break;
+		++fPos;
+	}
+	return jsonLiteral;
+}
+
+
+bool VJSONStreamTokenizer::ReadStringChunk( VString& outChunk)
+{
+	outChunk.Clear();
+
+	while( !fStringDone && (outChunk.GetLength() < kStreamChunkSize))
+	{
+		if (!_Fill())
+		{
+			// unterminated string
+			fMalformed = true;
+			fStringDone = true;
+			break;
+		}
+
+		const UniChar *begin = fChunk.GetCPointer() + fPos;
+		const UniChar *end = fChunk.GetCPointer() + fChunk.GetLength();
+		const UniChar *p = begin;
+		while( p != end && *p != '"' && *p != '\\')
+			++p;
+
+		outChunk.AppendUniChars( begin, (VIndex) (p - begin));
+		fPos += (VIndex) (p - begin);
+
+		if (p == end)
+			continue;
+
+		++fPos;
+		if (*p == '"')
+		{
+			fStringDone = true;
+			break;
+		}
+
+		UniChar c = 0;
+		if (!_GetNextChar( c))
+			continue;
+
+		switch( c)
+		{
+			case 'n':	c = 0x0A; break;
+			case 'r':	c = 0x0D; break;
+			case 't':	c = 0x09; break;
+			case 'b':	c = 0x08; break;
+			case 'f':	c = 0x0C; break;
+			case 'u':
+				{
+					UniChar value = 0;
+					for( sLONG i = 0 ; i < 4 ; ++i)
+					{
+						UniChar digit = 0;
+						if (!_GetNextChar( digit))
+							break;
+						value <<= 4;
+						if (digit >= '0' && digit <= '9')
+							value |= digit - '0';
+						else if (digit >= 'a' && digit <= 'f')
+							value |= digit - 'a' + 10;
+						else if (digit >= 'A' && digit <= 'F')
+							value |= digit - 'A' + 10;
+						else
+							fMalformed = true;
+					}
+					c = value;
+					break;
+				}
+			// '"', '\\' and '/' stand for themselves
+		}
+		outChunk.AppendUniChar( c);
+	}
+
+	return !outChunk.IsEmpty();
+}
+
+
+void VJSONStreamTokenizer::ReadString( VString& outString)
+{
+	VString chunk;
+	outString.Clear();
+	while( ReadStringChunk( chunk))
+		outString += chunk;
+}
+
+
+void VJSONStreamTokenizer::SkipString()
+{
+	VString chunk;
+	while( ReadStringChunk( chunk))
+		;
+}
+
+
+void VJSONStreamTokenizer::SkipValue( JsonToken inToken)
+{
+	if (inToken == jsonString)
+	{
+		SkipString();
+	}
+	else if (inToken == jsonBeginObject || inToken == jsonBeginArray)
+	{
+		sLONG depth = 1;
+		while( depth > 0)
+		{
+			JsonToken token = GetNextToken();
+			if (token == jsonNone)
+			{
+				fMalformed = true;
+				break;
+			}
+			else if (token == jsonBeginObject || token == jsonBeginArray)
+				++depth;
+			else if (token == jsonEndObject || token == jsonEndArray)
+				--depth;
+		}
+	}
+}
+
+
+// Writes XML while the JSON description is read.
+// Like the producer above, nodeType and nodeName must come before the other members of a node.
+class VJsonToXMLConverter
+{
+public:
+	VJsonToXMLConverter( VJSONStreamTokenizer& inTokenizer, VTextStreamWriter& inWriter, bool inToXHTML, bool inWithCR)
+		: fTokenizer( inTokenizer), fWriter( inWriter), fToXHTML( inToXHTML), fWithCR( inWithCR)	{}
+
+			VError		ConvertDocument();
+
+private:
+			bool		_ConvertNode();
+			bool		_ReadAttributes( VString& outAttributes);
+			bool		_IsEmptyXHTMLElement( const VString& inName) const;
+
+	VJSONStreamTokenizer&	fTokenizer;
+	VTextStreamWriter&		fWriter;
+	bool					fToXHTML;
+	bool					fWithCR;
+};
+
+
+VError VJsonToXMLConverter::ConvertDocument()
+{
+	VString key;
+
+	if (fTokenizer.GetNextToken() != VJSONStreamTokenizer::jsonBeginObject || fTokenizer.GetNextToken() != VJSONStreamTokenizer::jsonString)
+		return VE_MALFORMED_JSON_DESCRIPTION;
+
+	fTokenizer.ReadString( key);
+	if (key != DOM_ROOT)
+		return VE_MALFORMED_JSON_DESCRIPTION;	// not a document description
+
+	// the document layout is loose (see XMLNodeToJson), so every object found below it is a node
+	sLONG depth = 1;
+	while( depth > 0)
+	{
+		VJSONStreamTokenizer::JsonToken token = fTokenizer.GetNextToken();
+		switch( token)
+		{
+			case VJSONStreamTokenizer::jsonNone:
+				depth = 0;
+				break;
+
+			case VJSONStreamTokenizer::jsonBeginObject:
+				if (!_ConvertNode())
+					return VE_MALFORMED_JSON_DESCRIPTION;
+				break;
+
+			case VJSONStreamTokenizer::jsonBeginArray:
+				++depth;
+				break;
+
+			case VJSONStreamTokenizer::jsonEndArray:
+			case VJSONStreamTokenizer::jsonEndObject:
+				--depth;
+				break;
+
+			default:
+				fTokenizer.SkipValue( token);
+				break;
+		}
+	}
+
+	return fTokenizer.IsMalformed() ? VE_MALFORMED_JSON_DESCRIPTION : VE_OK;
+}
+
+
+bool VJsonToXMLConverter::_ConvertNode()
+{
+	VString type, name, attributes, value, target, data, docName, publicId, systemId;
+	bool hasChildren = false;
+	bool valueWritten = false;
+
+	for( ;;)
+	{
+		VJSONStreamTokenizer::JsonToken token = fTokenizer.GetNextToken();
+		if (token == VJSONStreamTokenizer::jsonEndObject)
+			break;
+		if (token == VJSONStreamTokenizer::jsonNone)
+			return false;
+		if (token == VJSONStreamTokenizer::jsonSeparator)
+			continue;
+		if (token != VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.SkipValue( token);
+			continue;
+		}
+
+		VString key;
+		fTokenizer.ReadString( key);
+		if (fTokenizer.GetNextToken() != VJSONStreamTokenizer::jsonAssigne)
+			return false;
+
+		VString literal;
+		VJSONStreamTokenizer::JsonToken valueToken = fTokenizer.GetNextToken( &literal);
+
+		if (key == DOM_TYPE && valueToken == VJSONStreamTokenizer::jsonLiteral)
+		{
+			type = literal;
+		}
+		else if (key == DOM_NAME && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( name);
+		}
+		else if (key == DOM_ATTRIBUT && valueToken == VJSONStreamTokenizer::jsonBeginObject)
+		{
+			if (!_ReadAttributes( attributes))
+				return false;
+		}
+		else if (key == DOM_CHILDREN && valueToken == VJSONStreamTokenizer::jsonBeginArray && type == DOM_ELEMENT && !name.IsEmpty())
+		{
+			for( ;;)
+			{
+				VJSONStreamTokenizer::JsonToken child = fTokenizer.GetNextToken();
+				if (child == VJSONStreamTokenizer::jsonEndArray)
+					break;
+				if (child == VJSONStreamTokenizer::jsonNone)
+					return false;
+				if (child == VJSONStreamTokenizer::jsonBeginObject)
+				{
+					if (!hasChildren)
+					{
+						fWriter.Append( "<");
+						fWriter.Append( name);
+						fWriter.Append( attributes);
+						fWriter.Append( ">");
+						hasChildren = true;
+					}
+					if (!_ConvertNode())
+						return false;
+				}
+				else
+				{
+					fTokenizer.SkipValue( child);
+				}
+			}
+		}
+		else if (key == DOM_NODE_VALUE && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			if (type == DOM_TEXT || type == DOM_CDATA || type == DOM_COMMENT)
+			{
+				// written as it is read : text nodes may be huge
+				bool isText = (type == DOM_TEXT);
+				fWriter.Append( (type == DOM_CDATA) ? "<![CDATA[" : (type == DOM_COMMENT) ? "<!--" : "");
+				VString chunk;
+				while( fTokenizer.ReadStringChunk( chunk))
+				{
+					if (isText)
+						fWriter.AppendXML( chunk, false);
+					else
+						fWriter.Append( chunk);
+				}
+				fWriter.Append( (type == DOM_CDATA) ? "]]>" : (type == DOM_COMMENT) ? "-->" : "");
+				valueWritten = true;
+			}
+			else
+			{
+				fTokenizer.ReadString( value);
+			}
+		}
+		else if (key == DOM_TARGET && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( target);
+		}
+		else if (key == DOM_DATA && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( data);
+		}
+		else if (key == DOM_DOCUMENT_TYPE_NAME && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( docName);
+		}
+		else if (key == DOM_PUBLIC_ID && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( publicId);
+		}
+		else if (key == DOM_SYSTEM_ID && valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( systemId);
+		}
+		else
+		{
+			fTokenizer.SkipValue( valueToken);
+		}
+	}
+
+	if (type == DOM_ELEMENT)
+	{
+		if (hasChildren)
+		{
+			fWriter.Append( "</");
+			fWriter.Append( name);
+			fWriter.Append( ">");
+		}
+		else
+		{
+			fWriter.Append( "<");
+			fWriter.Append( name);
+			fWriter.Append( attributes);
+			if (fToXHTML && !_IsEmptyXHTMLElement( name))
+			{
+				fWriter.Append( "></");
+				fWriter.Append( name);
+				fWriter.Append( ">");
+			}
+			else
+			{
+				fWriter.Append( "/>");
+			}
+		}
+	}
+	else if (!valueWritten && (type == DOM_TEXT || type == DOM_CDATA || type == DOM_COMMENT))
+	{
+		if (type == DOM_TEXT)
+		{
+			fWriter.AppendXML( value, false);
+		}
+		else
+		{
+			fWriter.Append( (type == DOM_CDATA) ? "<![CDATA[" : "<!--");
+			fWriter.Append( value);
+			fWriter.Append( (type == DOM_CDATA) ? "]]>" : "-->");
+		}
+	}
+	else if (type == DOM_PROCESSING_INSTRUCTION_NODE)
+	{
+		fWriter.Append( "<?");
+		fWriter.Append( target);
+		fWriter.Append( " ");
+		fWriter.Append( data);
+		fWriter.Append( "?>");
+	}
+	else if (type == DOM_DOCUMENT_TYPE)
+	{
+		fWriter.Append( "<!DOCTYPE ");
+		fWriter.Append( docName);
+		if (!publicId.IsEmpty())
+		{
+			fWriter.Append( " PUBLIC \"");
+			fWriter.Append( publicId);
+			fWriter.Append( "\"");
+			if (!systemId.IsEmpty())
+			{
+				fWriter.Append( " \"");
+				fWriter.Append( systemId);
+				fWriter.Append( "\"");
+			}
+		}
+		else if (!systemId.IsEmpty())
+		{
+			fWriter.Append( " SYSTEM \"");
+			fWriter.Append( systemId);
+			fWriter.Append( "\"");
+		}
+		fWriter.Append( ">");
+	}
+
+	if (fWithCR && fWriter.GetLastChar() == '>')
+		fWriter.Append( (UniChar) 13);
+
+	return true;
+}
+
+
+bool VJsonToXMLConverter::_ReadAttributes( VString& outAttributes)
+{
+	VString key, value;
+	for( ;;)
+	{
+		VJSONStreamTokenizer::JsonToken token = fTokenizer.GetNextToken();
+		if (token == VJSONStreamTokenizer::jsonEndObject)
+			return true;
+		if (token == VJSONStreamTokenizer::jsonNone)
+			return false;
+		if (token != VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.SkipValue( token);
+			continue;
+		}
+
+		fTokenizer.ReadString( key);
+		if (fTokenizer.GetNextToken() != VJSONStreamTokenizer::jsonAssigne)
+			return false;
+
+		VJSONStreamTokenizer::JsonToken valueToken = fTokenizer.GetNextToken();
+		if (valueToken == VJSONStreamTokenizer::jsonString)
+		{
+			fTokenizer.ReadString( value);
+			outAttributes += " ";
+			outAttributes += key;
+			outAttributes += "=\"";
+			AppendXMLEscaped( outAttributes, value.GetCPointer(), value.GetLength(), true);
+			outAttributes += "\"";
+		}
+		else
+		{
+			fTokenizer.SkipValue( valueToken);
+		}
+	}
+}
+
+
+bool VJsonToXMLConverter::_IsEmptyXHTMLElement( const VString& inName) const
+{
+	// HTML elements that must be written <elem/>, see JsonObject::GetXml
+	return inName == "area" || inName == "br" || inName == "hr" || inName == "img" || inName == "input" || inName == "link" || inName == "meta" || inName == "param";
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
@@ -1342,4 +2462,69 @@ VError VXMLJsonUtility::XMLNodeToJson(VXMLDOMNodeRef inNode, VString& outJson )
 	return err;
 }
 
+VError VXMLJsonUtility::XMLToJson( VStream *inXML, VStream *outJson, VString& outErrorMessage, sLONG& outLineNumber)
+{
+	if (inXML == NULL || outJson == NULL)
+		return VE_INVALID_PARAMETER;
+
+	StErrorContextInstaller errContext;
+
+	VTextStreamWriter writer( outJson);
+	VXMLToJsonHandler handler( writer);
+	xercesc::SAX2XMLReader *reader = NULL;
+	bool ok = false;
+
+	try
+	{
+		// same settings as VXmlPrefs::InitFromXml without DTD verification
+		reader = xercesc::XMLReaderFactory::createXMLReader();
+		reader->setFeature( xercesc::XMLUni::fgSAX2CoreNameSpaces, true);
+		reader->setFeature( xercesc::XMLUni::fgSAX2CoreNameSpacePrefixes, true);	// keep xmlns attributes
+		reader->setFeature( xercesc::XMLUni::fgSAX2CoreValidation, false);
+		reader->setFeature( xercesc::XMLUni::fgXercesLoadExternalDTD, false);
+
+		reader->setContentHandler( &handler);
+		reader->setLexicalHandler( &handler);
+		reader->setDTDHandler( &handler);
+		reader->setDeclarationHandler( &handler);
+		reader->setErrorHandler( &handler);
+
+		VStreamInputSource source( inXML);
+		reader->parse( source);
+		ok = !handler.HasError();
+	}
+	catch (...)
+	{
+		//	just avoid crashing...
+		;
+	}
+
+	delete reader;
+
+	if (handler.HasError())
+		handler.GetErrorMessage( outErrorMessage, outLineNumber);
+
+	VError err = writer.Flush();
+	if (err == VE_OK)
+		err = errContext.GetLastError();
+	if (err == VE_OK && (!ok))
+		err = XBOX::VE_XML_ParsingError;
+	return err;
+}
+
+VError VXMLJsonUtility::JsonToXML( VStream *inJson, VStream *outXML, bool inToXHTML, bool inWithCR)
+{
+	if (inJson == NULL || outXML == NULL)
+		return VE_INVALID_PARAMETER;
+
+	VJSONStreamTokenizer tokenizer( inJson);
+	VTextStreamWriter writer( outXML);
+	VJsonToXMLConverter converter( tokenizer, writer, inToXHTML, inWithCR);
+
+	VError err = converter.ConvertDocument();
+	VError writeErr = writer.Flush();
+
+	return (err != VE_OK) ? err : writeErr;
+}
+
 END_TOOLBOX_NAMESPACE
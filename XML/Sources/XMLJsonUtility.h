@@ -31,6 +31,12 @@ public:
 	static VError XMLNodeToJson(VXMLDOMNodeRef inNode, VString& outJson);
 	static VError JsonToXML(const VString& inJson, VString& outXML);
 	static VError JsonToXHTML(const VString& inJson, VString& outXML, bool inWithCR = false);
+
+	// Streaming conversions: the document is converted while it is read, memory use does not depend on its size.
+	// Streams must be opened by the caller. JSON is read and written with the stream charset, XML is read as bytes.
+	// On error the output stream holds the part converted so far.
+	static VError XMLToJson(VStream* inXML, VStream* outJson, VString& outErrorMessage, sLONG& outLineNumber );
+	static VError JsonToXML(VStream* inJson, VStream* outXML, bool inToXHTML = false, bool inWithCR = false);
 private:
 	static VError _JsonToXML(const VString& inJson, VString& outXML, bool inToXHTML = false, bool inWithCR = false);
 };
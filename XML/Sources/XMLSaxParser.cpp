@@ -22,43 +22,309 @@
 #include "XMLSaxParser.h"
 #include "XMLSaxHandler.h"
 
+#include <vector>
+#include <map>
+
 
 BEGIN_TOOLBOX_NAMESPACE
 
 
 
-static bool SAXParse( VXMLParser *inUserParser, const xercesc::InputSource& inSource, IXMLHandler *inHandler, XMLParsingOptions inOptions)
+/*
+	Xerces parsers are expensive to build (scanner, string pools, validators...)
+	and most of our payloads are small, so they are recycled instead.
+
+	A parser is owned by a single thread while in use and is reconfigured before
+	each parse. Nested parses (from inside a handler) simply take another one.
+
+	Each parser keeps the DTD grammars it loaded for validating parses in its own
+	grammar cache, so that a DTD is read once per pooled parser rather than once per
+	document. The caches are not shared between parsers because a xerces grammar
+	pool is only thread safe once locked.
+
+	Xerces keys a cached grammar on the system id of the input source it was read from.
+	While caching, every external entity is resolved by VXMLGrammarResolver into a local
+	file input source, so that the key is its absolute path, and the modification stamp
+	of that file is recorded. The cache is dropped before a parse as soon as one of these
+	files has changed, or if an entity could not be resolved to a local file.
+*/
+class VXMLPooledParser
 {
-	//
-    //  Create a SAX parser object. Then, set it to validate or not.
-    //
-	xercesc::SAXParser parser;
+public:
+									VXMLPooledParser() : fParser( new xercesc::SAXParser), fHasUncheckedEntities( false)	{}
+									~VXMLPooledParser()	{ delete fParser; }
 
-	if (inOptions & XML_ValidateAlways)
-	    parser.setValidationScheme( xercesc::SAXParser::Val_Always);
-	else if (inOptions & XML_ValidateNever)
-	    parser.setValidationScheme( xercesc::SAXParser::Val_Never);
-    else
-	    parser.setValidationScheme( xercesc::SAXParser::Val_Auto);
+			xercesc::SAXParser*		GetParser() const	{ return fParser; }
 
-	parser.setLoadExternalDTD( (inOptions & XML_LoadExternalDTD) != 0);
-    parser.setDoNamespaces( (inOptions & XML_DoNameSpaces) != 0);
+			void					RecordEntityFile( const VFilePath& inPath);
+			void					RecordUncheckedEntity()		{ fHasUncheckedEntities = true; }
 
-	SAX_Handlers sax_handler( &parser, inUserParser);
-	sax_handler.SetUserHandler( inHandler);
+			// drops the cached grammars if one of the entity files they were read from has changed
+			void					PurgeStaleGrammars();
 
-	parser.setDocumentHandler( static_cast<xercesc::DocumentHandler *>(&sax_handler));
-	parser.setErrorHandler( static_cast<xercesc::ErrorHandler *>(&sax_handler));
-	parser.setEntityResolver( static_cast<xercesc::EntityResolver *>(&sax_handler));
-	parser.parse( inSource);
-	
-	return parser.getErrorCount() == 0;
+private:
+	typedef std::map<VString, VTime>	MapOfStamps;
+
+			xercesc::SAXParser*		fParser;
+			MapOfStamps				fEntityStamps;	// native path -> last modification time
+			bool					fHasUncheckedEntities;
+};
+
+
+void VXMLPooledParser::RecordEntityFile( const VFilePath& inPath)
+{
+	VFile file( inPath);
+	VTime stamp;
+	if (file.GetTimeAttributes( &stamp) == VE_OK)
+		fEntityStamps[inPath.GetPath()] = stamp;
+	else
+		fHasUncheckedEntities = true;
+}
+
+
+void VXMLPooledParser::PurgeStaleGrammars()
+{
+	bool stale = fHasUncheckedEntities;
+	for( MapOfStamps::const_iterator i = fEntityStamps.begin() ; !stale && i != fEntityStamps.end() ; ++i)
+	{
+		VFile file( VFilePath( i->first));
+		VTime stamp;
+		stale = !file.Exists() || file.GetTimeAttributes( &stamp) != VE_OK || stamp != i->second;
+	}
+
+	if (stale)
+	{
+		fParser->resetCachedGrammarPool();
+		fEntityStamps.clear();
+		fHasUncheckedEntities = false;
+	}
 }
 
 
 //====================================================================================================
 
 
+/*
+	Entity resolver used while grammars are cached.
+	Gives first chance to the user handlers, then resolves the system id relative to the
+	folder of the parsed document, and records the file in the pooled parser.
+*/
+class VXMLGrammarResolver : public xercesc::EntityResolver
+{
+public:
+									VXMLGrammarResolver( SAX_Handlers *inHandlers, VXMLPooledParser *inParser, const VFolder *inBaseFolder)
+										: fHandlers( inHandlers), fParser( inParser), fBaseFolder( inBaseFolder)	{}
+
+	virtual	xercesc::InputSource*	resolveEntity( const XMLCh* const inPublicId, const XMLCh* const inSystemId);
+
+private:
+	static	bool					_GetLocalPath( const VString& inNativePath, VFilePath& outPath);
+
+			SAX_Handlers*			fHandlers;
+			VXMLPooledParser*		fParser;
+			const VFolder*			fBaseFolder;
+};
+
+
+bool VXMLGrammarResolver::_GetLocalPath( const VString& inNativePath, VFilePath& outPath)
+{
+	#if VERSIONMAC || VERSION_LINUX
+	outPath = VFilePath( inNativePath, FPS_POSIX);
+	#else
+	outPath = VFilePath( inNativePath);
+	#endif
+	return outPath.IsFile();
+}
+
+
+xercesc::InputSource* VXMLGrammarResolver::resolveEntity( const XMLCh* const inPublicId, const XMLCh* const inSystemId)
+{
+	VFilePath path;
+
+	xercesc::InputSource *source = fHandlers->resolveEntity( inPublicId, inSystemId);
+	if (source != NULL)
+	{
+		// the user handlers always return a local file input source with an absolute path
+		const VString sourceID( const_cast<XMLCh*>(source->getSystemId()), (VSize) -1);
+		if (_GetLocalPath( sourceID, path))
+			fParser->RecordEntityFile( path);
+		else
+			fParser->RecordUncheckedEntity();
+		return source;
+	}
+
+	const VString systemID( const_cast<XMLCh*>(inSystemId), (VSize) -1);
+	VURL url( systemID, false);
+	VString scheme;
+	url.GetScheme( scheme);
+
+	// GetFilePath() only accepts "file" urls and paths
+	bool resolved = true;
+	if (scheme.IsEmpty())
+	{
+		if (systemID.BeginsWith( CVSTR( "/")))
+			url.FromFilePath( systemID, eURL_POSIX_STYLE);
+		else if (fBaseFolder != NULL)
+			url.FromRelativePath( *fBaseFolder, systemID, eURL_POSIX_STYLE);
+		else
+			resolved = false;
+	}
+
+	if (resolved && url.GetFilePath( path) && path.IsFile())
+	{
+		VString fullPath;
+		#if VERSIONMAC || VERSION_LINUX
+		path.GetPosixPath( fullPath);
+		#else
+		fullPath = path.GetPath();
+		#endif
+		fParser->RecordEntityFile( path);
+		return new xercesc::LocalFileInputSource( fullPath.GetCPointer());
+	}
+
+	// left to xerces (remote entity...), its grammar can't be checked
+	fParser->RecordUncheckedEntity();
+	return NULL;
+}
+
+
+//====================================================================================================
+
+
+class VXMLParserPool
+{
+public:
+	static	VXMLPooledParser*		Acquire();
+	static	void					Release( VXMLPooledParser *inParser, bool inReusable);
+	static	void					Clear();
+
+private:
+	enum { kMaxIdleParsers = 8 };
+
+	static	VCriticalSection				sMutex;
+	static	std::vector<VXMLPooledParser*>	sIdleParsers;
+};
+
+
+VCriticalSection					VXMLParserPool::sMutex;
+std::vector<VXMLPooledParser*>		VXMLParserPool::sIdleParsers;
+
+
+VXMLPooledParser* VXMLParserPool::Acquire()
+{
+	{
+		VTaskLock lock( &sMutex);
+		if (!sIdleParsers.empty())
+		{
+			VXMLPooledParser *parser = sIdleParsers.back();
+			sIdleParsers.pop_back();
+			return parser;
+		}
+	}
+	return new VXMLPooledParser;
+}
+
+
+void VXMLParserPool::Release( VXMLPooledParser *inParser, bool inReusable)
+{
+	if (inParser == NULL)
+		return;
+
+	// the handlers live on the caller stack
+	inParser->GetParser()->setDocumentHandler( NULL);
+	inParser->GetParser()->setErrorHandler( NULL);
+	inParser->GetParser()->setEntityResolver( NULL);
+
+	if (inReusable)
+	{
+		VTaskLock lock( &sMutex);
+		if (sIdleParsers.size() < kMaxIdleParsers)
+		{
+			sIdleParsers.push_back( inParser);
+			inParser = NULL;
+		}
+	}
+
+	delete inParser;
+}
+
+
+void VXMLParserPool::Clear()
+{
+	std::vector<VXMLPooledParser*> parsers;
+	{
+		VTaskLock lock( &sMutex);
+		parsers.swap( sIdleParsers);
+	}
+
+	for( std::vector<VXMLPooledParser*>::iterator i = parsers.begin() ; i != parsers.end() ; ++i)
+		delete *i;
+}
+
+
+//====================================================================================================
+
+
+static bool SAXParse( VXMLParser *inUserParser, const xercesc::InputSource& inSource, IXMLHandler *inHandler, XMLParsingOptions inOptions, const VFolder *inBaseFolder = NULL)
+{
+	//
+    //  Get a SAX parser object. Then, set it to validate or not.
+    //
+	VXMLPooledParser *pooled = VXMLParserPool::Acquire();
+	if (pooled == NULL)
+		return false;
+
+	xercesc::SAXParser *parser = pooled->GetParser();
+	bool ok = false;
+	try
+	{
+		if (inOptions & XML_ValidateAlways)
+			parser->setValidationScheme( xercesc::SAXParser::Val_Always);
+		else if (inOptions & XML_ValidateNever)
+			parser->setValidationScheme( xercesc::SAXParser::Val_Never);
+		else
+			parser->setValidationScheme( xercesc::SAXParser::Val_Auto);
+
+		parser->setLoadExternalDTD( (inOptions & XML_LoadExternalDTD) != 0);
+		parser->setDoNamespaces( (inOptions & XML_DoNameSpaces) != 0);
+
+		// reuse the external DTDs already parsed by this parser, unless their files have changed
+		bool cacheGrammars = ((inOptions & XML_LoadExternalDTD) != 0) && ((inOptions & XML_ValidateNever) == 0);
+		if (cacheGrammars)
+			pooled->PurgeStaleGrammars();
+		parser->cacheGrammarFromParse( cacheGrammars);
+		parser->useCachedGrammarInParse( cacheGrammars);
+
+		SAX_Handlers sax_handler( parser, inUserParser);
+		sax_handler.SetUserHandler( inHandler);
+
+		VXMLGrammarResolver grammar_resolver( &sax_handler, pooled, inBaseFolder);
+
+		parser->setDocumentHandler( static_cast<xercesc::DocumentHandler *>(&sax_handler));
+		parser->setErrorHandler( static_cast<xercesc::ErrorHandler *>(&sax_handler));
+		if (cacheGrammars)
+			parser->setEntityResolver( static_cast<xercesc::EntityResolver *>(&grammar_resolver));
+		else
+			parser->setEntityResolver( static_cast<xercesc::EntityResolver *>(&sax_handler));
+		parser->parse( inSource);
+
+		ok = parser->getErrorCount() == 0;
+	}
+	catch(...)
+	{
+		// a parser left in the middle of a failed parse is not trusted again
+		VXMLParserPool::Release( pooled, false);
+		throw;
+	}
+
+	VXMLParserPool::Release( pooled, true);
+
+	return ok;
+}
+
+//====================================================================================================
+
+
 
 // Components custom implementation
 
@@ -75,7 +341,10 @@ bool VXMLParser::Parse( VFile *inFile, IXMLHandler *inHandler, XMLParsingOptions
 	
 	xercesc::LocalFileInputSource source(full_path.GetCPointer());
 
-	return SAXParse( this, source, inHandler, inOptions);
+	// relative system ids are resolved from the document folder
+	VRefPtr<VFolder> folder( inFile->RetainParentFolder(), false);
+
+	return SAXParse( this, source, inHandler, inOptions, folder.Get());
 }
 
 
@@ -143,6 +412,7 @@ XBOX::VFile *VXMLParser::ResolveEntityFromFolder( const VString& inEntityBase, V
 
 void VXMLParser::DeInit()
 {
+	VXMLParserPool::Clear();
 	xercesc::XMLPlatformUtils::Terminate();
 }
 